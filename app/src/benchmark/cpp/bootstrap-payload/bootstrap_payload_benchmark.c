@@ -0,0 +1,183 @@
+/*
+ * Benchmark for the bootstrap payload extracted by termux-bootstrap.c for BootstrapExtractor.
+ *
+ * The bootstrap zip and the manifest generated for it by app/build.gradle are read from
+ * app/src/main/cpp, so that the payload that would be embedded in the app is benchmarked. Run
+ * `./gradlew :app:downloadBootstraps` first to download and index them.
+ * The zip is then extracted into a temporary staging directory with extract_zip() for each thread
+ * count, and the median extraction time of the runs is reported.
+ *
+ * Build and run with `make run` in this directory. See `./bootstrap-payload-benchmark -h` for options.
+ */
+
+#include <jni.h>
+
+// The symbols of termux-bootstrap-zip.S, which are only used by the JNI functions
+jbyte blob[1];
+int blob_size;
+jbyte manifest[1];
+int manifest_size;
+
+#include "../../../main/cpp/termux-bootstrap.c"
+
+#include <ftw.h>
+#include <getopt.h>
+
+#define MAX_RUN_THREAD_COUNTS 16
+
+struct options {
+    const char* zip_path;
+    const char* manifest_path;
+    const char* base_dir;
+    int thread_counts[MAX_RUN_THREAD_COUNTS];
+    int thread_count_count;
+    int runs;
+};
+
+struct payload {
+    const char* name;
+    uint8_t* data;
+    size_t size;
+    char* manifest;
+    size_t manifest_size;
+};
+
+static bool read_file(const char* path, uint8_t** data, size_t* size) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd == -1 || fstat(fd, &st) == -1) {
+        fprintf(stderr, "Failed to open \"%s\": %s\n", path, strerror(errno));
+        if (fd != -1) close(fd);
+        return false;
+    }
+
+    *size = (size_t) st.st_size;
+    *data = malloc(*size > 0 ? *size : 1);
+    size_t offset = 0;
+    while (*data != NULL && offset < *size) {
+        ssize_t length = read(fd, *data + offset, *size - offset);
+        if (length <= 0) break;
+        offset += (size_t) length;
+    }
+    close(fd);
+    if (*data == NULL || offset != *size) {
+        fprintf(stderr, "Failed to read \"%s\"\n", path);
+        return false;
+    }
+    return true;
+}
+
+static int remove_entry(const char* path, const struct stat* st, int flag, struct FTW* ftw) {
+    (void) st;
+    (void) flag;
+    if (ftw->level == 0) return 0;
+    return remove(path) == 0 ? 0 : -1;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double value_a = *(const double*) a;
+    double value_b = *(const double*) b;
+    return value_a < value_b ? -1 : (value_a > value_b ? 1 : 0);
+}
+
+// Extract the payload opts->runs times with thread_count threads and report the median time
+static bool run_payload(const struct options* opts, const struct payload* payload, int thread_count) {
+    double seconds[opts->runs];
+    int used_thread_count = 0;
+    long symlink_count = 0;
+    size_t file_count = 0;
+    uint64_t total_bytes = 0;
+    for (int run = 0; run < opts->runs; run++) {
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/bootstrap-payload-benchmark.XXXXXX", opts->base_dir);
+        if (mkdtemp(path) == NULL) {
+            fprintf(stderr, "Failed to create directory under \"%s\": %s\n", opts->base_dir, strerror(errno));
+            return false;
+        }
+        int staging_fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+        struct extraction x;
+        init_extraction(&x, payload->data, payload->size, payload->manifest, payload->manifest_size, staging_fd);
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        symlink_count = extract_zip(&x, thread_count, 0, NULL, NULL);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        seconds[run] = (double) (end.tv_sec - start.tv_sec) + (double) (end.tv_nsec - start.tv_nsec) / 1e9;
+
+        if (symlink_count < 0)
+            fprintf(stderr, "Failed to %s \"%s\" of %s: %s\n", x.error_operation, x.error_path != NULL ? x.error_path : "",
+                    payload->name, strerror(x.error));
+        file_count = x.file_count;
+        total_bytes = x.total_bytes;
+        used_thread_count = x.thread_count;
+        destroy_extraction(&x);
+        close(staging_fd);
+
+        nftw(path, remove_entry, 64, FTW_DEPTH | FTW_PHYS);
+        rmdir(path);
+        if (symlink_count < 0) return false;
+    }
+
+    qsort(seconds, (size_t) opts->runs, sizeof(double), compare_doubles);
+    double median = seconds[opts->runs / 2];
+    printf("%-12s %10zu bytes %2d thread%s %6zu files %5ld symlinks %8.1f ms %8.1f MB/s\n", payload->name, payload->size,
+           used_thread_count, used_thread_count == 1 ? " " : "s", file_count, symlink_count, median * 1000,
+           (double) total_bytes / median / 1e6);
+    return true;
+}
+
+static void print_usage(const char* name) {
+    printf("Usage: %s [-z zip] [-m manifest] [-d dir] [-t threads] [-r runs]\n"
+           "  -z zip         bootstrap zip (default: ../../../main/cpp/bootstrap-aarch64.zip)\n"
+           "  -m manifest    manifest of the zip (default: ../../../main/cpp/bootstrap-aarch64.manifest)\n"
+           "  -d dir         directory to extract under (default: /tmp)\n"
+           "  -t threads     comma separated thread counts (default: 1,2,4,8)\n"
+           "  -r runs        number of runs of each thread count (default: 5)\n", name);
+}
+
+int main(int argc, char** argv) {
+    struct options opts = {"../../../main/cpp/bootstrap-aarch64.zip", "../../../main/cpp/bootstrap-aarch64.manifest",
+                           "/tmp", {1, 2, 4, 8}, 4, 5};
+    int opt;
+    while ((opt = getopt(argc, argv, "z:m:d:t:r:h")) != -1) {
+        switch (opt) {
+            case 'z': opts.zip_path = optarg; break;
+            case 'm': opts.manifest_path = optarg; break;
+            case 'd': opts.base_dir = optarg; break;
+            case 't': {
+                opts.thread_count_count = 0;
+                char* save;
+                for (char* count = strtok_r(optarg, ",", &save); count != NULL && opts.thread_count_count < MAX_RUN_THREAD_COUNTS;
+                     count = strtok_r(NULL, ",", &save))
+                    opts.thread_counts[opts.thread_count_count++] = atoi(count);
+                break;
+            }
+            case 'r': opts.runs = atoi(optarg); break;
+            default: print_usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (opts.thread_count_count == 0 || opts.runs < 1) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    // The manifest is generated by app/build.gradle with downloadBootstraps
+    struct payload zip = {"zip", NULL, 0, NULL, 0};
+    uint8_t* manifest_data = NULL;
+    if (!read_file(opts.zip_path, &zip.data, &zip.size) ||
+        !read_file(opts.manifest_path, &manifest_data, &zip.manifest_size)) {
+        fprintf(stderr, "Run `./gradlew :app:downloadBootstraps` to download the zip and generate its manifest\n");
+        return 1;
+    }
+    zip.manifest = (char*) manifest_data;
+
+    printf("zip %zu bytes with a %zu bytes manifest\n", zip.size, zip.manifest_size);
+
+    bool success = true;
+    for (int i = 0; i < opts.thread_count_count; i++)
+        success &= run_payload(&opts, &zip, opts.thread_counts[i]);
+
+    free(zip.data);
+    free(manifest_data);
+    return success ? 0 : 1;
+}
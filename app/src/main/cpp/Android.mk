@@ -2,4 +2,5 @@ LOCAL_PATH:= $(call my-dir)
 include $(CLEAR_VARS)
 LOCAL_MODULE := libtermux-bootstrap
 LOCAL_SRC_FILES := termux-bootstrap-zip.S termux-bootstrap.c
+LOCAL_LDLIBS := -lz
 include $(BUILD_SHARED_LIBRARY)
@@ -1,11 +1,764 @@
+#include <errno.h>
+#include <fcntl.h>
 #include <jni.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <zlib.h>
 
 extern jbyte blob[];
 extern int blob_size;
+extern jbyte manifest[];
+extern int manifest_size;
 
-JNIEXPORT jbyteArray JNICALL Java_com_termux_app_TermuxInstaller_getZip(JNIEnv *env, __attribute__((__unused__)) jobject This)
+#define ZIP_METHOD_STORED 0
+#define ZIP_METHOD_DEFLATED 8
+
+// The first line of the manifest generated for the zip by app/build.gradle
+#define MANIFEST_HEADER "termux-bootstrap-manifest 1\n"
+#define MANIFEST_ID_PREFIX "id "
+#define MANIFEST_MAX_ID_LENGTH 64
+#define MANIFEST_TYPE_DIRECTORY 'd'
+#define MANIFEST_TYPE_FILE 'f'
+#define MANIFEST_TYPE_SYMLINKS 's'
+
+// The file in the staging directory with the id of the manifest being extracted into it, which
+// exists until the extraction has finished, so that a killed extraction can be resumed
+#define RESUME_ID_FILE_NAME ".termux-bootstrap-id"
+
+#define SYMLINKS_FILE_NAME "SYMLINKS.txt"
+// The separator between the target and the path of the symlinks in SYMLINKS.txt
+#define SYMLINKS_SEPARATOR "\xe2\x86\x90"
+
+#define MAX_THREAD_COUNT 8
+#define WRITE_BUFFER_SIZE (256 * 1024)
+
+// An entry of the zip, as indexed by the manifest
+struct zip_entry {
+    const char* name;
+    uint16_t name_length;
+    char type;
+    uint16_t method;
+    uint32_t mode;
+    uint32_t crc;
+    uint32_t compressed_size;
+    uint32_t uncompressed_size;
+    uint32_t data_offset;
+};
+
+struct extraction {
+    const uint8_t* zip;
+    size_t zip_size;
+    const char* manifest;
+    size_t manifest_size;
+    int staging_fd;
+
+    const char* id;
+    size_t id_length;
+    // Whether files already extracted by a previous extraction of the same manifest are kept
+    bool resuming;
+
+    struct zip_entry* entries;
+    size_t entry_count;
+    // The regular file entries, with the largest first, so that large files do not end up last on
+    // a single thread
+    const struct zip_entry** files;
+    size_t file_count;
+    uint64_t total_bytes;
+
+    atomic_size_t next_file;
+    atomic_size_t extracted_file_count;
+    atomic_size_t resumed_file_count;
+    atomic_uint_fast64_t extracted_bytes;
+    atomic_bool stopped;
+
+    pthread_mutex_t lock;
+    pthread_cond_t done_cond;
+    int thread_count;
+    int running_thread_count;
+    // The first failure, protected by lock while worker threads are running. Use stopped to check
+    // for failures without the lock.
+    int error;
+    char error_operation[32];
+    char* error_path;
+};
+
+static void init_extraction(struct extraction* x, const uint8_t* zip, size_t zip_size,
+                            const char* manifest, size_t manifest_size, int staging_fd) {
+    memset(x, 0, sizeof(*x));
+    x->zip = zip;
+    x->zip_size = zip_size;
+    x->manifest = manifest;
+    x->manifest_size = manifest_size;
+    x->staging_fd = staging_fd;
+    atomic_init(&x->next_file, 0);
+    atomic_init(&x->extracted_file_count, 0);
+    atomic_init(&x->resumed_file_count, 0);
+    atomic_init(&x->extracted_bytes, 0);
+    atomic_init(&x->stopped, false);
+    pthread_mutex_init(&x->lock, NULL);
+    pthread_cond_init(&x->done_cond, NULL);
+}
+
+static void destroy_extraction(struct extraction* x) {
+    free(x->error_path);
+    free(x->files);
+    free(x->entries);
+    pthread_cond_destroy(&x->done_cond);
+    pthread_mutex_destroy(&x->lock);
+}
+
+static long get_monotonic_millis(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long) now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/* readlinkat() and symlinkat() are only available in bionic from api 21, so call the syscalls directly. */
+static ssize_t sys_readlinkat(int dir_fd, const char* path, char* buf, size_t buf_size) {
+    return (ssize_t) syscall(__NR_readlinkat, dir_fd, path, buf, buf_size);
+}
+
+static int sys_symlinkat(const char* target, int dir_fd, const char* path) {
+    return (int) syscall(__NR_symlinkat, target, dir_fd, path);
+}
+
+static void set_error(struct extraction* x, int error, const char* operation, const char* name, size_t name_length) {
+    pthread_mutex_lock(&x->lock);
+    if (x->error == 0) {
+        x->error = error;
+        snprintf(x->error_operation, sizeof(x->error_operation), "%s", operation);
+        x->error_path = strndup(name, name_length);
+    }
+    pthread_mutex_unlock(&x->lock);
+    atomic_store(&x->stopped, true);
+}
+
+// Whether the entry name is a relative path that stays under the staging directory
+static bool is_safe_entry_name(const char* name, size_t length) {
+    if (length == 0 || name[0] == '/' || memchr(name, '\0', length) != NULL) return false;
+    const char* end = name + length;
+    for (const char* component = name; component < end;) {
+        const char* slash = memchr(component, '/', (size_t) (end - component));
+        size_t component_length = (size_t) ((slash != NULL ? slash : end) - component);
+        if (component_length == 2 && component[0] == '.' && component[1] == '.') return false;
+        if (slash == NULL) break;
+        component = slash + 1;
+    }
+    return true;
+}
+
+// Parse the decimal, hex or octal number at *p followed by a space
+static bool parse_manifest_number(const char** p, const char* end, int base, uint32_t* value) {
+    uint64_t result = 0;
+    const char* start = *p;
+    for (; *p < end && **p != ' '; (*p)++) {
+        char c = **p;
+        int digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else return false;
+        if (digit >= base) return false;
+        result = result * (unsigned) base + (unsigned) digit;
+        if (result > UINT32_MAX) return false;
+    }
+    if (*p == start || *p == end) return false;
+    (*p)++;
+    *value = (uint32_t) result;
+    return true;
+}
+
+/*
+ * Read the entries of the zip from the manifest, which has the header line and an
+ * "id <sha256 of zip>" line, followed by a
+ * "<type> <mode octal> <size> <crc32 hex> <method> <compressed size> <data offset> <name>" line
+ * for each entry, in the order of the zip. The data offset is the offset of the compressed data
+ * in the zip, so the entries can be extracted without reading the zip headers. Returns 0 on
+ * success, otherwise EINVAL if the manifest is malformed or does not match the zip.
+ */
+static int read_manifest_entries(struct extraction* x) {
+    const char* p = x->manifest;
+    const char* end = x->manifest + x->manifest_size;
+    size_t header_length = strlen(MANIFEST_HEADER);
+    if (x->manifest_size < header_length || memcmp(p, MANIFEST_HEADER, header_length) != 0 || end[-1] != '\n')
+        return EINVAL;
+    p += header_length;
+
+    const char* newline = memchr(p, '\n', (size_t) (end - p));
+    size_t id_prefix_length = strlen(MANIFEST_ID_PREFIX);
+    if (newline == NULL || (size_t) (newline - p) <= id_prefix_length || (size_t) (newline - p) > id_prefix_length + MANIFEST_MAX_ID_LENGTH ||
+        memcmp(p, MANIFEST_ID_PREFIX, id_prefix_length) != 0)
+        return EINVAL;
+    x->id = p + id_prefix_length;
+    x->id_length = (size_t) (newline - x->id);
+    p = newline + 1;
+
+    size_t entry_count = 0;
+    for (const char* line = p; line < end; line = (const char*) memchr(line, '\n', (size_t) (end - line)) + 1)
+        entry_count++;
+
+    x->entries = calloc(entry_count > 0 ? entry_count : 1, sizeof(struct zip_entry));
+    if (x->entries == NULL) return ENOMEM;
+
+    for (size_t i = 0; i < entry_count; i++) {
+        struct zip_entry* entry = &x->entries[i];
+        newline = memchr(p, '\n', (size_t) (end - p));
+        if (newline - p < 2 || p[1] != ' ') return EINVAL;
+        entry->type = p[0];
+        p += 2;
+
+        uint32_t method;
+        if (!parse_manifest_number(&p, newline, 8, &entry->mode) ||
+            !parse_manifest_number(&p, newline, 10, &entry->uncompressed_size) ||
+            !parse_manifest_number(&p, newline, 16, &entry->crc) ||
+            !parse_manifest_number(&p, newline, 10, &method) ||
+            !parse_manifest_number(&p, newline, 10, &entry->compressed_size) ||
+            !parse_manifest_number(&p, newline, 10, &entry->data_offset) ||
+            newline - p > UINT16_MAX)
+            return EINVAL;
+        entry->method = (uint16_t) method;
+        entry->name = p;
+        entry->name_length = (uint16_t) (newline - p);
+        p = newline + 1;
+
+        if (entry->type != MANIFEST_TYPE_DIRECTORY && entry->type != MANIFEST_TYPE_FILE && entry->type != MANIFEST_TYPE_SYMLINKS)
+            return EINVAL;
+        if (entry->method != ZIP_METHOD_STORED && entry->method != ZIP_METHOD_DEFLATED) return EINVAL;
+        if ((entry->mode & ~07777u) != 0) return EINVAL;
+        if ((uint64_t) entry->data_offset + entry->compressed_size > x->zip_size) return EINVAL;
+        if (!is_safe_entry_name(entry->name, entry->name_length)) return EINVAL;
+    }
+    x->entry_count = entry_count;
+    return 0;
+}
+
+static bool is_directory_entry(const struct zip_entry* entry) {
+    return entry->type == MANIFEST_TYPE_DIRECTORY;
+}
+
+static bool is_symlinks_entry(const struct zip_entry* entry) {
+    return entry->type == MANIFEST_TYPE_SYMLINKS;
+}
+
+/*
+ * Create the directory at path relative to the staging directory and all its parents. The last
+ * created directory is remembered, since entries are mostly ordered by directory.
+ */
+static int make_directories(struct extraction* x, const char* path, size_t length, char** last_created) {
+    while (length > 0 && path[length - 1] == '/') length--;
+    if (length == 0) return 0;
+    if (*last_created != NULL && strlen(*last_created) == length && memcmp(*last_created, path, length) == 0) return 0;
+
+    char* dir = strndup(path, length);
+    if (dir == NULL) return ENOMEM;
+    for (char* slash = dir;; slash++) {
+        slash = strchr(slash, '/');
+        if (slash != NULL) *slash = '\0';
+        if (mkdirat(x->staging_fd, dir, 0700) == -1 && errno != EEXIST) {
+            int error = errno;
+            set_error(x, error, "mkdir", dir, strlen(dir));
+            free(dir);
+            return error;
+        }
+        if (slash == NULL) break;
+        *slash = '/';
+    }
+    free(*last_created);
+    *last_created = dir;
+    return 0;
+}
+
+static int make_parent_directories(struct extraction* x, const char* path, size_t length, char** last_created) {
+    while (length > 0 && path[length - 1] != '/') length--;
+    return make_directories(x, path, length, last_created);
+}
+
+/*
+ * Decompress the entry with the output buffer, calling write_data for each full buffer. Returns
+ * 0 on success, otherwise the errno of the failure.
+ */
+static int decompress_entry(struct extraction* x, const struct zip_entry* entry, uint8_t* buffer,
+                            int (*write_data)(void* arg, const uint8_t* data, size_t size), void* arg) {
+    const uint8_t* data = x->zip + entry->data_offset;
+
+    uLong crc = crc32(0L, Z_NULL, 0);
+    if (entry->method == ZIP_METHOD_STORED) {
+        if (entry->compressed_size != entry->uncompressed_size) return EINVAL;
+        crc = crc32(crc, data, entry->uncompressed_size);
+        if (crc != entry->crc) return EBADMSG;
+        return write_data(arg, data, entry->uncompressed_size);
+    }
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) return ENOMEM;
+    stream.next_in = (Bytef*) data;
+    stream.avail_in = entry->compressed_size;
+
+    int error = 0;
+    uint64_t total = 0;
+    for (;;) {
+        stream.next_out = buffer;
+        stream.avail_out = WRITE_BUFFER_SIZE;
+        int rc = inflate(&stream, Z_NO_FLUSH);
+        if (rc != Z_OK && rc != Z_STREAM_END) {
+            error = rc == Z_MEM_ERROR ? ENOMEM : EBADMSG;
+            break;
+        }
+
+        size_t size = WRITE_BUFFER_SIZE - stream.avail_out;
+        if (size > 0) {
+            crc = crc32(crc, buffer, (uInt) size);
+            total += size;
+            error = write_data(arg, buffer, size);
+            if (error != 0) break;
+        }
+        if (rc == Z_STREAM_END) break;
+        if (size == 0 && stream.avail_in == 0) {
+            // Truncated data
+            error = EBADMSG;
+            break;
+        }
+        if (atomic_load(&x->stopped)) {
+            error = ECANCELED;
+            break;
+        }
+    }
+    inflateEnd(&stream);
+
+    if (error == 0 && (total != entry->uncompressed_size || crc != entry->crc)) error = EBADMSG;
+    return error;
+}
+
+static int write_to_fd(void* arg, const uint8_t* data, size_t size) {
+    int fd = *(int*) arg;
+    while (size > 0) {
+        ssize_t written = TEMP_FAILURE_RETRY(write(fd, data, size));
+        if (written == -1) return errno;
+        data += written;
+        size -= (size_t) written;
+    }
+    return 0;
+}
+
+struct memory_buffer {
+    uint8_t* data;
+    size_t size;
+    size_t capacity;
+};
+
+static int write_to_memory(void* arg, const uint8_t* data, size_t size) {
+    struct memory_buffer* buffer = arg;
+    if (buffer->size + size + 1 > buffer->capacity) {
+        size_t capacity = (buffer->size + size + 1) * 2;
+        uint8_t* new_data = realloc(buffer->data, capacity);
+        if (new_data == NULL) return ENOMEM;
+        buffer->data = new_data;
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->data + buffer->size, data, size);
+    buffer->size += size;
+    buffer->data[buffer->size] = '\0';
+    return 0;
+}
+
+/*
+ * Whether the file of the entry was already extracted by the killed extraction being resumed, which
+ * is the case if it is a regular file with the size, mode and crc32 of the entry. The crc32 only
+ * detects files that the killed extraction left partially written, and is not a content hash, so
+ * files are never kept this way for a different manifest, like when the app is updated.
+ */
+static bool is_file_resumable(struct extraction* x, const struct zip_entry* entry, const char* name, uint8_t* buffer) {
+    int fd = TEMP_FAILURE_RETRY(openat(x->staging_fd, name, O_RDONLY | O_NOFOLLOW | O_CLOEXEC));
+    if (fd == -1) return false;
+
+    struct stat st;
+    bool extracted = fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size == (off_t) entry->uncompressed_size &&
+        (st.st_mode & 07777) == entry->mode;
+    if (extracted) {
+        uLong crc = crc32(0L, Z_NULL, 0);
+        for (;;) {
+            ssize_t size = TEMP_FAILURE_RETRY(read(fd, buffer, WRITE_BUFFER_SIZE));
+            if (size <= 0) {
+                extracted = size == 0;
+                break;
+            }
+            crc = crc32(crc, buffer, (uInt) size);
+        }
+        extracted = extracted && crc == entry->crc;
+    }
+    close(fd);
+    return extracted;
+}
+
+/*
+ * Extract the file of the entry with the mode of the entry. Sets resumed to true if the file was
+ * kept since it was already extracted by the killed extraction being resumed.
+ */
+static int extract_file(struct extraction* x, const struct zip_entry* entry, uint8_t* buffer, bool* resumed) {
+    char* name = strndup(entry->name, entry->name_length);
+    if (name == NULL) return ENOMEM;
+
+    *resumed = x->resuming && is_file_resumable(x, entry, name, buffer);
+    if (*resumed) {
+        free(name);
+        return 0;
+    }
+
+    int fd = TEMP_FAILURE_RETRY(openat(x->staging_fd, name, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC,
+                                       entry->mode & 0700));
+    if (fd == -1) {
+        int error = errno;
+        set_error(x, error, "open", entry->name, entry->name_length);
+        free(name);
+        return error;
+    }
+
+    int error = decompress_entry(x, entry, buffer, write_to_fd, &fd);
+    // Set the mode explicitly since the mode passed to openat() is masked by the umask and is not
+    // used for existing files
+    if (error == 0 && fchmod(fd, entry->mode) == -1) error = errno;
+    if (close(fd) == -1 && error == 0) error = errno;
+    if (error != 0 && error != ECANCELED)
+        set_error(x, error, "extract", entry->name, entry->name_length);
+    free(name);
+    return error;
+}
+
+static void* extract_files(void* arg) {
+    struct extraction* x = arg;
+    uint8_t* buffer = malloc(WRITE_BUFFER_SIZE);
+    if (buffer == NULL) {
+        set_error(x, ENOMEM, "malloc", "", 0);
+    } else {
+        while (!atomic_load(&x->stopped)) {
+            size_t i = atomic_fetch_add(&x->next_file, 1);
+            if (i >= x->file_count) break;
+            const struct zip_entry* entry = x->files[i];
+            bool resumed;
+            if (extract_file(x, entry, buffer, &resumed) != 0) break;
+            if (resumed) atomic_fetch_add(&x->resumed_file_count, 1);
+            atomic_fetch_add(&x->extracted_file_count, 1);
+            atomic_fetch_add(&x->extracted_bytes, entry->uncompressed_size);
+        }
+        free(buffer);
+    }
+
+    pthread_mutex_lock(&x->lock);
+    x->running_thread_count--;
+    pthread_cond_signal(&x->done_cond);
+    pthread_mutex_unlock(&x->lock);
+    return NULL;
+}
+
+/*
+ * Replace the existing file at path with a symlink to target, unless it already is one, when
+ * resuming an extraction. Returns 0 on success, otherwise -1 with errno set.
+ */
+static int replace_symlink(struct extraction* x, const char* target, const char* path) {
+    char existing_target[PATH_MAX];
+    ssize_t length = sys_readlinkat(x->staging_fd, path, existing_target, sizeof(existing_target));
+    if (length >= 0 && (size_t) length == strlen(target) && memcmp(existing_target, target, (size_t) length) == 0)
+        return 0;
+    if (unlinkat(x->staging_fd, path, 0) == -1 && errno != ENOENT) return -1;
+    return sys_symlinkat(target, x->staging_fd, path);
+}
+
+/*
+ * Create the symlinks listed in the SYMLINKS.txt entry, with a "target←path" line for each.
+ * Returns the number of symlinks created, or -1 on failure.
+ */
+static long create_symlinks(struct extraction* x, const struct zip_entry* entry, char** last_created) {
+    struct memory_buffer symlinks = {NULL, 0, 0};
+    uint8_t* buffer = malloc(WRITE_BUFFER_SIZE);
+    int error = buffer != NULL ? decompress_entry(x, entry, buffer, write_to_memory, &symlinks) : ENOMEM;
+    free(buffer);
+    if (error != 0 || symlinks.data == NULL) {
+        set_error(x, error != 0 ? error : EINVAL, "extract", entry->name, entry->name_length);
+        free(symlinks.data);
+        return -1;
+    }
+
+    long count = 0;
+    char* save = NULL;
+    for (char* line = strtok_r((char*) symlinks.data, "\n", &save); line != NULL; line = strtok_r(NULL, "\n", &save)) {
+        char* separator = strstr(line, SYMLINKS_SEPARATOR);
+        char* path = separator != NULL ? separator + strlen(SYMLINKS_SEPARATOR) : NULL;
+        if (separator == NULL || strstr(path, SYMLINKS_SEPARATOR) != NULL || !is_safe_entry_name(path, strlen(path))) {
+            set_error(x, EINVAL, "symlink", line, strlen(line));
+            count = -1;
+            break;
+        }
+        *separator = '\0';
+
+        if (make_parent_directories(x, path, strlen(path), last_created) != 0) {
+            count = -1;
+            break;
+        }
+        if (sys_symlinkat(line, x->staging_fd, path) == -1 &&
+            (errno != EEXIST || !x->resuming || replace_symlink(x, line, path) != 0)) {
+            set_error(x, errno, "symlink", path, strlen(path));
+            count = -1;
+            break;
+        }
+        count++;
+    }
+
+    free(symlinks.data);
+    if (count == 0) {
+        set_error(x, EINVAL, "symlink", entry->name, entry->name_length);
+        count = -1;
+    }
+    return count;
+}
+
+static int compare_file_sizes(const void* a, const void* b) {
+    uint32_t size_a = (*(const struct zip_entry* const*) a)->uncompressed_size;
+    uint32_t size_b = (*(const struct zip_entry* const*) b)->uncompressed_size;
+    return size_a < size_b ? 1 : (size_a > size_b ? -1 : 0);
+}
+
+// Whether the resume id file in the staging directory has the id of the manifest
+static bool has_resume_id(const struct extraction* x) {
+    int fd = TEMP_FAILURE_RETRY(openat(x->staging_fd, RESUME_ID_FILE_NAME, O_RDONLY | O_NOFOLLOW | O_CLOEXEC));
+    if (fd == -1) return false;
+    char id[MANIFEST_MAX_ID_LENGTH + 1];
+    ssize_t length = TEMP_FAILURE_RETRY(read(fd, id, sizeof(id)));
+    close(fd);
+    return length >= 0 && (size_t) length == x->id_length && memcmp(id, x->id, x->id_length) == 0;
+}
+
+static int write_resume_id(const struct extraction* x) {
+    int fd = TEMP_FAILURE_RETRY(openat(x->staging_fd, RESUME_ID_FILE_NAME, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC, 0600));
+    if (fd == -1) return errno;
+    int error = write_to_fd(&fd, (const uint8_t*) x->id, x->id_length);
+    if (close(fd) == -1 && error == 0) error = errno;
+    return error;
+}
+
+/*
+ * Extract the zip into the staging directory, with thread_count threads inflating regular files
+ * in parallel while the calling thread creates the directories and the symlinks listed in
+ * SYMLINKS.txt. The on_progress callback is called on the calling thread every
+ * progress_interval_millis if it is > 0, and extraction is cancelled if it returns false.
+ * If the staging directory has the resume id of the manifest, then files that were already
+ * extracted are kept. Returns the number of symlinks created, or -1 on failure, in which case the
+ * error is set.
+ */
+static long extract_zip(struct extraction* x, int thread_count, long progress_interval_millis,
+                        bool (*on_progress)(const struct extraction* x, void* arg), void* arg) {
+    int error = read_manifest_entries(x);
+    if (error != 0) {
+        set_error(x, error, "read", "manifest", strlen("manifest"));
+        return -1;
+    }
+
+    // Keep the files already extracted into the staging directory if a previous extraction of the
+    // same manifest was killed, otherwise mark the staging directory as being extracted into
+    x->resuming = has_resume_id(x);
+    if (!x->resuming && (error = write_resume_id(x)) != 0) {
+        set_error(x, error, "write", RESUME_ID_FILE_NAME, strlen(RESUME_ID_FILE_NAME));
+        return -1;
+    }
+
+    x->files = malloc((x->entry_count > 0 ? x->entry_count : 1) * sizeof(struct zip_entry*));
+    if (x->files == NULL) {
+        set_error(x, ENOMEM, "read", "", 0);
+        return -1;
+    }
+
+    // Create all directories before any files are extracted into them
+    char* last_created = NULL;
+    const struct zip_entry* symlinks_entry = NULL;
+    for (size_t i = 0; i < x->entry_count && x->error == 0; i++) {
+        const struct zip_entry* entry = &x->entries[i];
+        if (is_directory_entry(entry)) {
+            make_directories(x, entry->name, entry->name_length, &last_created);
+        } else if (is_symlinks_entry(entry)) {
+            symlinks_entry = entry;
+        } else {
+            make_parent_directories(x, entry->name, entry->name_length, &last_created);
+            x->files[x->file_count++] = entry;
+            x->total_bytes += entry->uncompressed_size;
+        }
+    }
+    if (x->error == 0 && symlinks_entry == NULL)
+        set_error(x, EINVAL, "find", SYMLINKS_FILE_NAME, strlen(SYMLINKS_FILE_NAME));
+    if (x->error != 0) {
+        free(last_created);
+        return -1;
+    }
+
+    qsort(x->files, x->file_count, sizeof(struct zip_entry*), compare_file_sizes);
+
+    if (thread_count <= 0) {
+        long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = cpu_count > 0 ? (int) cpu_count : 1;
+    }
+    if (thread_count > MAX_THREAD_COUNT) thread_count = MAX_THREAD_COUNT;
+    if ((size_t) thread_count > x->file_count) thread_count = x->file_count > 0 ? (int) x->file_count : 1;
+
+    pthread_t threads[MAX_THREAD_COUNT];
+    for (int i = 0; i < thread_count; i++) {
+        pthread_mutex_lock(&x->lock);
+        x->running_thread_count++;
+        pthread_mutex_unlock(&x->lock);
+        if (pthread_create(&threads[i], NULL, extract_files, x) != 0) {
+            pthread_mutex_lock(&x->lock);
+            x->running_thread_count--;
+            pthread_mutex_unlock(&x->lock);
+            // The threads already started extract everything
+            if (i == 0) set_error(x, EAGAIN, "pthread_create", "", 0);
+            break;
+        }
+        x->thread_count++;
+    }
+
+    // Create the symlinks while the files are extracted. The workers may set the error, so check
+    // the atomic stopped flag instead of reading it without the lock.
+    long symlink_count = !atomic_load(&x->stopped) ? create_symlinks(x, symlinks_entry, &last_created) : -1;
+    free(last_created);
+
+    pthread_mutex_lock(&x->lock);
+    while (x->running_thread_count > 0) {
+        if (progress_interval_millis > 0) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += progress_interval_millis / 1000;
+            deadline.tv_nsec += (progress_interval_millis % 1000) * 1000000;
+            if (deadline.tv_nsec >= 1000000000) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000;
+            }
+            if (pthread_cond_timedwait(&x->done_cond, &x->lock, &deadline) == ETIMEDOUT && !atomic_load(&x->stopped)) {
+                pthread_mutex_unlock(&x->lock);
+                if (!on_progress(x, arg))
+                    set_error(x, ECANCELED, "extract", "", 0);
+                pthread_mutex_lock(&x->lock);
+            }
+        } else {
+            pthread_cond_wait(&x->done_cond, &x->lock);
+        }
+    }
+    pthread_mutex_unlock(&x->lock);
+
+    for (int i = 0; i < x->thread_count; i++)
+        pthread_join(threads[i], NULL);
+
+    if (x->error == 0 && unlinkat(x->staging_fd, RESUME_ID_FILE_NAME, 0) == -1)
+        set_error(x, errno, "unlink", RESUME_ID_FILE_NAME, strlen(RESUME_ID_FILE_NAME));
+
+    return x->error == 0 ? symlink_count : -1;
+}
+
+static void throw_io_exception(JNIEnv* env, const char* message) {
+    jclass exception_class = (*env)->FindClass(env, "java/io/IOException");
+    if (exception_class != NULL)
+        (*env)->ThrowNew(env, exception_class, message);
+}
+
+struct progress_context {
+    JNIEnv* env;
+    jobject extractor;
+    jmethodID on_native_progress;
+};
+
+static bool call_on_native_progress(const struct extraction* x, void* arg) {
+    struct progress_context* context = arg;
+    JNIEnv* env = context->env;
+    jboolean cont = (*env)->CallBooleanMethod(env, context->extractor, context->on_native_progress,
+        (jlong) atomic_load(&x->extracted_file_count), (jlong) x->file_count,
+        (jlong) atomic_load(&x->extracted_bytes), (jlong) x->total_bytes);
+    return !(*env)->ExceptionCheck(env) && cont;
+}
+
+/*
+ * Extract the embedded bootstrap zip into the staging directory with extract_zip(), reading it
+ * directly from the blob so that it is never copied into the java heap.
+ * BootstrapExtractor.onNativeProgress() is called every progressIntervalMillis if it is > 0.
+ */
+JNIEXPORT void JNICALL Java_com_termux_app_BootstrapExtractor_extractNative(JNIEnv *env, __attribute__((__unused__)) jclass clazz,
+                                                                            jobject extractor, jstring javaStagingPath,
+                                                                            jint threadCount, jlong progressIntervalMillis)
 {
-    jbyteArray ret = (*env)->NewByteArray(env, blob_size);
-    (*env)->SetByteArrayRegion(env, ret, 0, blob_size, blob);
-    return ret;
+    jclass extractor_class = (*env)->GetObjectClass(env, extractor);
+    jmethodID on_native_progress = (*env)->GetMethodID(env, extractor_class, "onNativeProgress", "(JJJJ)Z");
+    jfieldID file_count_field = (*env)->GetFieldID(env, extractor_class, "mFileCount", "J");
+    jfieldID resumed_file_count_field = (*env)->GetFieldID(env, extractor_class, "mResumedFileCount", "J");
+    jfieldID symlink_count_field = (*env)->GetFieldID(env, extractor_class, "mSymlinkCount", "J");
+    jfieldID extracted_bytes_field = (*env)->GetFieldID(env, extractor_class, "mExtractedBytes", "J");
+    jfieldID thread_count_field = (*env)->GetFieldID(env, extractor_class, "mThreadCount", "I");
+    jfieldID elapsed_millis_field = (*env)->GetFieldID(env, extractor_class, "mElapsedMillis", "J");
+    if (on_native_progress == NULL || file_count_field == NULL || resumed_file_count_field == NULL || symlink_count_field == NULL ||
+        extracted_bytes_field == NULL || thread_count_field == NULL || elapsed_millis_field == NULL)
+        return;
+
+    long start_millis = get_monotonic_millis();
+    char message[PATH_MAX + 128];
+
+    const char* staging_path = (*env)->GetStringUTFChars(env, javaStagingPath, NULL);
+    if (staging_path == NULL) return;
+    int staging_fd = TEMP_FAILURE_RETRY(open(staging_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (staging_fd == -1) {
+        snprintf(message, sizeof(message), "Failed to open staging directory \"%s\": %s", staging_path, strerror(errno));
+        (*env)->ReleaseStringUTFChars(env, javaStagingPath, staging_path);
+        throw_io_exception(env, message);
+        return;
+    }
+    (*env)->ReleaseStringUTFChars(env, javaStagingPath, staging_path);
+
+    struct extraction x;
+    init_extraction(&x, (const uint8_t*) blob, (size_t) blob_size, (const char*) manifest, (size_t) manifest_size, staging_fd);
+    struct progress_context context = {env, extractor, on_native_progress};
+    long symlink_count = extract_zip(&x, threadCount, (long) progressIntervalMillis, call_on_native_progress, &context);
+
+    if (symlink_count >= 0) {
+        (*env)->SetLongField(env, extractor, file_count_field, (jlong) x.file_count);
+        (*env)->SetLongField(env, extractor, resumed_file_count_field, (jlong) atomic_load(&x.resumed_file_count));
+        (*env)->SetLongField(env, extractor, symlink_count_field, (jlong) symlink_count);
+        (*env)->SetLongField(env, extractor, extracted_bytes_field, (jlong) x.total_bytes);
+        (*env)->SetIntField(env, extractor, thread_count_field, x.thread_count);
+        (*env)->SetLongField(env, extractor, elapsed_millis_field, (jlong) (get_monotonic_millis() - start_millis));
+    } else if (!(*env)->ExceptionCheck(env)) {
+        if (x.error == ECANCELED)
+            snprintf(message, sizeof(message), "Extracting bootstrap zip was cancelled");
+        else
+            snprintf(message, sizeof(message), "Failed to %s \"%s\" of bootstrap zip: %s", x.error_operation,
+                     x.error_path != NULL ? x.error_path : "", strerror(x.error));
+        throw_io_exception(env, message);
+    }
+
+    destroy_extraction(&x);
+    close(staging_fd);
+}
+
+/*
+ * Whether an extraction of the embedded bootstrap zip into the staging directory was killed and
+ * can be resumed, since it has the resume id of the manifest.
+ */
+JNIEXPORT jboolean JNICALL Java_com_termux_app_BootstrapExtractor_canResumeNative(JNIEnv *env, __attribute__((__unused__)) jclass clazz,
+                                                                                jstring javaStagingPath)
+{
+    const char* staging_path = (*env)->GetStringUTFChars(env, javaStagingPath, NULL);
+    if (staging_path == NULL) return JNI_FALSE;
+    int staging_fd = TEMP_FAILURE_RETRY(open(staging_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    (*env)->ReleaseStringUTFChars(env, javaStagingPath, staging_path);
+    if (staging_fd == -1) return JNI_FALSE;
+
+    struct extraction x;
+    init_extraction(&x, (const uint8_t*) blob, (size_t) blob_size, (const char*) manifest, (size_t) manifest_size, staging_fd);
+    bool can_resume = read_manifest_entries(&x) == 0 && has_resume_id(&x);
+    destroy_extraction(&x);
+    close(staging_fd);
+    return can_resume ? JNI_TRUE : JNI_FALSE;
 }
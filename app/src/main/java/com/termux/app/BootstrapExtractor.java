@@ -0,0 +1,173 @@
+package com.termux.app;
+
+import androidx.annotation.Keep;
+import androidx.annotation.NonNull;
+import androidx.annotation.Nullable;
+
+import java.io.IOException;
+
+/**
+ * A native extractor for the bootstrap zip embedded in the termux-bootstrap library.
+ *
+ * The zip is read directly from the memory of the library, so it is never copied into the java
+ * heap. Its entries are indexed by a manifest generated by app/build.gradle and embedded next to
+ * it, with the mode, size, crc32 and offset of the data of each entry. All directories are created
+ * first, and the regular files are inflated on a pool of native threads and written relative to
+ * the staging directory fd, with the modes from the manifest. The symlinks listed in its
+ * SYMLINKS.txt are created on the calling thread while the files are extracted.
+ *
+ * The id of the manifest is kept in the staging directory until the extraction has finished. If
+ * the app is killed during an extraction, then {@link #canResume(String)} returns {@code true} and
+ * the next extraction resumes it, only extracting the files whose size, mode or crc32 differ from
+ * the manifest. The crc32 only detects files left partially written, so an existing prefix is not
+ * updated this way, and a staging directory of a different manifest is extracted from scratch.
+ *
+ * Example:
+ * <pre>
+ * BootstrapExtractor extractor = new BootstrapExtractor(stagingPrefixPath)
+ *     .setProgressCallback((extractedCount, totalCount, extractedBytes, totalBytes) -> {
+ *         Logger.logVerbose(LOG_TAG, "Extracted " + extractedCount + "/" + totalCount + " files");
+ *         return true;
+ *     }, 1000);
+ * extractor.extract();
+ * </pre>
+ */
+final class BootstrapExtractor {
+
+    private final String mStagingPath;
+    private int mRequestedThreadCount;
+    private ProgressCallback mProgressCallback;
+    private long mProgressIntervalMillis;
+
+    /* The results of the last extraction, set by native. */
+    @Keep
+    private long mFileCount;
+    @Keep
+    private long mResumedFileCount;
+    @Keep
+    private long mSymlinkCount;
+    @Keep
+    private long mExtractedBytes;
+    @Keep
+    private int mThreadCount;
+    @Keep
+    private long mElapsedMillis;
+
+    /** The callback for the progress of the extraction. */
+    interface ProgressCallback {
+        /**
+         * Called periodically on the thread that called {@link #extract()}.
+         *
+         * @param extractedCount The number of regular files extracted so far.
+         * @param totalCount The number of regular files in the zip.
+         * @param extractedBytes The number of bytes of regular files extracted so far.
+         * @param totalBytes The number of bytes of regular files in the zip.
+         * @return Returns {@code true} to continue the extraction, otherwise {@code false} to cancel it.
+         */
+        boolean onProgress(long extractedCount, long totalCount, long extractedBytes, long totalBytes);
+    }
+
+    /**
+     * Create an new instance of {@link BootstrapExtractor}.
+     *
+     * @param stagingPath The {@code path} of the existing directory to extract to, which must be empty unless
+     *                    {@link #canResume(String)} returns {@code true} for it.
+     */
+    BootstrapExtractor(@NonNull String stagingPath) {
+        mStagingPath = stagingPath;
+    }
+
+    /** Set the number of threads to extract with. Defaults to 0 for the number of processors. */
+    BootstrapExtractor setThreadCount(int threadCount) {
+        mRequestedThreadCount = threadCount;
+        return this;
+    }
+
+    /** Set the {@link ProgressCallback} to call every {@code intervalMillis}. */
+    BootstrapExtractor setProgressCallback(@Nullable ProgressCallback progressCallback, long intervalMillis) {
+        mProgressCallback = progressCallback;
+        mProgressIntervalMillis = intervalMillis;
+        return this;
+    }
+
+    /**
+     * Extract the bootstrap zip to the staging directory.
+     *
+     * @throws IOException If the zip is invalid, any file could not be extracted or the
+     * extraction was cancelled.
+     */
+    void extract() throws IOException {
+        mFileCount = 0;
+        mResumedFileCount = 0;
+        mSymlinkCount = 0;
+        mExtractedBytes = 0;
+        mThreadCount = 0;
+        mElapsedMillis = 0;
+
+        // Only load the shared library when necessary to save memory usage.
+        System.loadLibrary("termux-bootstrap");
+        extractNative(this, mStagingPath, mRequestedThreadCount, mProgressCallback != null ? mProgressIntervalMillis : 0);
+    }
+
+    /** Get the number of regular files extracted by the last extraction. */
+    long getFileCount() {
+        return mFileCount;
+    }
+
+    /**
+     * Get the number of regular files of the last extraction that were kept since they were
+     * already extracted by the killed extraction it resumed.
+     */
+    long getResumedFileCount() {
+        return mResumedFileCount;
+    }
+
+    /** Get the number of symlinks created by the last extraction. */
+    long getSymlinkCount() {
+        return mSymlinkCount;
+    }
+
+    /** Get the number of bytes of regular files extracted by the last extraction. */
+    long getExtractedBytes() {
+        return mExtractedBytes;
+    }
+
+    /** Get the number of threads used by the last extraction. */
+    int getThreadCount() {
+        return mThreadCount;
+    }
+
+    /** Get the time in milliseconds taken by the last extraction. */
+    long getElapsedMillis() {
+        return mElapsedMillis;
+    }
+
+    /**
+     * Check whether an extraction into the staging directory was killed and can be resumed by
+     * {@link #extract()}, instead of deleting the staging directory.
+     *
+     * @param stagingPath The {@code path} of the staging directory.
+     * @return Returns {@code true} if the staging directory has the id of the manifest of the
+     * embedded zip.
+     */
+    static boolean canResume(@NonNull String stagingPath) {
+        // Only load the shared library when necessary to save memory usage.
+        System.loadLibrary("termux-bootstrap");
+        return canResumeNative(stagingPath);
+    }
+
+    /** Called by native every progress interval. */
+    @Keep
+    @SuppressWarnings("unused")
+    private boolean onNativeProgress(long extractedCount, long totalCount, long extractedBytes, long totalBytes) {
+        return mProgressCallback == null || mProgressCallback.onProgress(extractedCount, totalCount, extractedBytes, totalBytes);
+    }
+
+
+
+    private static native void extractNative(BootstrapExtractor extractor, String stagingPath, int threadCount,
+                                             long progressIntervalMillis) throws IOException;
+
+    private static native boolean canResumeNative(String stagingPath);
+
+}
@@ -206,9 +206,9 @@ public final class TermuxActivity extends AppCompatActivity implements ServiceCo
         // Delete ReportInfo serialized object files from cache older than 14 days
         ReportActivity.deleteReportInfoFilesOlderThanXDays(this, 14, false);
 
-        // Load Termux app SharedProperties from disk
+        // Load Termux app SharedProperties from disk if they changed since they were last loaded
         mProperties = TermuxAppSharedProperties.getProperties();
-        reloadProperties();
+        reloadProperties(true);
 
         setActivityTheme();
 
@@ -445,11 +445,19 @@ public final class TermuxActivity extends AppCompatActivity implements ServiceCo
 
 
 
-    private void reloadProperties() {
-        mProperties.loadTermuxPropertiesFromDisk();
+    private void reloadProperties(boolean onlyIfChanged) {
+        if (onlyIfChanged) {
+            if (!mProperties.loadTermuxPropertiesFromDiskIfChanged())
+                return;
+        } else {
+            mProperties.loadTermuxPropertiesFromDisk();
+        }
 
         if (mTermuxTerminalViewClient != null)
             mTermuxTerminalViewClient.onReloadProperties();
+
+        if (mTermuxService != null)
+            mTermuxService.onTermuxPropertiesReloaded();
     }
 
 
@@ -986,7 +994,7 @@ public final class TermuxActivity extends AppCompatActivity implements ServiceCo
 
     private void reloadActivityStyling(boolean recreateActivity) {
         if (mProperties != null) {
-            reloadProperties();
+            reloadProperties(false);
 
             if (mExtraKeysView != null) {
                 mExtraKeysView.setButtonTextAllCaps(mProperties.shouldExtraKeysTextBeAllCaps());
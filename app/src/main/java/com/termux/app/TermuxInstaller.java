@@ -7,7 +7,6 @@ import android.content.Context;
 import android.os.Build;
 import android.os.Environment;
 // import android.system.Os;
-import android.util.Pair;
 import android.view.WindowManager;
 
 import com.termux.R;
@@ -24,15 +23,7 @@ import com.termux.shared.termux.TermuxConstants;
 import com.termux.shared.termux.TermuxUtils;
 import com.termux.shared.termux.shell.command.environment.TermuxShellEnvironment;
 
-import java.io.BufferedReader;
-import java.io.ByteArrayInputStream;
 import java.io.File;
-import java.io.FileOutputStream;
-import java.io.InputStreamReader;
-import java.util.ArrayList;
-import java.util.List;
-import java.util.zip.ZipEntry;
-import java.util.zip.ZipInputStream;
 
 import static com.termux.shared.termux.TermuxConstants.TERMUX_PREFIX_DIR;
 import static com.termux.shared.termux.TermuxConstants.TERMUX_PREFIX_DIR_PATH;
@@ -47,16 +38,18 @@ import static com.termux.shared.termux.TermuxConstants.TERMUX_STAGING_PREFIX_DIR
  * <p/>
  * (2) A progress dialog is shown with "Installing..." message and a spinner.
  * <p/>
- * (3) A staging directory, $STAGING_PREFIX, is cleared if left over from broken installation below.
+ * (3) A staging directory, $STAGING_PREFIX, is cleared if left over from broken installation below, unless the
+ * installation was killed while extracting the same bootstrap, in which case the extraction is resumed.
  * <p/>
- * (4) The zip file is loaded from a shared library.
+ * (4) The zip, containing entries relative to the $PREFIX, is read in place from the memory of the termux-bootstrap
+ * shared library by the native {@link BootstrapExtractor}:
  * <p/>
- * (5) The zip, containing entries relative to the $PREFIX, is is downloaded and extracted by a zip input stream
- * continuously encountering zip file entries:
+ * (4.1) All directories are created and the files are extracted into $STAGING_PREFIX on multiple threads, with execute
+ * permissions set if necessary.
  * <p/>
- * (5.1) If the zip entry encountered is SYMLINKS.txt, go through it and remember all symlinks to setup.
+ * (4.2) The symlinks listed in SYMLINKS.txt are created while the files are being extracted.
  * <p/>
- * (5.2) For every other zip entry, extract it into $STAGING_PREFIX and set execute permissions if necessary.
+ * (5) $STAGING_PREFIX is moved to $PREFIX.
  */
 final class TermuxInstaller {
 
@@ -124,11 +117,16 @@ final class TermuxInstaller {
 
                     Error error;
 
-                    // Delete prefix staging directory or any file at its destination
-                    error = FileUtils.deleteFile("termux prefix staging directory", TERMUX_STAGING_PREFIX_DIR_PATH, true);
-                    if (error != null) {
-                        showBootstrapErrorDialog(activity, whenDone, Error.getErrorMarkdownString(error));
-                        return;
+                    // Delete prefix staging directory or any file at its destination, unless the app was killed
+                    // while extracting the same bootstrap into it, in which case the extraction is resumed
+                    if (BootstrapExtractor.canResume(TERMUX_STAGING_PREFIX_DIR_PATH)) {
+                        Logger.logInfo(LOG_TAG, "Resuming extraction of bootstrap zip to prefix staging directory \"" + TERMUX_STAGING_PREFIX_DIR_PATH + "\".");
+                    } else {
+                        error = FileUtils.deleteFile("termux prefix staging directory", TERMUX_STAGING_PREFIX_DIR_PATH, true);
+                        if (error != null) {
+                            showBootstrapErrorDialog(activity, whenDone, Error.getErrorMarkdownString(error));
+                            return;
+                        }
                     }
 
                     // Delete prefix directory or any file at its destination
@@ -154,62 +152,18 @@ final class TermuxInstaller {
 
                     Logger.logInfo(LOG_TAG, "Extracting bootstrap zip to prefix staging directory \"" + TERMUX_STAGING_PREFIX_DIR_PATH + "\".");
 
-                    final byte[] buffer = new byte[8096];
-                    final List<Pair<String, String>> symlinks = new ArrayList<>(50);
-
-                    final byte[] zipBytes = loadZipBytes();
-                    try (ZipInputStream zipInput = new ZipInputStream(new ByteArrayInputStream(zipBytes))) {
-                        ZipEntry zipEntry;
-                        while ((zipEntry = zipInput.getNextEntry()) != null) {
-                            if (zipEntry.getName().equals("SYMLINKS.txt")) {
-                                BufferedReader symlinksReader = new BufferedReader(new InputStreamReader(zipInput));
-                                String line;
-                                while ((line = symlinksReader.readLine()) != null) {
-                                    String[] parts = line.split("←");
-                                    if (parts.length != 2)
-                                        throw new RuntimeException("Malformed symlink line: " + line);
-                                    String oldPath = parts[0];
-                                    String newPath = TERMUX_STAGING_PREFIX_DIR_PATH + "/" + parts[1];
-                                    symlinks.add(Pair.create(oldPath, newPath));
-
-                                    error = ensureDirectoryExists(new File(newPath).getParentFile());
-                                    if (error != null) {
-                                        showBootstrapErrorDialog(activity, whenDone, Error.getErrorMarkdownString(error));
-                                        return;
-                                    }
-                                }
-                            } else {
-                                String zipEntryName = zipEntry.getName();
-                                File targetFile = new File(TERMUX_STAGING_PREFIX_DIR_PATH, zipEntryName);
-                                boolean isDirectory = zipEntry.isDirectory();
-
-                                error = ensureDirectoryExists(isDirectory ? targetFile : targetFile.getParentFile());
-                                if (error != null) {
-                                    showBootstrapErrorDialog(activity, whenDone, Error.getErrorMarkdownString(error));
-                                    return;
-                                }
-
-                                if (!isDirectory) {
-                                    try (FileOutputStream outStream = new FileOutputStream(targetFile)) {
-                                        int readBytes;
-                                        while ((readBytes = zipInput.read(buffer)) != -1)
-                                            outStream.write(buffer, 0, readBytes);
-                                    }
-                                    if (zipEntryName.startsWith("bin/") || zipEntryName.startsWith("libexec") ||
-                                        zipEntryName.startsWith("lib/apt/apt-helper") || zipEntryName.startsWith("lib/apt/methods")) {
-                                        //noinspection OctalInteger
-                                        Os.chmod(targetFile.getAbsolutePath(), 0700);
-                                    }
-                                }
-                            }
-                        }
-                    }
+                    BootstrapExtractor extractor = new BootstrapExtractor(TERMUX_STAGING_PREFIX_DIR_PATH)
+                        .setProgressCallback((extractedCount, totalCount, extractedBytes, totalBytes) -> {
+                            Logger.logVerbose(LOG_TAG, "Extracted " + extractedCount + "/" + totalCount + " bootstrap files (" +
+                                extractedBytes + "/" + totalBytes + " bytes).");
+                            return true;
+                        }, 1000);
+                    extractor.extract();
 
-                    if (symlinks.isEmpty())
-                        throw new RuntimeException("No SYMLINKS.txt encountered");
-                    for (Pair<String, String> symlink : symlinks) {
-                        Os.symlink(symlink.first, symlink.second);
-                    }
+                    Logger.logInfo(LOG_TAG, "Extracted " + extractor.getFileCount() + " files (" + extractor.getResumedFileCount() +
+                        " resumed) and " + extractor.getSymlinkCount() +
+                        " symlinks (" + extractor.getExtractedBytes() + " bytes) with " + extractor.getThreadCount() +
+                        " threads in " + extractor.getElapsedMillis() + "ms.");
 
                     Logger.logInfo(LOG_TAG, "Moving termux prefix staging to prefix directory.");
 
@@ -372,16 +326,4 @@ final class TermuxInstaller {
         }.start();
     }
 
-    private static Error ensureDirectoryExists(File directory) {
-        return FileUtils.createDirectoryFile(directory.getAbsolutePath());
-    }
-
-    public static byte[] loadZipBytes() {
-        // Only load the shared library when necessary to save memory usage.
-        System.loadLibrary("termux-bootstrap");
-        return getZip();
-    }
-
-    public static native byte[] getZip();
-
 }
@@ -20,6 +20,7 @@ import androidx.annotation.Nullable;
 
 import com.termux.R;
 import com.termux.app.event.SystemEventReceiver;
+import com.termux.app.terminal.TermuxSessionPool;
 import com.termux.app.terminal.TermuxTerminalSessionActivityClient;
 import com.termux.app.terminal.TermuxTerminalSessionServiceClient;
 import com.termux.shared.termux.plugins.TermuxPluginUtils;
@@ -28,6 +29,7 @@ import com.termux.shared.net.uri.UriUtils;
 import com.termux.shared.errors.Errno;
 import com.termux.shared.shell.ShellUtils;
 import com.termux.shared.shell.command.runner.app.AppShell;
+import com.termux.shared.shell.command.runner.app.AppShellScheduler;
 import com.termux.shared.termux.settings.properties.TermuxAppSharedProperties;
 import com.termux.shared.termux.shell.command.environment.TermuxShellEnvironment;
 import com.termux.shared.termux.shell.TermuxShellUtils;
@@ -88,6 +90,12 @@ public final class TermuxService extends Service implements AppShell.AppShellCli
      */
     private final TermuxTerminalSessionServiceClient mTermuxTerminalSessionServiceClient = new TermuxTerminalSessionServiceClient(this);
 
+    /**
+     * The {@link TermuxSessionPool} of sessions whose shell has already been started, that are
+     * added by {@link #createTermuxSessionFromPool(String, String)}.
+     */
+    private final TermuxSessionPool mTermuxSessionPool = new TermuxSessionPool(this);
+
     /**
      * Termux app shared properties manager, loaded from termux.properties
      */
@@ -98,6 +106,18 @@ public final class TermuxService extends Service implements AppShell.AppShellCli
      */
     private TermuxShellManager mShellManager;
 
+    /**
+     * The {@link AppShellScheduler} that limits how many background {@link Runner#APP_SHELL}
+     * commands of the {@link TERMUX_SERVICE#ACTION_SERVICE_EXECUTE} intent run in parallel.
+     */
+    private AppShellScheduler mAppShellScheduler;
+
+    /**
+     * Starts the queued commands of {@link #mAppShellScheduler} in the slots released by long
+     * running commands, see {@link AppShellScheduler#checkLongRunningJobs()}.
+     */
+    private final Runnable mCheckLongRunningTermuxTasksRunnable = this::checkLongRunningTermuxTasks;
+
     /** The wake lock and wifi lock are always acquired and released together. */
     private PowerManager.WakeLock mWakeLock;
     private WifiManager.WifiLock mWifiLock;
@@ -117,6 +137,8 @@ public final class TermuxService extends Service implements AppShell.AppShellCli
 
         mShellManager = TermuxShellManager.getShellManager();
 
+        mAppShellScheduler = new AppShellScheduler(mProperties.getBackgroundCommandsMaxParallelism());
+
         runStartForeground();
 
         SystemEventReceiver.registerPackageUpdateEvents(this);
@@ -182,6 +204,18 @@ public final class TermuxService extends Service implements AppShell.AppShellCli
         runStopForeground();
     }
 
+    @Override
+    public void onTrimMemory(int level) {
+        super.onTrimMemory(level);
+
+        // The pooled sessions are refilled when the next session is added
+        if (level == TRIM_MEMORY_RUNNING_LOW || level == TRIM_MEMORY_RUNNING_CRITICAL || level >= TRIM_MEMORY_BACKGROUND) {
+            if (mTermuxSessionPool.size() > 0)
+                Logger.logDebug(LOG_TAG, "Killing " + mTermuxSessionPool.size() + " pooled TermuxSessions on trim memory level " + level);
+            mTermuxSessionPool.clear();
+        }
+    }
+
     @Override
     public IBinder onBind(Intent intent) {
         Logger.logVerbose(LOG_TAG, "onBind");
@@ -267,10 +301,21 @@ public final class TermuxService extends Service implements AppShell.AppShellCli
             ", TermuxTasks=" + mShellManager.mTermuxTasks.size() +
             ", PendingPluginExecutionCommands=" + mShellManager.mPendingPluginExecutionCommands.size());
 
+        mTermuxSessionPool.clear();
+
         List<TermuxSession> termuxSessions = new ArrayList<>(mShellManager.mTermuxSessions);
         List<AppShell> termuxTasks = new ArrayList<>(mShellManager.mTermuxTasks);
         List<ExecutionCommand> pendingPluginExecutionCommands = new ArrayList<>(mShellManager.mPendingPluginExecutionCommands);
 
+        // Queued commands are still in the pending plugin execution commands list if they were sent
+        // by plugins, so their results are processed with them
+        mHandler.removeCallbacks(mCheckLongRunningTermuxTasksRunnable);
+        List<Object> queuedTermuxTaskCommands = mAppShellScheduler.cancelAll();
+        if (!queuedTermuxTaskCommands.isEmpty())
+            Logger.logDebug(LOG_TAG, "Cancelled " + queuedTermuxTaskCommands.size() + " queued TermuxTask commands");
+        Logger.logDebug(LOG_TAG, "TermuxTask scheduler metrics: " + mAppShellScheduler.getMetrics());
+        Logger.logDebugExtended(LOG_TAG, "Resource usage per caller:\n" + mShellManager.mResourceUsageAccounting.getLogString());
+
         for (int i = 0; i < termuxSessions.size(); i++) {
             ExecutionCommand executionCommand = termuxSessions.get(i).getExecutionCommand();
             processResult = mWantsToStop || executionCommand.isPluginExecutionCommandWithPendingResult();
@@ -388,6 +433,9 @@ public final class TermuxService extends Service implements AppShell.AppShellCli
             executionCommand.backgroundCustomLogLevel = IntentUtils.getIntegerExtraIfSet(intent, TERMUX_SERVICE.EXTRA_BACKGROUND_CUSTOM_LOG_LEVEL, null);
         }
 
+        if (Runner.APP_SHELL.equalsRunner(executionCommand.runner))
+            executionCommand.backgroundPriority = IntentUtils.getStringExtraIfSet(intent, TERMUX_SERVICE.EXTRA_BACKGROUND_PRIORITY, null);
+
         executionCommand.workingDirectory = IntentUtils.getStringExtraIfSet(intent, TERMUX_SERVICE.EXTRA_WORKDIR, null);
         executionCommand.isFailsafe = intent.getBooleanExtra(TERMUX_ACTIVITY.EXTRA_FAILSAFE_SESSION, false);
         executionCommand.sessionAction = intent.getStringExtra(TERMUX_SERVICE.EXTRA_SESSION_ACTION);
@@ -438,19 +486,51 @@ public final class TermuxService extends Service implements AppShell.AppShellCli
         if (executionCommand.shellName == null && executionCommand.executable != null)
             executionCommand.shellName = ShellUtils.getExecutableBasename(executionCommand.executable);
 
-        AppShell newTermuxTask = null;
         ShellCreateMode shellCreateMode = processShellCreateMode(executionCommand);
         if (shellCreateMode == null) return;
-        if (ShellCreateMode.NO_SHELL_WITH_NAME.equals(shellCreateMode)) {
-            newTermuxTask = getTermuxTaskForShellName(executionCommand.shellName);
-            if (newTermuxTask != null)
-                Logger.logVerbose(LOG_TAG, "Existing TermuxTask with \"" + executionCommand.shellName + "\" shell name found for shell create mode \"" + shellCreateMode.getMode() + "\"");
-            else
-                Logger.logVerbose(LOG_TAG, "No existing TermuxTask with \"" + executionCommand.shellName + "\" shell name found for shell create mode \"" + shellCreateMode.getMode() + "\"");
+
+        // Plugin commands are batch by default since they are usually sent by automation, while
+        // commands from the app itself, like from widgets and shortcuts, are interactive
+        AppShellScheduler.Priority priority = AppShellScheduler.Priority.priorityOf(executionCommand.backgroundPriority,
+            executionCommand.isPluginExecutionCommand ? AppShellScheduler.Priority.BATCH : AppShellScheduler.Priority.INTERACTIVE);
+        String caller = getExecutionCommandCaller(executionCommand);
+
+        // Reload in case the property was changed since the service was created
+        mAppShellScheduler.setMaxParallelism(mProperties.getBackgroundCommandsMaxParallelism());
+
+        boolean started = mAppShellScheduler.submit(executionCommand, priority, caller, () -> {
+            AppShell newTermuxTask = null;
+            if (ShellCreateMode.NO_SHELL_WITH_NAME.equals(shellCreateMode)) {
+                newTermuxTask = getTermuxTaskForShellName(executionCommand.shellName);
+                if (newTermuxTask != null)
+                    Logger.logVerbose(LOG_TAG, "Existing TermuxTask with \"" + executionCommand.shellName + "\" shell name found for shell create mode \"" + shellCreateMode.getMode() + "\"");
+                else
+                    Logger.logVerbose(LOG_TAG, "No existing TermuxTask with \"" + executionCommand.shellName + "\" shell name found for shell create mode \"" + shellCreateMode.getMode() + "\"");
+            }
+
+            // Free the slot if no new TermuxTask is running for the command
+            if (newTermuxTask != null || createTermuxTask(executionCommand) == null)
+                mAppShellScheduler.onJobFinished(executionCommand);
+        });
+
+        if (!started) {
+            Logger.logDebug(LOG_TAG, "Queued " + priority.getName() + " \"" + executionCommand.getCommandIdAndLabelLogString() + "\" TermuxTask command of \"" + caller + "\"");
+            scheduleLongRunningTermuxTasksCheck(mAppShellScheduler.checkLongRunningJobs());
+            updateNotification();
         }
+    }
+
+    /** Start the queued TermuxTask commands in the slots released by long running commands. */
+    private void checkLongRunningTermuxTasks() {
+        scheduleLongRunningTermuxTasksCheck(mAppShellScheduler.checkLongRunningJobs());
+        updateNotification();
+    }
 
-        if (newTermuxTask == null)
-            newTermuxTask = createTermuxTask(executionCommand);
+    /** Schedule {@link #checkLongRunningTermuxTasks()} after {@code delay}, or cancel it if {@code -1}. */
+    private void scheduleLongRunningTermuxTasksCheck(long delay) {
+        mHandler.removeCallbacks(mCheckLongRunningTermuxTasksRunnable);
+        if (delay >= 0)
+            mHandler.postDelayed(mCheckLongRunningTermuxTasksRunnable, delay);
     }
 
     /** Create a TermuxTask. */
@@ -517,6 +597,13 @@ public final class TermuxService extends Service implements AppShell.AppShellCli
                     TermuxPluginUtils.processPluginExecutionCommandResult(this, LOG_TAG, executionCommand);
 
                 mShellManager.mTermuxTasks.remove(termuxTask);
+                recordResourceUsage(executionCommand);
+
+                // Start the queued commands that were waiting for a free slot
+                if (executionCommand != null) {
+                    mAppShellScheduler.onJobFinished(executionCommand);
+                    scheduleLongRunningTermuxTasksCheck(mAppShellScheduler.checkLongRunningJobs());
+                }
             }
 
             updateNotification();
@@ -625,6 +712,44 @@ public final class TermuxService extends Service implements AppShell.AppShellCli
         return newTermuxSession;
     }
 
+    /**
+     * Add a {@link TermuxSession} from the {@link TermuxSessionPool} whose shell has already been started.
+     * Currently called by {@link TermuxTerminalSessionActivityClient#addNewSession(boolean, String)} to add a new {@link TermuxSession}.
+     *
+     * @return Returns the {@link TermuxSession}, or {@code null} if the pool is disabled or had no
+     * session for {@code workingDirectory}, in which case {@link #createTermuxSession(String, String[], String, String, boolean, String)}
+     * should be called instead.
+     */
+    @Nullable
+    public synchronized TermuxSession createTermuxSessionFromPool(String workingDirectory, String sessionName) {
+        if (workingDirectory == null) return null;
+
+        TermuxSession newTermuxSession = mTermuxSessionPool.acquire(workingDirectory, sessionName);
+        if (newTermuxSession == null) return null;
+
+        newTermuxSession.getTerminalSession().updateTerminalSessionClient(getTermuxTerminalSessionClient());
+        mShellManager.mTermuxSessions.add(newTermuxSession);
+
+        // Notify {@link TermuxSessionsListViewController} that sessions list has been updated if
+        // activity in is foreground
+        if (mTermuxTerminalSessionActivityClient != null)
+            mTermuxTerminalSessionActivityClient.termuxSessionListNotifyUpdated();
+
+        updateNotification();
+
+        TermuxActivity.updateTermuxActivityStyling(this, false);
+
+        return newTermuxSession;
+    }
+
+    /**
+     * This should be called when the termux properties have been reloaded, so that the sessions
+     * of the {@link TermuxSessionPool} are started again with the new environment.
+     */
+    public synchronized void onTermuxPropertiesReloaded() {
+        mTermuxSessionPool.invalidate("termux properties reloaded");
+    }
+
     /** Remove a TermuxSession. */
     public synchronized int removeTermuxSession(TerminalSession sessionToRemove) {
         int index = getIndexOfSession(sessionToRemove);
@@ -648,6 +773,7 @@ public final class TermuxService extends Service implements AppShell.AppShellCli
                 TermuxPluginUtils.processPluginExecutionCommandResult(this, LOG_TAG, executionCommand);
 
             mShellManager.mTermuxSessions.remove(termuxSession);
+            recordResourceUsage(executionCommand);
 
             // Notify {@link TermuxSessionsListViewController} that sessions list has been updated if
             // activity in is foreground
@@ -662,6 +788,25 @@ public final class TermuxService extends Service implements AppShell.AppShellCli
 
 
 
+    /** Get the package name of the app that sent the {@link ExecutionCommand}, or of the Termux app if unknown. */
+    @NonNull
+    private static String getExecutionCommandCaller(@NonNull ExecutionCommand executionCommand) {
+        String caller = null;
+        if (executionCommand.resultConfig.resultPendingIntent != null)
+            caller = executionCommand.resultConfig.resultPendingIntent.getCreatorPackage();
+        return caller != null ? caller : TermuxConstants.TERMUX_PACKAGE_NAME;
+    }
+
+    /** Add the resource usage of the finished {@link ExecutionCommand} to the totals of its caller. */
+    private void recordResourceUsage(@Nullable ExecutionCommand executionCommand) {
+        if (executionCommand == null || executionCommand.resultData.resourceUsage == null) return;
+
+        String caller = getExecutionCommandCaller(executionCommand);
+        mShellManager.mResourceUsageAccounting.add(caller, executionCommand.resultData.resourceUsage);
+        Logger.logVerbose(LOG_TAG, "The \"" + executionCommand.getCommandIdAndLabelLogString() + "\" command of \"" + caller +
+            "\" used " + executionCommand.resultData.resourceUsage + ", totals: " + mShellManager.mResourceUsageAccounting.get(caller));
+    }
+
     private ShellCreateMode processShellCreateMode(@NonNull ExecutionCommand executionCommand) {
         if (ShellCreateMode.ALWAYS.equalsMode(executionCommand.shellCreateMode))
             return ShellCreateMode.ALWAYS; // Default
@@ -762,6 +907,9 @@ public final class TermuxService extends Service implements AppShell.AppShellCli
 
         for (int i = 0; i < mShellManager.mTermuxSessions.size(); i++)
             mShellManager.mTermuxSessions.get(i).getTerminalSession().updateTerminalSessionClient(mTermuxTerminalSessionActivityClient);
+
+        // Start the pooled sessions now that new sessions may be added by the user
+        mTermuxSessionPool.fill();
     }
 
     /** This should be called when {@link TermuxActivity} has been destroyed and in {@link #onUnbind(Intent)}
@@ -794,6 +942,10 @@ public final class TermuxService extends Service implements AppShell.AppShellCli
         if (taskCount > 0) {
             notificationText += ", " + taskCount + " task" + (taskCount == 1 ? "" : "s");
         }
+        int queuedTaskCount = mAppShellScheduler != null ? mAppShellScheduler.getQueuedCount() : 0;
+        if (queuedTaskCount > 0) {
+            notificationText += ", " + queuedTaskCount + " queued";
+        }
 
         final boolean wakeLockHeld = mWakeLock != null;
         if (wakeLockHeld) notificationText += " (wake lock held)";
@@ -0,0 +1,266 @@
+package com.termux.app.terminal;
+
+import android.os.Handler;
+import android.os.Looper;
+
+import androidx.annotation.NonNull;
+import androidx.annotation.Nullable;
+
+import com.termux.app.TermuxService;
+import com.termux.shared.file.FileUtils;
+import com.termux.shared.logger.Logger;
+import com.termux.shared.shell.command.ExecutionCommand;
+import com.termux.shared.shell.command.ExecutionCommand.Runner;
+import com.termux.shared.termux.settings.properties.TermuxAppSharedProperties;
+import com.termux.shared.termux.shell.TermuxShellManager;
+import com.termux.shared.termux.shell.command.environment.TermuxShellEnvironment;
+import com.termux.shared.termux.shell.command.runner.terminal.TermuxSession;
+import com.termux.shared.termux.terminal.TermuxTerminalSessionClientBase;
+import com.termux.terminal.TerminalEmulator;
+import com.termux.terminal.TerminalSession;
+import com.termux.terminal.TerminalSessionClient;
+
+import java.util.ArrayList;
+import java.util.List;
+
+/**
+ * A pool of {@link TermuxSession} whose shell has already been started with the default
+ * environment, so that a new session can be added without waiting for the fork and the shell
+ * startup files. The number of sessions is defined by the
+ * {@link com.termux.shared.termux.settings.properties.TermuxPropertyConstants#KEY_TERMINAL_SESSION_POOL_SIZE}
+ * property and the pool is disabled if its {@code 0}.
+ *
+ * The pooled sessions are started in the default working directory and are only handed out for
+ * sessions requested with the same working directory, since the cwd of a started shell cannot be
+ * changed. Sessions requested for other working directories are not served from the pool, but the
+ * pool is kept for the next session in the default working directory, which is what most new
+ * sessions use. The pooled sessions are started with the size of the last session and are resized
+ * when attached to the terminal view.
+ *
+ * The pooled sessions are not in {@link TermuxShellManager#mTermuxSessions} until they are handed
+ * out, and they use this class as their {@link TerminalSessionClient} until then. The pool is
+ * refilled in the background one session at a time after a delay, so that the fork does not delay
+ * the session being shown. If pooled shells exit on their own, like due to invalid startup files,
+ * then refilling is stopped after {@link #MAX_CONSECUTIVE_FAILURES} until the pool is invalidated.
+ *
+ * All methods must be called on the main thread.
+ */
+public class TermuxSessionPool extends TermuxTerminalSessionClientBase {
+
+    /** The delay before refilling the pool after a change. */
+    private static final int FILL_DELAY_MILLIS = 1000;
+
+    /** The number of pooled shells that may exit on their own in a row before refilling is stopped. */
+    private static final int MAX_CONSECUTIVE_FAILURES = 3;
+
+    private static final int DEFAULT_COLUMNS = 80;
+    private static final int DEFAULT_ROWS = 24;
+
+    private final TermuxService mService;
+
+    private final Handler mHandler = new Handler(Looper.getMainLooper());
+
+    private final List<TermuxSession> mTermuxSessions = new ArrayList<>();
+
+    /** The pool size, working directory and transcript rows that the pooled sessions were started for. */
+    private int mSize;
+    private String mWorkingDirectory;
+    private int mTranscriptRows;
+
+    private int mConsecutiveFailures;
+
+    private final Runnable mFillRunnable = this::fillOne;
+
+    private static final String LOG_TAG = "TermuxSessionPool";
+
+    public TermuxSessionPool(@NonNull TermuxService service) {
+        this.mService = service;
+    }
+
+    /**
+     * Start filling the pool in the background if it is enabled and not full.
+     */
+    public void fill() {
+        updateConfig();
+        scheduleFill();
+    }
+
+    /**
+     * Get a pooled {@link TermuxSession} to be added as a new session.
+     *
+     * The caller must add it to {@link TermuxShellManager#mTermuxSessions}.
+     *
+     * @param workingDirectory The working directory of the new session.
+     * @param sessionName The optional name of the new session.
+     * @return Returns the {@link TermuxSession} if one was available for {@code workingDirectory},
+     * otherwise {@code null}, in which case the caller should create a new session itself. The
+     * pool is left untouched if {@code workingDirectory} is not the default working directory.
+     */
+    @Nullable
+    public TermuxSession acquire(@NonNull String workingDirectory, @Nullable String sessionName) {
+        updateConfig();
+        if (mSize == 0) return null;
+
+        if (!FileUtils.getCanonicalPath(workingDirectory, null).equals(mWorkingDirectory)) {
+            Logger.logDebug(LOG_TAG, "Not using pooled TermuxSession for \"" + workingDirectory + "\" working directory since pool is for \"" + mWorkingDirectory + "\"");
+            return null;
+        }
+
+        TermuxSession termuxSession = null;
+        while (!mTermuxSessions.isEmpty()) {
+            TermuxSession pooledTermuxSession = mTermuxSessions.remove(0);
+            if (pooledTermuxSession.getTerminalSession().isRunning()) {
+                termuxSession = pooledTermuxSession;
+                break;
+            }
+        }
+
+        scheduleFill();
+
+        if (termuxSession == null) {
+            Logger.logDebug(LOG_TAG, "No pooled TermuxSession available for \"" + workingDirectory + "\" working directory");
+            return null;
+        }
+
+        mConsecutiveFailures = 0;
+
+        ExecutionCommand executionCommand = termuxSession.getExecutionCommand();
+        executionCommand.shellName = sessionName;
+        termuxSession.getTerminalSession().mSessionName = sessionName;
+        // Do not count the time the shell was idle in the pool as its run time
+        termuxSession.getTerminalSession().resetRunTimeStart();
+
+        Logger.logDebug(LOG_TAG, "Handing out pooled \"" + executionCommand.getCommandIdAndLabelLogString() + "\" TermuxSession");
+        return termuxSession;
+    }
+
+    /**
+     * Kill the pooled sessions and refill the pool, like after the termux properties or anything
+     * else that affects the environment of new sessions has changed.
+     */
+    public void invalidate(@NonNull String reason) {
+        if (!mTermuxSessions.isEmpty())
+            Logger.logDebug(LOG_TAG, "Invalidating " + mTermuxSessions.size() + " pooled TermuxSessions: " + reason);
+        killAll();
+        mConsecutiveFailures = 0;
+        fill();
+    }
+
+    /** Kill the pooled sessions without refilling the pool, like when the service is stopping. */
+    public void clear() {
+        mHandler.removeCallbacks(mFillRunnable);
+        killAll();
+    }
+
+    /** Get the number of pooled sessions. */
+    public int size() {
+        return mTermuxSessions.size();
+    }
+
+
+
+    /** Load the pool config from the termux properties and kill the pooled sessions if it has changed. */
+    private void updateConfig() {
+        TermuxAppSharedProperties properties = TermuxAppSharedProperties.getProperties();
+        if (properties == null) return;
+
+        int size = properties.getTerminalSessionPoolSize();
+        int transcriptRows = properties.getTerminalTranscriptRows();
+        String workingDirectory = FileUtils.getCanonicalPath(properties.getDefaultWorkingDirectory(), null);
+
+        if (size == mSize && transcriptRows == mTranscriptRows && workingDirectory.equals(mWorkingDirectory))
+            return;
+
+        if (!mTermuxSessions.isEmpty())
+            Logger.logDebug(LOG_TAG, "Killing " + mTermuxSessions.size() + " pooled TermuxSessions since pool config changed");
+        killAll();
+        mConsecutiveFailures = 0;
+
+        mSize = size;
+        mWorkingDirectory = workingDirectory;
+        mTranscriptRows = transcriptRows;
+    }
+
+    private void scheduleFill() {
+        mHandler.removeCallbacks(mFillRunnable);
+        if (mTermuxSessions.size() < mSize && mConsecutiveFailures < MAX_CONSECUTIVE_FAILURES && !mService.wantsToStop())
+            mHandler.postDelayed(mFillRunnable, FILL_DELAY_MILLIS);
+    }
+
+    /** Start one pooled session and schedule the next one if the pool is still not full. */
+    private void fillOne() {
+        if (mTermuxSessions.size() >= mSize || mConsecutiveFailures >= MAX_CONSECUTIVE_FAILURES || mService.wantsToStop())
+            return;
+
+        ExecutionCommand executionCommand = new ExecutionCommand(TermuxShellManager.getNextShellId(),
+            null, null, null, mWorkingDirectory, Runner.TERMINAL_SESSION.getName(), false);
+        executionCommand.setShellCommandShellEnvironment = true;
+        executionCommand.terminalTranscriptRows = mTranscriptRows;
+
+        TermuxSession termuxSession = TermuxSession.execute(mService, executionCommand, this,
+            mService, new TermuxShellEnvironment(), null, false);
+        if (termuxSession == null) {
+            Logger.logError(LOG_TAG, "Failed to start pooled TermuxSession for:\n" + executionCommand.getCommandIdAndLabelLogString());
+            mConsecutiveFailures++;
+            scheduleFill();
+            return;
+        }
+
+        // Add before starting the shell so that setTerminalShellPid() finds the session
+        mTermuxSessions.add(termuxSession);
+
+        int columns = DEFAULT_COLUMNS;
+        int rows = DEFAULT_ROWS;
+        TermuxSession lastTermuxSession = mService.getLastTermuxSession();
+        TerminalEmulator emulator = lastTermuxSession != null ? lastTermuxSession.getTerminalSession().getEmulator() : null;
+        if (emulator != null) {
+            columns = emulator.mColumns;
+            rows = emulator.mRows;
+        }
+
+        Logger.logVerbose(LOG_TAG, "Starting pooled \"" + executionCommand.getCommandIdAndLabelLogString() + "\" TermuxSession with " + columns + "x" + rows + " size");
+        termuxSession.getTerminalSession().updateSize(columns, rows);
+
+        scheduleFill();
+    }
+
+    private void killAll() {
+        List<TermuxSession> termuxSessions = new ArrayList<>(mTermuxSessions);
+        mTermuxSessions.clear();
+        for (TermuxSession termuxSession : termuxSessions)
+            termuxSession.killIfExecuting(mService, false);
+    }
+
+    @Nullable
+    private TermuxSession getTermuxSessionForTerminalSession(@NonNull TerminalSession terminalSession) {
+        for (TermuxSession termuxSession : mTermuxSessions) {
+            if (termuxSession.getTerminalSession().equals(terminalSession))
+                return termuxSession;
+        }
+        return null;
+    }
+
+
+
+    @Override
+    public void onSessionFinished(@NonNull TerminalSession finishedSession) {
+        // Sessions killed by the pool have already been removed
+        TermuxSession termuxSession = getTermuxSessionForTerminalSession(finishedSession);
+        if (termuxSession == null) return;
+
+        mTermuxSessions.remove(termuxSession);
+        mConsecutiveFailures++;
+        Logger.logError(LOG_TAG, "The pooled \"" + termuxSession.getExecutionCommand().getCommandIdAndLabelLogString() +
+            "\" TermuxSession exited with code " + finishedSession.getExitStatus() + " before being used" +
+            (mConsecutiveFailures >= MAX_CONSECUTIVE_FAILURES ? ", not refilling pool until it is invalidated" : ""));
+        scheduleFill();
+    }
+
+    @Override
+    public void setTerminalShellPid(@NonNull TerminalSession terminalSession, int pid) {
+        TermuxSession termuxSession = getTermuxSessionForTerminalSession(terminalSession);
+        if (termuxSession != null)
+            termuxSession.getExecutionCommand().mPid = pid;
+    }
+
+}
@@ -17,6 +17,7 @@ import androidx.annotation.NonNull;
 import androidx.annotation.Nullable;
 
 import com.termux.R;
+import com.termux.shared.file.filesystem.FileChangeWatcher;
 import com.termux.shared.interact.ShareUtils;
 import com.termux.shared.termux.shell.command.runner.terminal.TermuxSession;
 import com.termux.shared.termux.interact.TextInputDialogUtils;
@@ -48,6 +49,13 @@ public class TermuxTerminalSessionActivityClient extends TermuxTerminalSessionCl
 
     private int mBellSoundId;
 
+    /** The typeface loaded from the font file by {@link #checkForFontAndColors(boolean)}. */
+    private static Typeface sTypeface;
+    /** Whether the colors or font files changed since they were last loaded. */
+    private static volatile boolean sFontAndColorsChanged = true;
+    /** Whether the colors and font files are being watched by {@link FileChangeWatcher}. */
+    private static Boolean sWatchingFontAndColors;
+
     private static final String LOG_TAG = "TermuxTerminalSessionActivityClient";
 
     public TermuxTerminalSessionActivityClient(TermuxActivity activity) {
@@ -58,8 +66,8 @@ public class TermuxTerminalSessionActivityClient extends TermuxTerminalSessionCl
      * Should be called when mActivity.onCreate() is called
      */
     public void onCreate() {
-        // Set terminal fonts and colors
-        checkForFontAndColors();
+        // Set terminal fonts and colors, which are only reloaded if their files changed
+        checkForFontAndColors(false);
     }
 
     /**
@@ -378,7 +386,12 @@ public class TermuxTerminalSessionActivityClient extends TermuxTerminalSessionCl
                 workingDirectory = currentSession.getCwd();
             }
 
-            TermuxSession newTermuxSession = service.createTermuxSession(null, null, null, workingDirectory, isFailSafe, sessionName);
+            // Use a session whose shell has already been started if available
+            TermuxSession newTermuxSession = null;
+            if (!isFailSafe)
+                newTermuxSession = service.createTermuxSessionFromPool(workingDirectory, sessionName);
+            if (newTermuxSession == null)
+                newTermuxSession = service.createTermuxSession(null, null, null, workingDirectory, isFailSafe, sessionName);
             if (newTermuxSession == null) return;
 
             TerminalSession newTerminalSession = newTermuxSession.getTerminalSession();
@@ -492,31 +505,62 @@ public class TermuxTerminalSessionActivityClient extends TermuxTerminalSessionCl
 
 
     public void checkForFontAndColors() {
-        try {
-            File colorsFile = TermuxConstants.TERMUX_COLOR_PROPERTIES_FILE;
-            File fontFile = TermuxConstants.TERMUX_FONT_FILE;
+        checkForFontAndColors(true);
+    }
 
-            final Properties props = new Properties();
-            if (colorsFile.isFile()) {
-                try (InputStream in = new FileInputStream(colorsFile)) {
-                    props.load(in);
+    /**
+     * Load the colors and font files and set them for the terminal.
+     *
+     * @param forceReload If {@code false}, then the files are only reloaded if they changed since
+     *                    they were last loaded, otherwise the loaded colors and font are set again.
+     */
+    public void checkForFontAndColors(boolean forceReload) {
+        try {
+            if (forceReload || haveFontAndColorsChanged()) {
+                // Reset before reading so that changes while reading are not lost
+                sFontAndColorsChanged = false;
+
+                File colorsFile = TermuxConstants.TERMUX_COLOR_PROPERTIES_FILE;
+                File fontFile = TermuxConstants.TERMUX_FONT_FILE;
+
+                final Properties props = new Properties();
+                if (colorsFile.isFile()) {
+                    try (InputStream in = new FileInputStream(colorsFile)) {
+                        props.load(in);
+                    }
                 }
+
+                TerminalColors.COLOR_SCHEME.updateWith(props);
+                sTypeface = (fontFile.exists() && fontFile.length() > 0) ? Typeface.createFromFile(fontFile) : Typeface.MONOSPACE;
             }
 
-            TerminalColors.COLOR_SCHEME.updateWith(props);
             TerminalSession session = mActivity.getCurrentSession();
             if (session != null && session.getEmulator() != null) {
                 session.getEmulator().mColors.reset();
             }
             updateBackgroundColor();
 
-            final Typeface newTypeface = (fontFile.exists() && fontFile.length() > 0) ? Typeface.createFromFile(fontFile) : Typeface.MONOSPACE;
-            mActivity.getTerminalView().setTypeface(newTypeface);
+            mActivity.getTerminalView().setTypeface(sTypeface);
         } catch (Exception e) {
             Logger.logStackTraceWithMessage(LOG_TAG, "Error in checkForFontAndColors()", e);
         }
     }
 
+    /**
+     * Whether the colors or font files may have changed since they were last loaded. This is
+     * always {@code true} if they cannot be watched.
+     */
+    private static synchronized boolean haveFontAndColorsChanged() {
+        if (sWatchingFontAndColors == null) {
+            FileChangeWatcher watcher = FileChangeWatcher.getInstance();
+            FileChangeWatcher.Listener listener = path -> sFontAndColorsChanged = true;
+            sWatchingFontAndColors = watcher.addListener(TermuxConstants.TERMUX_COLOR_PROPERTIES_FILE_PATH, listener) &&
+                watcher.addListener(TermuxConstants.TERMUX_FONT_FILE_PATH, listener);
+        }
+
+        return sFontAndColorsChanged || sTypeface == null || !sWatchingFontAndColors || !FileChangeWatcher.getInstance().isWatching();
+    }
+
     public void updateBackgroundColor() {
         if (!mActivity.isVisible()) return;
         TerminalSession session = mActivity.getCurrentSession();
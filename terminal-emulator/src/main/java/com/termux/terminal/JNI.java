@@ -31,9 +31,14 @@ final class JNI {
     /**
      * Causes the calling thread to wait for the process associated with the receiver to finish executing.
      *
+     * @param processId The process ID of the process to wait for.
+     * @param resourceUsage An optional array of at least 5 elements to which the resource usage of the
+     *                      process will be written: user CPU time in microseconds, system CPU time in
+     *                      microseconds, max RSS in KiB, voluntary context switches and involuntary
+     *                      context switches.
      * @return if >= 0, the exit status of the process. If < 0, the signal causing the process to stop negated.
      */
-    public static native int waitFor(int processId);
+    public static native int waitFor(int processId, long[] resourceUsage);
 
     /** Close a file descriptor through the close(2) system call. */
     public static native void close(int fileDescriptor);
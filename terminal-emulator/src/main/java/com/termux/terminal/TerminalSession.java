@@ -3,6 +3,7 @@ package com.termux.terminal;
 import android.annotation.SuppressLint;
 import android.os.Handler;
 import android.os.Message;
+import android.os.SystemClock;
 import android.system.ErrnoException;
 import android.system.Os;
 import android.system.OsConstants;
@@ -59,6 +60,16 @@ public final class TerminalSession extends TerminalOutput {
     /** The exit status of the shell process. Only valid if ${@link #mShellPid} is -1. */
     int mShellExitStatus;
 
+    /** The resource usage of the shell process, in the format of {@link JNI#waitFor(int, long[])}. Only valid if ${@link #mShellPid} is -1. */
+    private final long[] mShellResourceUsage = new long[5];
+    /**
+     * The {@link SystemClock#elapsedRealtime()} when the shell process was started, or when it was
+     * handed out if it was pre-started, see {@link #resetRunTimeStart()}.
+     */
+    private long mShellStartTime;
+    /** The time in milliseconds the shell process ran for. Only valid if ${@link #mShellPid} is -1. */
+    private long mShellRunTime;
+
     /**
      * The file descriptor referencing the master half of a pseudo-terminal pair, resulting from calling
      * {@link JNI#createSubprocess(String, String, String[], String[], int[], int, int)}.
@@ -126,6 +137,9 @@ public final class TerminalSession extends TerminalOutput {
         int[] processId = new int[1];
         mTerminalFileDescriptor = JNI.createSubprocess(mShellPath, mCwd, mArgs, mEnv, processId, rows, columns);
         mShellPid = processId[0];
+        synchronized (this) {
+            mShellStartTime = SystemClock.elapsedRealtime();
+        }
         mClient.setTerminalShellPid(this, mShellPid);
 
         final FileDescriptor terminalFileDescriptorWrapped = wrapFileDescriptor(mTerminalFileDescriptor, mClient);
@@ -166,7 +180,12 @@ public final class TerminalSession extends TerminalOutput {
         new Thread("TermSessionWaiter[pid=" + mShellPid + "]") {
             @Override
             public void run() {
-                int processExitCode = JNI.waitFor(mShellPid);
+                long[] resourceUsage = new long[5];
+                int processExitCode = JNI.waitFor(mShellPid, resourceUsage);
+                synchronized (TerminalSession.this) {
+                    System.arraycopy(resourceUsage, 0, mShellResourceUsage, 0, resourceUsage.length);
+                    mShellRunTime = SystemClock.elapsedRealtime() - mShellStartTime;
+                }
                 mMainThreadHandler.sendMessage(mMainThreadHandler.obtainMessage(MSG_PROCESS_EXITED, processExitCode));
             }
         }.start();
@@ -269,6 +288,28 @@ public final class TerminalSession extends TerminalOutput {
         return mShellExitStatus;
     }
 
+    /**
+     * Get the resource usage of the shell process in the format of {@link JNI#waitFor(int, long[])}.
+     * Only valid if not {@link #isRunning()}.
+     */
+    public synchronized long[] getResourceUsage() {
+        return mShellResourceUsage.clone();
+    }
+
+    /** Get the time in milliseconds the shell process ran for. Only valid if not {@link #isRunning()}. */
+    public synchronized long getRunTime() {
+        return mShellRunTime;
+    }
+
+    /**
+     * Start measuring {@link #getRunTime()} from now instead of from when the shell process was
+     * started, like when a pre-started session is handed out, so that its idle time is not counted.
+     */
+    public synchronized void resetRunTimeStart() {
+        if (mShellPid > 0)
+            mShellStartTime = SystemClock.elapsedRealtime();
+    }
+
     @Override
     public void onCopyTextToClipboard(String text) {
         mClient.onCopyTextToClipboard(this, text);
@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/ioctl.h>
+#include <sys/resource.h>
 #include <sys/wait.h>
 #include <termios.h>
 #include <unistd.h>
@@ -194,10 +195,23 @@ JNIEXPORT void JNICALL Java_com_termux_terminal_JNI_setPtyUTF8Mode(JNIEnv* TERMU
     }
 }
 
-JNIEXPORT jint JNICALL Java_com_termux_terminal_JNI_waitFor(JNIEnv* TERMUX_UNUSED(env), jclass TERMUX_UNUSED(clazz), jint pid)
+JNIEXPORT jint JNICALL Java_com_termux_terminal_JNI_waitFor(JNIEnv* env, jclass TERMUX_UNUSED(clazz), jint pid, jlongArray resourceUsage)
 {
     int status;
-    waitpid(pid, &status, 0);
+    struct rusage usage;
+    memset(&usage, 0, sizeof(usage));
+    wait4(pid, &status, 0, &usage);
+
+    if (resourceUsage != NULL && (*env)->GetArrayLength(env, resourceUsage) >= 5) {
+        jlong fields[5];
+        fields[0] = (jlong) usage.ru_utime.tv_sec * 1000000 + usage.ru_utime.tv_usec;
+        fields[1] = (jlong) usage.ru_stime.tv_sec * 1000000 + usage.ru_stime.tv_usec;
+        fields[2] = usage.ru_maxrss;
+        fields[3] = usage.ru_nvcsw;
+        fields[4] = usage.ru_nivcsw;
+        (*env)->SetLongArrayRegion(env, resourceUsage, 0, 5, fields);
+    }
+
     if (WIFEXITED(status)) {
         return WEXITSTATUS(status);
     } else if (WIFSIGNALED(status)) {
@@ -0,0 +1,29 @@
+#ifndef HOST_ANDROID_LOG_H
+#define HOST_ANDROID_LOG_H
+
+/*
+ * A stub for the NDK <android/log.h> header so that the termux-shared natives can be built on a
+ * Linux host. Messages are written to stderr instead of logcat.
+ */
+
+#include <stdio.h>
+
+typedef enum android_LogPriority {
+    ANDROID_LOG_UNKNOWN = 0,
+    ANDROID_LOG_DEFAULT,
+    ANDROID_LOG_VERBOSE,
+    ANDROID_LOG_DEBUG,
+    ANDROID_LOG_INFO,
+    ANDROID_LOG_WARN,
+    ANDROID_LOG_ERROR,
+    ANDROID_LOG_FATAL,
+    ANDROID_LOG_SILENT,
+} android_LogPriority;
+
+static inline int __android_log_write(int prio, const char *tag, const char *text) {
+    if (prio < ANDROID_LOG_WARN)
+        return 0;
+    return fprintf(stderr, "%s: %s\n", tag, text);
+}
+
+#endif // HOST_ANDROID_LOG_H
@@ -0,0 +1,324 @@
+#include "host_jni_env.h"
+
+#include <cstdarg>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+namespace host_jni {
+
+struct Class;
+
+/* The base of all objects created by the host JNIEnv. */
+struct Object {
+    Class *clazz = nullptr;
+    virtual ~Object() = default;
+};
+
+struct Class : Object {
+    string name;
+};
+
+struct String : Object {
+    string value;
+};
+
+struct ByteArray : Object {
+    vector<jbyte> data;
+};
+
+struct ObjectArray : Object {
+    vector<Object *> elements;
+};
+
+/* An instance of a class whose fields are stored by name. */
+struct Instance : Object {
+    map<string, jlong> primitiveFields;
+    map<string, Object *> objectFields;
+};
+
+/* The interned id of a field or method. */
+struct MemberId {
+    string className;
+    string name;
+    string signature;
+};
+
+static mutex intern_lock;
+static map<string, unique_ptr<Class>> classes;
+static map<string, unique_ptr<MemberId>> member_ids;
+
+static thread_local vector<Object *> local_refs;
+
+static Class *find_class(const string &name) {
+    lock_guard<mutex> guard(intern_lock);
+    unique_ptr<Class> &clazz = classes[name];
+    if (!clazz) {
+        clazz.reset(new Class());
+        clazz->name = name;
+    }
+    return clazz.get();
+}
+
+static MemberId *get_member_id(Class *clazz, const char *name, const char *signature) {
+    string key = clazz->name + "." + name + signature;
+    lock_guard<mutex> guard(intern_lock);
+    unique_ptr<MemberId> &id = member_ids[key];
+    if (!id) {
+        id.reset(new MemberId());
+        id->className = clazz->name;
+        id->name = name;
+        id->signature = signature;
+    }
+    return id.get();
+}
+
+template <typename T>
+static T *new_local(Class *clazz) {
+    T *obj = new T();
+    obj->clazz = clazz;
+    local_refs.push_back(obj);
+    return obj;
+}
+
+static Object *to_object(jobject obj) {
+    return reinterpret_cast<Object *>(obj);
+}
+
+static jobject to_jobject(Object *obj) {
+    return reinterpret_cast<jobject>(obj);
+}
+
+static String *new_local_string(const string &value) {
+    String *str = new_local<String>(find_class("java/lang/String"));
+    str->value = value;
+    return str;
+}
+
+
+
+static jclass FindClass(JNIEnv *, const char *name) {
+    return reinterpret_cast<jclass>(find_class(name));
+}
+
+static jclass GetObjectClass(JNIEnv *, jobject obj) {
+    return reinterpret_cast<jclass>(to_object(obj)->clazz);
+}
+
+static jmethodID GetMethodID(JNIEnv *, jclass clazz, const char *name, const char *signature) {
+    return reinterpret_cast<jmethodID>(get_member_id(reinterpret_cast<Class *>(clazz), name, signature));
+}
+
+static jfieldID GetFieldID(JNIEnv *, jclass clazz, const char *name, const char *signature) {
+    return reinterpret_cast<jfieldID>(get_member_id(reinterpret_cast<Class *>(clazz), name, signature));
+}
+
+static jobject NewObjectV(JNIEnv *, jclass clazz, jmethodID methodID, va_list args) {
+    Class *cls = reinterpret_cast<Class *>(clazz);
+    MemberId *method = reinterpret_cast<MemberId *>(methodID);
+
+    Instance *instance = new_local<Instance>(cls);
+    if (cls->name == "com/termux/shared/jni/models/JniResult" && method->signature == "(IILjava/lang/String;I)V") {
+        instance->primitiveFields["retval"] = va_arg(args, jint);
+        instance->primitiveFields["errno"] = va_arg(args, jint);
+        instance->objectFields["errmsg"] = to_object(va_arg(args, jobject));
+        instance->primitiveFields["intData"] = va_arg(args, jint);
+    }
+
+    return to_jobject(instance);
+}
+
+static jobject CallObjectMethodV(JNIEnv *, jobject obj, jmethodID methodID, va_list) {
+    Object *object = to_object(obj);
+    MemberId *method = reinterpret_cast<MemberId *>(methodID);
+
+    if (method->name == "getBytes") {
+        ByteArray *array = new_local<ByteArray>(find_class("[B"));
+        const string &value = static_cast<String *>(object)->value;
+        array->data.assign(value.begin(), value.end());
+        return to_jobject(array);
+    } else if (method->name == "getName") {
+        return to_jobject(new_local_string(static_cast<Class *>(object)->name));
+    }
+
+    return nullptr;
+}
+
+static jstring NewStringUTF(JNIEnv *, const char *utf) {
+    return reinterpret_cast<jstring>(new_local_string(utf));
+}
+
+static jsize GetArrayLength(JNIEnv *, jarray array) {
+    Object *object = to_object(array);
+    if (ByteArray *byteArray = dynamic_cast<ByteArray *>(object))
+        return (jsize) byteArray->data.size();
+    if (ObjectArray *objectArray = dynamic_cast<ObjectArray *>(object))
+        return (jsize) objectArray->elements.size();
+    return 0;
+}
+
+static jbyte *GetByteArrayElements(JNIEnv *, jbyteArray array, jboolean *isCopy) {
+    if (isCopy) *isCopy = JNI_FALSE;
+    return static_cast<ByteArray *>(to_object(array))->data.data();
+}
+
+static void ReleaseByteArrayElements(JNIEnv *, jbyteArray, jbyte *, jint) {
+}
+
+static jobject GetObjectArrayElement(JNIEnv *, jobjectArray array, jsize index) {
+    return to_jobject(static_cast<ObjectArray *>(to_object(array))->elements[index]);
+}
+
+static void SetIntField(JNIEnv *, jobject obj, jfieldID fieldID, jint value) {
+    static_cast<Instance *>(to_object(obj))->primitiveFields[reinterpret_cast<MemberId *>(fieldID)->name] = value;
+}
+
+static void SetLongField(JNIEnv *, jobject obj, jfieldID fieldID, jlong value) {
+    static_cast<Instance *>(to_object(obj))->primitiveFields[reinterpret_cast<MemberId *>(fieldID)->name] = value;
+}
+
+static void SetObjectField(JNIEnv *, jobject obj, jfieldID fieldID, jobject value) {
+    static_cast<Instance *>(to_object(obj))->objectFields[reinterpret_cast<MemberId *>(fieldID)->name] = to_object(value);
+}
+
+static jint GetIntField(JNIEnv *, jobject obj, jfieldID fieldID) {
+    return (jint) static_cast<Instance *>(to_object(obj))->primitiveFields[reinterpret_cast<MemberId *>(fieldID)->name];
+}
+
+static jlong GetLongField(JNIEnv *, jobject obj, jfieldID fieldID) {
+    return static_cast<Instance *>(to_object(obj))->primitiveFields[reinterpret_cast<MemberId *>(fieldID)->name];
+}
+
+static jboolean ExceptionCheck(JNIEnv *) {
+    return JNI_FALSE;
+}
+
+static jthrowable ExceptionOccurred(JNIEnv *) {
+    return nullptr;
+}
+
+static void ExceptionClear(JNIEnv *) {
+}
+
+static jint Throw(JNIEnv *, jthrowable) {
+    return 0;
+}
+
+static void DeleteLocalRef(JNIEnv *, jobject) {
+    // Local references are freed by delete_local_refs()
+}
+
+static jint EnsureLocalCapacity(JNIEnv *, jint) {
+    return 0;
+}
+
+
+
+JNIEnv *get_env() {
+    using Interface = remove_const<remove_pointer<decltype(JNIEnv::functions)>::type>::type;
+
+    static Interface functions = [] {
+        Interface f = {};
+        f.FindClass = FindClass;
+        f.GetObjectClass = GetObjectClass;
+        f.GetMethodID = GetMethodID;
+        f.GetFieldID = GetFieldID;
+        f.NewObjectV = NewObjectV;
+        f.CallObjectMethodV = CallObjectMethodV;
+        f.NewStringUTF = NewStringUTF;
+        f.GetArrayLength = GetArrayLength;
+        f.GetByteArrayElements = GetByteArrayElements;
+        f.ReleaseByteArrayElements = ReleaseByteArrayElements;
+        f.GetObjectArrayElement = GetObjectArrayElement;
+        f.SetIntField = SetIntField;
+        f.SetLongField = SetLongField;
+        f.SetObjectField = SetObjectField;
+        f.GetIntField = GetIntField;
+        f.GetLongField = GetLongField;
+        f.ExceptionCheck = ExceptionCheck;
+        f.ExceptionOccurred = ExceptionOccurred;
+        f.ExceptionClear = ExceptionClear;
+        f.Throw = Throw;
+        f.DeleteLocalRef = DeleteLocalRef;
+        f.EnsureLocalCapacity = EnsureLocalCapacity;
+        return f;
+    }();
+
+    static JNIEnv env = [] {
+        JNIEnv e = {};
+        e.functions = &functions;
+        return e;
+    }();
+
+    return &env;
+}
+
+jbyteArray new_byte_array(size_t length) {
+    ByteArray *array = new ByteArray();
+    array->clazz = find_class("[B");
+    array->data.resize(length);
+    return reinterpret_cast<jbyteArray>(array);
+}
+
+jbyte *get_byte_array_data(jbyteArray array) {
+    return static_cast<ByteArray *>(to_object(array))->data.data();
+}
+
+jobjectArray new_byte_array_array(const jbyteArray *arrays, size_t count) {
+    ObjectArray *array = new ObjectArray();
+    array->clazz = find_class("[[B");
+    for (size_t i = 0; i < count; i++)
+        array->elements.push_back(to_object(arrays[i]));
+    return reinterpret_cast<jobjectArray>(array);
+}
+
+jstring new_string(const std::string &value) {
+    String *str = new String();
+    str->clazz = find_class("java/lang/String");
+    str->value = value;
+    return reinterpret_cast<jstring>(str);
+}
+
+jobject new_instance(const std::string &className) {
+    Instance *instance = new Instance();
+    instance->clazz = find_class(className);
+    return to_jobject(instance);
+}
+
+void delete_object(jobject obj) {
+    delete to_object(obj);
+}
+
+void delete_local_refs() {
+    for (Object *obj : local_refs)
+        delete obj;
+    local_refs.clear();
+}
+
+jlong get_long_field(jobject obj, const std::string &name) {
+    Instance *instance = static_cast<Instance *>(to_object(obj));
+    auto it = instance->primitiveFields.find(name);
+    return it != instance->primitiveFields.end() ? it->second : 0;
+}
+
+std::string get_string_field(jobject obj, const std::string &name) {
+    Instance *instance = static_cast<Instance *>(to_object(obj));
+    auto it = instance->objectFields.find(name);
+    if (it == instance->objectFields.end() || it->second == nullptr)
+        return "";
+    return static_cast<String *>(it->second)->value;
+}
+
+JniResult get_jni_result(jobject result) {
+    if (result == nullptr)
+        return {-1, 0, "JNI exception raised", 0};
+
+    return {(int) get_long_field(result, "retval"), (int) get_long_field(result, "errno"),
+            get_string_field(result, "errmsg"), (int) get_long_field(result, "intData")};
+}
+
+}
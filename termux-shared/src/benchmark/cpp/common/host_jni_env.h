@@ -0,0 +1,68 @@
+#ifndef HOST_JNI_ENV_H
+#define HOST_JNI_ENV_H
+
+/*
+ * A minimal in-process JNIEnv implementation for running the termux-shared JNI natives on a Linux
+ * host without a JVM, so that their performance can be benchmarked with host tools.
+ *
+ * Only the JNIEnv functions called by the natives are implemented, which are plain byte arrays,
+ * object arrays, strings, int/long/object fields and the "JniResult" constructor. Java exceptions
+ * are never raised. Objects created by natives are tracked as local references of the current
+ * thread and must be freed with delete_local_refs() after the result of a call has been read.
+ *
+ * The jni.h of any JDK (or the NDK sysroot) can be used, since functions are assigned by name.
+ */
+
+#include <jni.h>
+
+#include <string>
+
+namespace host_jni {
+
+/* Get the JNIEnv to pass to natives. It can be shared between threads. */
+JNIEnv *get_env();
+
+/* Create a byte array of length bytes that is owned by the caller. */
+jbyteArray new_byte_array(size_t length);
+
+/* Get the elements of a byte array. */
+jbyte *get_byte_array_data(jbyteArray array);
+
+/* Create an array of byte arrays that is owned by the caller. The byte arrays are not owned. */
+jobjectArray new_byte_array_array(const jbyteArray *arrays, size_t count);
+
+/* Create a string that is owned by the caller. */
+jstring new_string(const std::string &value);
+
+/* Create an instance of a class with the JNI name like "com/termux/shared/net/socket/local/PeerCred" that is owned by the caller. */
+jobject new_instance(const std::string &className);
+
+/* Delete an object owned by the caller. */
+void delete_object(jobject obj);
+
+/* Delete all objects created by natives on the current thread since the last call. */
+void delete_local_refs();
+
+/* Get the value of an int or long field of an object. */
+jlong get_long_field(jobject obj, const std::string &name);
+
+/* Get the value of a String field of an object. Returns an empty string if it is null. */
+std::string get_string_field(jobject obj, const std::string &name);
+
+/* The fields of a "com/termux/shared/jni/models/JniResult" object returned by natives. */
+struct JniResult {
+    int retval;
+    int errnoCode;
+    std::string errmsg;
+    int intData;
+};
+
+/*
+ * Convert a JniResult object returned by a native. A null object, which is returned if a JNI
+ * exception was raised, is converted to a failure result.
+ */
+JniResult get_jni_result(jobject result);
+
+}
+
+#endif // HOST_JNI_ENV_H
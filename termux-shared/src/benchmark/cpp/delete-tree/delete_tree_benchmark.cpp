@@ -0,0 +1,206 @@
+/*
+ * Benchmark for the delete-tree.cpp engine used by FileTreeDeleter.
+ *
+ * A synthetic tree with the requested number of files is created under a temporary directory,
+ * spread over nested directories with a fixed number of files and subdirectories each, like an
+ * extracted prefix. It is then deleted with deleteTree() for each thread count, and once with a
+ * sequential path based nftw() and remove() walk as a baseline for deleting from Java with
+ * java.io.File paths. The files/sec of each run is reported and the tree is checked to be empty.
+ *
+ * Build and run with `make run` in this directory. See `./delete-tree-benchmark -h` for options.
+ */
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <getopt.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "delete_tree.h"
+
+using namespace std;
+
+struct options {
+    string base_dir = "/tmp";
+    uint64_t files = 100000;
+    int files_per_dir = 64;
+    int subdirs_per_dir = 8;
+    vector<int> thread_counts = {1, 2, 4, 8};
+    bool baseline = true;
+};
+
+/*
+ * Create opts.files entries under rootFd breadth first, with files_per_dir files and
+ * subdirs_per_dir subdirectories in each directory, so that the tree is as shallow as possible.
+ */
+static bool create_tree(int rootFd, const options &opts, uint64_t &created) {
+    deque<string> dirs = {"."};
+    char name[32];
+    created = 0;
+    while (created < opts.files && !dirs.empty()) {
+        string dir = dirs.front();
+        dirs.pop_front();
+        int dirFd = openat(rootFd, dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dirFd == -1) {
+            fprintf(stderr, "Failed to open directory: %s\n", strerror(errno));
+            return false;
+        }
+
+        for (int i = 0; i < opts.files_per_dir && created < opts.files; i++, created++) {
+            snprintf(name, sizeof(name), "file-%d", i);
+            int fd = openat(dirFd, name, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+            if (fd == -1) {
+                fprintf(stderr, "Failed to create file: %s\n", strerror(errno));
+                close(dirFd);
+                return false;
+            }
+            close(fd);
+        }
+
+        for (int i = 0; i < opts.subdirs_per_dir && created < opts.files; i++, created++) {
+            snprintf(name, sizeof(name), "dir-%d", i);
+            if (mkdirat(dirFd, name, 0700) == -1) {
+                fprintf(stderr, "Failed to create directory: %s\n", strerror(errno));
+                close(dirFd);
+                return false;
+            }
+            dirs.push_back(dir + "/" + name);
+        }
+
+        close(dirFd);
+    }
+    return true;
+}
+
+static string create_root(const options &opts, uint64_t &created) {
+    string path = opts.base_dir + "/delete-tree-benchmark.XXXXXX";
+    if (mkdtemp(&path[0]) == nullptr) {
+        fprintf(stderr, "Failed to create directory under \"%s\": %s\n", opts.base_dir.c_str(), strerror(errno));
+        return "";
+    }
+
+    int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    bool success = fd != -1 && create_tree(fd, opts, created);
+    if (fd != -1) close(fd);
+    if (!success) return "";
+
+    // Flush the created tree so that writeback does not slow down the delete
+    sync();
+    return path;
+}
+
+static bool is_empty_dir(const string &path) {
+    DIR *dir = opendir(path.c_str());
+    if (dir == nullptr) return false;
+    int count = 0;
+    while (struct dirent *d = readdir(dir))
+        if (strcmp(d->d_name, ".") != 0 && strcmp(d->d_name, "..") != 0) count++;
+    closedir(dir);
+    return count == 0;
+}
+
+static int remove_entry(const char *path, const struct stat *, int, struct FTW *ftw) {
+    if (ftw->level == 0) return 0;
+    return remove(path) == 0 ? 0 : -1;
+}
+
+static void report(const char *name, uint64_t entries, double seconds, uint64_t failed) {
+    printf("%-20s %8llu entries %8.3f s %12.0f entries/s %6llu failed\n", name,
+           (unsigned long long) entries, seconds, entries / seconds, (unsigned long long) failed);
+}
+
+static bool run_delete_tree(const options &opts, int threads) {
+    uint64_t created;
+    string path = create_root(opts, created);
+    if (path.empty()) return false;
+
+    int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    DeleteTreeResult result;
+    uint64_t progress_calls = 0;
+    auto start = chrono::steady_clock::now();
+    deleteTree(fd, threads, 10, 100, [&](uint64_t, uint64_t) { progress_calls++; return true; }, result);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    close(fd);
+
+    char name[32];
+    snprintf(name, sizeof(name), "deleteTree %d thread%s", threads, threads == 1 ? "" : "s");
+    report(name, result.deletedCount, seconds, result.failedCount);
+    for (const DeleteTreeError &error : result.errors)
+        fprintf(stderr, "  \"%s\": %s\n", error.path.c_str(), strerror(error.error));
+
+    bool success = result.failedCount == 0 && result.deletedCount == created && is_empty_dir(path);
+    if (!success)
+        fprintf(stderr, "  Expected %llu deleted entries and an empty root directory\n", (unsigned long long) created);
+    rmdir(path.c_str());
+    return success;
+}
+
+static bool run_baseline(const options &opts) {
+    uint64_t created;
+    string path = create_root(opts, created);
+    if (path.empty()) return false;
+
+    auto start = chrono::steady_clock::now();
+    int rc = nftw(path.c_str(), remove_entry, 64, FTW_DEPTH | FTW_PHYS);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    report("nftw+remove", created, seconds, rc == 0 ? 0 : 1);
+
+    bool success = rc == 0 && is_empty_dir(path);
+    rmdir(path.c_str());
+    return success;
+}
+
+static void print_usage(const char *name) {
+    printf("Usage: %s [-d dir] [-n files] [-f files_per_dir] [-s subdirs_per_dir] [-t threads] [-B]\n"
+           "  -d dir              directory to create the trees under (default: /tmp)\n"
+           "  -n files            number of files and directories in each tree (default: 100000)\n"
+           "  -f files_per_dir    number of files in each directory (default: 64)\n"
+           "  -s subdirs_per_dir  number of subdirectories in each directory (default: 8)\n"
+           "  -t threads          comma separated thread counts (default: 1,2,4,8)\n"
+           "  -B                  do not run the sequential nftw() baseline\n", name);
+}
+
+int main(int argc, char **argv) {
+    options opts;
+    int opt;
+    while ((opt = getopt(argc, argv, "d:n:f:s:t:Bh")) != -1) {
+        switch (opt) {
+            case 'd': opts.base_dir = optarg; break;
+            case 'n': opts.files = strtoull(optarg, nullptr, 10); break;
+            case 'f': opts.files_per_dir = atoi(optarg); break;
+            case 's': opts.subdirs_per_dir = atoi(optarg); break;
+            case 't': {
+                opts.thread_counts.clear();
+                char *saveptr;
+                for (char *count = strtok_r(optarg, ",", &saveptr); count; count = strtok_r(nullptr, ",", &saveptr))
+                    opts.thread_counts.push_back(atoi(count));
+                break;
+            }
+            case 'B': opts.baseline = false; break;
+            default: print_usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (opts.files < 1 || opts.files_per_dir < 1 || opts.subdirs_per_dir < 1 || opts.thread_counts.empty()) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    bool success = true;
+    if (opts.baseline)
+        success &= run_baseline(opts);
+    for (int threads : opts.thread_counts)
+        success &= run_delete_tree(opts, threads);
+
+    return success ? 0 : 1;
+}
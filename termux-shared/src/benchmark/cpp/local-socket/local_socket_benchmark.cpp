@@ -0,0 +1,381 @@
+/*
+ * Load test and latency benchmark for the local-socket.cpp natives used by LocalSocketManager.
+ *
+ * A server is run in-process with the same native calls and threading model as LocalServerSocket:
+ * a listener thread that accepts clients, gets their peer credentials and sets socket timeouts,
+ * and a new thread for each accepted client. Each client thread connects to the server, sends a
+ * 4 byte payload length followed by the payload and reads the echoed payload until EOF. The
+ * connections/sec, bytes/sec and latency percentiles and histogram of the connect-to-EOF time
+ * are reported for each payload size.
+ *
+ * Build and run with `make run` in this directory. See `./local-socket-benchmark -h` for options.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <getopt.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "host_jni_env.h"
+
+using namespace std;
+
+#define LOCAL_SOCKET_NATIVE(name) Java_com_termux_shared_net_socket_local_LocalSocketManager_##name
+
+extern "C" {
+JNIEXPORT jobject JNICALL LOCAL_SOCKET_NATIVE(createServerSocketNative)(JNIEnv *env, jclass clazz, jstring logTitle, jbyteArray pathArray, jint backlog, jint socketType);
+JNIEXPORT jobject JNICALL LOCAL_SOCKET_NATIVE(closeSocketNative)(JNIEnv *env, jclass clazz, jstring logTitle, jint fd);
+JNIEXPORT jobject JNICALL LOCAL_SOCKET_NATIVE(acceptNative)(JNIEnv *env, jclass clazz, jstring logTitle, jint fd);
+JNIEXPORT jobject JNICALL LOCAL_SOCKET_NATIVE(readNative)(JNIEnv *env, jclass clazz, jstring logTitle, jint fd, jbyteArray dataArray, jlong deadline);
+JNIEXPORT jobject JNICALL LOCAL_SOCKET_NATIVE(sendNative)(JNIEnv *env, jclass clazz, jstring logTitle, jint fd, jbyteArray dataArray, jlong deadline);
+JNIEXPORT jobject JNICALL LOCAL_SOCKET_NATIVE(setSocketReadTimeoutNative)(JNIEnv *env, jclass clazz, jstring logTitle, jint fd, jint timeout);
+JNIEXPORT jobject JNICALL LOCAL_SOCKET_NATIVE(setSocketSendTimeoutNative)(JNIEnv *env, jclass clazz, jstring logTitle, jint fd, jint timeout);
+JNIEXPORT jobject JNICALL LOCAL_SOCKET_NATIVE(getPeerCredNative)(JNIEnv *env, jclass clazz, jstring logTitle, jint fd, jobject peerCred);
+}
+
+// The same defaults as LocalSocketRunConfig
+#define DEFAULT_BACKLOG 50
+#define DEFAULT_RECEIVE_TIMEOUT 10000
+#define DEFAULT_SEND_TIMEOUT 10000
+
+struct options {
+    string path = "/tmp/local-socket-benchmark.sock";
+    int clients = 8;
+    int connections = 1000;
+    vector<size_t> payload_sizes = {64, 4096, 65536};
+    bool histogram = false;
+};
+
+static atomic<int> server_errors(0);
+static atomic<int> active_client_handlers(0);
+static mutex client_handlers_lock;
+static condition_variable client_handlers_done;
+
+/* Call a native that returns a JniResult, free its local refs and return the converted result. */
+template <typename F>
+static host_jni::JniResult call_native(F native) {
+    host_jni::JniResult result = host_jni::get_jni_result(native());
+    host_jni::delete_local_refs();
+    return result;
+}
+
+static void report_server_error(const string &message, const host_jni::JniResult &result) {
+    if (server_errors++ < 10)
+        fprintf(stderr, "server: %s: %s\n", message.c_str(), result.errmsg.c_str());
+}
+
+
+
+/* Echo the payload sent by a client, like a LocalSocketManager client handler thread. */
+static void handle_client(jstring title, int clientFd) {
+    JNIEnv *env = host_jni::get_env();
+
+    jbyteArray header = host_jni::new_byte_array(4);
+    host_jni::JniResult result = call_native([&] { return LOCAL_SOCKET_NATIVE(readNative)(env, nullptr, title, clientFd, header, 0); });
+    if (result.retval != 0 || result.intData != 4) {
+        report_server_error("read header failed", result);
+    } else {
+        uint32_t length;
+        memcpy(&length, host_jni::get_byte_array_data(header), sizeof(length));
+
+        jbyteArray payload = host_jni::new_byte_array(length);
+        result = call_native([&] { return LOCAL_SOCKET_NATIVE(readNative)(env, nullptr, title, clientFd, payload, 0); });
+        if (result.retval != 0 || (uint32_t) result.intData != length) {
+            report_server_error("read payload failed", result);
+        } else {
+            result = call_native([&] { return LOCAL_SOCKET_NATIVE(sendNative)(env, nullptr, title, clientFd, payload, 0); });
+            if (result.retval != 0)
+                report_server_error("send payload failed", result);
+        }
+        host_jni::delete_object(payload);
+    }
+    host_jni::delete_object(header);
+
+    result = call_native([&] { return LOCAL_SOCKET_NATIVE(closeSocketNative)(env, nullptr, title, clientFd); });
+    if (result.retval != 0)
+        report_server_error("close client failed", result);
+
+    lock_guard<mutex> guard(client_handlers_lock);
+    if (--active_client_handlers == 0)
+        client_handlers_done.notify_all();
+}
+
+/* Accept clients until the server socket is shut down, like LocalServerSocket.ClientSocketListener. */
+static void run_client_socket_listener(jstring title, int serverFd, const atomic<bool> &stopping) {
+    JNIEnv *env = host_jni::get_env();
+
+    while (true) {
+        host_jni::JniResult result = call_native([&] { return LOCAL_SOCKET_NATIVE(acceptNative)(env, nullptr, title, serverFd); });
+        if (result.retval != 0) {
+            if (stopping) break;
+            report_server_error("accept failed", result);
+            continue;
+        }
+        int clientFd = result.intData;
+
+        jobject peerCred = host_jni::new_instance("com/termux/shared/net/socket/local/PeerCred");
+        result = call_native([&] { return LOCAL_SOCKET_NATIVE(getPeerCredNative)(env, nullptr, title, clientFd, peerCred); });
+        host_jni::delete_object(peerCred);
+        if (result.retval != 0) {
+            report_server_error("get peer cred failed", result);
+            close(clientFd);
+            continue;
+        }
+
+        result = call_native([&] { return LOCAL_SOCKET_NATIVE(setSocketReadTimeoutNative)(env, nullptr, title, clientFd, DEFAULT_RECEIVE_TIMEOUT); });
+        if (result.retval == 0)
+            result = call_native([&] { return LOCAL_SOCKET_NATIVE(setSocketSendTimeoutNative)(env, nullptr, title, clientFd, DEFAULT_SEND_TIMEOUT); });
+        if (result.retval != 0) {
+            report_server_error("set timeout failed", result);
+            close(clientFd);
+            continue;
+        }
+
+        {
+            lock_guard<mutex> guard(client_handlers_lock);
+            active_client_handlers++;
+        }
+        thread(handle_client, title, clientFd).detach();
+    }
+}
+
+
+
+/* Run one connection and return its latency in nanoseconds, or 0 on failure. */
+static uint64_t run_client_connection(const string &path, const vector<char> &payload, vector<char> &response) {
+    auto start = chrono::steady_clock::now();
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) return 0;
+
+    struct sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    if (connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == -1) {
+        close(fd);
+        return 0;
+    }
+
+    uint32_t length = (uint32_t) payload.size();
+    struct iovec iov[2] = {{&length, sizeof(length)}, {(void *) payload.data(), payload.size()}};
+    size_t remaining = sizeof(length) + payload.size();
+    int iov_index = 0;
+    while (remaining > 0) {
+        ssize_t ret = writev(fd, &iov[iov_index], 2 - iov_index);
+        if (ret == -1) {
+            if (errno == EINTR) continue;
+            close(fd);
+            return 0;
+        }
+        remaining -= ret;
+        while (ret > 0 && iov_index < 2) {
+            size_t consumed = min((size_t) ret, iov[iov_index].iov_len);
+            iov[iov_index].iov_base = (char *) iov[iov_index].iov_base + consumed;
+            iov[iov_index].iov_len -= consumed;
+            ret -= consumed;
+            if (iov[iov_index].iov_len == 0) iov_index++;
+        }
+    }
+
+    size_t received = 0;
+    while (true) {
+        ssize_t ret = read(fd, response.data() + received, response.size() - received);
+        if (ret == -1) {
+            if (errno == EINTR) continue;
+            close(fd);
+            return 0;
+        }
+        if (ret == 0) break;
+        received += ret;
+        if (received == response.size()) response.resize(response.size() * 2);
+    }
+    close(fd);
+
+    if (received != payload.size())
+        return 0;
+
+    return (uint64_t) chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+}
+
+static string format_duration(uint64_t ns) {
+    char buf[32];
+    if (ns < 1000)
+        snprintf(buf, sizeof(buf), "%llu ns", (unsigned long long) ns);
+    else if (ns < 1000000)
+        snprintf(buf, sizeof(buf), "%.1f us", ns / 1e3);
+    else
+        snprintf(buf, sizeof(buf), "%.2f ms", ns / 1e6);
+    return buf;
+}
+
+static string format_bytes(double bytes) {
+    const char *units[] = {"B", "KiB", "MiB", "GiB"};
+    int unit = 0;
+    while (bytes >= 1024 && unit < 3) {
+        bytes /= 1024;
+        unit++;
+    }
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.1f %s", bytes, units[unit]);
+    return buf;
+}
+
+static uint64_t get_percentile(const vector<uint64_t> &sorted, double percentile) {
+    if (sorted.empty()) return 0;
+    size_t index = (size_t) (percentile / 100.0 * sorted.size());
+    return sorted[min(index, sorted.size() - 1)];
+}
+
+/* Print a histogram of latencies with power of 2 microsecond buckets. */
+static void print_histogram(const vector<uint64_t> &sorted) {
+    vector<size_t> buckets(32, 0);
+    for (uint64_t latency : sorted) {
+        uint64_t us = latency / 1000;
+        int bucket = 0;
+        while (us > 1 && bucket < 31) {
+            us >>= 1;
+            bucket++;
+        }
+        buckets[bucket]++;
+    }
+
+    size_t max_count = *max_element(buckets.begin(), buckets.end());
+    for (int i = 0; i < 32; i++) {
+        if (buckets[i] == 0) continue;
+        int bar = (int) (buckets[i] * 50 / max_count);
+        printf("    <= %10s: %8zu %s\n", format_duration((1ULL << (i + 1)) * 1000).c_str(), buckets[i], string(bar, '#').c_str());
+    }
+}
+
+static bool run_benchmark(const options &opts, size_t payload_size) {
+    vector<vector<uint64_t>> client_latencies(opts.clients);
+    atomic<int> failures(0);
+
+    auto start = chrono::steady_clock::now();
+    vector<thread> clients;
+    for (int i = 0; i < opts.clients; i++) {
+        clients.emplace_back([&, i] {
+            vector<char> payload(payload_size, (char) ('a' + i % 26));
+            vector<char> response(payload_size + 1);
+            client_latencies[i].reserve(opts.connections);
+            for (int j = 0; j < opts.connections; j++) {
+                uint64_t latency = run_client_connection(opts.path, payload, response);
+                if (latency == 0)
+                    failures++;
+                else
+                    client_latencies[i].push_back(latency);
+            }
+        });
+    }
+    for (thread &client : clients)
+        client.join();
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    vector<uint64_t> latencies;
+    for (const vector<uint64_t> &l : client_latencies)
+        latencies.insert(latencies.end(), l.begin(), l.end());
+    sort(latencies.begin(), latencies.end());
+
+    printf("payload %s: %d clients x %d connections in %.3f s, %d failed\n",
+           format_bytes(payload_size).c_str(), opts.clients, opts.connections, elapsed, failures.load());
+    printf("  connections/sec: %.1f\n", latencies.size() / elapsed);
+    printf("  bytes/sec: %s (request and response payloads)\n", format_bytes(latencies.size() * payload_size * 2 / elapsed).c_str());
+    printf("  latency: p50 %s, p99 %s, p999 %s, max %s\n",
+           format_duration(get_percentile(latencies, 50)).c_str(),
+           format_duration(get_percentile(latencies, 99)).c_str(),
+           format_duration(get_percentile(latencies, 99.9)).c_str(),
+           format_duration(latencies.empty() ? 0 : latencies.back()).c_str());
+    if (opts.histogram)
+        print_histogram(latencies);
+
+    return failures == 0;
+}
+
+static void print_usage(const char *name) {
+    printf("Usage: %s [-p path] [-c clients] [-n connections] [-s sizes] [-H]\n"
+           "  -p path         server socket path (default: /tmp/local-socket-benchmark.sock)\n"
+           "  -c clients      number of concurrent clients (default: 8)\n"
+           "  -n connections  number of connections per client for each payload size (default: 1000)\n"
+           "  -s sizes        comma separated payload sizes in bytes (default: 64,4096,65536)\n"
+           "  -H              print latency histogram\n", name);
+}
+
+int main(int argc, char **argv) {
+    options opts;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:c:n:s:Hh")) != -1) {
+        switch (opt) {
+            case 'p': opts.path = optarg; break;
+            case 'c': opts.clients = atoi(optarg); break;
+            case 'n': opts.connections = atoi(optarg); break;
+            case 's': {
+                opts.payload_sizes.clear();
+                char *saveptr;
+                for (char *size = strtok_r(optarg, ",", &saveptr); size; size = strtok_r(nullptr, ",", &saveptr))
+                    opts.payload_sizes.push_back(strtoull(size, nullptr, 10));
+                break;
+            }
+            case 'H': opts.histogram = true; break;
+            default: print_usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (opts.clients < 1 || opts.connections < 1 || opts.payload_sizes.empty()) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    JNIEnv *env = host_jni::get_env();
+    jstring title = host_jni::new_string("local-socket-benchmark");
+
+    unlink(opts.path.c_str());
+    jbyteArray path = host_jni::new_byte_array(opts.path.size());
+    memcpy(host_jni::get_byte_array_data(path), opts.path.data(), opts.path.size());
+    host_jni::JniResult result = call_native([&] { return LOCAL_SOCKET_NATIVE(createServerSocketNative)(env, nullptr, title, path, DEFAULT_BACKLOG, 0); });
+    host_jni::delete_object(path);
+    if (result.retval != 0) {
+        fprintf(stderr, "Failed to create server socket: %s\n", result.errmsg.c_str());
+        return 1;
+    }
+    int serverFd = result.intData;
+
+    atomic<bool> stopping(false);
+    thread listener(run_client_socket_listener, title, serverFd, ref(stopping));
+
+    bool success = true;
+    for (size_t payload_size : opts.payload_sizes)
+        success &= run_benchmark(opts, payload_size);
+
+    // Wake up the listener blocked in accept() and wait for client handlers to finish
+    stopping = true;
+    shutdown(serverFd, SHUT_RDWR);
+    listener.join();
+    {
+        unique_lock<mutex> guard(client_handlers_lock);
+        client_handlers_done.wait(guard, [] { return active_client_handlers == 0; });
+    }
+    call_native([&] { return LOCAL_SOCKET_NATIVE(closeSocketNative)(env, nullptr, title, serverFd); });
+    unlink(opts.path.c_str());
+    host_jni::delete_object(title);
+
+    if (server_errors > 0) {
+        fprintf(stderr, "%d server errors\n", server_errors.load());
+        success = false;
+    }
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+/*
+ * Tests for the local-socket.cpp natives used by LocalSocketManager.
+ *
+ * A peer sends pipelined am socket protocol frames, an 8 byte header with the request id and body
+ * length followed by the body, split across several writes with delays between them, so that
+ * readNative() receives each frame in pieces. The frames must be read into buffers of their exact
+ * size without writing past them, which is checked by building with AddressSanitizer.
+ *
+ * Build and run with `make test` in this directory.
+ */
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "host_jni_env.h"
+
+using namespace std;
+
+#define LOCAL_SOCKET_NATIVE(name) Java_com_termux_shared_net_socket_local_LocalSocketManager_##name
+
+extern "C" {
+JNIEXPORT jobject JNICALL LOCAL_SOCKET_NATIVE(readNative)(JNIEnv *env, jclass clazz, jstring logTitle, jint fd, jbyteArray dataArray, jlong deadline);
+}
+
+// The same as AmSocketServer.PIPELINED_HEADER_SIZE
+#define PIPELINED_HEADER_SIZE 8
+
+static int failures = 0;
+
+#define EXPECT(condition, ...) do { \
+    if (!(condition)) { \
+        fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__); \
+        fprintf(stderr, __VA_ARGS__); \
+        fprintf(stderr, "\n"); \
+        failures++; \
+    } \
+} while (0)
+
+/* Write data in chunks of chunkSize bytes with a delay between them so that each is read separately. */
+static void write_split(int fd, const vector<uint8_t> &data, size_t chunkSize) {
+    for (size_t offset = 0; offset < data.size(); offset += chunkSize) {
+        size_t length = min(chunkSize, data.size() - offset);
+        if (write(fd, data.data() + offset, length) != (ssize_t) length)
+            perror("write");
+        this_thread::sleep_for(chrono::milliseconds(2));
+    }
+}
+
+static vector<uint8_t> get_frame(uint32_t requestId, const string &body) {
+    vector<uint8_t> frame(PIPELINED_HEADER_SIZE);
+    uint32_t value = htonl(requestId);
+    memcpy(frame.data(), &value, 4);
+    value = htonl(body.size());
+    memcpy(frame.data() + 4, &value, 4);
+    frame.insert(frame.end(), body.begin(), body.end());
+    return frame;
+}
+
+/* Read a buffer of exactly length bytes with readNative() and return its data. */
+static string read_exact(JNIEnv *env, jstring title, int fd, size_t length) {
+    jbyteArray array = host_jni::new_byte_array(length);
+    host_jni::JniResult result = host_jni::get_jni_result(LOCAL_SOCKET_NATIVE(readNative)(env, nullptr, title, fd, array, 0));
+    host_jni::delete_local_refs();
+    EXPECT(result.retval == 0, "readNative() failed: %s", result.errmsg.c_str());
+    EXPECT((size_t) result.intData == length, "readNative() read %d bytes instead of %zu", result.intData, length);
+    string data((const char *) host_jni::get_byte_array_data(array), length);
+    host_jni::delete_object(array);
+    return data;
+}
+
+/* Read the frames of requests sent in pieces of chunkSize bytes. */
+static void test_split_frames(JNIEnv *env, jstring title, size_t chunkSize) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        perror("socketpair");
+        failures++;
+        return;
+    }
+
+    vector<string> bodies = {"start -a android.intent.action.VIEW", "", string(600, 'x'), "broadcast -a test"};
+    thread peer([&] {
+        for (size_t i = 0; i < bodies.size(); i++)
+            write_split(fds[1], get_frame(i + 1, bodies[i]), chunkSize);
+        close(fds[1]);
+    });
+
+    for (size_t i = 0; i < bodies.size(); i++) {
+        string header = read_exact(env, title, fds[0], PIPELINED_HEADER_SIZE);
+        uint32_t requestId, length;
+        memcpy(&requestId, header.data(), 4);
+        memcpy(&length, header.data() + 4, 4);
+        requestId = ntohl(requestId);
+        length = ntohl(length);
+        EXPECT(requestId == i + 1, "chunk size %zu: request id %u instead of %zu", chunkSize, requestId, i + 1);
+        EXPECT(length == bodies[i].size(), "chunk size %zu: body length %u instead of %zu", chunkSize, length, bodies[i].size());
+        if (length != bodies[i].size()) break;
+
+        if (length > 0) {
+            string body = read_exact(env, title, fds[0], length);
+            EXPECT(body == bodies[i], "chunk size %zu: body of request %zu does not match", chunkSize, i + 1);
+        }
+    }
+
+    peer.join();
+    close(fds[0]);
+}
+
+int main() {
+    JNIEnv *env = host_jni::get_env();
+    jstring title = host_jni::new_string("LocalSocketTest");
+
+    // Header split inside the request id and length fields, and body split in many writes
+    for (size_t chunkSize : {1, 3, 5, 7, 1000})
+        test_split_frames(env, title, chunkSize);
+
+    host_jni::delete_object(title);
+
+    if (failures > 0) {
+        fprintf(stderr, "%d failures\n", failures);
+        return 1;
+    }
+    printf("All tests passed\n");
+    return 0;
+}
@@ -0,0 +1,220 @@
+/*
+ * Benchmark for the AppShellScheduler used by TermuxService for background commands.
+ *
+ * A synthetic burst of batch commands, like sent by automation apps through the RUN_COMMAND
+ * intent, is replayed from multiple callers. Each command is a real `sh` process that busy loops
+ * for the requested number of iterations. While the burst runs, a trivial interactive command is
+ * submitted at a fixed interval, like from a widget, and its latency from submit to exit is
+ * measured. A foreground thread also wakes up every 16ms like a frame loop of a terminal session
+ * and measures how late it wakes up, which is how much the burst starves the foreground.
+ *
+ * The burst is replayed for each max parallelism, where 0 is unlimited, which is the behaviour
+ * before the scheduler. The wall time and throughput of the burst, the queue wait of each priority
+ * and the interactive and frame latencies are reported.
+ *
+ * Build and run with `make run` in this directory. See `java -cp build AppShellSchedulerBenchmark -h` for options.
+ */
+
+import com.termux.shared.shell.command.runner.app.AppShellScheduler;
+import com.termux.shared.shell.command.runner.app.AppShellScheduler.Priority;
+
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.List;
+import java.util.Locale;
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicBoolean;
+
+public class AppShellSchedulerBenchmark {
+
+    private static final long FRAME_INTERVAL_NANOS = 16_000_000;
+
+    private static int sBurstCount = 200;
+    private static int sCallerCount = 4;
+    private static int sWorkIterations = 100_000;
+    private static int sInteractiveIntervalMillis = 100;
+    private static int[] sParallelisms = {0, Runtime.getRuntime().availableProcessors() * 2,
+        Runtime.getRuntime().availableProcessors(), 2};
+
+    private static final class Command {
+        final Priority priority;
+        long submitNanos;
+        long startNanos;
+        long exitNanos;
+
+        Command(Priority priority) {
+            this.priority = priority;
+        }
+    }
+
+    private static final class Result {
+        long burstNanos;
+        final List<Long> batchWaits = new ArrayList<>();
+        final List<Long> interactiveWaits = new ArrayList<>();
+        final List<Long> interactiveLatencies = new ArrayList<>();
+        final List<Long> frameLatenesses = new ArrayList<>();
+        int maxQueuedCount;
+    }
+
+    public static void main(String[] args) throws Exception {
+        for (int i = 0; i < args.length; i++) {
+            switch (args[i]) {
+                case "-n": sBurstCount = Integer.parseInt(args[++i]); break;
+                case "-c": sCallerCount = Integer.parseInt(args[++i]); break;
+                case "-w": sWorkIterations = Integer.parseInt(args[++i]); break;
+                case "-i": sInteractiveIntervalMillis = Integer.parseInt(args[++i]); break;
+                case "-p": {
+                    String[] values = args[++i].split(",");
+                    sParallelisms = new int[values.length];
+                    for (int j = 0; j < values.length; j++)
+                        sParallelisms[j] = Integer.parseInt(values[j].trim());
+                    break;
+                }
+                default:
+                    System.out.println("Usage: AppShellSchedulerBenchmark [-n burst_commands] [-c callers]" +
+                        " [-w work_iterations] [-i interactive_interval_ms] [-p parallelism,...]");
+                    System.out.println("A parallelism of 0 is unlimited.");
+                    return;
+            }
+        }
+
+        System.out.printf(Locale.ENGLISH, "burst=%d callers=%d work=%d interactive_interval=%dms cpus=%d%n",
+            sBurstCount, sCallerCount, sWorkIterations, sInteractiveIntervalMillis, Runtime.getRuntime().availableProcessors());
+        System.out.printf(Locale.ENGLISH, "%-10s %9s %9s %9s %19s %19s %19s %24s%n",
+            "parallel", "wall(ms)", "cmds/s", "maxqueue", "batch wait p50/p99", "inter wait p50/p99",
+            "inter lat p50/p99", "frame late p50/p99/max");
+
+        // Warm up the process creation and JIT
+        run(0, Math.min(sBurstCount, 20));
+
+        for (int parallelism : sParallelisms) {
+            Result result = run(parallelism, sBurstCount);
+            System.out.printf(Locale.ENGLISH, "%-10s %9.1f %9.1f %9d %19s %19s %19s %24s%n",
+                parallelism == 0 ? "unlimited" : String.valueOf(parallelism),
+                result.burstNanos / 1e6, sBurstCount / (result.burstNanos / 1e9), result.maxQueuedCount,
+                percentiles(result.batchWaits, 50, 99), percentiles(result.interactiveWaits, 50, 99),
+                percentiles(result.interactiveLatencies, 50, 99), percentiles(result.frameLatenesses, 50, 99, 100));
+        }
+    }
+
+    private static Result run(int parallelism, int burstCount) throws Exception {
+        Result result = new Result();
+        AppShellScheduler scheduler = new AppShellScheduler(parallelism);
+        ExecutorService waiters = Executors.newCachedThreadPool();
+        List<Command> commands = Collections.synchronizedList(new ArrayList<>());
+        CountDownLatch burstDone = new CountDownLatch(burstCount);
+        AtomicBoolean running = new AtomicBoolean(true);
+
+        Thread frameThread = new Thread(() -> {
+            long deadline = System.nanoTime() + FRAME_INTERVAL_NANOS;
+            while (running.get()) {
+                long sleepNanos = deadline - System.nanoTime();
+                if (sleepNanos > 0) {
+                    try {
+                        TimeUnit.NANOSECONDS.sleep(sleepNanos);
+                    } catch (InterruptedException e) {
+                        return;
+                    }
+                }
+                long now = System.nanoTime();
+                synchronized (result.frameLatenesses) {
+                    result.frameLatenesses.add(Math.max(now - deadline, 0));
+                }
+                deadline = Math.max(deadline + FRAME_INTERVAL_NANOS, now);
+            }
+        });
+        frameThread.start();
+
+        Thread interactiveThread = new Thread(() -> {
+            while (running.get()) {
+                Command command = new Command(Priority.INTERACTIVE);
+                CountDownLatch exited = new CountDownLatch(1);
+                submit(scheduler, waiters, command, "widget", "exit 0", exited);
+                commands.add(command);
+                try {
+                    exited.await();
+                    Thread.sleep(sInteractiveIntervalMillis);
+                } catch (InterruptedException e) {
+                    return;
+                }
+            }
+        });
+
+        long burstStartNanos = System.nanoTime();
+        interactiveThread.start();
+        String script = "i=0; while [ $i -lt " + sWorkIterations + " ]; do i=$((i+1)); done";
+        for (int i = 0; i < burstCount; i++) {
+            Command command = new Command(Priority.BATCH);
+            commands.add(command);
+            submit(scheduler, waiters, command, "caller-" + (i % sCallerCount), script, burstDone);
+        }
+        burstDone.await();
+        result.burstNanos = System.nanoTime() - burstStartNanos;
+
+        running.set(false);
+        interactiveThread.join();
+        frameThread.join();
+        waiters.shutdown();
+        waiters.awaitTermination(1, TimeUnit.MINUTES);
+        result.maxQueuedCount = scheduler.getMetrics().maxQueuedCount;
+
+        synchronized (commands) {
+            for (Command command : commands) {
+                if (command.exitNanos == 0) continue;
+                if (command.priority == Priority.BATCH) {
+                    result.batchWaits.add(command.startNanos - command.submitNanos);
+                } else {
+                    result.interactiveWaits.add(command.startNanos - command.submitNanos);
+                    result.interactiveLatencies.add(command.exitNanos - command.submitNanos);
+                }
+            }
+        }
+        return result;
+    }
+
+    private static void submit(AppShellScheduler scheduler, ExecutorService waiters, Command command,
+                               String caller, String script, CountDownLatch exited) {
+        command.submitNanos = System.nanoTime();
+        scheduler.submit(command, command.priority, caller, () -> {
+            command.startNanos = System.nanoTime();
+            Process process;
+            try {
+                process = new ProcessBuilder("sh", "-c", script).start();
+            } catch (Exception e) {
+                // The scheduler frees the slot of the command
+                exited.countDown();
+                throw new RuntimeException(e);
+            }
+            waiters.execute(() -> {
+                try {
+                    process.waitFor();
+                } catch (InterruptedException e) {
+                    process.destroy();
+                }
+                command.exitNanos = System.nanoTime();
+                scheduler.onJobFinished(command);
+                exited.countDown();
+            });
+        });
+    }
+
+    private static String percentiles(List<Long> values, int... percentiles) {
+        if (values.isEmpty()) return "-";
+        List<Long> sorted;
+        synchronized (values) {
+            sorted = new ArrayList<>(values);
+        }
+        Collections.sort(sorted);
+        StringBuilder result = new StringBuilder();
+        for (int percentile : percentiles) {
+            int index = Math.min(sorted.size() - 1, (int) Math.ceil(percentile / 100.0 * sorted.size()) - 1);
+            if (result.length() > 0) result.append("/");
+            result.append(String.format(Locale.ENGLISH, "%.1f", sorted.get(Math.max(index, 0)) / 1e6));
+        }
+        return result.toString();
+    }
+
+}
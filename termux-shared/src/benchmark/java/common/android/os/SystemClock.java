@@ -0,0 +1,10 @@
+package android.os;
+
+/** Host stub of the android {@link SystemClock} for building shared sources outside of gradle. */
+public final class SystemClock {
+
+    public static long elapsedRealtime() {
+        return System.nanoTime() / 1000000;
+    }
+
+}
@@ -0,0 +1,5 @@
+package androidx.annotation;
+
+/** Host stub of the androidx annotation for building shared sources outside of gradle. */
+public @interface NonNull {
+}
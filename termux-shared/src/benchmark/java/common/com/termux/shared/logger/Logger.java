@@ -0,0 +1,28 @@
+package com.termux.shared.logger;
+
+/**
+ * Host stub of the {@link Logger} for building shared sources outside of gradle. Only warnings and
+ * errors are printed to stderr, so that verbose logs do not skew benchmarks.
+ */
+public class Logger {
+
+    public static void logDebug(String tag, String message) {
+    }
+
+    public static void logVerbose(String tag, String message) {
+    }
+
+    public static void logWarn(String tag, String message) {
+        System.err.println("W/" + tag + ": " + message);
+    }
+
+    public static void logError(String tag, String message) {
+        System.err.println("E/" + tag + ": " + message);
+    }
+
+    public static void logStackTraceWithMessage(String tag, String message, Throwable throwable) {
+        System.err.println("E/" + tag + ": " + message);
+        throwable.printStackTrace();
+    }
+
+}
@@ -11,10 +11,48 @@ LOCAL_MODULE := readlink
 LOCAL_SRC_FILES := readlink.cpp
 include $(BUILD_STATIC_LIBRARY)
 
+include $(CLEAR_VARS)
+LOCAL_MODULE := canonicalize-path
+LOCAL_SRC_FILES := canonicalize-path.cpp
+LOCAL_STATIC_LIBRARIES := libreadlink
+include $(BUILD_STATIC_LIBRARY)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := chmod-tree
+LOCAL_SRC_FILES := chmod-tree.cpp
+include $(BUILD_STATIC_LIBRARY)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := copy-tree
+LOCAL_SRC_FILES := copy-tree.cpp
+include $(BUILD_STATIC_LIBRARY)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := delete-tree
+LOCAL_SRC_FILES := delete-tree.cpp
+include $(BUILD_STATIC_LIBRARY)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := file-io
+LOCAL_SRC_FILES := file-io.cpp
+include $(BUILD_STATIC_LIBRARY)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := file-watcher
+LOCAL_SRC_FILES := file-watcher.cpp
+include $(BUILD_STATIC_LIBRARY)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := process-runner
+LOCAL_SRC_FILES := process-runner.cpp
+# posix_spawn() and its file actions are only available from newer api levels
+LOCAL_CFLAGS := -D__ANDROID_UNAVAILABLE_SYMBOLS_ARE_WEAK__ -Werror=unguarded-availability
+include $(BUILD_STATIC_LIBRARY)
+
 include $(CLEAR_VARS)
 LOCAL_MODULE := posix
 LOCAL_SRC_FILES := posix.cpp
-LOCAL_STATIC_LIBRARIES := libreadlink
+LOCAL_STATIC_LIBRARIES := libreadlink libcanonicalize-path libchmod-tree libcopy-tree libdelete-tree libfile-io libfile-watcher libprocess-runner
 include $(BUILD_SHARED_LIBRARY)
 
 include $(CLEAR_VARS)
@@ -0,0 +1,329 @@
+#include "include/canonicalize_path.h"
+#include "include/readlink.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <deque>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// The max number of directories in the cache
+const size_t CACHE_CAPACITY = 128;
+
+// The max number of symlinks to follow, like MAXSYMLINKS of the kernel
+const int MAX_SYMLINK_FOLLOWS = 40;
+
+struct CachedDirectory {
+    // The normalized path of the directory as given, which is the key of the cache
+    std::string path;
+    std::string canonicalPath;
+    dev_t dev;
+    ino_t ino;
+};
+
+pthread_mutex_t cacheLock = PTHREAD_MUTEX_INITIALIZER;
+// The cached directories, most recently used first
+std::list<CachedDirectory> cacheList;
+std::unordered_map<std::string, std::list<CachedDirectory>::iterator> cacheMap;
+// Incremented whenever the cache is invalidated, so that canonicalizations that started before
+// do not add what they resolved to it
+uint64_t cacheGeneration = 0;
+
+bool getCachedDirectory(const std::string& path, CachedDirectory& directory) {
+    pthread_mutex_lock(&cacheLock);
+    auto it = cacheMap.find(path);
+    bool found = it != cacheMap.end();
+    if (found) {
+        cacheList.splice(cacheList.begin(), cacheList, it->second);
+        directory = *it->second;
+    }
+    pthread_mutex_unlock(&cacheLock);
+    return found;
+}
+
+void removeCachedDirectory(const std::string& path) {
+    pthread_mutex_lock(&cacheLock);
+    auto it = cacheMap.find(path);
+    if (it != cacheMap.end()) {
+        cacheList.erase(it->second);
+        cacheMap.erase(it);
+    }
+    pthread_mutex_unlock(&cacheLock);
+}
+
+void addCachedDirectories(std::vector<CachedDirectory>& directories, uint64_t generation) {
+    pthread_mutex_lock(&cacheLock);
+    if (generation == cacheGeneration) {
+        for (CachedDirectory& directory : directories) {
+            auto it = cacheMap.find(directory.path);
+            if (it != cacheMap.end()) {
+                cacheList.erase(it->second);
+                cacheMap.erase(it);
+            }
+            cacheList.push_front(std::move(directory));
+            cacheMap[cacheList.front().path] = cacheList.begin();
+        }
+        while (cacheList.size() > CACHE_CAPACITY) {
+            cacheMap.erase(cacheList.back().path);
+            cacheList.pop_back();
+        }
+    }
+    pthread_mutex_unlock(&cacheLock);
+}
+
+/*
+ * Open the directory at the canonical path with an O_PATH fd, without following a symlink in any
+ * of its components. Returns -1 if it cannot be opened, like if a component is now a symlink.
+ */
+int openCanonicalDirectory(const std::string& canonicalPath) {
+    int fd = open("/", O_PATH | O_DIRECTORY | O_CLOEXEC);
+    for (size_t start = 1; fd != -1 && start < canonicalPath.size();) {
+        size_t end = canonicalPath.find('/', start);
+        if (end == std::string::npos) end = canonicalPath.size();
+        int nextFd = openat(fd, canonicalPath.substr(start, end - start).c_str(), O_PATH | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        close(fd);
+        fd = nextFd;
+        start = end + 1;
+    }
+    return fd;
+}
+
+/*
+ * Check that the cached directory is still the directory the path resolves to, and that the
+ * canonical path is still the same directory without following symlinks. Only checking that the
+ * canonical path resolves to the directory is not enough, since a directory along it may have
+ * been moved and replaced with a symlink to where it was moved, in which case the canonical path
+ * would now go through that symlink.
+ */
+bool isCachedDirectoryValid(const CachedDirectory& directory) {
+    struct stat sb;
+    if (stat(directory.path.c_str(), &sb) == -1 || sb.st_dev != directory.dev || sb.st_ino != directory.ino)
+        return false;
+    int fd = openCanonicalDirectory(directory.canonicalPath);
+    if (fd == -1) return false;
+    bool valid = fstat(fd, &sb) == 0 && sb.st_dev == directory.dev && sb.st_ino == directory.ino;
+    close(fd);
+    return valid;
+}
+
+// A component of the path still to be resolved
+struct Component {
+    // The name, or empty for a marker that the symlink at prefixIndex has been resolved
+    std::string name;
+    // The index of the component in the original path once it is resolved, or -1 for the
+    // components of symlink targets
+    int prefixIndex;
+};
+
+void appendComponent(std::string& path, const std::string& name) {
+    if (path.size() > 1) path += '/';
+    path += name;
+}
+
+void removeLastComponent(std::string& path) {
+    size_t slash = path.rfind('/');
+    path.resize(slash == 0 ? 1 : slash);
+}
+
+void splitComponents(const std::string& path, int prefixIndex, std::deque<Component>& components) {
+    std::vector<Component> split;
+    for (size_t start = 0; start < path.size();) {
+        size_t end = path.find('/', start);
+        if (end == std::string::npos) end = path.size();
+        if (end > start && path.compare(start, end - start, ".") != 0)
+            split.push_back({path.substr(start, end - start), -1});
+        start = end + 1;
+    }
+    if (prefixIndex >= 0)
+        split.push_back({"", prefixIndex});
+    components.insert(components.begin(), split.begin(), split.end());
+}
+
+class PathResolver {
+public:
+    ~PathResolver() {
+        if (dirFd != -1) close(dirFd);
+    }
+
+    int resolve(const char* path, std::string& result) {
+        if (path == NULL || path[0] != '/') return EINVAL;
+
+        // Normalize the path and remember where each of its components end
+        std::string normalized = "/";
+        std::vector<size_t> prefixEnds;
+        bool hasParentComponents = false;
+        std::deque<Component> components;
+        splitComponents(path, -1, components);
+        for (size_t i = 0; i < components.size(); i++) {
+            components[i].prefixIndex = static_cast<int>(i);
+            appendComponent(normalized, components[i].name);
+            prefixEnds.push_back(normalized.size());
+            if (components[i].name == "..") hasParentComponents = true;
+        }
+
+        pthread_mutex_lock(&cacheLock);
+        uint64_t generation = cacheGeneration;
+        pthread_mutex_unlock(&cacheLock);
+
+        // The cache is keyed by the paths as given, and a ".." may refer to the parent of a
+        // symlink target instead, so only paths without them are cached
+        bool useCache = !hasParentComponents;
+
+        // Start from the closest cached parent directory
+        resolved = "/";
+        if (useCache) {
+            for (size_t i = components.size() - (components.empty() ? 0 : 1); i > 0; i--) {
+                std::string prefix = normalized.substr(0, prefixEnds[i - 1]);
+                CachedDirectory directory;
+                if (!getCachedDirectory(prefix, directory)) continue;
+                if (!isCachedDirectoryValid(directory)) {
+                    removeCachedDirectory(prefix);
+                    break;
+                }
+                resolved = directory.canonicalPath;
+                components.erase(components.begin(), components.begin() + i);
+                break;
+            }
+        }
+
+        std::vector<CachedDirectory> resolvedDirectories;
+        size_t remainingNames = components.size();
+        int symlinkFollows = 0;
+        // Whether a component did not exist and the rest are only normalized
+        bool unresolved = false;
+
+        while (!components.empty()) {
+            Component component = std::move(components.front());
+            components.pop_front();
+
+            if (!component.name.empty()) {
+                remainingNames--;
+                if (unresolved) {
+                    if (component.name == "..")
+                        removeLastComponent(resolved);
+                    else
+                        appendComponent(resolved, component.name);
+                    continue;
+                }
+
+                if (component.name == "..") {
+                    // The resolved path has no symlinks, so its parent is the parent directory
+                    removeLastComponent(resolved);
+                    closeDirFd();
+                } else {
+                    std::string target;
+                    int result = resolveComponent(component.name, remainingNames == 0, target);
+                    if (result == RESOLVED_SYMLINK) {
+                        if (++symlinkFollows > MAX_SYMLINK_FOLLOWS) return ELOOP;
+                        if (target[0] == '/') {
+                            resolved = "/";
+                            closeDirFd();
+                        }
+                        size_t count = components.size();
+                        splitComponents(target, component.prefixIndex, components);
+                        for (size_t i = 0; i < components.size() - count; i++)
+                            if (!components[i].name.empty()) remainingNames++;
+                        continue;
+                    } else if (result == RESOLVED_NOT_FOUND) {
+                        appendComponent(resolved, component.name);
+                        unresolved = true;
+                        continue;
+                    }
+                }
+            }
+
+            // Cache the directories of the original path once they have been resolved
+            if (useCache && !unresolved && component.prefixIndex >= 0 &&
+                static_cast<size_t>(component.prefixIndex) + 1 < prefixEnds.size()) {
+                struct stat sb;
+                if ((dirFd != -1 ? fstat(dirFd, &sb) : stat(resolved.c_str(), &sb)) == 0 && S_ISDIR(sb.st_mode))
+                    resolvedDirectories.push_back({normalized.substr(0, prefixEnds[component.prefixIndex]), resolved, sb.st_dev, sb.st_ino});
+            }
+        }
+
+        if (!resolvedDirectories.empty())
+            addCachedDirectories(resolvedDirectories, generation);
+
+        result = resolved;
+        return 0;
+    }
+
+private:
+    enum {
+        RESOLVED,
+        RESOLVED_SYMLINK,
+        RESOLVED_NOT_FOUND
+    };
+
+    // The canonical path resolved so far
+    std::string resolved;
+    // An O_PATH fd for the resolved directory, or -1 if it has not been opened yet
+    int dirFd = -1;
+
+    void closeDirFd() {
+        if (dirFd != -1) {
+            close(dirFd);
+            dirFd = -1;
+        }
+    }
+
+    /*
+     * Resolve the name in the resolved directory. Directories that are not the last component are
+     * opened so that the next component is resolved relative to them, which fails for symlinks
+     * because of O_NOFOLLOW, and only then is the symlink read.
+     */
+    int resolveComponent(const std::string& name, bool isLast, std::string& target) {
+        int atFd = dirFd;
+        std::string atPath = name;
+        if (atFd == -1) {
+            atFd = AT_FDCWD;
+            atPath = resolved;
+            appendComponent(atPath, name);
+        }
+
+        if (!isLast) {
+            int fd = openat(atFd, atPath.c_str(), O_PATH | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            if (fd != -1) {
+                closeDirFd();
+                dirFd = fd;
+                appendComponent(resolved, name);
+                return RESOLVED;
+            }
+            if (errno != ENOTDIR && errno != ELOOP) return RESOLVED_NOT_FOUND;
+        } else {
+            struct stat sb;
+            if (fstatat(atFd, atPath.c_str(), &sb, AT_SYMLINK_NOFOLLOW) == -1) return RESOLVED_NOT_FOUND;
+            if (!S_ISLNK(sb.st_mode)) {
+                appendComponent(resolved, name);
+                return RESOLVED;
+            }
+        }
+
+        if (!readlinkat(atFd, atPath.c_str(), target) || target.empty()) return RESOLVED_NOT_FOUND;
+        return RESOLVED_SYMLINK;
+    }
+};
+
+}
+
+int canonicalizePath(const char* path, std::string& result) {
+    PathResolver resolver;
+    return resolver.resolve(path, result);
+}
+
+void invalidateCanonicalPathCache() {
+    pthread_mutex_lock(&cacheLock);
+    cacheGeneration++;
+    cacheList.clear();
+    cacheMap.clear();
+    pthread_mutex_unlock(&cacheLock);
+}
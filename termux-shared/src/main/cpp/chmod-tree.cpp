@@ -0,0 +1,140 @@
+#include "include/chmod_tree.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+namespace {
+
+struct linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+class TreeChmodder {
+public:
+    TreeChmodder(const ChmodTreeOptions& options, ChmodTreeResult& result) : options(options), result(result) {}
+
+    int run(const char* rootPath) {
+        struct stat sb;
+        if (fstatat(AT_FDCWD, rootPath, &sb, AT_SYMLINK_NOFOLLOW) == -1) return errno;
+
+        if (!fixMode(AT_FDCWD, rootPath, "", sb) || !S_ISDIR(sb.st_mode) || !options.recursive)
+            return 0;
+
+        int fd = openat(AT_FDCWD, rootPath, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (fd == -1) {
+            addEntry("", sb.st_mode, sb.st_mode, errno);
+            return 0;
+        }
+        fixDirectory(fd, "");
+        close(fd);
+        return 0;
+    }
+
+private:
+    const ChmodTreeOptions& options;
+    ChmodTreeResult& result;
+    // The buffer for getdents64(), shared by all directories since their entries are read
+    // completely before descending into subdirectories
+    std::vector<char> direntBuffer = std::vector<char>(32 * 1024);
+
+    static std::string getPath(const std::string& dirPath, const char* name) {
+        return dirPath.empty() ? name : dirPath + "/" + name;
+    }
+
+    void addEntry(const std::string& path, mode_t oldMode, mode_t newMode, int error) {
+        if (error != 0)
+            result.failedCount++;
+        if (result.entries.size() < options.maxEntries)
+            result.entries.push_back({path, static_cast<uint32_t>(oldMode & 07777), static_cast<uint32_t>(newMode & 07777), error});
+    }
+
+    /*
+     * Change the mode of the regular file or directory if needed. Returns false if changing it
+     * failed, in which case a directory is not descended into.
+     */
+    bool fixMode(int dirFd, const char* name, const std::string& path, const struct stat& sb) {
+        mode_t addMode;
+        mode_t removeMode;
+        if (S_ISREG(sb.st_mode)) {
+            addMode = options.fileAddMode;
+            removeMode = options.fileRemoveMode;
+        } else if (S_ISDIR(sb.st_mode)) {
+            addMode = options.dirAddMode;
+            removeMode = options.dirRemoveMode;
+        } else {
+            return true;
+        }
+
+        result.checkedCount++;
+        mode_t oldMode = sb.st_mode & 07777;
+        mode_t newMode = (oldMode | addMode) & ~removeMode & 07777;
+        if (newMode == oldMode) return true;
+
+        if (!options.checkOnly && fchmodat(dirFd, name, newMode, 0) == -1) {
+            addEntry(path, oldMode, newMode, errno);
+            return false;
+        }
+
+        result.changedCount++;
+        addEntry(path, oldMode, newMode, 0);
+        return true;
+    }
+
+    void fixDirectory(int dirFd, const std::string& dirPath) {
+        std::vector<std::string> names;
+        for (;;) {
+            long n = syscall(__NR_getdents64, dirFd, direntBuffer.data(), direntBuffer.size());
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                addEntry(dirPath, 0, 0, errno);
+                break;
+            }
+            if (n == 0) break;
+
+            for (long pos = 0; pos < n;) {
+                struct linux_dirent64* d = reinterpret_cast<struct linux_dirent64*>(direntBuffer.data() + pos);
+                pos += d->d_reclen;
+                if (strcmp(d->d_name, ".") == 0 || strcmp(d->d_name, "..") == 0) continue;
+                // Only regular files, directories and files of unknown type may need to be changed
+                if (d->d_type != DT_REG && d->d_type != DT_DIR && d->d_type != DT_UNKNOWN) continue;
+                names.push_back(d->d_name);
+            }
+        }
+
+        for (const std::string& name : names) {
+            std::string path = getPath(dirPath, name.c_str());
+            struct stat sb;
+            if (fstatat(dirFd, name.c_str(), &sb, AT_SYMLINK_NOFOLLOW) == -1) {
+                if (errno != ENOENT)
+                    addEntry(path, 0, 0, errno);
+                continue;
+            }
+
+            if (!fixMode(dirFd, name.c_str(), path, sb) || !S_ISDIR(sb.st_mode)) continue;
+
+            int fd = openat(dirFd, name.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            if (fd == -1) {
+                addEntry(path, sb.st_mode, sb.st_mode, errno);
+                continue;
+            }
+            fixDirectory(fd, path);
+            close(fd);
+        }
+    }
+};
+
+}
+
+int chmodTree(const char* rootPath, const ChmodTreeOptions& options, ChmodTreeResult& result) {
+    TreeChmodder chmodder(options, result);
+    return chmodder.run(rootPath);
+}
@@ -0,0 +1,496 @@
+#include "include/copy_tree.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#if defined(__ANDROID__)
+#include <android/api-level.h>
+#endif
+
+#ifndef FICLONE
+#define FICLONE _IOW(0x94, 9, int)
+#endif
+
+namespace {
+
+// The buffer size for the read() and write() fallback
+const size_t READ_WRITE_BUFFER_SIZE = 256 * 1024;
+
+// The max bytes to copy with each copy_file_range() and sendfile() call, so that progress is
+// updated and cancellation is checked between calls for large files
+const size_t COPY_CHUNK_SIZE = 16 * 1024 * 1024;
+
+// Whether copy_file_range() can be used. It is 1 if it can, 0 if it cannot and -1 if not yet
+// checked. Before Android 11, copy_file_range() is not allowed by the seccomp filter of app
+// processes and calling it would kill the process with SIGSYS, so do not even try.
+volatile int copyFileRangeSupported = -1;
+
+bool isCopyFileRangeSupported() {
+    int supported = __atomic_load_n(&copyFileRangeSupported, __ATOMIC_RELAXED);
+    if (supported < 0) {
+#if !defined(__NR_copy_file_range)
+        supported = 0;
+#elif defined(__ANDROID__)
+        supported = android_get_device_api_level() >= 30 ? 1 : 0;
+#else
+        supported = 1;
+#endif
+        __atomic_store_n(&copyFileRangeSupported, supported, __ATOMIC_RELAXED);
+    }
+    return supported == 1;
+}
+
+// Whether the errno of a failed copy call means the method is not supported for the files and
+// the next one should be tried, as long as nothing was copied yet.
+bool isCopyMethodUnsupported(int error) {
+    return error == ENOSYS || error == EOPNOTSUPP || error == ENOTTY || error == EXDEV ||
+           error == EINVAL || error == EBADF || error == EPERM;
+}
+
+// readlinkat(), symlinkat() and mknodat() are only available in bionic from api 21, so call the
+// syscalls directly
+ssize_t sysReadlinkat(int dirFd, const char* path, char* buf, size_t bufSize) {
+    return static_cast<ssize_t>(syscall(__NR_readlinkat, dirFd, path, buf, bufSize));
+}
+
+int sysSymlinkat(const char* target, int dirFd, const char* path) {
+    return static_cast<int>(syscall(__NR_symlinkat, target, dirFd, path));
+}
+
+int sysMknodat(int dirFd, const char* path, mode_t mode, dev_t dev) {
+    return static_cast<int>(syscall(__NR_mknodat, dirFd, path, mode, dev));
+}
+
+}
+
+int copyFileData(int srcFd, int destFd, uint64_t& copiedBytes, CopyMethod& method) {
+    copiedBytes = 0;
+
+    // A reflink only works for the whole file and from offset 0
+    method = COPY_METHOD_CLONE;
+    if (lseek(srcFd, 0, SEEK_CUR) == 0 && lseek(destFd, 0, SEEK_CUR) == 0 &&
+        ioctl(destFd, FICLONE, srcFd) == 0) {
+        struct stat sb;
+        if (fstat(destFd, &sb) == 0) copiedBytes = static_cast<uint64_t>(sb.st_size);
+        return 0;
+    }
+
+#if defined(__NR_copy_file_range)
+    if (isCopyFileRangeSupported()) {
+        method = COPY_METHOD_COPY_FILE_RANGE;
+        for (;;) {
+            long n = syscall(__NR_copy_file_range, srcFd, NULL, destFd, NULL, COPY_CHUNK_SIZE, 0);
+            if (n > 0) {
+                copiedBytes += static_cast<uint64_t>(n);
+                continue;
+            }
+            if (n == 0) return 0;
+            if (errno == EINTR) continue;
+            if (errno == ENOSYS)
+                __atomic_store_n(&copyFileRangeSupported, 0, __ATOMIC_RELAXED);
+            if (copiedBytes > 0 || !isCopyMethodUnsupported(errno)) return errno;
+            break;
+        }
+    }
+#endif
+
+    method = COPY_METHOD_SENDFILE;
+    for (;;) {
+        ssize_t n = sendfile(destFd, srcFd, NULL, COPY_CHUNK_SIZE);
+        if (n > 0) {
+            copiedBytes += static_cast<uint64_t>(n);
+            continue;
+        }
+        if (n == 0) return 0;
+        if (errno == EINTR) continue;
+        if (copiedBytes > 0 || !isCopyMethodUnsupported(errno)) return errno;
+        break;
+    }
+
+    method = COPY_METHOD_READ_WRITE;
+    std::vector<char> buf(READ_WRITE_BUFFER_SIZE);
+    for (;;) {
+        ssize_t n = read(srcFd, buf.data(), buf.size());
+        if (n == 0) return 0;
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            return errno;
+        }
+        for (ssize_t written = 0; written < n;) {
+            ssize_t w = write(destFd, buf.data() + written, static_cast<size_t>(n - written));
+            if (w == -1) {
+                if (errno == EINTR) continue;
+                return errno;
+            }
+            written += w;
+        }
+        copiedBytes += static_cast<uint64_t>(n);
+    }
+}
+
+namespace {
+
+struct linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+struct Directory {
+    Directory* parent;
+    // The name in the parent directory, empty for the root directory
+    std::string name;
+    int srcFd = -1;
+    int destFd = -1;
+    struct stat sb;
+    // One for reading the entries of the directory and one for each entry not yet copied
+    std::atomic<int> pending{1};
+
+    Directory(Directory* parent, std::string name) : parent(parent), name(std::move(name)) {}
+};
+
+// An entry of a directory to copy
+struct Entry {
+    Directory* parent;
+    std::string name;
+};
+
+class TreeCopier {
+public:
+    TreeCopier(size_t maxErrors, CopyTreeResult& result) : maxErrors(maxErrors), result(result) {}
+
+    ~TreeCopier() {
+        pthread_cond_destroy(&workAvailable);
+        pthread_cond_destroy(&finishedCond);
+        pthread_mutex_destroy(&errorsLock);
+        pthread_mutex_destroy(&lock);
+    }
+
+    int run(const char* srcPath, const char* destPath, int threadCount, long progressIntervalMillis,
+            const CopyTreeProgressCallback& progressCallback) {
+        struct stat sb;
+        if (lstat(srcPath, &sb) == -1) return errno;
+
+        if (!S_ISDIR(sb.st_mode)) {
+            // Copy a single file on the calling thread
+            int error = copyEntry(AT_FDCWD, srcPath, AT_FDCWD, destPath, sb);
+            if (error == 0) result.copiedCount++;
+            return error;
+        }
+
+        Directory* root = new Directory(NULL, "");
+        root->sb = sb;
+        int error = openDirectory(AT_FDCWD, srcPath, AT_FDCWD, destPath, root);
+        if (error != 0) {
+            delete root;
+            return error;
+        }
+
+        // Do not copy the destination directory into itself if it is under the source directory
+        struct stat destSb;
+        if (fstat(root->destFd, &destSb) == 0) {
+            destDev = destSb.st_dev;
+            destIno = destSb.st_ino;
+        }
+
+        std::vector<pthread_t> threads;
+        for (int i = 0; i < threadCount; i++) {
+            pthread_t thread;
+            if (pthread_create(&thread, NULL, workerMain, this) != 0)
+                break;
+            threads.push_back(thread);
+        }
+
+        readDirectory(root);
+
+        // If no thread could be started, then copy on the calling thread
+        if (threads.empty())
+            worker();
+
+        pthread_mutex_lock(&lock);
+        while (!finished) {
+            if (!progressCallback || progressIntervalMillis <= 0) {
+                pthread_cond_wait(&finishedCond, &lock);
+                continue;
+            }
+
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += progressIntervalMillis / 1000;
+            deadline.tv_nsec += (progressIntervalMillis % 1000) * 1000000;
+            if (deadline.tv_nsec >= 1000000000) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000;
+            }
+            pthread_cond_timedwait(&finishedCond, &lock, &deadline);
+            if (finished) break;
+
+            pthread_mutex_unlock(&lock);
+            bool cont = progressCallback(result.copiedCount.load(), result.copiedBytes.load(), result.failedCount.load());
+            pthread_mutex_lock(&lock);
+            if (!cont) cancelled = true;
+        }
+        pthread_mutex_unlock(&lock);
+
+        for (pthread_t thread : threads)
+            pthread_join(thread, NULL);
+
+        result.cancelled = cancelled;
+        return 0;
+    }
+
+private:
+    const size_t maxErrors;
+    CopyTreeResult& result;
+
+    dev_t destDev = 0;
+    ino_t destIno = 0;
+
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t workAvailable = PTHREAD_COND_INITIALIZER;
+    pthread_cond_t finishedCond = PTHREAD_COND_INITIALIZER;
+    // The entries to copy. This is used as a stack so that directories are copied depth first,
+    // which limits the number of directory fds kept open by unfinished directories.
+    std::vector<Entry> stack;
+    bool finished = false;
+    std::atomic<bool> cancelled{false};
+
+    pthread_mutex_t errorsLock = PTHREAD_MUTEX_INITIALIZER;
+
+    static void* workerMain(void* arg) {
+        static_cast<TreeCopier*>(arg)->worker();
+        return NULL;
+    }
+
+    void worker() {
+        for (;;) {
+            pthread_mutex_lock(&lock);
+            while (stack.empty() && !finished)
+                pthread_cond_wait(&workAvailable, &lock);
+            if (stack.empty()) {
+                pthread_mutex_unlock(&lock);
+                return;
+            }
+            Entry entry = std::move(stack.back());
+            stack.pop_back();
+            pthread_mutex_unlock(&lock);
+
+            processEntry(entry);
+        }
+    }
+
+    static std::string getPath(const Directory* dir, const std::string& name) {
+        std::string path = name;
+        for (; dir != NULL && dir->parent != NULL; dir = dir->parent)
+            path = path.empty() ? dir->name : dir->name + "/" + path;
+        return path;
+    }
+
+    void addError(const Directory* dir, const std::string& name, int error) {
+        result.failedCount++;
+        pthread_mutex_lock(&errorsLock);
+        if (result.errors.size() < maxErrors)
+            result.errors.push_back({getPath(dir, name), error});
+        pthread_mutex_unlock(&errorsLock);
+    }
+
+    static void setTimes(int dirFd, const char* name, const struct stat& sb) {
+        struct timespec times[2] = {sb.st_atim, sb.st_mtim};
+        utimensat(dirFd, name, times, AT_SYMLINK_NOFOLLOW);
+    }
+
+    /*
+     * Copy a non-directory file. The mode and times are set on the destination file itself,
+     * so that they are not changed by the copy.
+     */
+    int copyEntry(int srcDirFd, const char* srcName, int destDirFd, const char* destName, const struct stat& sb) {
+        if (S_ISREG(sb.st_mode)) {
+            int srcFd = openat(srcDirFd, srcName, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+            if (srcFd == -1) return errno;
+            int destFd = openat(destDirFd, destName, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC, 0600);
+            if (destFd == -1) {
+                int error = errno;
+                close(srcFd);
+                return error;
+            }
+
+            uint64_t copiedBytes;
+            CopyMethod method;
+            int error = copyFileData(srcFd, destFd, copiedBytes, method);
+            close(srcFd);
+            result.copiedBytes += copiedBytes;
+            if (error == 0) {
+                result.methodCounts[method]++;
+                fchmod(destFd, sb.st_mode & 07777);
+                struct timespec times[2] = {sb.st_atim, sb.st_mtim};
+                futimens(destFd, times);
+            }
+            if (close(destFd) == -1 && error == 0) error = errno;
+            return error;
+        } else if (S_ISLNK(sb.st_mode)) {
+            std::vector<char> target(sb.st_size > 0 ? static_cast<size_t>(sb.st_size) + 1 : PATH_MAX);
+            ssize_t length = sysReadlinkat(srcDirFd, srcName, target.data(), target.size());
+            if (length == -1) return errno;
+            if (static_cast<size_t>(length) == target.size()) return ENAMETOOLONG;
+            target[static_cast<size_t>(length)] = '\0';
+
+            if (sysSymlinkat(target.data(), destDirFd, destName) == -1) {
+                if (errno != EEXIST) return errno;
+                if (unlinkat(destDirFd, destName, 0) == -1 || sysSymlinkat(target.data(), destDirFd, destName) == -1)
+                    return errno;
+            }
+            setTimes(destDirFd, destName, sb);
+            return 0;
+        } else if (S_ISFIFO(sb.st_mode) || S_ISSOCK(sb.st_mode)) {
+            if (sysMknodat(destDirFd, destName, (sb.st_mode & S_IFMT) | (sb.st_mode & 07777), 0) == -1)
+                return errno;
+            setTimes(destDirFd, destName, sb);
+            return 0;
+        } else {
+            // Device files cannot be created by apps
+            return EOPNOTSUPP;
+        }
+    }
+
+    int openDirectory(int srcDirFd, const char* srcName, int destDirFd, const char* destName, Directory* dir) {
+        dir->srcFd = openat(srcDirFd, srcName, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (dir->srcFd == -1) return errno;
+
+        // Create the directory only accessible by the owner until its contents are copied
+        if (mkdirat(destDirFd, destName, 0700) == -1 && errno != EEXIST) {
+            int error = errno;
+            close(dir->srcFd);
+            return error;
+        }
+        dir->destFd = openat(destDirFd, destName, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (dir->destFd == -1) {
+            int error = errno;
+            close(dir->srcFd);
+            return error;
+        }
+        return 0;
+    }
+
+    void readDirectory(Directory* dir) {
+        std::vector<Entry> entries;
+        std::vector<char> buf(32 * 1024);
+        for (;;) {
+            long n = syscall(__NR_getdents64, dir->srcFd, buf.data(), buf.size());
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                addError(dir, "", errno);
+                break;
+            }
+            if (n == 0) break;
+
+            for (long pos = 0; pos < n;) {
+                struct linux_dirent64* d = reinterpret_cast<struct linux_dirent64*>(buf.data() + pos);
+                pos += d->d_reclen;
+                if (strcmp(d->d_name, ".") == 0 || strcmp(d->d_name, "..") == 0) continue;
+                entries.push_back({dir, d->d_name});
+            }
+        }
+
+        if (!entries.empty() && !cancelled) {
+            dir->pending += static_cast<int>(entries.size());
+            pthread_mutex_lock(&lock);
+            stack.insert(stack.end(), std::make_move_iterator(entries.begin()), std::make_move_iterator(entries.end()));
+            if (entries.size() > 1)
+                pthread_cond_broadcast(&workAvailable);
+            else
+                pthread_cond_signal(&workAvailable);
+            pthread_mutex_unlock(&lock);
+        }
+
+        releaseDirectory(dir);
+    }
+
+    void processEntry(const Entry& entry) {
+        Directory* parent = entry.parent;
+        const char* name = entry.name.c_str();
+
+        struct stat sb;
+        if (cancelled) {
+            // Nothing to do
+        } else if (fstatat(parent->srcFd, name, &sb, AT_SYMLINK_NOFOLLOW) == -1) {
+            if (errno != ENOENT)
+                addError(parent, entry.name, errno);
+        } else if (S_ISDIR(sb.st_mode)) {
+            if (sb.st_dev == destDev && sb.st_ino == destIno) {
+                releaseDirectory(parent);
+                return;
+            }
+
+            Directory* dir = new Directory(parent, entry.name);
+            dir->sb = sb;
+            int error = openDirectory(parent->srcFd, name, parent->destFd, name, dir);
+            if (error != 0) {
+                addError(parent, entry.name, error);
+                delete dir;
+            } else {
+                // The parent is released once the directory is finished
+                readDirectory(dir);
+                return;
+            }
+        } else {
+            int error = copyEntry(parent->srcFd, name, parent->destFd, name, sb);
+            if (error == 0)
+                result.copiedCount++;
+            else
+                addError(parent, entry.name, error);
+        }
+
+        releaseDirectory(parent);
+    }
+
+    // Release one pending reference of the directory. Once none remain, its mode and times are
+    // set, since copying its contents would have changed them, and its parent is released.
+    void releaseDirectory(Directory* dir) {
+        while (dir != NULL && --dir->pending == 0) {
+            Directory* parent = dir->parent;
+
+            fchmod(dir->destFd, dir->sb.st_mode & 07777);
+            struct timespec times[2] = {dir->sb.st_atim, dir->sb.st_mtim};
+            futimens(dir->destFd, times);
+            close(dir->srcFd);
+            close(dir->destFd);
+            result.copiedCount++;
+
+            delete dir;
+
+            if (parent == NULL) {
+                pthread_mutex_lock(&lock);
+                finished = true;
+                pthread_cond_broadcast(&workAvailable);
+                pthread_cond_signal(&finishedCond);
+                pthread_mutex_unlock(&lock);
+                return;
+            }
+            dir = parent;
+        }
+    }
+};
+
+}
+
+int copyTree(const char* srcPath, const char* destPath, int threadCount, size_t maxErrors,
+             long progressIntervalMillis, const CopyTreeProgressCallback& progressCallback,
+             CopyTreeResult& result) {
+    TreeCopier copier(maxErrors, result);
+    return copier.run(srcPath, destPath, threadCount, progressIntervalMillis, progressCallback);
+}
@@ -0,0 +1,284 @@
+#include "include/delete_tree.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+struct linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+struct Dirent {
+    std::string name;
+    unsigned char type;
+};
+
+struct Directory {
+    Directory* parent;
+    // The name in the parent directory, empty for the root directory
+    std::string name;
+    int fd = -1;
+    // One for processing the entries of the directory and one for each subdirectory not yet done
+    std::atomic<int> pending{1};
+    // Whether anything under the directory failed to be deleted, so it cannot be removed
+    std::atomic<bool> failed{false};
+    // Whether the directory was already deleted by someone else
+    bool gone = false;
+
+    Directory(Directory* parent, std::string name) : parent(parent), name(std::move(name)) {}
+};
+
+class TreeDeleter {
+public:
+    TreeDeleter(size_t maxErrors, DeleteTreeResult& result) : maxErrors(maxErrors), result(result) {}
+
+    ~TreeDeleter() {
+        pthread_cond_destroy(&workAvailable);
+        pthread_cond_destroy(&finishedCond);
+        pthread_mutex_destroy(&errorsLock);
+        pthread_mutex_destroy(&lock);
+    }
+
+    void run(int rootFd, int threadCount, long progressIntervalMillis,
+             const DeleteTreeProgressCallback& progressCallback) {
+        Directory* root = new Directory(NULL, "");
+        root->fd = rootFd;
+        stack.push_back(root);
+
+        std::vector<pthread_t> threads;
+        for (int i = 0; i < threadCount; i++) {
+            pthread_t thread;
+            if (pthread_create(&thread, NULL, workerMain, this) != 0)
+                break;
+            threads.push_back(thread);
+        }
+
+        // If no thread could be started, then delete on the calling thread
+        if (threads.empty())
+            worker();
+
+        pthread_mutex_lock(&lock);
+        while (!finished) {
+            if (!progressCallback || progressIntervalMillis <= 0) {
+                pthread_cond_wait(&finishedCond, &lock);
+                continue;
+            }
+
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += progressIntervalMillis / 1000;
+            deadline.tv_nsec += (progressIntervalMillis % 1000) * 1000000;
+            if (deadline.tv_nsec >= 1000000000) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000;
+            }
+            pthread_cond_timedwait(&finishedCond, &lock, &deadline);
+            if (finished) break;
+
+            pthread_mutex_unlock(&lock);
+            bool cont = progressCallback(result.deletedCount.load(), result.failedCount.load());
+            pthread_mutex_lock(&lock);
+            if (!cont) cancelled = true;
+        }
+        pthread_mutex_unlock(&lock);
+
+        for (pthread_t thread : threads)
+            pthread_join(thread, NULL);
+
+        delete root;
+        result.cancelled = cancelled;
+    }
+
+private:
+    const size_t maxErrors;
+    DeleteTreeResult& result;
+
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t workAvailable = PTHREAD_COND_INITIALIZER;
+    pthread_cond_t finishedCond = PTHREAD_COND_INITIALIZER;
+    // The directories to process. This is used as a stack so that directories are processed
+    // depth first, which limits the number of directory fds kept open by unfinished directories.
+    std::vector<Directory*> stack;
+    bool finished = false;
+    std::atomic<bool> cancelled{false};
+
+    pthread_mutex_t errorsLock = PTHREAD_MUTEX_INITIALIZER;
+
+    static void* workerMain(void* arg) {
+        static_cast<TreeDeleter*>(arg)->worker();
+        return NULL;
+    }
+
+    void worker() {
+        std::vector<char> buf(64 * 1024);
+        std::vector<Dirent> dirents;
+        for (;;) {
+            pthread_mutex_lock(&lock);
+            while (stack.empty() && !finished)
+                pthread_cond_wait(&workAvailable, &lock);
+            if (stack.empty()) {
+                pthread_mutex_unlock(&lock);
+                return;
+            }
+            Directory* dir = stack.back();
+            stack.pop_back();
+            pthread_mutex_unlock(&lock);
+
+            processDirectory(dir, buf, dirents);
+        }
+    }
+
+    static std::string getPath(const Directory* dir, const std::string& name) {
+        std::string path = name;
+        for (; dir != NULL && dir->parent != NULL; dir = dir->parent)
+            path = path.empty() ? dir->name : dir->name + "/" + path;
+        return path;
+    }
+
+    void addError(const Directory* dir, const std::string& name, int error) {
+        result.failedCount++;
+        pthread_mutex_lock(&errorsLock);
+        if (result.errors.size() < maxErrors)
+            result.errors.push_back({getPath(dir, name), error});
+        pthread_mutex_unlock(&errorsLock);
+    }
+
+    // Read all entries of the directory before deleting any of them, since deleting entries
+    // while reading the directory may cause other entries to be skipped.
+    static int readDirents(int fd, std::vector<char>& buf, std::vector<Dirent>& dirents) {
+        for (;;) {
+            long n = syscall(__NR_getdents64, fd, buf.data(), buf.size());
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                return errno;
+            }
+            if (n == 0) return 0;
+
+            for (long pos = 0; pos < n;) {
+                struct linux_dirent64* d = reinterpret_cast<struct linux_dirent64*>(buf.data() + pos);
+                pos += d->d_reclen;
+                if (strcmp(d->d_name, ".") == 0 || strcmp(d->d_name, "..") == 0) continue;
+                dirents.push_back({d->d_name, d->d_type});
+            }
+        }
+    }
+
+    void processDirectory(Directory* dir, std::vector<char>& buf, std::vector<Dirent>& dirents) {
+        if (cancelled) {
+            releaseDirectory(dir);
+            return;
+        }
+
+        if (dir->fd == -1) {
+            dir->fd = openat(dir->parent->fd, dir->name.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            if (dir->fd == -1) {
+                if (errno == ENOENT) {
+                    dir->gone = true;
+                } else {
+                    addError(dir->parent, dir->name, errno);
+                    dir->failed = true;
+                }
+                releaseDirectory(dir);
+                return;
+            }
+        }
+
+        dirents.clear();
+        int error = readDirents(dir->fd, buf, dirents);
+        if (error != 0) {
+            addError(dir, "", error);
+            dir->failed = true;
+        }
+
+        std::vector<Directory*> subDirs;
+        for (const Dirent& dirent : dirents) {
+            if (cancelled) break;
+
+            if (dirent.type != DT_DIR) {
+                if (unlinkat(dir->fd, dirent.name.c_str(), 0) == 0) {
+                    result.deletedCount++;
+                    continue;
+                } else if (errno == ENOENT) {
+                    continue;
+                } else if (errno != EISDIR || dirent.type != DT_UNKNOWN) {
+                    addError(dir, dirent.name, errno);
+                    dir->failed = true;
+                    continue;
+                }
+                // A directory whose type was not known from the entry
+            }
+
+            subDirs.push_back(new Directory(dir, dirent.name));
+        }
+
+        if (!subDirs.empty()) {
+            dir->pending += static_cast<int>(subDirs.size());
+            pthread_mutex_lock(&lock);
+            stack.insert(stack.end(), subDirs.begin(), subDirs.end());
+            if (subDirs.size() > 1)
+                pthread_cond_broadcast(&workAvailable);
+            else
+                pthread_cond_signal(&workAvailable);
+            pthread_mutex_unlock(&lock);
+        }
+
+        releaseDirectory(dir);
+    }
+
+    // Release one pending reference of the directory. Once none remain, it is removed from its
+    // parent, which is then released as well.
+    void releaseDirectory(Directory* dir) {
+        while (dir != NULL && --dir->pending == 0) {
+            Directory* parent = dir->parent;
+            if (parent == NULL) {
+                // The root directory fd is owned by the caller
+                pthread_mutex_lock(&lock);
+                finished = true;
+                pthread_cond_broadcast(&workAvailable);
+                pthread_cond_signal(&finishedCond);
+                pthread_mutex_unlock(&lock);
+                return;
+            }
+
+            if (dir->fd != -1)
+                close(dir->fd);
+
+            if (!dir->failed && !dir->gone && !cancelled) {
+                if (unlinkat(parent->fd, dir->name.c_str(), AT_REMOVEDIR) == 0) {
+                    result.deletedCount++;
+                } else if (errno != ENOENT) {
+                    addError(parent, dir->name, errno);
+                    dir->failed = true;
+                }
+            }
+
+            if (dir->failed)
+                parent->failed = true;
+
+            delete dir;
+            dir = parent;
+        }
+    }
+};
+
+}
+
+void deleteTree(int rootFd, int threadCount, size_t maxErrors, long progressIntervalMillis,
+                const DeleteTreeProgressCallback& progressCallback, DeleteTreeResult& result) {
+    TreeDeleter deleter(maxErrors, result);
+    deleter.run(rootFd, threadCount, progressIntervalMillis, progressCallback);
+}
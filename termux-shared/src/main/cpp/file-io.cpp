@@ -0,0 +1,168 @@
+#include "include/file_io.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <atomic>
+
+namespace {
+
+// The counter for unique temp file names of the process
+std::atomic<unsigned int> tempFileCounter(0);
+
+// The max number of temp file names to try if they already exist
+const int MAX_TEMP_FILE_ATTEMPTS = 100;
+
+}
+
+int mapFile(const char* path, size_t maxSize, MappedFile& result) {
+    result = MappedFile();
+
+    int fd = TEMP_FAILURE_RETRY(open(path, O_RDONLY | O_CLOEXEC));
+    if (fd == -1) return errno;
+
+    struct stat sb;
+    if (fstat(fd, &sb) == -1) {
+        int error = errno;
+        close(fd);
+        return error;
+    }
+    if (!S_ISREG(sb.st_mode)) {
+        close(fd);
+        return EINVAL;
+    }
+    if (static_cast<uint64_t>(sb.st_size) > maxSize) {
+        close(fd);
+        return EFBIG;
+    }
+    if (sb.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    void* address = mmap(NULL, static_cast<size_t>(sb.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    int error = errno;
+    // The mapping keeps its own reference to the file
+    close(fd);
+    if (address == MAP_FAILED) return error;
+
+    // Files are normally read from start to end, so read ahead aggressively
+    madvise(address, static_cast<size_t>(sb.st_size), MADV_SEQUENTIAL);
+
+    result.address = address;
+    result.size = static_cast<size_t>(sb.st_size);
+    return 0;
+}
+
+void unmapFile(MappedFile& mappedFile) {
+    if (mappedFile.address != nullptr)
+        munmap(mappedFile.address, mappedFile.size);
+    mappedFile = MappedFile();
+}
+
+AtomicFile::~AtomicFile() {
+    abort();
+}
+
+int AtomicFile::begin(const char* path, mode_t mode) {
+    abort();
+
+    std::string filePath(path);
+    size_t slash = filePath.rfind('/');
+    std::string dirPath = slash == std::string::npos ? "." : (slash == 0 ? "/" : filePath.substr(0, slash));
+    name = slash == std::string::npos ? filePath : filePath.substr(slash + 1);
+    if (name.empty()) return EISDIR;
+
+    dirFd = TEMP_FAILURE_RETRY(open(dirPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (dirFd == -1) return errno;
+
+    struct stat sb;
+    if (fstatat(dirFd, name.c_str(), &sb, AT_SYMLINK_NOFOLLOW) == 0) {
+        if (!S_ISREG(sb.st_mode)) {
+            abort();
+            return EINVAL;
+        }
+        existingMode = static_cast<int>(sb.st_mode & 07777);
+    } else if (errno != ENOENT) {
+        int error = errno;
+        abort();
+        return error;
+    }
+
+    for (int attempt = 0; attempt < MAX_TEMP_FILE_ATTEMPTS; attempt++) {
+        tempName = "." + name + "." + std::to_string(getpid()) + "-" + std::to_string(tempFileCounter++) + ".tmp";
+        fd = TEMP_FAILURE_RETRY(openat(dirFd, tempName.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+                                       existingMode == -1 ? mode : 0600));
+        if (fd != -1 || errno != EEXIST) break;
+    }
+    if (fd == -1) {
+        int error = errno;
+        tempName.clear();
+        abort();
+        return error;
+    }
+
+    if (existingMode != -1 && fchmod(fd, static_cast<mode_t>(existingMode)) == -1) {
+        int error = errno;
+        abort();
+        return error;
+    }
+    return 0;
+}
+
+int AtomicFile::write(const void* data, size_t size) {
+    if (fd == -1) return EBADF;
+
+    const char* pos = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t written = TEMP_FAILURE_RETRY(::write(fd, pos, size));
+        if (written == -1) return errno;
+        pos += written;
+        size -= static_cast<size_t>(written);
+    }
+    return 0;
+}
+
+int AtomicFile::commit(bool sync) {
+    if (fd == -1) return EBADF;
+
+    int error = 0;
+    if (sync && fsync(fd) == -1)
+        error = errno;
+    if (close(fd) == -1 && error == 0)
+        error = errno;
+    fd = -1;
+    if (error == 0 && renameat(dirFd, tempName.c_str(), dirFd, name.c_str()) == -1)
+        error = errno;
+    if (error != 0) {
+        abort();
+        return error;
+    }
+    tempName.clear();
+
+    // The rename is only durable once the directory is synced. Some filesystems do not support
+    // syncing directories, which is not a failure of the write.
+    if (sync && fsync(dirFd) == -1 && errno != EINVAL && errno != EROFS)
+        error = errno;
+    abort();
+    return error;
+}
+
+void AtomicFile::abort() {
+    if (fd != -1) {
+        close(fd);
+        fd = -1;
+    }
+    if (!tempName.empty()) {
+        unlinkat(dirFd, tempName.c_str(), 0);
+        tempName.clear();
+    }
+    if (dirFd != -1) {
+        close(dirFd);
+        dirFd = -1;
+    }
+    existingMode = -1;
+}
@@ -0,0 +1,212 @@
+#include "include/file_watcher.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+
+#include <algorithm>
+
+namespace {
+
+// The events of the watched directories that may change a file in them
+const uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                            IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+// The max time to wait for changes to stop after the first one, as a multiple of the debounce
+// time, so that a file that is written continuously is still reported
+const long MAX_DEBOUNCE_FACTOR = 5;
+
+std::string getParentPath(const std::string& path) {
+    size_t slash = path.rfind('/');
+    return slash == 0 || slash == std::string::npos ? "/" : path.substr(0, slash);
+}
+
+// Whether path is under dirPath
+bool isUnderPath(const std::string& path, const std::string& dirPath) {
+    if (dirPath == "/") return path.size() > 1 && path[0] == '/';
+    return path.size() > dirPath.size() && path.compare(0, dirPath.size(), dirPath) == 0 && path[dirPath.size()] == '/';
+}
+
+void addChangedPath(std::vector<std::string>& changedPaths, const std::string& path) {
+    if (std::find(changedPaths.begin(), changedPaths.end(), path) == changedPaths.end())
+        changedPaths.push_back(path);
+}
+
+long getMonotonicMillis() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<long>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+}
+
+}
+
+FileWatcher::FileWatcher() {}
+
+FileWatcher::~FileWatcher() {
+    if (inotifyFd != -1) ::close(inotifyFd);
+    if (wakeFd != -1) ::close(wakeFd);
+    pthread_mutex_destroy(&lock);
+}
+
+int FileWatcher::init() {
+    // inotify_init1() is only available in bionic from api 21
+    inotifyFd = inotify_init();
+    if (inotifyFd == -1) return errno;
+    if (fcntl(inotifyFd, F_SETFD, FD_CLOEXEC) == -1 || fcntl(inotifyFd, F_SETFL, O_NONBLOCK) == -1)
+        return errno;
+
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wakeFd == -1) return errno;
+    return 0;
+}
+
+void FileWatcher::setPaths(const std::vector<std::string>& newPaths) {
+    pthread_mutex_lock(&lock);
+    paths = newPaths;
+    pathsChanged = true;
+    pthread_mutex_unlock(&lock);
+
+    uint64_t value = 1;
+    TEMP_FAILURE_RETRY(write(wakeFd, &value, sizeof(value)));
+}
+
+void FileWatcher::close() {
+    pthread_mutex_lock(&lock);
+    closed = true;
+    pthread_mutex_unlock(&lock);
+
+    uint64_t value = 1;
+    TEMP_FAILURE_RETRY(write(wakeFd, &value, sizeof(value)));
+}
+
+/*
+ * Watch the parent directory of each file, or its closest existing ancestor if it does not exist,
+ * and remove the watches of directories that are no longer needed.
+ */
+void FileWatcher::updateWatches() {
+    watchesChanged = false;
+
+    std::unordered_map<int, std::string> newWatchedDirs;
+    for (const std::string& path : watchedPaths) {
+        std::string dir = getParentPath(path);
+        for (;;) {
+            int wd = inotify_add_watch(inotifyFd, dir.c_str(), WATCH_MASK);
+            if (wd != -1) {
+                newWatchedDirs[wd] = dir;
+                break;
+            }
+            if ((errno != ENOENT && errno != ENOTDIR) || dir == "/") break;
+            dir = getParentPath(dir);
+        }
+    }
+
+    for (const auto& watchedDir : watchedDirs)
+        if (newWatchedDirs.find(watchedDir.first) == newWatchedDirs.end())
+            inotify_rm_watch(inotifyFd, watchedDir.first);
+    watchedDirs.swap(newWatchedDirs);
+}
+
+void FileWatcher::handleEvent(int wd, uint32_t mask, const char* name, std::vector<std::string>& changedPaths) {
+    if (mask & IN_Q_OVERFLOW) {
+        // Events were lost, so assume that everything changed
+        for (const std::string& path : watchedPaths)
+            addChangedPath(changedPaths, path);
+        watchesChanged = true;
+        return;
+    }
+
+    auto it = watchedDirs.find(wd);
+    if (it == watchedDirs.end()) return;
+    std::string dir = it->second;
+
+    if (mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) {
+        // The directory is gone, so the files in it are too. A moved directory is still watched
+        // under its new path, so remove the watch.
+        if (mask & IN_MOVE_SELF) inotify_rm_watch(inotifyFd, wd);
+        watchedDirs.erase(it);
+        for (const std::string& path : watchedPaths)
+            if (isUnderPath(path, dir))
+                addChangedPath(changedPaths, path);
+        watchesChanged = true;
+        return;
+    }
+
+    if (name == NULL || name[0] == '\0') return;
+    std::string eventPath = dir == "/" ? "/" + std::string(name) : dir + "/" + name;
+    for (const std::string& path : watchedPaths) {
+        if (path == eventPath) {
+            addChangedPath(changedPaths, path);
+        } else if (isUnderPath(path, eventPath)) {
+            // A missing parent directory was created, or a parent directory was replaced
+            addChangedPath(changedPaths, path);
+            watchesChanged = true;
+        }
+    }
+}
+
+int FileWatcher::waitForChanges(long debounceMillis, std::vector<std::string>& changedPaths) {
+    changedPaths.clear();
+    long firstChangeMillis = 0;
+    alignas(struct inotify_event) char buf[4096];
+
+    for (;;) {
+        pthread_mutex_lock(&lock);
+        if (closed) {
+            pthread_mutex_unlock(&lock);
+            return ECANCELED;
+        }
+        if (pathsChanged) {
+            watchedPaths = paths;
+            pathsChanged = false;
+            watchesChanged = true;
+        }
+        pthread_mutex_unlock(&lock);
+
+        if (watchesChanged)
+            updateWatches();
+
+        int timeout = -1;
+        if (!changedPaths.empty()) {
+            long remainingMillis = firstChangeMillis + debounceMillis * MAX_DEBOUNCE_FACTOR - getMonotonicMillis();
+            timeout = static_cast<int>(std::max(0L, std::min(debounceMillis, remainingMillis)));
+        }
+
+        struct pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {wakeFd, POLLIN, 0}};
+        int rc = poll(fds, 2, timeout);
+        if (rc == -1) {
+            if (errno == EINTR) continue;
+            return errno;
+        }
+        if (rc == 0) {
+            if (!changedPaths.empty()) return 0;
+            continue;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            uint64_t value;
+            TEMP_FAILURE_RETRY(read(wakeFd, &value, sizeof(value)));
+        }
+
+        if (fds[0].revents & POLLIN) {
+            ssize_t length = read(inotifyFd, buf, sizeof(buf));
+            if (length == -1) {
+                if (errno == EINTR || errno == EAGAIN) continue;
+                return errno;
+            }
+
+            bool hadChanges = !changedPaths.empty();
+            for (ssize_t pos = 0; pos < length;) {
+                struct inotify_event* event = reinterpret_cast<struct inotify_event*>(buf + pos);
+                pos += sizeof(struct inotify_event) + event->len;
+                handleEvent(event->wd, event->mask, event->len > 0 ? event->name : NULL, changedPaths);
+            }
+            if (!hadChanges && !changedPaths.empty())
+                firstChangeMillis = getMonotonicMillis();
+        }
+    }
+}
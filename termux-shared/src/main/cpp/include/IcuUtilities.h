@@ -13,6 +13,7 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <stdio.h>
 #include "scoped_local_ref.h"
 #include "ustrenum.h"
 #include <unicode/strenum.h>
@@ -34,7 +35,11 @@ bool maybeThrowIcuException(JNIEnv* env, const char* function, UErrorCode error)
   } else if (error == U_FORMAT_INEXACT_ERROR) {
     exceptionClass = "java/lang/ArithmeticException";
   }
-  //jniThrowExceptionFmt(env, exceptionClass, "%s failed: %s", function, u_errorName(error));
-  printf("%s\n%s failed: %s\n", exceptionClass, function, u_errorName(error));
+  char message[256];
+  snprintf(message, sizeof(message), "%s failed: %s", function, u_errorName(error));
+  ScopedLocalRef<jclass> exceptionClassRef(env, env->FindClass(exceptionClass));
+  if (exceptionClassRef.get() != nullptr) {
+    env->ThrowNew(exceptionClassRef.get(), message);
+  }
   return true;
 }
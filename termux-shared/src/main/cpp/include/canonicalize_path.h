@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+
+/*
+ * Get the canonical path of the absolute path, like java.io.File.getCanonicalPath(). All symlinks
+ * are resolved and "." and ".." components and duplicate and trailing slashes removed. The
+ * components after the first one that does not exist or cannot be accessed are not resolved and
+ * are only normalized, so the path does not need to exist.
+ *
+ * The path is resolved one component at a time with openat(O_PATH) relative to the directory
+ * resolved so far. The canonical paths of the directories along the path are kept in a bounded
+ * LRU cache, so that symlinks along paths under a recently canonicalized directory do not need to
+ * be read and resolved again. A cached directory is only used if the path still resolves to the
+ * same inode and its canonical path can still be opened to that inode without following symlinks,
+ * so that symlinks replaced and directories moved after they were cached are detected.
+ *
+ * Returns 0 on success, otherwise EINVAL if path is not absolute or ELOOP if too many symlinks
+ * were followed.
+ */
+int canonicalizePath(const char* path, std::string& result);
+
+/*
+ * Remove all the directories from the cache of canonicalizePath(). Canonicalizations running
+ * concurrently do not add the directories they resolved to the cache.
+ */
+void invalidateCanonicalPathCache();
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+struct ChmodTreeOptions {
+    /* The permission bits to add to and remove from regular files. */
+    mode_t fileAddMode = 0;
+    mode_t fileRemoveMode = 0;
+    /* The permission bits to add to and remove from directories. */
+    mode_t dirAddMode = 0;
+    mode_t dirRemoveMode = 0;
+    /* Whether to also fix everything under the root directory, or only the root itself. */
+    bool recursive = true;
+    /* Whether to only report the files whose modes would be changed without changing them. */
+    bool checkOnly = false;
+    /* The max number of entries to collect. */
+    size_t maxEntries = 100;
+};
+
+/* A file whose mode was changed, or which could not be checked or changed. */
+struct ChmodTreeEntry {
+    /* The path relative to the root, or empty for the root itself. */
+    std::string path;
+    /* The permission bits before and after the change. */
+    uint32_t oldMode;
+    uint32_t newMode;
+    /* The errno of the failure, or 0 if the mode was changed. */
+    int error;
+};
+
+struct ChmodTreeResult {
+    /* The number of regular files and directories checked. */
+    uint64_t checkedCount = 0;
+    /* The number of files whose modes were changed, or would be if checkOnly. */
+    uint64_t changedCount = 0;
+    /* The number of failures. */
+    uint64_t failedCount = 0;
+    /* The first maxEntries changed files and failures. */
+    std::vector<ChmodTreeEntry> entries;
+};
+
+/*
+ * Add and remove permission bits of the regular files and directories at and under rootPath,
+ * without following symlinks. Other file types are ignored.
+ *
+ * Directories are walked depth first with their open fds, and the mode of each file is read with
+ * fstatat() and only changed with fchmodat() if any bits actually need to change. The mode of a
+ * directory is fixed before it is opened, so that directories without read or execute permission
+ * can be fixed too. Failures do not stop the walk.
+ *
+ * Returns 0 if rootPath could be checked, otherwise the errno of the failure.
+ */
+int chmodTree(const char* rootPath, const ChmodTreeOptions& options, ChmodTreeResult& result);
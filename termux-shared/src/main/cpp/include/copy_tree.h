@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/* The ways that the data of a regular file can be copied, in the order they are tried. */
+enum CopyMethod {
+    /* Share the data blocks with the FICLONE ioctl on filesystems that support reflinks. */
+    COPY_METHOD_CLONE,
+    /* Copy in the kernel with copy_file_range(), which may also be offloaded to the storage. */
+    COPY_METHOD_COPY_FILE_RANGE,
+    /* Copy in the kernel with sendfile(). */
+    COPY_METHOD_SENDFILE,
+    /* Copy with read() and write() through a large buffer. */
+    COPY_METHOD_READ_WRITE,
+    COPY_METHOD_COUNT
+};
+
+/* A failure to copy a file under the source directory. */
+struct CopyTreeError {
+    /* The path relative to the source directory. */
+    std::string path;
+    /* The errno of the failure. */
+    int error;
+};
+
+struct CopyTreeResult {
+    /* The number of files, symlinks and directories copied. */
+    std::atomic<uint64_t> copiedCount{0};
+    /* The number of bytes of regular files copied. */
+    std::atomic<uint64_t> copiedBytes{0};
+    /* The number of failures, which may be more than the errors collected. */
+    std::atomic<uint64_t> failedCount{0};
+    /* The number of regular files copied with each CopyMethod. */
+    std::atomic<uint64_t> methodCounts[COPY_METHOD_COUNT] = {};
+    /* The first maxErrors failures. */
+    std::vector<CopyTreeError> errors;
+    /* Whether the copy was cancelled by the progress callback. */
+    bool cancelled = false;
+};
+
+/*
+ * Called on the calling thread of copyTree() every progressIntervalMillis with the current
+ * counts. Return false to cancel the copy, in which case it stops as soon as possible.
+ */
+typedef std::function<bool(uint64_t copiedCount, uint64_t copiedBytes, uint64_t failedCount)> CopyTreeProgressCallback;
+
+/*
+ * Copy the data of srcFd to destFd from their current offsets, trying each CopyMethod in order
+ * until one is supported. The method used is set in method. Returns 0 on success, otherwise the
+ * errno of the failure.
+ */
+int copyFileData(int srcFd, int destFd, uint64_t& copiedBytes, CopyMethod& method);
+
+/*
+ * Copy the file at srcPath to destPath without following symlinks. Directories are copied
+ * recursively, regular files with copyFileData(), symlinks as symlinks with the same target, and
+ * fifos and sockets are recreated. The permission mode and the access and modification times are
+ * preserved. The parent directory of destPath must exist. If destPath is a directory under
+ * srcPath, it is not copied into itself.
+ *
+ * The files of directories are split between threadCount threads. Failures for files under
+ * srcPath do not stop the copy and the first maxErrors of them are collected in result. The
+ * progressCallback is optional.
+ *
+ * Returns 0 if srcPath could be read and destPath created, otherwise the errno of the failure.
+ */
+int copyTree(const char* srcPath, const char* destPath, int threadCount, size_t maxErrors,
+             long progressIntervalMillis, const CopyTreeProgressCallback& progressCallback,
+             CopyTreeResult& result);
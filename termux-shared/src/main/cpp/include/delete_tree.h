@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/* A failure to open, read or delete a file under the root directory. */
+struct DeleteTreeError {
+    /* The path relative to the root directory. */
+    std::string path;
+    /* The errno of the failure. */
+    int error;
+};
+
+struct DeleteTreeResult {
+    /* The number of files and directories deleted. */
+    std::atomic<uint64_t> deletedCount{0};
+    /* The number of failures, which may be more than the errors collected. */
+    std::atomic<uint64_t> failedCount{0};
+    /* The first maxErrors failures. */
+    std::vector<DeleteTreeError> errors;
+    /* Whether the delete was cancelled by the progress callback. */
+    bool cancelled = false;
+};
+
+/*
+ * Called on the calling thread of deleteTree() every progressIntervalMillis with the current
+ * counts. Return false to cancel the delete, in which case it stops as soon as possible.
+ */
+typedef std::function<bool(uint64_t deletedCount, uint64_t failedCount)> DeleteTreeProgressCallback;
+
+/*
+ * Delete everything under the directory at rootFd, without deleting the directory itself and
+ * without following symlinks. The rootFd is not closed.
+ *
+ * Subdirectories are split between threadCount threads, each of which deletes the files of a
+ * directory with unlinkat() relative to its open fd and removes it once the directories under it
+ * have been removed. Failures do not stop the delete and the first maxErrors of them are
+ * collected in result. The progressCallback is optional.
+ */
+void deleteTree(int rootFd, int threadCount, size_t maxErrors, long progressIntervalMillis,
+                const DeleteTreeProgressCallback& progressCallback, DeleteTreeResult& result);
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include <sys/types.h>
+
+/* A read-only memory mapping of a whole regular file. */
+struct MappedFile {
+    /* The address of the mapping, or NULL if the file is empty. */
+    void* address = nullptr;
+    size_t size = 0;
+};
+
+/*
+ * Map the regular file at path read-only into memory. The pages are only read from disk when they
+ * are accessed, so a large file can be read without copying it into memory first.
+ * Accessing the mapping past the end of the file after it was truncated raises SIGBUS, so only
+ * files that are not modified in place while mapped may be mapped.
+ *
+ * Returns 0 on success, EINVAL if path is not a regular file, EFBIG if the file is larger than
+ * maxSize, otherwise the errno of the failure.
+ */
+int mapFile(const char* path, size_t maxSize, MappedFile& result);
+
+/* Unmap a file mapped by mapFile(). */
+void unmapFile(MappedFile& mappedFile);
+
+/*
+ * A writer that replaces a file atomically.
+ *
+ * The data is written to a temp file in the same directory as the file, which replaces the file
+ * with renameat() on commit(), so that readers either see the old or the new file, and never a
+ * partially written one, even if the process is killed while writing. The temp file keeps the
+ * permissions of the existing file.
+ */
+class AtomicFile {
+public:
+    AtomicFile() {}
+    ~AtomicFile();
+
+    AtomicFile(const AtomicFile&) = delete;
+    AtomicFile& operator=(const AtomicFile&) = delete;
+
+    /*
+     * Create the temp file for the file at path. The mode is used if the file does not exist yet,
+     * and is masked by the umask. Returns 0 on success, otherwise the errno of the failure.
+     */
+    int begin(const char* path, mode_t mode);
+
+    /* Append data to the temp file. Returns 0 on success, otherwise the errno of the failure. */
+    int write(const void* data, size_t size);
+
+    /*
+     * Replace the file with the temp file. If sync is true, then the temp file and the directory
+     * are synced to disk, so that the new file survives a power loss. Returns 0 on success,
+     * otherwise the errno of the failure, in which case the temp file is deleted.
+     */
+    int commit(bool sync);
+
+    /* Delete the temp file without replacing the file. */
+    void abort();
+
+private:
+    int dirFd = -1;
+    int fd = -1;
+    std::string name;
+    std::string tempName;
+    // The mode of the existing file to set on the temp file, or -1 if the file does not exist
+    int existingMode = -1;
+};
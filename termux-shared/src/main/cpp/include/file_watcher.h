@@ -0,0 +1,61 @@
+#pragma once
+
+#include <pthread.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * A watcher for changes to a set of files with inotify.
+ *
+ * The parent directories of the files are watched instead of the files themselves, so that files
+ * that do not exist yet or are replaced by a rename, like editors do when saving, are also
+ * detected. If a parent directory does not exist, then its closest existing ancestor is watched
+ * until it is created.
+ *
+ * One thread calls waitForChanges() in a loop, while setPaths() and close() may be called from
+ * any thread.
+ */
+class FileWatcher {
+public:
+    FileWatcher();
+    ~FileWatcher();
+
+    /* Create the inotify instance. Returns 0 on success, otherwise the errno of the failure. */
+    int init();
+
+    /* Set the absolute paths of the files to watch. */
+    void setPaths(const std::vector<std::string>& paths);
+
+    /*
+     * Wait until any of the files are changed, and then until no more changes occur for
+     * debounceMillis, so that all the writes of a save are reported together. The paths of the
+     * changed files as passed to setPaths() are set in changedPaths.
+     *
+     * Returns 0 on success, ECANCELED if close() was called, otherwise the errno of the failure.
+     */
+    int waitForChanges(long debounceMillis, std::vector<std::string>& changedPaths);
+
+    /* Make the current and all future waitForChanges() calls return ECANCELED. */
+    void close();
+
+private:
+    int inotifyFd = -1;
+    // An eventfd to wake up waitForChanges() when the paths are changed or on close()
+    int wakeFd = -1;
+
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    std::vector<std::string> paths;
+    bool pathsChanged = false;
+    bool closed = false;
+
+    // The watched directories by their watch descriptor, only used by waitForChanges()
+    std::unordered_map<int, std::string> watchedDirs;
+    // The files being watched and whether the watches need to be updated
+    std::vector<std::string> watchedPaths;
+    bool watchesChanged = true;
+
+    void updateWatches();
+    void handleEvent(int wd, uint32_t mask, const char* name, std::vector<std::string>& changedPaths);
+};
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+
+#include <string>
+#include <vector>
+
+/*
+ * A runner for processes with pipes for their stdin, stdout and stderr.
+ *
+ * The stdin of all the processes is written and their stdout and stderr are read as raw bytes on
+ * the single thread that calls waitForExits() in a loop, with one epoll instance, so that running
+ * a process does not need any threads of its own. Exits are detected with a pidfd if the kernel
+ * supports it, otherwise by polling with wait4() once the output of a process is closed.
+ *
+ * Only the head and tail of an output larger than the max output size of its process are kept in
+ * memory, and the full output is spilled to a file, so that a process that writes a lot of output
+ * cannot exhaust the memory of the app.
+ *
+ * Processes are reaped with wait4(), so that the resources they used are reported with their result.
+ *
+ * spawn() may be called from any thread.
+ */
+class ProcessRunner {
+public:
+    /* The captured stdout or stderr of a process. */
+    struct Output {
+        // The head of the output, followed by its tail if it was larger than the max output size
+        std::string data;
+        // The size of the head in data, which equals the size of data if the output was not truncated
+        size_t headSize;
+        // The size of the full output
+        uint64_t size;
+        // The path of the file with the full output if it was truncated, or empty if it was not
+        // truncated or the file could not be written
+        std::string spillPath;
+    };
+
+    /* The result of a process that exited and whose stdout and stderr were closed. */
+    struct Result {
+        long id;
+        pid_t pid;
+        // The exit code, 128 + the signal number if the process was killed by a signal, or -1 if
+        // the process was reaped by someone else
+        int exitCode;
+        // The resource usage of the process, which is zeroed if it was reaped by someone else
+        struct rusage usage;
+        // The time from the spawn of the process until it was reaped
+        int64_t wallTimeNanos;
+        Output stdoutOutput;
+        Output stderrOutput;
+    };
+
+    ProcessRunner();
+    ~ProcessRunner();
+
+    /* Create the epoll instance. Returns 0 on success, otherwise the errno of the failure. */
+    int init();
+
+    /*
+     * Spawn the executable at path with argv and envp in workingDirectory. The stdinData is
+     * written to its stdin, which is then closed.
+     *
+     * If the stdout or stderr of the process is larger than maxOutputSize, then only its first and
+     * last maxOutputSize / 2 bytes are kept, and the full output is written to a new file in
+     * spillDirectory, unless it is empty. A maxOutputSize of 0 keeps the full output.
+     *
+     * The id is returned with the Result of the process. Returns 0 and sets pid on success,
+     * otherwise the errno of the failure.
+     */
+    int spawn(long id, const char* path, char* const argv[], char* const envp[], const char* workingDirectory,
+              const std::string& stdinData, size_t maxOutputSize, const std::string& spillDirectory, pid_t* pid);
+
+    /*
+     * Wait until at least one process has exited and its output was closed, and set their
+     * results in results.
+     *
+     * Returns 0 on success, otherwise the errno of the failure.
+     */
+    int waitForExits(std::vector<Result>& results);
+
+private:
+    struct Process;
+
+    // An fd of a process registered with epoll
+    struct Watch {
+        Process* process;
+        int fd;
+    };
+
+    // The output of a stream of a process being captured
+    struct Capture {
+        const char* name;
+        std::string head;
+        // The last bytes of the output once it was truncated, which may hold up to twice the tail
+        // size so that it is not trimmed on every read
+        std::string tail;
+        uint64_t size = 0;
+        bool truncated = false;
+        int spillFd = -1;
+        std::string spillPath;
+    };
+
+    struct Process {
+        long id;
+        pid_t pid;
+        // The pidfd of the process, or -1 if not supported or it was reaped
+        Watch pidWatch;
+        Watch stdinWatch;
+        Watch stdoutWatch;
+        Watch stderrWatch;
+        std::string stdinData;
+        size_t stdinOffset = 0;
+        size_t maxOutputSize;
+        std::string spillDirectory;
+        Capture stdoutCapture;
+        Capture stderrCapture;
+        bool exited = false;
+        int exitCode = 0;
+        struct rusage usage = {};
+        int64_t spawnTimeNanos = 0;
+        int64_t wallTimeNanos = 0;
+    };
+
+    int epollFd = -1;
+    // An eventfd to wake up waitForExits() when a process is spawned
+    int wakeFd = -1;
+
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    std::vector<Process*> spawnedProcesses;
+
+    // The running processes and the buffer to read their output, only used by waitForExits()
+    std::vector<Process*> processes;
+    std::vector<char> readBuffer;
+
+    int addProcess(Process* process);
+    void closeWatch(Watch& watch);
+    void writeStdin(Process* process);
+    void readOutput(Watch& watch, Capture& capture);
+    void appendOutput(Process* process, Capture& capture, const char* data, size_t size);
+    static void spill(Capture& capture, const char* data, size_t size);
+    static Output finishCapture(Process* process, Capture& capture);
+    void reap(Process* process);
+};
@@ -23,3 +23,9 @@
  * buffer appropriately.
  */
 bool readlink(const char* path, std::string& result);
+
+/**
+ * Like readlink(const char*, std::string&), but for the symbolic link 'path' relative to the
+ * directory 'dirFd', like readlinkat(2). The 'dirFd' may be AT_FDCWD.
+ */
+bool readlinkat(int dirFd, const char* path, std::string& result);
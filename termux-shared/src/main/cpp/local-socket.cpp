@@ -1,21 +1,32 @@
+#include <algorithm>
 #include <cstdio>
+#include <cstdlib>
 #include <ctime>
 #include <cerrno>
+#include <fcntl.h>
+#include <climits>
 #include <jni.h>
-#include <sstream>
+#include <pthread.h>
 #include <string>
 #include <unistd.h>
+#include <vector>
 
 #include <android/log.h>
 
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 
 #define LOG_TAG "local-socket"
 #define JNI_EXCEPTION "jni-exception"
 
+// The socket types that can be passed to createServerSocketNative(). These must be kept in sync
+// with the LocalSocketRunConfig.SOCKET_TYPE_* constants.
+#define SOCKET_TYPE_STREAM 0
+#define SOCKET_TYPE_SEQPACKET 1
+
 using namespace std;
 
 
@@ -32,34 +43,18 @@ string jstring_to_stdstr(JNIEnv *env, jstring jString) {
 }
 
 /* Get characters before first occurrence of the delim in a std:string. */
-string get_string_till_first_delim(string str, char delim) {
-    if (!str.empty()) {
-        stringstream cmdline_args(str);
-        string tmp;
-        if (getline(cmdline_args, tmp, delim))
-            return tmp;
-    }
-    return "";
+string get_string_till_first_delim(const string &str, char delim) {
+    size_t pos = str.find(delim);
+    return pos == string::npos ? str : str.substr(0, pos);
 }
 
-/* Replace `\0` values with spaces in a std:string. */
+/* Replace `\0` values with spaces in a std:string, ignoring the trailing `\0` if any. */
 string replace_null_with_space(string str) {
-    if (str.empty())
-        return "";
+    if (!str.empty() && str.back() == '\0')
+        str.pop_back();
 
-    stringstream tokens(str);
-    string tmp;
-    string str_spaced;
-    while (getline(tokens, tmp, '\0')){
-        str_spaced.append(" " + tmp);
-    }
-
-    if (!str_spaced.empty()) {
-        if (str_spaced.front() == ' ')
-            str_spaced.erase(0, 1);
-    }
-
-    return str_spaced;
+    replace(str.begin(), str.end(), '\0', ' ');
+    return str;
 }
 
 /* Get class name of a jclazz object with a call to `Class.getName()`. */
@@ -72,39 +67,146 @@ string get_class_name(JNIEnv *env, jclass clazz) {
 
 
 
+/* Read the entire contents of a /proc file. Returns an empty string if reading fails. */
+string read_proc_file(const char *path) {
+    string contents;
+    int fd = TEMP_FAILURE_RETRY(open(path, O_RDONLY | O_CLOEXEC));
+    if (fd == -1)
+        return contents;
+
+    char buf[1024];
+    ssize_t len;
+    while ((len = TEMP_FAILURE_RETRY(read(fd, buf, sizeof(buf)))) > 0) {
+        contents.append(buf, len);
+    }
+    close(fd);
+
+    return contents;
+}
+
 /*
  * Get /proc/[pid]/cmdline for a process with pid.
  *
  * https://manpages.debian.org/testing/manpages/proc.5.en.html
  */
 string get_process_cmdline(const pid_t pid) {
-    string cmdline;
-    char buf[BUFSIZ];
-    size_t len;
-    char procfile[BUFSIZ];
-    sprintf(procfile, "/proc/%d/cmdline", pid);
-    FILE *fp = fopen(procfile, "rb");
-    if (fp) {
-        while ((len = fread(buf, 1, sizeof(buf), fp)) > 0) {
-            cmdline.append(buf, len);
-        }
-        fclose(fp);
+    char procfile[32];
+    snprintf(procfile, sizeof(procfile), "/proc/%d/cmdline", pid);
+    return read_proc_file(procfile);
+}
+
+/*
+ * Get the starttime field of /proc/[pid]/stat for a process with pid, which is the time in clock
+ * ticks the process started after system boot. Since pids can be reused, the (pid, starttime)
+ * pair uniquely identifies a process. Returns 0 if it could not be read, like for processes of
+ * other users/apps if /proc is mounted with hidepid.
+ *
+ * https://manpages.debian.org/testing/manpages/proc.5.en.html
+ */
+uint64_t get_process_start_time(const pid_t pid) {
+    char procfile[32];
+    snprintf(procfile, sizeof(procfile), "/proc/%d/stat", pid);
+    string stat = read_proc_file(procfile);
+
+    // The comm field is enclosed in parentheses and may itself contain spaces and parentheses,
+    // so start parsing after its last closing parenthesis, where the 3rd field starts.
+    size_t pos = stat.rfind(')');
+    if (pos == string::npos)
+        return 0;
+
+    // Find the space before each field till the 22nd field
+    for (int field = 3; field <= 22; field++) {
+        pos = stat.find(' ', pos + 1);
+        if (pos == string::npos)
+            return 0;
     }
 
-    return cmdline;
+    return strtoull(stat.c_str() + pos + 1, nullptr, 10);
 }
 
 /* Extract process name from /proc/[pid]/cmdline value of a process. */
-string get_process_name_from_cmdline(string cmdline) {
+string get_process_name_from_cmdline(const string &cmdline) {
     return get_string_till_first_delim(cmdline, '\0');
 }
 
 /* Replace `\0` values with spaces in /proc/[pid]/cmdline value of a process. */
-string get_process_cmdline_spaced(string cmdline) {
+string get_process_cmdline_spaced(const string &cmdline) {
     return replace_null_with_space(cmdline);
 }
 
 
+
+/*
+ * A cache of process names and cmdlines keyed by (pid, starttime), since most clients connect from
+ * the same few long-lived processes. The table is bounded and the least recently used entry is
+ * replaced when it is full.
+ */
+#define PROCESS_INFO_CACHE_SIZE 32
+
+struct process_info {
+    pid_t pid;
+    uint64_t start_time;
+    uint64_t last_used;
+    string pname;
+    string cmdline;
+};
+
+static process_info process_info_cache[PROCESS_INFO_CACHE_SIZE];
+static uint64_t process_info_cache_clock = 0;
+static pthread_mutex_t process_info_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Get the process name and cmdline of the process with pid and start_time from cache, or read
+ * them from /proc/[pid]/cmdline and add them to the cache. Returns false if they could not be read.
+ */
+bool get_process_info(const pid_t pid, const uint64_t start_time, string &pname, string &cmdline) {
+    if (start_time > 0) {
+        pthread_mutex_lock(&process_info_cache_lock);
+        for (process_info &entry : process_info_cache) {
+            if (entry.pid == pid && entry.start_time == start_time) {
+                entry.last_used = ++process_info_cache_clock;
+                pname = entry.pname;
+                cmdline = entry.cmdline;
+                pthread_mutex_unlock(&process_info_cache_lock);
+                return true;
+            }
+        }
+        pthread_mutex_unlock(&process_info_cache_lock);
+    }
+
+    string cmdline_raw = get_process_cmdline(pid);
+    if (cmdline_raw.empty())
+        return false;
+
+    // If the process exited and its pid was reused while cmdline was being read, then do not
+    // report the cmdline of the new process
+    if (start_time > 0 && get_process_start_time(pid) != start_time)
+        return false;
+
+    pname = get_process_name_from_cmdline(cmdline_raw);
+    cmdline = get_process_cmdline_spaced(cmdline_raw);
+
+    // Do not cache if start time is not known, since pid alone is not unique
+    if (start_time == 0)
+        return true;
+
+    pthread_mutex_lock(&process_info_cache_lock);
+    process_info *lru = &process_info_cache[0];
+    for (process_info &entry : process_info_cache) {
+        if (entry.last_used < lru->last_used)
+            lru = &entry;
+    }
+    lru->pid = pid;
+    lru->start_time = start_time;
+    lru->last_used = ++process_info_cache_clock;
+    lru->pname = pname;
+    lru->cmdline = cmdline;
+    pthread_mutex_unlock(&process_info_cache_lock);
+
+    return true;
+}
+
+
 /* Send an ERROR log message to android logcat. */
 void log_error(string message) {
     __android_log_write(ANDROID_LOG_ERROR, LOG_TAG, message.c_str());
@@ -255,14 +357,27 @@ JNIEXPORT jobject JNICALL
 Java_com_termux_shared_net_socket_local_LocalSocketManager_createServerSocketNative(JNIEnv *env, jclass clazz,
                                                                                     jstring logTitle,
                                                                                     jbyteArray pathArray,
-                                                                                    jint backlog) {
+                                                                                    jint backlog,
+                                                                                    jint socketType) {
     if (backlog < 1 || backlog > 500) {
         return getJniResult(env, logTitle, -1, "createServerSocketNative(): Backlog \"" +
                                                to_string(backlog) + "\" is not between 1-500");
     }
 
+    int type;
+    if (socketType == SOCKET_TYPE_STREAM) {
+        type = SOCK_STREAM;
+    } else if (socketType == SOCKET_TYPE_SEQPACKET) {
+        // Preserves message boundaries, so that each send() on one side is received by exactly
+        // one recv() on the other side, while still being connection-oriented and reliable.
+        type = SOCK_SEQPACKET;
+    } else {
+        return getJniResult(env, logTitle, -1, "createServerSocketNative(): Socket type \"" +
+                                               to_string(socketType) + "\" is not supported");
+    }
+
     // Create server socket
-    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    int fd = socket(AF_UNIX, type, 0);
     if (fd == -1) {
         return getJniResult(env, logTitle, -1, errno, "createServerSocketNative(): Create local socket failed");
     }
@@ -387,7 +502,7 @@ Java_com_termux_shared_net_socket_local_LocalSocketManager_readNative(JNIEnv *en
         }
 
         // Read data from socket
-        int ret = read(fd, current, bytes);
+        int ret = read(fd, current, bytes - bytesRead);
         if (ret == -1) {
             int errnoBackup = errno;
             env->ReleaseByteArrayElements(dataArray, data, 0);
@@ -468,6 +583,386 @@ Java_com_termux_shared_net_socket_local_LocalSocketManager_sendNative(JNIEnv *en
     return getJniResult(env, logTitle);
 }
 
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_termux_shared_net_socket_local_LocalSocketManager_readMessageNative(JNIEnv *env, jclass clazz,
+                                                                             jstring logTitle,
+                                                                             jint fd, jbyteArray dataArray,
+                                                                             jlong deadline) {
+    if (fd < 0) {
+        return getJniResult(env, logTitle, -1, "readMessageNative(): Invalid fd \"" + to_string(fd) + "\" passed");
+    }
+
+    if (deadline > 0) {
+        struct timespec time = {};
+        if (clock_gettime(CLOCK_REALTIME, &time) != -1) {
+            // If current time is greater than the time defined in deadline
+            if (timespec_to_milliseconds(&time) > deadline) {
+                return getJniResult(env, logTitle, -1,
+                                    "readMessageNative(): Deadline \"" + to_string(deadline) + "\" timeout");
+            }
+        } else {
+            log_warn(get_title_and_message(env, logTitle,
+                                           "readMessageNative(): Deadline \"" + to_string(deadline) +
+                                           "\" timeout will not work since failed to get current time"));
+        }
+    }
+
+    jbyte* data = env->GetByteArrayElements(dataArray, nullptr);
+    if (checkJniException(env)) return NULL;
+    if (data == nullptr) {
+        return getJniResult(env, logTitle, -1, "readMessageNative(): data passed is null");
+    }
+
+    int bytes = env->GetArrayLength(dataArray);
+    if (checkJniException(env)) return NULL;
+
+    // Receive exactly one message from socket. Unlike readNative(), this does not loop, since for
+    // SOCK_SEQPACKET sockets each call returns one complete message and any part of the message
+    // that does not fit in the buffer is discarded by the kernel, which must be reported instead.
+    struct iovec iov = {.iov_base = data, .iov_len = (size_t) bytes};
+    struct msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    ssize_t ret;
+    do {
+        ret = recvmsg(fd, &msg, 0);
+    } while (ret == -1 && errno == EINTR);
+
+    if (ret == -1) {
+        int errnoBackup = errno;
+        env->ReleaseByteArrayElements(dataArray, data, 0);
+        if (checkJniException(env)) return NULL;
+        return getJniResult(env, logTitle, -1, errnoBackup, "readMessageNative(): Failed to read message on fd " + to_string(fd));
+    }
+
+    env->ReleaseByteArrayElements(dataArray, data, 0);
+    if (checkJniException(env)) return NULL;
+
+    if ((msg.msg_flags & MSG_TRUNC) != 0) {
+        return getJniResult(env, logTitle, -1, EMSGSIZE,
+                            "readMessageNative(): Message received on fd " + to_string(fd) +
+                            " was truncated since it was larger than the " + to_string(bytes) + " bytes buffer", (int) ret);
+    }
+
+    // Return success and bytes read in JniResult.intData field. Zero bytes means peer closed the
+    // connection, since empty messages are not sent by sendMessageNative().
+    return getJniResult(env, logTitle, (int) ret);
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_termux_shared_net_socket_local_LocalSocketManager_sendMessageNative(JNIEnv *env, jclass clazz,
+                                                                             jstring logTitle,
+                                                                             jint fd, jbyteArray dataArray,
+                                                                             jlong deadline) {
+    if (fd < 0) {
+        return getJniResult(env, logTitle, -1, "sendMessageNative(): Invalid fd \"" + to_string(fd) + "\" passed");
+    }
+
+    if (deadline > 0) {
+        struct timespec time = {};
+        if (clock_gettime(CLOCK_REALTIME, &time) != -1) {
+            // If current time is greater than the time defined in deadline
+            if (timespec_to_milliseconds(&time) > deadline) {
+                return getJniResult(env, logTitle, -1,
+                                    "sendMessageNative(): Deadline \"" + to_string(deadline) + "\" timeout");
+            }
+        } else {
+            log_warn(get_title_and_message(env, logTitle,
+                                           "sendMessageNative(): Deadline \"" + to_string(deadline) +
+                                           "\" timeout will not work since failed to get current time"));
+        }
+    }
+
+    jbyte* data = env->GetByteArrayElements(dataArray, nullptr);
+    if (checkJniException(env)) return NULL;
+    if (data == nullptr) {
+        return getJniResult(env, logTitle, -1, "sendMessageNative(): data passed is null");
+    }
+
+    int bytes = env->GetArrayLength(dataArray);
+    if (checkJniException(env)) return NULL;
+    if (bytes == 0) {
+        env->ReleaseByteArrayElements(dataArray, data, JNI_ABORT);
+        if (checkJniException(env)) return NULL;
+        return getJniResult(env, logTitle, -1, "sendMessageNative(): Empty messages cannot be sent since they are indistinguishable from EOF");
+    }
+
+    // Send data to socket as one message. For SOCK_SEQPACKET sockets the send is atomic, either
+    // the whole message is queued or the call fails, like with EMSGSIZE if it is too large.
+    ssize_t ret;
+    do {
+        ret = send(fd, data, bytes, MSG_NOSIGNAL | MSG_EOR);
+    } while (ret == -1 && errno == EINTR);
+
+    if (ret == -1) {
+        int errnoBackup = errno;
+        env->ReleaseByteArrayElements(dataArray, data, JNI_ABORT);
+        if (checkJniException(env)) return NULL;
+        return getJniResult(env, logTitle, -1, errnoBackup, "sendMessageNative(): Failed to send message on fd " + to_string(fd));
+    }
+
+    env->ReleaseByteArrayElements(dataArray, data, JNI_ABORT);
+    if (checkJniException(env)) return NULL;
+
+    if (ret != bytes) {
+        return getJniResult(env, logTitle, -1, "sendMessageNative(): Only " + to_string(ret) + " of " +
+                                               to_string(bytes) + " bytes of message were sent on fd " + to_string(fd));
+    }
+
+    // Return success
+    return getJniResult(env, logTitle);
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_termux_shared_net_socket_local_LocalSocketManager_peekNative(JNIEnv *env, jclass clazz,
+                                                                      jstring logTitle,
+                                                                      jint fd, jbyteArray dataArray) {
+    if (fd < 0) {
+        return getJniResult(env, logTitle, -1, "peekNative(): Invalid fd \"" + to_string(fd) + "\" passed");
+    }
+
+    jbyte* data = env->GetByteArrayElements(dataArray, nullptr);
+    if (checkJniException(env)) return NULL;
+    if (data == nullptr) {
+        return getJniResult(env, logTitle, -1, "peekNative(): data passed is null");
+    }
+
+    int bytes = env->GetArrayLength(dataArray);
+    if (checkJniException(env)) return NULL;
+
+    // Wait for data and copy it without removing it from the receive queue, so that a following
+    // read will still return it. This is used to detect the protocol used by the peer.
+    ssize_t ret;
+    do {
+        ret = recv(fd, data, bytes, MSG_PEEK);
+    } while (ret == -1 && errno == EINTR);
+
+    if (ret == -1) {
+        int errnoBackup = errno;
+        env->ReleaseByteArrayElements(dataArray, data, 0);
+        if (checkJniException(env)) return NULL;
+        return getJniResult(env, logTitle, -1, errnoBackup, "peekNative(): Failed to peek on fd " + to_string(fd));
+    }
+
+    env->ReleaseByteArrayElements(dataArray, data, 0);
+    if (checkJniException(env)) return NULL;
+
+    // Return success and bytes peeked in JniResult.intData field
+    return getJniResult(env, logTitle, (int) ret);
+}
+
+/* The byte arrays of a jobjectArray pinned for a vectored I/O call. */
+struct pinned_buffers {
+    vector<jbyteArray> arrays;
+    vector<jbyte*> elements;
+    vector<struct iovec> iov;
+    size_t total_bytes = 0;
+};
+
+/* Release the byte arrays pinned by pin_buffers() with mode. */
+void release_buffers(JNIEnv *env, pinned_buffers &buffers, jint mode) {
+    for (size_t i = 0; i < buffers.elements.size(); i++) {
+        env->ReleaseByteArrayElements(buffers.arrays[i], buffers.elements[i], mode);
+    }
+    buffers.elements.clear();
+}
+
+/*
+ * Pin all byte arrays in buffersArray and fill an iovec for each of them. Empty buffers are
+ * skipped. On failure, any pinned arrays are released and the error is returned.
+ */
+string pin_buffers(JNIEnv *env, jobjectArray buffersArray, pinned_buffers &buffers) {
+    if (buffersArray == nullptr)
+        return "buffers passed is null";
+
+    jsize count = env->GetArrayLength(buffersArray);
+    if (checkJniException(env)) return JNI_EXCEPTION;
+    if (count > IOV_MAX)
+        return "buffers count " + to_string(count) + " is greater than IOV_MAX " + to_string(IOV_MAX);
+
+    // A local reference is held for each buffer until it is released
+    if (env->EnsureLocalCapacity(count) != 0) {
+        checkJniException(env);
+        return JNI_EXCEPTION;
+    }
+
+    buffers.arrays.reserve(count);
+    buffers.elements.reserve(count);
+    buffers.iov.reserve(count);
+
+    for (jsize i = 0; i < count; i++) {
+        jbyteArray array = (jbyteArray) env->GetObjectArrayElement(buffersArray, i);
+        if (checkJniException(env)) { release_buffers(env, buffers, JNI_ABORT); return JNI_EXCEPTION; }
+        if (array == nullptr) {
+            release_buffers(env, buffers, JNI_ABORT);
+            return "buffer at index " + to_string(i) + " is null";
+        }
+
+        jsize length = env->GetArrayLength(array);
+        if (checkJniException(env)) { release_buffers(env, buffers, JNI_ABORT); return JNI_EXCEPTION; }
+        if (length == 0) {
+            env->DeleteLocalRef(array);
+            continue;
+        }
+
+        jbyte* data = env->GetByteArrayElements(array, nullptr);
+        if (checkJniException(env)) { release_buffers(env, buffers, JNI_ABORT); return JNI_EXCEPTION; }
+        if (data == nullptr) {
+            release_buffers(env, buffers, JNI_ABORT);
+            return "failed to get elements of buffer at index " + to_string(i);
+        }
+
+        buffers.arrays.push_back(array);
+        buffers.elements.push_back(data);
+        buffers.iov.push_back({data, (size_t) length});
+        buffers.total_bytes += length;
+    }
+
+    return "";
+}
+
+/* Skip bytes from the start of the iovec array starting at index iov_index, which is updated. */
+void advance_iov(vector<struct iovec> &iov, size_t &iov_index, size_t bytes) {
+    while (bytes > 0 && iov_index < iov.size()) {
+        if (bytes >= iov[iov_index].iov_len) {
+            bytes -= iov[iov_index].iov_len;
+            iov[iov_index].iov_len = 0;
+            iov_index++;
+        } else {
+            iov[iov_index].iov_base = (char *) iov[iov_index].iov_base + bytes;
+            iov[iov_index].iov_len -= bytes;
+            bytes = 0;
+        }
+    }
+}
+
+/* Check if the deadline has elapsed. A warning is logged if current time cannot be read. */
+bool is_deadline_elapsed(JNIEnv *env, jstring logTitle, const string &function, jlong deadline) {
+    if (deadline <= 0)
+        return false;
+
+    struct timespec time = {};
+    if (clock_gettime(CLOCK_REALTIME, &time) == -1) {
+        log_warn(get_title_and_message(env, logTitle,
+                                       function + "(): Deadline \"" + to_string(deadline) +
+                                       "\" timeout will not work since failed to get current time"));
+        return false;
+    }
+
+    // If current time is greater than the time defined in deadline
+    return timespec_to_milliseconds(&time) > deadline;
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_termux_shared_net_socket_local_LocalSocketManager_readvNative(JNIEnv *env, jclass clazz,
+                                                                       jstring logTitle,
+                                                                       jint fd, jobjectArray buffersArray,
+                                                                       jlong deadline) {
+    if (fd < 0) {
+        return getJniResult(env, logTitle, -1, "readvNative(): Invalid fd \"" + to_string(fd) + "\" passed");
+    }
+
+    pinned_buffers buffers;
+    string error = pin_buffers(env, buffersArray, buffers);
+    if (!error.empty()) {
+        if (error == JNI_EXCEPTION) return NULL;
+        return getJniResult(env, logTitle, -1, "readvNative(): " + error);
+    }
+
+    // Fill the buffers in order with a single readv() call for all of them, unless the call
+    // returns fewer bytes than requested, in which case continue with the remaining buffers
+    size_t iov_index = 0;
+    size_t bytesRead = 0;
+    while (bytesRead < buffers.total_bytes) {
+        if (is_deadline_elapsed(env, logTitle, "readvNative", deadline)) {
+            release_buffers(env, buffers, 0);
+            if (checkJniException(env)) return NULL;
+            return getJniResult(env, logTitle, -1,
+                                "readvNative(): Deadline \"" + to_string(deadline) + "\" timeout");
+        }
+
+        ssize_t ret = readv(fd, &buffers.iov[iov_index], buffers.iov.size() - iov_index);
+        if (ret == -1) {
+            if (errno == EINTR) continue;
+            int errnoBackup = errno;
+            release_buffers(env, buffers, 0);
+            if (checkJniException(env)) return NULL;
+            return getJniResult(env, logTitle, -1, errnoBackup, "readvNative(): Failed to read on fd " + to_string(fd));
+        }
+        // EOF, peer closed writing end
+        if (ret == 0) {
+            break;
+        }
+
+        bytesRead += ret;
+        advance_iov(buffers.iov, iov_index, ret);
+    }
+
+    release_buffers(env, buffers, 0);
+    if (checkJniException(env)) return NULL;
+
+    // Return success and bytes read in JniResult.intData field
+    return getJniResult(env, logTitle, (int) bytesRead);
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_termux_shared_net_socket_local_LocalSocketManager_writevNative(JNIEnv *env, jclass clazz,
+                                                                        jstring logTitle,
+                                                                        jint fd, jobjectArray buffersArray,
+                                                                        jlong deadline) {
+    if (fd < 0) {
+        return getJniResult(env, logTitle, -1, "writevNative(): Invalid fd \"" + to_string(fd) + "\" passed");
+    }
+
+    pinned_buffers buffers;
+    string error = pin_buffers(env, buffersArray, buffers);
+    if (!error.empty()) {
+        if (error == JNI_EXCEPTION) return NULL;
+        return getJniResult(env, logTitle, -1, "writevNative(): " + error);
+    }
+
+    // Send all buffers with a single sendmsg() call, which unlike writev() accepts MSG_NOSIGNAL,
+    // unless the call sends fewer bytes than requested, in which case continue with the remaining
+    size_t iov_index = 0;
+    size_t bytesSent = 0;
+    while (bytesSent < buffers.total_bytes) {
+        if (is_deadline_elapsed(env, logTitle, "writevNative", deadline)) {
+            release_buffers(env, buffers, JNI_ABORT);
+            if (checkJniException(env)) return NULL;
+            return getJniResult(env, logTitle, -1,
+                                "writevNative(): Deadline \"" + to_string(deadline) + "\" timeout");
+        }
+
+        struct msghdr msg = {};
+        msg.msg_iov = &buffers.iov[iov_index];
+        msg.msg_iovlen = buffers.iov.size() - iov_index;
+
+        ssize_t ret = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (ret == -1) {
+            if (errno == EINTR) continue;
+            int errnoBackup = errno;
+            release_buffers(env, buffers, JNI_ABORT);
+            if (checkJniException(env)) return NULL;
+            return getJniResult(env, logTitle, -1, errnoBackup, "writevNative(): Failed to send on fd " + to_string(fd));
+        }
+
+        bytesSent += ret;
+        advance_iov(buffers.iov, iov_index, ret);
+    }
+
+    release_buffers(env, buffers, JNI_ABORT);
+    if (checkJniException(env)) return NULL;
+
+    // Return success and bytes sent in JniResult.intData field
+    return getJniResult(env, logTitle, (int) bytesSent);
+}
+
 extern "C"
 JNIEXPORT jobject JNICALL
 Java_com_termux_shared_net_socket_local_LocalSocketManager_availableNative(JNIEnv *env, jclass clazz,
@@ -530,6 +1025,64 @@ Java_com_termux_shared_net_socket_local_LocalSocketManager_setSocketSendTimeoutN
     return getJniResult(env, logTitle);
 }
 
+/* The cached field ids of "com.termux.shared.net.socket.local.PeerCred" class. */
+struct peer_cred_field_ids {
+    bool initialized;
+    jfieldID pid;
+    jfieldID uid;
+    jfieldID gid;
+    jfieldID startTime;
+    jfieldID pname;
+    jfieldID cmdline;
+};
+
+static peer_cred_field_ids peer_cred_fields = {};
+static pthread_mutex_t peer_cred_fields_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Get the cached field ids of PeerCred class, looking them up on first call. Field ids remain
+ * valid as long as the class is loaded, so they do not need to be looked up on every accept.
+ */
+string get_peer_cred_field_ids(JNIEnv *env, jobject peerCred, peer_cred_field_ids &fields) {
+    pthread_mutex_lock(&peer_cred_fields_lock);
+    if (peer_cred_fields.initialized) {
+        fields = peer_cred_fields;
+        pthread_mutex_unlock(&peer_cred_fields_lock);
+        return "";
+    }
+
+    jclass peerCredClazz = env->GetObjectClass(peerCred);
+    if (checkJniException(env)) { pthread_mutex_unlock(&peer_cred_fields_lock); return JNI_EXCEPTION; }
+    if (!peerCredClazz) {
+        pthread_mutex_unlock(&peer_cred_fields_lock);
+        return "Failed to get PeerCred class";
+    }
+
+    const struct { jfieldID *field; const char *name; const char *signature; } field_specs[] = {
+        {&fields.pid, "pid", "I"},
+        {&fields.uid, "uid", "I"},
+        {&fields.gid, "gid", "I"},
+        {&fields.startTime, "startTime", "J"},
+        {&fields.pname, "pname", "Ljava/lang/String;"},
+        {&fields.cmdline, "cmdline", "Ljava/lang/String;"},
+    };
+
+    for (const auto &spec : field_specs) {
+        *spec.field = env->GetFieldID(peerCredClazz, spec.name, spec.signature);
+        if (checkJniException(env)) { pthread_mutex_unlock(&peer_cred_fields_lock); return JNI_EXCEPTION; }
+        if (!*spec.field) {
+            pthread_mutex_unlock(&peer_cred_fields_lock);
+            return "Failed to get \"" + string(spec.name) + "\" field of \"" +
+                   get_class_name(env, peerCredClazz) + "\" class";
+        }
+    }
+
+    fields.initialized = true;
+    peer_cred_fields = fields;
+    pthread_mutex_unlock(&peer_cred_fields_lock);
+    return "";
+}
+
 extern "C"
 JNIEXPORT jobject JNICALL
 Java_com_termux_shared_net_socket_local_LocalSocketManager_getPeerCredNative(JNIEnv *env, jclass clazz,
@@ -553,51 +1106,67 @@ Java_com_termux_shared_net_socket_local_LocalSocketManager_getPeerCredNative(JNI
         return getJniResult(env, logTitle, -1, errno, "getPeerCredNative(): Failed to get peer credentials for fd " + to_string(fd));
     }
 
+    peer_cred_field_ids fields = {};
+    string error = get_peer_cred_field_ids(env, peerCred, fields);
+    if (!error.empty()) {
+        if (error == JNI_EXCEPTION) return NULL;
+        return getJniResult(env, logTitle, -1, "getPeerCredNative(): " + error);
+    }
+
     // Fill "com.termux.shared.net.socket.local.PeerCred" object.
     // The pid, uid and gid will always be set based on ucred.
-    // The pname and cmdline will only be set if current process has access to "/proc/[pid]/cmdline"
-    // of peer process. Processes of other users/apps are not normally accessible.
-    jclass peerCredClazz = env->GetObjectClass(peerCred);
+    // The startTime will only be set if current process has access to "/proc/[pid]/stat" of peer
+    // process. The pname and cmdline are not set here and are resolved lazily with
+    // getPeerProcessInfoNative() only if they are actually needed.
+    env->SetIntField(peerCred, fields.pid, cred.pid);
     if (checkJniException(env)) return NULL;
-    if (!peerCredClazz) {
-        return getJniResult(env, logTitle, -1, errno, "getPeerCredNative(): Failed to get PeerCred class");
+    env->SetIntField(peerCred, fields.uid, cred.uid);
+    if (checkJniException(env)) return NULL;
+    env->SetIntField(peerCred, fields.gid, cred.gid);
+    if (checkJniException(env)) return NULL;
+    if (cred.pid > 0) {
+        env->SetLongField(peerCred, fields.startTime, (jlong) get_process_start_time(cred.pid));
+        if (checkJniException(env)) return NULL;
     }
 
-    string error;
+    // Return success since PeerCred was filled successfully
+    return getJniResult(env, logTitle);
+}
 
-    error = setIntField(env, peerCred, peerCredClazz, "pid", cred.pid);
-    if (!error.empty()) {
-        if (error == JNI_EXCEPTION) return NULL;
-        return getJniResult(env, logTitle, -1, "getPeerCredNative(): " + error);
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_termux_shared_net_socket_local_LocalSocketManager_getPeerProcessInfoNative(JNIEnv *env, jclass clazz,
+                                                                                    jstring logTitle,
+                                                                                    jobject peerCred) {
+    if (peerCred == nullptr) {
+        return getJniResult(env, logTitle, -1, "getPeerProcessInfoNative(): peerCred passed is null");
     }
 
-    error = setIntField(env, peerCred, peerCredClazz, "uid", cred.uid);
+    peer_cred_field_ids fields = {};
+    string error = get_peer_cred_field_ids(env, peerCred, fields);
     if (!error.empty()) {
         if (error == JNI_EXCEPTION) return NULL;
-        return getJniResult(env, logTitle, -1, "getPeerCredNative(): " + error);
+        return getJniResult(env, logTitle, -1, "getPeerProcessInfoNative(): " + error);
     }
 
-    error = setIntField(env, peerCred, peerCredClazz, "gid", cred.gid);
-    if (!error.empty()) {
-        if (error == JNI_EXCEPTION) return NULL;
-        return getJniResult(env, logTitle, -1, "getPeerCredNative(): " + error);
+    pid_t pid = env->GetIntField(peerCred, fields.pid);
+    if (checkJniException(env)) return NULL;
+    uint64_t start_time = (uint64_t) env->GetLongField(peerCred, fields.startTime);
+    if (checkJniException(env)) return NULL;
+    if (pid <= 0) {
+        return getJniResult(env, logTitle, -1, "getPeerProcessInfoNative(): Invalid pid \"" + to_string(pid) + "\" set");
     }
 
-    string cmdline = get_process_cmdline(cred.pid);
-    if (!cmdline.empty()) {
-        error = setStringField(env, peerCred, peerCredClazz, "pname", get_process_name_from_cmdline(cmdline));
-        if (!error.empty()) {
-            if (error == JNI_EXCEPTION) return NULL;
-            return getJniResult(env, logTitle, -1, "getPeerCredNative(): " + error);
-        }
-
-        error = setStringField(env, peerCred, peerCredClazz, "cmdline", get_process_cmdline_spaced(cmdline));
-        if (!error.empty()) {
-            if (error == JNI_EXCEPTION) return NULL;
-            return getJniResult(env, logTitle, -1, "getPeerCredNative(): " + error);
-        }
+    // The pname and cmdline will only be set if current process has access to "/proc/[pid]/cmdline"
+    // of peer process. Processes of other users/apps are not normally accessible.
+    string pname, cmdline;
+    if (get_process_info(pid, start_time, pname, cmdline)) {
+        env->SetObjectField(peerCred, fields.pname, env->NewStringUTF(pname.c_str()));
+        if (checkJniException(env)) return NULL;
+        env->SetObjectField(peerCred, fields.cmdline, env->NewStringUTF(cmdline.c_str()));
+        if (checkJniException(env)) return NULL;
     }
 
-    // Return success since PeerCred was filled successfully
+    // Return success even if process info could not be read, since that is expected for other apps
     return getJniResult(env, logTitle);
 }
@@ -1,5 +1,8 @@
+#include <atomic>
 #include <string>
+#include <unordered_map>
 #include <vector>
+#include <pthread.h>
 #include <unicode/ucnv.h>
 #include "include/scoped_utf_chars.h"
 #include "include/toStringArray.h"
@@ -28,15 +31,15 @@ static const char* getICUCanonicalName(const char* name) {
   return NULL;
 }
 
-static jstring getJavaCanonicalName(JNIEnv* env, const char* icuCanonicalName) {
+static std::string getJavaCanonicalName(const char* icuCanonicalName) {
   UErrorCode status = U_ZERO_ERROR;
 
   // Check to see if this is a well-known MIME or IANA name.
   const char* cName = NULL;
   if ((cName = ucnv_getStandardName(icuCanonicalName, "MIME", &status)) != NULL) {
-    return env->NewStringUTF(cName);
+    return cName;
   } else if ((cName = ucnv_getStandardName(icuCanonicalName, "IANA", &status)) != NULL) {
-    return env->NewStringUTF(cName);
+    return cName;
   }
 
   // Check to see if an alias already exists with "x-" prefix, if yes then
@@ -45,7 +48,7 @@ static jstring getJavaCanonicalName(JNIEnv* env, const char* icuCanonicalName) {
   for (int i = 0; i < aliasCount; ++i) {
     const char* name = ucnv_getAlias(icuCanonicalName, i, &status);
     if (name != NULL && name[0] == 'x' && name[1] == '-') {
-      return env->NewStringUTF(name);
+      return name;
     }
   }
 
@@ -59,10 +62,7 @@ static jstring getJavaCanonicalName(JNIEnv* env, const char* icuCanonicalName) {
   if (name == NULL) {
     name = icuCanonicalName;
   }
-  std::unique_ptr<char[]> result(new char[2 + strlen(name) + 1]);
-  strcpy(&result[0], "x-");
-  strcat(&result[0], name);
-  return env->NewStringUTF(&result[0]);
+  return std::string("x-") + name;
 }
 
 static bool collectStandardNames(JNIEnv* env, const char* canonicalName, const char* standard, std::vector<std::string>& result) {
@@ -91,61 +91,175 @@ static bool collectStandardNames(JNIEnv* env, const char* canonicalName, const c
   return true;
 }
 
-extern "C"
-JNIEXPORT jobject JNICALL Java_NativeConverter_charsetForName
-  (JNIEnv* env, jclass, jstring charsetName) {
-    ScopedUtfChars charsetNameChars(env, charsetName);
-    if (charsetNameChars.c_str() == NULL) {
-        return NULL;
+// The max number of idle converters kept for each charset.
+#define MAX_POOLED_CONVERTERS 4
+// The max number of unsupported charset names cached.
+#define MAX_UNSUPPORTED_CHARSET_NAMES 64
+
+/*
+ * The resolved names and aliases of a charset, with a pool of idle converters for it that are
+ * checked out and returned without locks. Descriptors are never freed, since ICU only has a
+ * bounded number of converters.
+ */
+struct CharsetDescriptor {
+    bool supported;
+    std::string icuCanonicalName;
+    std::string javaCanonicalName;
+    std::vector<std::string> aliases;
+    std::atomic<UConverter*> idleConverters[MAX_POOLED_CONVERTERS];
+
+    CharsetDescriptor(bool supported) : supported(supported) {
+        for (std::atomic<UConverter*>& slot : idleConverters) {
+            slot.store(NULL, std::memory_order_relaxed);
+        }
     }
+};
 
-    // Get ICU's canonical name for this charset.
-    const char* icuCanonicalName = getICUCanonicalName(charsetNameChars.c_str());
-    if (icuCanonicalName == NULL) {
-        return NULL;
+// The descriptor of all unsupported charset names.
+static CharsetDescriptor unsupportedCharset(false);
+
+/*
+ * The cache of descriptors by the names they were requested with, and by their ICU canonical
+ * names, so that all names of a charset share one descriptor. Lookups only take the read lock, so
+ * threads looking up cached names never wait on each other.
+ */
+static pthread_rwlock_t descriptorCacheLock = PTHREAD_RWLOCK_INITIALIZER;
+static std::unordered_map<std::string, CharsetDescriptor*> descriptorsByName;
+static std::unordered_map<std::string, CharsetDescriptor*> descriptorsByIcuCanonicalName;
+static size_t unsupportedCharsetNameCount = 0;
+
+static CharsetDescriptor* getCachedCharsetDescriptor(const char* name) {
+    pthread_rwlock_rdlock(&descriptorCacheLock);
+    auto it = descriptorsByName.find(name);
+    CharsetDescriptor* descriptor = it != descriptorsByName.end() ? it->second : NULL;
+    pthread_rwlock_unlock(&descriptorCacheLock);
+    return descriptor;
+}
+
+// Check out an idle converter of the charset, or open a new one if there are none.
+static UConverter* checkoutConverter(CharsetDescriptor* descriptor, UErrorCode* status) {
+    for (std::atomic<UConverter*>& slot : descriptor->idleConverters) {
+        if (slot.load(std::memory_order_relaxed) == NULL) continue;
+        UConverter* converter = slot.exchange(NULL, std::memory_order_acquire);
+        if (converter != NULL) return converter;
     }
+    return ucnv_open(descriptor->icuCanonicalName.c_str(), status);
+}
 
-    // Get Java's canonical name for this charset.
-    jstring javaCanonicalName = getJavaCanonicalName(env, icuCanonicalName);
-    if (env->ExceptionCheck()) {
-        return NULL;
+// Reset and return a converter checked out with checkoutConverter(), or close it if the pool is full.
+static void returnConverter(CharsetDescriptor* descriptor, UConverter* converter) {
+    ucnv_reset(converter);
+    for (std::atomic<UConverter*>& slot : descriptor->idleConverters) {
+        UConverter* expected = NULL;
+        if (slot.compare_exchange_strong(expected, converter, std::memory_order_release, std::memory_order_relaxed)) return;
     }
+    ucnv_close(converter);
+}
+
+/*
+ * Get the descriptor for the charset name, resolving and caching it if it is not cached yet.
+ * Returns NULL only if a java exception is pending.
+ */
+static CharsetDescriptor* getCharsetDescriptor(JNIEnv* env, const char* name) {
+    CharsetDescriptor* descriptor = getCachedCharsetDescriptor(name);
+    if (descriptor != NULL) return descriptor;
 
-    // Check that this charset is supported.
-    {
-        // ICU doesn't offer any "isSupported", so we just open and immediately close.
+    // Get ICU's canonical name for this charset.
+    const char* icuCanonicalName = getICUCanonicalName(name);
+    UConverter* converter = NULL;
+    if (icuCanonicalName != NULL) {
+        // Check that this charset is supported. ICU doesn't offer any "isSupported", so we just
+        // open a converter, which is then kept in the pool.
         UErrorCode error = U_ZERO_ERROR;
-        icu::LocalUConverterPointer cnv(ucnv_open(icuCanonicalName, &error));
+        converter = ucnv_open(icuCanonicalName, &error);
         if (!U_SUCCESS(error)) {
-            return NULL;
+            converter = NULL;
         }
     }
 
-    // Get the aliases for this charset.
-    std::vector<std::string> aliases;
-    if (!collectStandardNames(env, icuCanonicalName, "IANA", aliases)) {
-        return NULL;
+    if (converter == NULL) {
+        descriptor = &unsupportedCharset;
+    } else {
+        descriptor = new CharsetDescriptor(true);
+        descriptor->icuCanonicalName = icuCanonicalName;
+        // Get Java's canonical name for this charset.
+        descriptor->javaCanonicalName = getJavaCanonicalName(icuCanonicalName);
+        // Get the aliases for this charset.
+        if (!collectStandardNames(env, icuCanonicalName, "IANA", descriptor->aliases) ||
+            !collectStandardNames(env, icuCanonicalName, "MIME", descriptor->aliases) ||
+            !collectStandardNames(env, icuCanonicalName, "JAVA", descriptor->aliases) ||
+            !collectStandardNames(env, icuCanonicalName, "WINDOWS", descriptor->aliases)) {
+            ucnv_close(converter);
+            delete descriptor;
+            return NULL;
+        }
+        descriptor->idleConverters[0].store(converter, std::memory_order_relaxed);
     }
-    if (!collectStandardNames(env, icuCanonicalName, "MIME", aliases)) {
-        return NULL;
+
+    pthread_rwlock_wrlock(&descriptorCacheLock);
+    if (descriptor->supported) {
+        // Share the descriptor of another name of the charset if it was resolved first.
+        auto it = descriptorsByIcuCanonicalName.find(descriptor->icuCanonicalName);
+        if (it != descriptorsByIcuCanonicalName.end()) {
+            ucnv_close(descriptor->idleConverters[0].load(std::memory_order_relaxed));
+            delete descriptor;
+            descriptor = it->second;
+        } else {
+            descriptorsByIcuCanonicalName.emplace(descriptor->icuCanonicalName, descriptor);
+        }
+        descriptorsByName.emplace(name, descriptor);
+    } else if (unsupportedCharsetNameCount < MAX_UNSUPPORTED_CHARSET_NAMES &&
+               descriptorsByName.emplace(name, descriptor).second) {
+        unsupportedCharsetNameCount++;
     }
-    if (!collectStandardNames(env, icuCanonicalName, "JAVA", aliases)) {
+    pthread_rwlock_unlock(&descriptorCacheLock);
+    return descriptor;
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL Java_com_termux_shared_file_libcore_NativeConverter_charsetForName
+  (JNIEnv* env, jclass, jstring charsetName) {
+    ScopedUtfChars charsetNameChars(env, charsetName);
+    if (charsetNameChars.c_str() == NULL) {
         return NULL;
     }
-    if (!collectStandardNames(env, icuCanonicalName, "WINDOWS", aliases)) {
+
+    CharsetDescriptor* descriptor = getCharsetDescriptor(env, charsetNameChars.c_str());
+    if (descriptor == NULL || !descriptor->supported) {
         return NULL;
     }
-    jobjectArray javaAliases = toStringArray(env, aliases);
+
+    jobjectArray javaAliases = toStringArray(env, descriptor->aliases);
     if (env->ExceptionCheck()) {
         return NULL;
     }
 
     // Construct the CharsetICU object.
     static jmethodID charsetConstructor = env->GetMethodID(JniConstants::GetCharsetICUClass(env), "<init>",
-            "(Ljava/lang/String;Ljava/lang/String;[Ljava/lang/String;)V");
+            "(Ljava/lang/String;Ljava/lang/String;[Ljava/lang/String;J)V");
     if (env->ExceptionCheck()) {
         return NULL;
     }
     return env->NewObject(JniConstants::GetCharsetICUClass(env), charsetConstructor,
-            javaCanonicalName, env->NewStringUTF(icuCanonicalName), javaAliases);
+            env->NewStringUTF(descriptor->javaCanonicalName.c_str()),
+            env->NewStringUTF(descriptor->icuCanonicalName.c_str()), javaAliases,
+            reinterpret_cast<jlong>(descriptor));
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL Java_com_termux_shared_file_libcore_NativeConverter_checkoutConverter
+  (JNIEnv* env, jclass, jlong descriptorHandle) {
+    CharsetDescriptor* descriptor = reinterpret_cast<CharsetDescriptor*>(descriptorHandle);
+    UErrorCode status = U_ZERO_ERROR;
+    UConverter* converter = checkoutConverter(descriptor, &status);
+    if (maybeThrowIcuException(env, "ucnv_open", status)) {
+        return 0;
+    }
+    return reinterpret_cast<jlong>(converter);
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_termux_shared_file_libcore_NativeConverter_returnConverter
+  (JNIEnv*, jclass, jlong descriptorHandle, jlong converterHandle) {
+    returnConverter(reinterpret_cast<CharsetDescriptor*>(descriptorHandle), reinterpret_cast<UConverter*>(converterHandle));
 }
@@ -1,10 +1,24 @@
+#include <dirent.h>
+#include <fcntl.h>
+#include <fnmatch.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <string>
+#include <vector>
 #include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <linux/stat.h>
 #include "include/scoped_utf_chars.h"
 #include "include/jni_constants.h"
 #include "include/readlink.h"
+#include "include/canonicalize_path.h"
+#include "include/chmod_tree.h"
+#include "include/copy_tree.h"
+#include "include/delete_tree.h"
+#include "include/file_io.h"
+#include "include/file_watcher.h"
+#include "include/process_runner.h"
 #include "include/properties.h"
 
 #include <netdb.h>
@@ -16,6 +30,14 @@
 #include <unistd.h>
 #include <net/if.h>
 
+#if defined(__ANDROID__)
+#include <android/api-level.h>
+#endif
+
+#ifndef STATX_MNT_ID
+#define STATX_MNT_ID 0x00001000U
+#endif
+
 #undef TEMP_FAILURE_RETRY
 #define TEMP_FAILURE_RETRY(exp) ({         \
     __typeof__(exp) _rc;                   \
@@ -98,6 +120,49 @@ static jobject doStat(JNIEnv* env, jstring javaPath, bool isLstat) {
     return makeStructStat(env, sb);
 }
 
+// The fields of each entry in the array returned by Os.statMany(). These must be kept in sync
+// with the StructStatArray.FIELD_* constants.
+enum {
+    STAT_MANY_FIELD_ERRNO,
+    STAT_MANY_FIELD_DEV,
+    STAT_MANY_FIELD_INO,
+    STAT_MANY_FIELD_MODE,
+    STAT_MANY_FIELD_NLINK,
+    STAT_MANY_FIELD_UID,
+    STAT_MANY_FIELD_GID,
+    STAT_MANY_FIELD_RDEV,
+    STAT_MANY_FIELD_SIZE,
+    STAT_MANY_FIELD_BLKSIZE,
+    STAT_MANY_FIELD_BLOCKS,
+    STAT_MANY_FIELD_ATIME_SEC,
+    STAT_MANY_FIELD_ATIME_NSEC,
+    STAT_MANY_FIELD_MTIME_SEC,
+    STAT_MANY_FIELD_MTIME_NSEC,
+    STAT_MANY_FIELD_CTIME_SEC,
+    STAT_MANY_FIELD_CTIME_NSEC,
+    STAT_MANY_FIELD_COUNT
+};
+
+static void packStructStat(jlong* entry, const struct stat& sb) {
+    entry[STAT_MANY_FIELD_ERRNO] = 0;
+    entry[STAT_MANY_FIELD_DEV] = static_cast<jlong>(sb.st_dev);
+    entry[STAT_MANY_FIELD_INO] = static_cast<jlong>(sb.st_ino);
+    entry[STAT_MANY_FIELD_MODE] = static_cast<jlong>(sb.st_mode);
+    entry[STAT_MANY_FIELD_NLINK] = static_cast<jlong>(sb.st_nlink);
+    entry[STAT_MANY_FIELD_UID] = static_cast<jlong>(sb.st_uid);
+    entry[STAT_MANY_FIELD_GID] = static_cast<jlong>(sb.st_gid);
+    entry[STAT_MANY_FIELD_RDEV] = static_cast<jlong>(sb.st_rdev);
+    entry[STAT_MANY_FIELD_SIZE] = static_cast<jlong>(sb.st_size);
+    entry[STAT_MANY_FIELD_BLKSIZE] = static_cast<jlong>(sb.st_blksize);
+    entry[STAT_MANY_FIELD_BLOCKS] = static_cast<jlong>(sb.st_blocks);
+    entry[STAT_MANY_FIELD_ATIME_SEC] = static_cast<jlong>(sb.st_atim.tv_sec);
+    entry[STAT_MANY_FIELD_ATIME_NSEC] = static_cast<jlong>(sb.st_atim.tv_nsec);
+    entry[STAT_MANY_FIELD_MTIME_SEC] = static_cast<jlong>(sb.st_mtim.tv_sec);
+    entry[STAT_MANY_FIELD_MTIME_NSEC] = static_cast<jlong>(sb.st_mtim.tv_nsec);
+    entry[STAT_MANY_FIELD_CTIME_SEC] = static_cast<jlong>(sb.st_ctim.tv_sec);
+    entry[STAT_MANY_FIELD_CTIME_NSEC] = static_cast<jlong>(sb.st_ctim.tv_nsec);
+}
+
 extern "C"
 JNIEXPORT jstring JNICALL Java_com_termux_shared_file_libcore_Os_readlink
   (JNIEnv *env, jclass, jstring javaPath) {
@@ -136,6 +201,196 @@ JNIEXPORT jobject JNICALL Java_com_termux_shared_file_libcore_Os_lstat
     return doStat(env, javaPath, true);
 }
 
+/*
+ * Stat all paths with a single JNI call and return the results packed in a long array with
+ * STAT_MANY_FIELD_COUNT fields for each path, instead of creating a StructStat object for each.
+ * Failures are not thrown but reported with the errno field of the entry, which is 0 on success.
+ * The only supported flag is AT_SYMLINK_NOFOLLOW, to lstat() instead of stat().
+ */
+extern "C"
+JNIEXPORT jlongArray JNICALL Java_com_termux_shared_file_libcore_Os_statMany
+  (JNIEnv *env, jclass, jobjectArray javaPaths, jint flags) {
+    if (javaPaths == NULL) {
+        jniThrowNullPointerException(env);
+        return NULL;
+    }
+
+    jsize count = env->GetArrayLength(javaPaths);
+    std::vector<jlong> entries(static_cast<size_t>(count) * STAT_MANY_FIELD_COUNT, 0);
+    int statFlags = flags & AT_SYMLINK_NOFOLLOW;
+
+    for (jsize i = 0; i < count; i++) {
+        jlong* entry = &entries[static_cast<size_t>(i) * STAT_MANY_FIELD_COUNT];
+
+        ScopedLocalRef<jstring> javaPath(env, reinterpret_cast<jstring>(env->GetObjectArrayElement(javaPaths, i)));
+        if (env->ExceptionCheck()) return NULL;
+        if (javaPath.get() == NULL) {
+            entry[STAT_MANY_FIELD_ERRNO] = EINVAL;
+            continue;
+        }
+
+        const char* path = env->GetStringUTFChars(javaPath.get(), NULL);
+        if (path == NULL) return NULL;
+
+        struct stat sb;
+        int rc = TEMP_FAILURE_RETRY(fstatat(AT_FDCWD, path, &sb, statFlags));
+        if (rc == -1)
+            entry[STAT_MANY_FIELD_ERRNO] = errno;
+        else
+            packStructStat(entry, sb);
+
+        env->ReleaseStringUTFChars(javaPath.get(), path);
+    }
+
+    jlongArray result = env->NewLongArray(static_cast<jsize>(entries.size()));
+    if (result == NULL) return NULL;
+    env->SetLongArrayRegion(result, 0, static_cast<jsize>(entries.size()), entries.data());
+    return result;
+}
+
+// The fields of the array returned by Os.statxNative(). These must be kept in sync with the
+// StructStatx.FIELD_* constants.
+enum {
+    STATX_FIELD_MASK,
+    STATX_FIELD_BLKSIZE,
+    STATX_FIELD_ATTRIBUTES,
+    STATX_FIELD_NLINK,
+    STATX_FIELD_UID,
+    STATX_FIELD_GID,
+    STATX_FIELD_MODE,
+    STATX_FIELD_INO,
+    STATX_FIELD_SIZE,
+    STATX_FIELD_BLOCKS,
+    STATX_FIELD_ATIME_SEC,
+    STATX_FIELD_ATIME_NSEC,
+    STATX_FIELD_BTIME_SEC,
+    STATX_FIELD_BTIME_NSEC,
+    STATX_FIELD_CTIME_SEC,
+    STATX_FIELD_CTIME_NSEC,
+    STATX_FIELD_MTIME_SEC,
+    STATX_FIELD_MTIME_NSEC,
+    STATX_FIELD_RDEV,
+    STATX_FIELD_DEV,
+    STATX_FIELD_MNT_ID,
+    STATX_FIELD_COUNT
+};
+
+// Whether the statx() system call can be used. It is 1 if it can, 0 if it cannot and -1 if not
+// yet checked. Before Android 11, statx() is not allowed by the seccomp filter of app processes
+// and calling it would kill the process with SIGSYS, so do not even try.
+static volatile int statxSupported = -1;
+
+static bool isStatxSupported() {
+    int supported = __atomic_load_n(&statxSupported, __ATOMIC_RELAXED);
+    if (supported < 0) {
+#if !defined(__NR_statx)
+        supported = 0;
+#elif defined(__ANDROID__)
+        supported = android_get_device_api_level() >= 30 ? 1 : 0;
+#else
+        supported = 1;
+#endif
+        __atomic_store_n(&statxSupported, supported, __ATOMIC_RELAXED);
+    }
+    return supported == 1;
+}
+
+static void packStatx(jlong* entry, const struct statx& stx) {
+    entry[STATX_FIELD_MASK] = static_cast<jlong>(stx.stx_mask);
+    entry[STATX_FIELD_BLKSIZE] = static_cast<jlong>(stx.stx_blksize);
+    entry[STATX_FIELD_ATTRIBUTES] = static_cast<jlong>(stx.stx_attributes);
+    entry[STATX_FIELD_NLINK] = static_cast<jlong>(stx.stx_nlink);
+    entry[STATX_FIELD_UID] = static_cast<jlong>(stx.stx_uid);
+    entry[STATX_FIELD_GID] = static_cast<jlong>(stx.stx_gid);
+    entry[STATX_FIELD_MODE] = static_cast<jlong>(stx.stx_mode);
+    entry[STATX_FIELD_INO] = static_cast<jlong>(stx.stx_ino);
+    entry[STATX_FIELD_SIZE] = static_cast<jlong>(stx.stx_size);
+    entry[STATX_FIELD_BLOCKS] = static_cast<jlong>(stx.stx_blocks);
+    entry[STATX_FIELD_ATIME_SEC] = static_cast<jlong>(stx.stx_atime.tv_sec);
+    entry[STATX_FIELD_ATIME_NSEC] = static_cast<jlong>(stx.stx_atime.tv_nsec);
+    entry[STATX_FIELD_BTIME_SEC] = static_cast<jlong>(stx.stx_btime.tv_sec);
+    entry[STATX_FIELD_BTIME_NSEC] = static_cast<jlong>(stx.stx_btime.tv_nsec);
+    entry[STATX_FIELD_CTIME_SEC] = static_cast<jlong>(stx.stx_ctime.tv_sec);
+    entry[STATX_FIELD_CTIME_NSEC] = static_cast<jlong>(stx.stx_ctime.tv_nsec);
+    entry[STATX_FIELD_MTIME_SEC] = static_cast<jlong>(stx.stx_mtime.tv_sec);
+    entry[STATX_FIELD_MTIME_NSEC] = static_cast<jlong>(stx.stx_mtime.tv_nsec);
+    entry[STATX_FIELD_RDEV] = static_cast<jlong>(makedev(stx.stx_rdev_major, stx.stx_rdev_minor));
+    entry[STATX_FIELD_DEV] = static_cast<jlong>(makedev(stx.stx_dev_major, stx.stx_dev_minor));
+    entry[STATX_FIELD_MNT_ID] = static_cast<jlong>(stx.stx_mnt_id);
+}
+
+// Pack a struct stat in the statx layout. Only the STATX_BASIC_STATS fields are available.
+static void packStatxFromStat(jlong* entry, const struct stat& sb) {
+    entry[STATX_FIELD_MASK] = static_cast<jlong>(STATX_BASIC_STATS);
+    entry[STATX_FIELD_BLKSIZE] = static_cast<jlong>(sb.st_blksize);
+    entry[STATX_FIELD_NLINK] = static_cast<jlong>(sb.st_nlink);
+    entry[STATX_FIELD_UID] = static_cast<jlong>(sb.st_uid);
+    entry[STATX_FIELD_GID] = static_cast<jlong>(sb.st_gid);
+    entry[STATX_FIELD_MODE] = static_cast<jlong>(sb.st_mode);
+    entry[STATX_FIELD_INO] = static_cast<jlong>(sb.st_ino);
+    entry[STATX_FIELD_SIZE] = static_cast<jlong>(sb.st_size);
+    entry[STATX_FIELD_BLOCKS] = static_cast<jlong>(sb.st_blocks);
+    entry[STATX_FIELD_ATIME_SEC] = static_cast<jlong>(sb.st_atim.tv_sec);
+    entry[STATX_FIELD_ATIME_NSEC] = static_cast<jlong>(sb.st_atim.tv_nsec);
+    entry[STATX_FIELD_CTIME_SEC] = static_cast<jlong>(sb.st_ctim.tv_sec);
+    entry[STATX_FIELD_CTIME_NSEC] = static_cast<jlong>(sb.st_ctim.tv_nsec);
+    entry[STATX_FIELD_MTIME_SEC] = static_cast<jlong>(sb.st_mtim.tv_sec);
+    entry[STATX_FIELD_MTIME_NSEC] = static_cast<jlong>(sb.st_mtim.tv_nsec);
+    entry[STATX_FIELD_RDEV] = static_cast<jlong>(sb.st_rdev);
+    entry[STATX_FIELD_DEV] = static_cast<jlong>(sb.st_dev);
+}
+
+/*
+ * Run statx() for path, requesting only the fields in mask, so that filesystems like FUSE can skip
+ * fetching the fields that are not needed. The STATX_FIELD_MASK field of the result has the
+ * fields that were actually filled. If statx() is not supported by the kernel or not allowed for
+ * the process, fstatat() is used instead and only the STATX_BASIC_STATS fields are filled.
+ * The supported flags are AT_SYMLINK_NOFOLLOW and the AT_STATX_* sync flags, the latter of which
+ * are ignored by the fstatat() fallback.
+ */
+extern "C"
+JNIEXPORT jlongArray JNICALL Java_com_termux_shared_file_libcore_Os_statxNative
+  (JNIEnv *env, jclass, jstring javaPath, jint flags, jint mask) {
+    ScopedUtfChars path(env, javaPath);
+    if (path.c_str() == NULL) { return NULL; }
+
+    jlong entry[STATX_FIELD_COUNT] = {};
+
+    bool done = false;
+#if defined(__NR_statx)
+    if (isStatxSupported()) {
+        struct statx stx = {};
+        int rc = TEMP_FAILURE_RETRY(syscall(__NR_statx, AT_FDCWD, path.c_str(),
+                flags & (AT_SYMLINK_NOFOLLOW | AT_STATX_SYNC_TYPE), static_cast<unsigned int>(mask), &stx));
+        if (rc == 0) {
+            packStatx(entry, stx);
+            done = true;
+        } else if (errno == ENOSYS) {
+            // Kernels older than 4.11
+            __atomic_store_n(&statxSupported, 0, __ATOMIC_RELAXED);
+        } else {
+            throwErrnoException(env, "statx");
+            return NULL;
+        }
+    }
+#endif
+
+    if (!done) {
+        struct stat sb;
+        int rc = TEMP_FAILURE_RETRY(fstatat(AT_FDCWD, path.c_str(), &sb, flags & AT_SYMLINK_NOFOLLOW));
+        if (rc == -1) {
+            throwErrnoException(env, "statx");
+            return NULL;
+        }
+        packStatxFromStat(entry, sb);
+    }
+
+    jlongArray result = env->NewLongArray(STATX_FIELD_COUNT);
+    if (result == NULL) return NULL;
+    env->SetLongArrayRegion(result, 0, STATX_FIELD_COUNT, entry);
+    return result;
+}
+
 extern "C"
 JNIEXPORT jobject JNICALL Java_com_termux_shared_file_libcore_Os_fstat
   (JNIEnv *env, jclass, jobject javaFd) {
@@ -157,6 +412,1041 @@ JNIEXPORT void JNICALL Java_com_termux_shared_file_libcore_Os_chmod
     throwIfMinusOne(env, "chmod", TEMP_FAILURE_RETRY(chmod(path.c_str(), mode)));
 }
 
+// The values of the com.termux.shared.file.filesystem.FileType enum
+enum {
+    FILE_TYPE_REGULAR = 1,
+    FILE_TYPE_DIRECTORY = 2,
+    FILE_TYPE_SYMLINK = 4,
+    FILE_TYPE_SOCKET = 8,
+    FILE_TYPE_CHARACTER = 16,
+    FILE_TYPE_FIFO = 32,
+    FILE_TYPE_BLOCK = 64,
+    FILE_TYPE_UNKNOWN = 128
+};
+
+static int fileTypeFromMode(mode_t mode) {
+    switch (mode & S_IFMT) {
+        case S_IFREG: return FILE_TYPE_REGULAR;
+        case S_IFDIR: return FILE_TYPE_DIRECTORY;
+        case S_IFLNK: return FILE_TYPE_SYMLINK;
+        case S_IFSOCK: return FILE_TYPE_SOCKET;
+        case S_IFCHR: return FILE_TYPE_CHARACTER;
+        case S_IFIFO: return FILE_TYPE_FIFO;
+        case S_IFBLK: return FILE_TYPE_BLOCK;
+        default: return FILE_TYPE_UNKNOWN;
+    }
+}
+
+// Returns 0 for DT_UNKNOWN, in which case the type must be found with fstatat().
+static int fileTypeFromDirentType(unsigned char type) {
+    switch (type) {
+        case DT_REG: return FILE_TYPE_REGULAR;
+        case DT_DIR: return FILE_TYPE_DIRECTORY;
+        case DT_LNK: return FILE_TYPE_SYMLINK;
+        case DT_SOCK: return FILE_TYPE_SOCKET;
+        case DT_CHR: return FILE_TYPE_CHARACTER;
+        case DT_FIFO: return FILE_TYPE_FIFO;
+        case DT_BLK: return FILE_TYPE_BLOCK;
+        default: return 0;
+    }
+}
+
+// The flags of FileTreeWalker.walkNative(). These must be kept in sync with the
+// FileTreeWalker.FLAG_* constants.
+enum {
+    WALK_FLAG_DELETE = 1,
+    WALK_FLAG_STAT = 2,
+    WALK_FLAG_REPORT = 4
+};
+
+// The fields of each entry in the entries array passed to FileTreeWalker.onNativeBatch(). These
+// must be kept in sync with the FileTreeWalker.Batch.FIELD_* constants.
+enum {
+    WALK_ENTRY_FIELD_PATH_OFFSET,
+    WALK_ENTRY_FIELD_PATH_LENGTH,
+    WALK_ENTRY_FIELD_TYPE,
+    WALK_ENTRY_FIELD_MODE,
+    WALK_ENTRY_FIELD_SIZE,
+    WALK_ENTRY_FIELD_MTIME_MILLIS,
+    WALK_ENTRY_FIELD_DEPTH,
+    WALK_ENTRY_FIELD_ERRNO,
+    WALK_ENTRY_FIELD_COUNT
+};
+
+struct linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+struct WalkDirent {
+    std::string name;
+    unsigned char type;
+};
+
+struct FileTreeWalk {
+    JNIEnv* env;
+    jobject walker;
+    jmethodID onNativeBatch;
+
+    int flags;
+    int fileTypeFlags;
+    int maxDepth;
+    jlong minMtimeMillis;
+    jlong maxMtimeMillis;
+    const char* nameGlob;
+    size_t batchSize;
+
+    // Shared by all directories since they are read completely before recursing into any
+    std::vector<char> direntsBuffer = std::vector<char>(32 * 1024);
+
+    // The UTF-8 paths relative to the root directory, each terminated with a null byte
+    std::vector<char> batchPaths;
+    std::vector<jlong> batchEntries;
+    size_t batchCount = 0;
+
+    jlong matchedCount = 0;
+    jlong failedCount = 0;
+    int firstFailedErrno = 0;
+    std::string firstFailedPath;
+
+    // The errno of failing to read the root directory, which is thrown like failing to open it
+    int rootReadErrno = 0;
+
+    bool stopped = false;
+};
+
+static bool flushWalkBatch(FileTreeWalk& w) {
+    if (w.batchCount == 0) return true;
+
+    JNIEnv* env = w.env;
+    ScopedLocalRef<jbyteArray> paths(env, env->NewByteArray(static_cast<jsize>(w.batchPaths.size())));
+    if (paths.get() == NULL) return false;
+    env->SetByteArrayRegion(paths.get(), 0, static_cast<jsize>(w.batchPaths.size()),
+            reinterpret_cast<const jbyte*>(w.batchPaths.data()));
+
+    ScopedLocalRef<jlongArray> entries(env, env->NewLongArray(static_cast<jsize>(w.batchEntries.size())));
+    if (entries.get() == NULL) return false;
+    env->SetLongArrayRegion(entries.get(), 0, static_cast<jsize>(w.batchEntries.size()), w.batchEntries.data());
+
+    jboolean cont = env->CallBooleanMethod(w.walker, w.onNativeBatch, paths.get(), entries.get(),
+            static_cast<jint>(w.batchCount));
+
+    w.batchPaths.clear();
+    w.batchEntries.clear();
+    w.batchCount = 0;
+
+    return !env->ExceptionCheck() && cont;
+}
+
+static void addWalkEntry(FileTreeWalk& w, const std::string& path, int type, const struct stat* sb,
+        int depth, int error) {
+    if (error != 0) {
+        if (w.failedCount++ == 0) {
+            w.firstFailedErrno = error;
+            w.firstFailedPath = path;
+        }
+    }
+
+    if (!(w.flags & WALK_FLAG_REPORT)) return;
+
+    size_t offset = w.batchPaths.size();
+    w.batchPaths.insert(w.batchPaths.end(), path.begin(), path.end());
+    w.batchPaths.push_back('\0');
+
+    size_t entry = w.batchEntries.size();
+    w.batchEntries.resize(entry + WALK_ENTRY_FIELD_COUNT, 0);
+    jlong* fields = &w.batchEntries[entry];
+    fields[WALK_ENTRY_FIELD_PATH_OFFSET] = static_cast<jlong>(offset);
+    fields[WALK_ENTRY_FIELD_PATH_LENGTH] = static_cast<jlong>(path.size());
+    fields[WALK_ENTRY_FIELD_TYPE] = type;
+    if (sb != NULL) {
+        fields[WALK_ENTRY_FIELD_MODE] = static_cast<jlong>(sb->st_mode);
+        fields[WALK_ENTRY_FIELD_SIZE] = static_cast<jlong>(sb->st_size);
+        fields[WALK_ENTRY_FIELD_MTIME_MILLIS] = static_cast<jlong>(sb->st_mtim.tv_sec) * 1000 + sb->st_mtim.tv_nsec / 1000000;
+    }
+    fields[WALK_ENTRY_FIELD_DEPTH] = depth;
+    fields[WALK_ENTRY_FIELD_ERRNO] = error;
+
+    if (++w.batchCount >= w.batchSize && !flushWalkBatch(w))
+        w.stopped = true;
+}
+
+// Read all entries of the directory before processing any of them, since entries may be deleted.
+static int readWalkDirents(FileTreeWalk& w, int dirFd, std::vector<WalkDirent>& dirents) {
+    char* buf = w.direntsBuffer.data();
+    for (;;) {
+        long n = TEMP_FAILURE_RETRY(syscall(__NR_getdents64, dirFd, buf, w.direntsBuffer.size()));
+        if (n == -1) return errno;
+        if (n == 0) return 0;
+
+        for (long pos = 0; pos < n;) {
+            struct linux_dirent64* d = reinterpret_cast<struct linux_dirent64*>(buf + pos);
+            pos += d->d_reclen;
+            if (strcmp(d->d_name, ".") == 0 || strcmp(d->d_name, "..") == 0) continue;
+            dirents.push_back({d->d_name, d->d_type});
+        }
+    }
+}
+
+/*
+ * Walk the directory at dirFd, which is closed before returning. All paths are relative to the
+ * dirFd of their parent directory, so no symlinks are followed and path lookups are not repeated.
+ */
+static void walkDirectory(FileTreeWalk& w, int dirFd, const std::string& dirPath, int depth) {
+    std::vector<WalkDirent> dirents;
+    int error = readWalkDirents(w, dirFd, dirents);
+    if (error != 0) {
+        if (depth == 1) {
+            w.rootReadErrno = error;
+            w.stopped = true;
+            close(dirFd);
+            return;
+        }
+        addWalkEntry(w, dirPath, FILE_TYPE_DIRECTORY, NULL, depth - 1, error);
+    }
+
+    bool filterMtime = w.minMtimeMillis != INT64_MIN || w.maxMtimeMillis != INT64_MAX;
+
+    for (const WalkDirent& dirent : dirents) {
+        if (w.stopped) break;
+
+        std::string path = dirPath.empty() ? dirent.name : dirPath + "/" + dirent.name;
+        const char* name = dirent.name.c_str();
+
+        int type = fileTypeFromDirentType(dirent.type);
+        struct stat sb;
+        bool hasStat = false;
+        if (type == 0 || filterMtime || (w.flags & WALK_FLAG_STAT)) {
+            if (TEMP_FAILURE_RETRY(fstatat(dirFd, name, &sb, AT_SYMLINK_NOFOLLOW)) == -1) {
+                // Deleted since the directory was read
+                if (errno != ENOENT)
+                    addWalkEntry(w, path, type == 0 ? FILE_TYPE_UNKNOWN : type, NULL, depth, errno);
+                continue;
+            }
+            type = fileTypeFromMode(sb.st_mode);
+            hasStat = true;
+        }
+
+        bool matches = (w.fileTypeFlags & type) != 0;
+        if (matches && filterMtime) {
+            jlong mtimeMillis = static_cast<jlong>(sb.st_mtim.tv_sec) * 1000 + sb.st_mtim.tv_nsec / 1000000;
+            matches = mtimeMillis >= w.minMtimeMillis && mtimeMillis <= w.maxMtimeMillis;
+        }
+        if (matches && w.nameGlob != NULL)
+            matches = fnmatch(w.nameGlob, name, 0) == 0;
+
+        bool isDirectory = type == FILE_TYPE_DIRECTORY;
+        bool deleteEntry = matches && (w.flags & WALK_FLAG_DELETE);
+
+        // Report directories before their contents, unless they need to be deleted after them
+        if (matches && !deleteEntry) {
+            w.matchedCount++;
+            addWalkEntry(w, path, type, hasStat ? &sb : NULL, depth, 0);
+            if (w.stopped) break;
+        }
+
+        if (isDirectory && depth < w.maxDepth) {
+            int subDirFd = TEMP_FAILURE_RETRY(openat(dirFd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+            if (subDirFd == -1) {
+                if (errno != ENOENT)
+                    addWalkEntry(w, path, type, hasStat ? &sb : NULL, depth, errno);
+                continue;
+            }
+            walkDirectory(w, subDirFd, path, depth + 1);
+            if (w.stopped) break;
+        }
+
+        if (deleteEntry) {
+            w.matchedCount++;
+            int rc = unlinkat(dirFd, name, isDirectory ? AT_REMOVEDIR : 0);
+            addWalkEntry(w, path, type, hasStat ? &sb : NULL, depth, rc == -1 && errno != ENOENT ? errno : 0);
+        }
+    }
+
+    close(dirFd);
+}
+
+/*
+ * Walk the file tree under the directory at rootPath, without including rootPath itself and
+ * without following symlinks. Entries matching the fileTypeFlags, mtime range and nameGlob are
+ * deleted with WALK_FLAG_DELETE and reported to FileTreeWalker.onNativeBatch() in batches of
+ * batchSize with WALK_FLAG_REPORT. Failures for entries are counted and reported, but do not stop
+ * the walk, only failing to open or read rootPath is thrown.
+ */
+extern "C"
+JNIEXPORT void JNICALL Java_com_termux_shared_file_filesystem_FileTreeWalker_walkNative
+  (JNIEnv *env, jclass, jobject walker, jstring javaRootPath, jint flags, jint fileTypeFlags,
+   jint maxDepth, jlong minMtimeMillis, jlong maxMtimeMillis, jstring javaNameGlob, jint batchSize) {
+    if (walker == NULL) {
+        jniThrowNullPointerException(env);
+        return;
+    }
+
+    ScopedUtfChars rootPath(env, javaRootPath);
+    if (rootPath.c_str() == NULL) { return; }
+
+    const char* nameGlob = NULL;
+    if (javaNameGlob != NULL) {
+        nameGlob = env->GetStringUTFChars(javaNameGlob, NULL);
+        if (nameGlob == NULL) return;
+    }
+
+    static jclass walkerClass = reinterpret_cast<jclass>(env->NewGlobalRef(env->GetObjectClass(walker)));
+    static jmethodID onNativeBatch = env->GetMethodID(walkerClass, "onNativeBatch", "([B[JI)Z");
+    static jfieldID matchedCountField = env->GetFieldID(walkerClass, "mMatchedCount", "J");
+    static jfieldID failedCountField = env->GetFieldID(walkerClass, "mFailedCount", "J");
+    static jfieldID firstFailedErrnoField = env->GetFieldID(walkerClass, "mFirstFailedErrno", "I");
+    static jfieldID firstFailedPathField = env->GetFieldID(walkerClass, "mFirstFailedPath", "Ljava/lang/String;");
+
+    FileTreeWalk w;
+    w.env = env;
+    w.walker = walker;
+    w.onNativeBatch = onNativeBatch;
+    w.flags = flags;
+    w.fileTypeFlags = fileTypeFlags;
+    w.maxDepth = maxDepth;
+    w.minMtimeMillis = minMtimeMillis;
+    w.maxMtimeMillis = maxMtimeMillis;
+    w.nameGlob = nameGlob;
+    w.batchSize = batchSize > 0 ? static_cast<size_t>(batchSize) : 1;
+
+    int rootFd = TEMP_FAILURE_RETRY(open(rootPath.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+    if (rootFd == -1) {
+        if (nameGlob != NULL) env->ReleaseStringUTFChars(javaNameGlob, nameGlob);
+        throwErrnoException(env, "open");
+        return;
+    }
+
+    if (maxDepth > 0)
+        walkDirectory(w, rootFd, "", 1);
+    else
+        close(rootFd);
+
+    if (nameGlob != NULL) env->ReleaseStringUTFChars(javaNameGlob, nameGlob);
+
+    if (env->ExceptionCheck()) return;
+    if (w.rootReadErrno != 0) {
+        errno = w.rootReadErrno;
+        throwErrnoException(env, "getdents64");
+        return;
+    }
+    if (!w.stopped) flushWalkBatch(w);
+    if (env->ExceptionCheck()) return;
+
+    env->SetLongField(walker, matchedCountField, w.matchedCount);
+    env->SetLongField(walker, failedCountField, w.failedCount);
+    env->SetIntField(walker, firstFailedErrnoField, w.firstFailedErrno);
+    if (w.failedCount > 0) {
+        ScopedLocalRef<jstring> firstFailedPath(env, env->NewStringUTF(w.firstFailedPath.c_str()));
+        env->SetObjectField(walker, firstFailedPathField, firstFailedPath.get());
+    }
+}
+
+// The fields of each entry in the entries array set by DirectoryLister.readNative(). These must be
+// kept in sync with the DirectoryLister.Page.FIELD_* constants.
+enum {
+    LIST_ENTRY_FIELD_NAME_OFFSET,
+    LIST_ENTRY_FIELD_NAME_LENGTH,
+    LIST_ENTRY_FIELD_TYPE,
+    LIST_ENTRY_FIELD_MODE,
+    LIST_ENTRY_FIELD_SIZE,
+    LIST_ENTRY_FIELD_MTIME_MILLIS,
+    LIST_ENTRY_FIELD_ERRNO,
+    LIST_ENTRY_FIELD_COUNT
+};
+
+/*
+ * An open directory being listed by DirectoryLister. The getdents64() buffer is kept between
+ * pages, so entries are only read from the kernel as they are needed.
+ */
+struct DirectoryListing {
+    int fd = -1;
+    std::vector<char> direntsBuffer = std::vector<char>(32 * 1024);
+    long direntsLength = 0;
+    long direntsPosition = 0;
+    bool ended = false;
+};
+
+extern "C"
+JNIEXPORT jlong JNICALL Java_com_termux_shared_file_filesystem_DirectoryLister_openNative
+  (JNIEnv *env, jclass, jstring javaPath) {
+    ScopedUtfChars path(env, javaPath);
+    if (path.c_str() == NULL) { return 0; }
+
+    int fd = TEMP_FAILURE_RETRY(open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (fd == -1) {
+        throwErrnoException(env, "open");
+        return 0;
+    }
+
+    DirectoryListing* listing = new DirectoryListing();
+    listing->fd = fd;
+    return reinterpret_cast<jlong>(listing);
+}
+
+/*
+ * Read the next page of up to maxEntries entries of the directory, without "." and "..", into
+ * the mPageNames and mPageEntries fields of the DirectoryLister. The names are UTF-8, each
+ * terminated with a null byte. With statEntries, the mode, size and modification time of each
+ * entry are found with fstatat() relative to the directory fd, otherwise only if the type is not
+ * known from getdents64(). Symlinks are not followed. Entries that fail to be stat-ed are reported
+ * with their errno. Returns the number of entries read, which is 0 once all entries have been read.
+ */
+extern "C"
+JNIEXPORT jint JNICALL Java_com_termux_shared_file_filesystem_DirectoryLister_readNative
+  (JNIEnv *env, jclass, jlong handle, jobject lister, jint maxEntries, jboolean statEntries) {
+    if (lister == NULL) {
+        jniThrowNullPointerException(env);
+        return 0;
+    }
+
+    static jclass listerClass = reinterpret_cast<jclass>(env->NewGlobalRef(env->GetObjectClass(lister)));
+    static jfieldID pageNamesField = env->GetFieldID(listerClass, "mPageNames", "[B");
+    static jfieldID pageEntriesField = env->GetFieldID(listerClass, "mPageEntries", "[J");
+
+    DirectoryListing* listing = reinterpret_cast<DirectoryListing*>(handle);
+    std::vector<char> names;
+    std::vector<jlong> entries;
+    jint count = 0;
+
+    while (count < maxEntries) {
+        if (listing->direntsPosition >= listing->direntsLength) {
+            if (listing->ended) break;
+            long n = TEMP_FAILURE_RETRY(syscall(__NR_getdents64, listing->fd, listing->direntsBuffer.data(),
+                    listing->direntsBuffer.size()));
+            if (n == -1) {
+                throwErrnoException(env, "getdents64");
+                return 0;
+            }
+            listing->direntsLength = n;
+            listing->direntsPosition = 0;
+            if (n == 0) {
+                listing->ended = true;
+                break;
+            }
+        }
+
+        struct linux_dirent64* d = reinterpret_cast<struct linux_dirent64*>(listing->direntsBuffer.data() + listing->direntsPosition);
+        listing->direntsPosition += d->d_reclen;
+        if (strcmp(d->d_name, ".") == 0 || strcmp(d->d_name, "..") == 0) continue;
+
+        int type = fileTypeFromDirentType(d->d_type);
+        struct stat sb;
+        bool hasStat = false;
+        int error = 0;
+        if (type == 0 || statEntries) {
+            if (TEMP_FAILURE_RETRY(fstatat(listing->fd, d->d_name, &sb, AT_SYMLINK_NOFOLLOW)) == -1) {
+                // Deleted since the directory was read
+                if (errno == ENOENT) continue;
+                error = errno;
+                if (type == 0) type = FILE_TYPE_UNKNOWN;
+            } else {
+                type = fileTypeFromMode(sb.st_mode);
+                hasStat = true;
+            }
+        }
+
+        size_t nameLength = strlen(d->d_name);
+        size_t offset = names.size();
+        names.insert(names.end(), d->d_name, d->d_name + nameLength);
+        names.push_back('\0');
+
+        size_t entry = entries.size();
+        entries.resize(entry + LIST_ENTRY_FIELD_COUNT, 0);
+        jlong* fields = &entries[entry];
+        fields[LIST_ENTRY_FIELD_NAME_OFFSET] = static_cast<jlong>(offset);
+        fields[LIST_ENTRY_FIELD_NAME_LENGTH] = static_cast<jlong>(nameLength);
+        fields[LIST_ENTRY_FIELD_TYPE] = type;
+        if (hasStat) {
+            fields[LIST_ENTRY_FIELD_MODE] = static_cast<jlong>(sb.st_mode);
+            fields[LIST_ENTRY_FIELD_SIZE] = static_cast<jlong>(sb.st_size);
+            fields[LIST_ENTRY_FIELD_MTIME_MILLIS] = static_cast<jlong>(sb.st_mtim.tv_sec) * 1000 + sb.st_mtim.tv_nsec / 1000000;
+        }
+        fields[LIST_ENTRY_FIELD_ERRNO] = error;
+        count++;
+    }
+
+    ScopedLocalRef<jbyteArray> pageNames(env, env->NewByteArray(static_cast<jsize>(names.size())));
+    if (pageNames.get() == NULL) return 0;
+    env->SetByteArrayRegion(pageNames.get(), 0, static_cast<jsize>(names.size()), reinterpret_cast<const jbyte*>(names.data()));
+    ScopedLocalRef<jlongArray> pageEntries(env, env->NewLongArray(static_cast<jsize>(entries.size())));
+    if (pageEntries.get() == NULL) return 0;
+    env->SetLongArrayRegion(pageEntries.get(), 0, static_cast<jsize>(entries.size()), entries.data());
+
+    env->SetObjectField(lister, pageNamesField, pageNames.get());
+    env->SetObjectField(lister, pageEntriesField, pageEntries.get());
+    return count;
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_termux_shared_file_filesystem_DirectoryLister_closeNative
+  (JNIEnv *, jclass, jlong handle) {
+    DirectoryListing* listing = reinterpret_cast<DirectoryListing*>(handle);
+    close(listing->fd);
+    delete listing;
+}
+
+/*
+ * Delete everything under the directory at rootPath with deleteTree() on threadCount threads.
+ * FileTreeDeleter.onNativeProgress() is called on the calling thread every progressIntervalMillis
+ * if it is > 0. Only failing to open rootPath is thrown, the failures for files under it are set
+ * in the FileTreeDeleter fields.
+ */
+extern "C"
+JNIEXPORT void JNICALL Java_com_termux_shared_file_filesystem_FileTreeDeleter_deleteNative
+  (JNIEnv *env, jclass, jobject deleter, jstring javaRootPath, jint threadCount, jint maxErrors,
+   jlong progressIntervalMillis) {
+    if (deleter == NULL) {
+        jniThrowNullPointerException(env);
+        return;
+    }
+
+    ScopedUtfChars rootPath(env, javaRootPath);
+    if (rootPath.c_str() == NULL) { return; }
+
+    static jclass deleterClass = reinterpret_cast<jclass>(env->NewGlobalRef(env->GetObjectClass(deleter)));
+    static jclass stringClass = reinterpret_cast<jclass>(env->NewGlobalRef(env->FindClass("java/lang/String")));
+    static jmethodID onNativeProgress = env->GetMethodID(deleterClass, "onNativeProgress", "(JJ)Z");
+    static jfieldID deletedCountField = env->GetFieldID(deleterClass, "mDeletedCount", "J");
+    static jfieldID failedCountField = env->GetFieldID(deleterClass, "mFailedCount", "J");
+    static jfieldID cancelledField = env->GetFieldID(deleterClass, "mCancelled", "Z");
+    static jfieldID errorPathsField = env->GetFieldID(deleterClass, "mErrorPaths", "[Ljava/lang/String;");
+    static jfieldID errorErrnosField = env->GetFieldID(deleterClass, "mErrorErrnos", "[I");
+
+    int rootFd = TEMP_FAILURE_RETRY(open(rootPath.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+    if (rootFd == -1) {
+        throwErrnoException(env, "open");
+        return;
+    }
+
+    DeleteTreeResult result;
+    deleteTree(rootFd, threadCount > 0 ? threadCount : 1, maxErrors > 0 ? static_cast<size_t>(maxErrors) : 0,
+            static_cast<long>(progressIntervalMillis),
+            [&](uint64_t deletedCount, uint64_t failedCount) {
+                jboolean cont = env->CallBooleanMethod(deleter, onNativeProgress,
+                        static_cast<jlong>(deletedCount), static_cast<jlong>(failedCount));
+                return !env->ExceptionCheck() && cont;
+            }, result);
+    close(rootFd);
+
+    if (env->ExceptionCheck()) return;
+
+    env->SetLongField(deleter, deletedCountField, static_cast<jlong>(result.deletedCount.load()));
+    env->SetLongField(deleter, failedCountField, static_cast<jlong>(result.failedCount.load()));
+    env->SetBooleanField(deleter, cancelledField, result.cancelled);
+
+    jsize errorCount = static_cast<jsize>(result.errors.size());
+    ScopedLocalRef<jobjectArray> errorPaths(env, env->NewObjectArray(errorCount, stringClass, NULL));
+    if (errorPaths.get() == NULL) return;
+    std::vector<jint> errnos(result.errors.size());
+    for (jsize i = 0; i < errorCount; i++) {
+        ScopedLocalRef<jstring> path(env, env->NewStringUTF(result.errors[i].path.c_str()));
+        if (path.get() == NULL) return;
+        env->SetObjectArrayElement(errorPaths.get(), i, path.get());
+        errnos[i] = result.errors[i].error;
+    }
+    ScopedLocalRef<jintArray> errorErrnos(env, env->NewIntArray(errorCount));
+    if (errorErrnos.get() == NULL) return;
+    env->SetIntArrayRegion(errorErrnos.get(), 0, errorCount, errnos.data());
+
+    env->SetObjectField(deleter, errorPathsField, errorPaths.get());
+    env->SetObjectField(deleter, errorErrnosField, errorErrnos.get());
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL Java_com_termux_shared_file_filesystem_FileChangeWatcher_createNative
+  (JNIEnv *env, jclass) {
+    FileWatcher* watcher = new FileWatcher();
+    int error = watcher->init();
+    if (error != 0) {
+        delete watcher;
+        errno = error;
+        throwErrnoException(env, "inotify_init");
+        return 0;
+    }
+    return reinterpret_cast<jlong>(watcher);
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_termux_shared_file_filesystem_FileChangeWatcher_setPathsNative
+  (JNIEnv *env, jclass, jlong handle, jobjectArray javaPaths) {
+    if (javaPaths == NULL) {
+        jniThrowNullPointerException(env);
+        return;
+    }
+
+    std::vector<std::string> paths;
+    jsize count = env->GetArrayLength(javaPaths);
+    for (jsize i = 0; i < count; i++) {
+        ScopedLocalRef<jstring> javaPath(env, reinterpret_cast<jstring>(env->GetObjectArrayElement(javaPaths, i)));
+        if (env->ExceptionCheck()) return;
+        ScopedUtfChars path(env, javaPath.get());
+        if (path.c_str() == NULL) return;
+        paths.push_back(path.c_str());
+    }
+    reinterpret_cast<FileWatcher*>(handle)->setPaths(paths);
+}
+
+extern "C"
+JNIEXPORT jobjectArray JNICALL Java_com_termux_shared_file_filesystem_FileChangeWatcher_waitNative
+  (JNIEnv *env, jclass, jlong handle, jlong debounceMillis) {
+    std::vector<std::string> changedPaths;
+    int error = reinterpret_cast<FileWatcher*>(handle)->waitForChanges(static_cast<long>(debounceMillis), changedPaths);
+    if (error == ECANCELED) return NULL;
+    if (error != 0) {
+        errno = error;
+        throwErrnoException(env, "inotify");
+        return NULL;
+    }
+
+    static jclass stringClass = reinterpret_cast<jclass>(env->NewGlobalRef(env->FindClass("java/lang/String")));
+    jsize count = static_cast<jsize>(changedPaths.size());
+    jobjectArray result = env->NewObjectArray(count, stringClass, NULL);
+    if (result == NULL) return NULL;
+    for (jsize i = 0; i < count; i++) {
+        ScopedLocalRef<jstring> path(env, env->NewStringUTF(changedPaths[i].c_str()));
+        if (path.get() == NULL) return NULL;
+        env->SetObjectArrayElement(result, i, path.get());
+    }
+    return result;
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_termux_shared_file_filesystem_FileChangeWatcher_destroyNative
+  (JNIEnv *, jclass, jlong handle) {
+    delete reinterpret_cast<FileWatcher*>(handle);
+}
+
+// Convert a java String[] to a vector of strings. Returns false if a java exception is pending.
+static bool toStringVector(JNIEnv* env, jobjectArray javaStrings, std::vector<std::string>& strings) {
+    if (javaStrings == NULL) {
+        jniThrowNullPointerException(env);
+        return false;
+    }
+    jsize count = env->GetArrayLength(javaStrings);
+    for (jsize i = 0; i < count; i++) {
+        ScopedLocalRef<jstring> javaString(env, reinterpret_cast<jstring>(env->GetObjectArrayElement(javaStrings, i)));
+        if (env->ExceptionCheck()) return false;
+        ScopedUtfChars string(env, javaString.get());
+        if (string.c_str() == NULL) return false;
+        strings.push_back(string.c_str());
+    }
+    return true;
+}
+
+// Get a NULL terminated array of the strings, which is valid while the strings are not modified
+static std::vector<char*> toCStringArray(std::vector<std::string>& strings) {
+    std::vector<char*> array;
+    for (std::string& string : strings) array.push_back(&string[0]);
+    array.push_back(NULL);
+    return array;
+}
+
+static jbyteArray toByteArray(JNIEnv* env, const std::string& data) {
+    jbyteArray array = env->NewByteArray(static_cast<jsize>(data.size()));
+    if (array == NULL) return NULL;
+    env->SetByteArrayRegion(array, 0, static_cast<jsize>(data.size()), reinterpret_cast<const jbyte*>(data.data()));
+    return array;
+}
+
+// The fields of the usage array passed to NativeProcessRunner.onNativeExit(). These must be kept
+// in sync with the ResourceUsage.FIELD_* constants.
+enum {
+    RUSAGE_FIELD_USER_CPU_TIME_MICROS,
+    RUSAGE_FIELD_SYSTEM_CPU_TIME_MICROS,
+    RUSAGE_FIELD_MAX_RSS_KB,
+    RUSAGE_FIELD_VOLUNTARY_CONTEXT_SWITCHES,
+    RUSAGE_FIELD_INVOLUNTARY_CONTEXT_SWITCHES,
+    RUSAGE_FIELD_COUNT
+};
+
+static jlongArray toUsageArray(JNIEnv* env, const struct rusage& usage) {
+    jlong fields[RUSAGE_FIELD_COUNT];
+    fields[RUSAGE_FIELD_USER_CPU_TIME_MICROS] = static_cast<jlong>(usage.ru_utime.tv_sec) * 1000000 + usage.ru_utime.tv_usec;
+    fields[RUSAGE_FIELD_SYSTEM_CPU_TIME_MICROS] = static_cast<jlong>(usage.ru_stime.tv_sec) * 1000000 + usage.ru_stime.tv_usec;
+    fields[RUSAGE_FIELD_MAX_RSS_KB] = usage.ru_maxrss;
+    fields[RUSAGE_FIELD_VOLUNTARY_CONTEXT_SWITCHES] = usage.ru_nvcsw;
+    fields[RUSAGE_FIELD_INVOLUNTARY_CONTEXT_SWITCHES] = usage.ru_nivcsw;
+
+    jlongArray array = env->NewLongArray(RUSAGE_FIELD_COUNT);
+    if (array == NULL) return NULL;
+    env->SetLongArrayRegion(array, 0, RUSAGE_FIELD_COUNT, fields);
+    return array;
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL Java_com_termux_shared_shell_command_runner_app_NativeProcessRunner_createNative
+  (JNIEnv *env, jclass) {
+    ProcessRunner* runner = new ProcessRunner();
+    int error = runner->init();
+    if (error != 0) {
+        delete runner;
+        errno = error;
+        throwErrnoException(env, "epoll_create");
+        return 0;
+    }
+    return reinterpret_cast<jlong>(runner);
+}
+
+extern "C"
+JNIEXPORT jint JNICALL Java_com_termux_shared_shell_command_runner_app_NativeProcessRunner_spawnNative
+  (JNIEnv *env, jclass, jlong handle, jlong id, jobjectArray javaArgv, jobjectArray javaEnvp,
+   jstring javaWorkingDirectory, jbyteArray javaStdin, jint maxOutputSize, jstring javaSpillDirectory) {
+    std::vector<std::string> argv;
+    std::vector<std::string> envp;
+    if (!toStringVector(env, javaArgv, argv) || !toStringVector(env, javaEnvp, envp)) return -1;
+    if (argv.empty()) {
+        errno = EINVAL;
+        throwErrnoException(env, "posix_spawn");
+        return -1;
+    }
+
+    std::string workingDirectory;
+    if (javaWorkingDirectory != NULL) {
+        ScopedUtfChars workingDirectoryChars(env, javaWorkingDirectory);
+        if (workingDirectoryChars.c_str() == NULL) return -1;
+        workingDirectory = workingDirectoryChars.c_str();
+    }
+
+    std::string stdinData;
+    if (javaStdin != NULL) {
+        stdinData.resize(static_cast<size_t>(env->GetArrayLength(javaStdin)));
+        env->GetByteArrayRegion(javaStdin, 0, static_cast<jsize>(stdinData.size()), reinterpret_cast<jbyte*>(&stdinData[0]));
+        if (env->ExceptionCheck()) return -1;
+    }
+
+    std::string spillDirectory;
+    if (javaSpillDirectory != NULL) {
+        ScopedUtfChars spillDirectoryChars(env, javaSpillDirectory);
+        if (spillDirectoryChars.c_str() == NULL) return -1;
+        spillDirectory = spillDirectoryChars.c_str();
+    }
+
+    std::vector<char*> argvArray = toCStringArray(argv);
+    std::vector<char*> envpArray = toCStringArray(envp);
+    pid_t pid;
+    int error = reinterpret_cast<ProcessRunner*>(handle)->spawn(static_cast<long>(id), argvArray[0], argvArray.data(),
+            envpArray.data(), javaWorkingDirectory != NULL ? workingDirectory.c_str() : NULL, stdinData,
+            maxOutputSize > 0 ? static_cast<size_t>(maxOutputSize) : 0, spillDirectory, &pid);
+    if (error != 0) {
+        errno = error;
+        throwErrnoException(env, "posix_spawn");
+        return -1;
+    }
+    return static_cast<jint>(pid);
+}
+
+// Clear the pending exception, like an OutOfMemoryError if a java array could not be created,
+// and return true if there was one.
+static bool clearPendingException(JNIEnv* env) {
+    if (!env->ExceptionCheck()) return false;
+    env->ExceptionClear();
+    return true;
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_termux_shared_shell_command_runner_app_NativeProcessRunner_waitNative
+  (JNIEnv *env, jclass, jobject runner, jlong handle) {
+    // Only the runner thread calls this, so the cached id needs no lock. If the method is not
+    // found, the NoSuchMethodError is left pending before any exit is taken from the runner.
+    static jmethodID onNativeExit = NULL;
+    if (onNativeExit == NULL) {
+        ScopedLocalRef<jclass> runnerClass(env, env->GetObjectClass(runner));
+        onNativeExit = env->GetMethodID(runnerClass.get(), "onNativeExit",
+                "(JII[JJ[BIJLjava/lang/String;[BIJLjava/lang/String;)V");
+        if (onNativeExit == NULL) return;
+    }
+
+    std::vector<ProcessRunner::Result> results;
+    int error = reinterpret_cast<ProcessRunner*>(handle)->waitForExits(results);
+    if (error != 0) {
+        errno = error;
+        throwErrnoException(env, "epoll_wait");
+        return;
+    }
+
+    // The processes of the results are no longer tracked by the runner, so every result must be
+    // reported even if a java object for it cannot be created, in which case it is passed as null.
+    // An exception thrown by onNativeExit() is rethrown once all results have been reported.
+    ScopedLocalRef<jthrowable> exitException(env, NULL);
+    for (const ProcessRunner::Result& result : results) {
+        const ProcessRunner::Output& stdoutOutput = result.stdoutOutput;
+        const ProcessRunner::Output& stderrOutput = result.stderrOutput;
+        ScopedLocalRef<jlongArray> usage(env, toUsageArray(env, result.usage));
+        clearPendingException(env);
+        ScopedLocalRef<jbyteArray> stdoutData(env, toByteArray(env, stdoutOutput.data));
+        clearPendingException(env);
+        ScopedLocalRef<jbyteArray> stderrData(env, toByteArray(env, stderrOutput.data));
+        clearPendingException(env);
+        ScopedLocalRef<jstring> stdoutSpillPath(env, stdoutOutput.spillPath.empty() ? NULL : env->NewStringUTF(stdoutOutput.spillPath.c_str()));
+        clearPendingException(env);
+        ScopedLocalRef<jstring> stderrSpillPath(env, stderrOutput.spillPath.empty() ? NULL : env->NewStringUTF(stderrOutput.spillPath.c_str()));
+        clearPendingException(env);
+        env->CallVoidMethod(runner, onNativeExit, static_cast<jlong>(result.id), static_cast<jint>(result.pid),
+                static_cast<jint>(result.exitCode), usage.get(), static_cast<jlong>(result.wallTimeNanos / 1000000),
+                stdoutData.get(), static_cast<jint>(stdoutOutput.headSize), static_cast<jlong>(stdoutOutput.size), stdoutSpillPath.get(),
+                stderrData.get(), static_cast<jint>(stderrOutput.headSize), static_cast<jlong>(stderrOutput.size), stderrSpillPath.get());
+        if (env->ExceptionCheck()) {
+            jthrowable exception = env->ExceptionOccurred();
+            env->ExceptionClear();
+            if (exitException.get() == NULL)
+                exitException.reset(exception);
+            else
+                env->DeleteLocalRef(exception);
+        }
+    }
+
+    if (exitException.get() != NULL)
+        env->Throw(exitException.get());
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL Java_com_termux_shared_file_filesystem_MappedFile_mapNative
+  (JNIEnv *env, jclass, jstring javaPath) {
+    ScopedUtfChars path(env, javaPath);
+    if (path.c_str() == NULL) { return NULL; }
+
+    // A java ByteBuffer can address at most INT_MAX bytes
+    MappedFile mappedFile;
+    int error = mapFile(path.c_str(), INT32_MAX, mappedFile);
+    if (error != 0) {
+        errno = error;
+        throwErrnoException(env, "mmap");
+        return NULL;
+    }
+    if (mappedFile.address == nullptr) return NULL;
+
+    jobject buffer = env->NewDirectByteBuffer(mappedFile.address, static_cast<jlong>(mappedFile.size));
+    if (buffer == NULL) unmapFile(mappedFile);
+    return buffer;
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_termux_shared_file_filesystem_MappedFile_unmapNative
+  (JNIEnv *env, jclass, jobject buffer) {
+    MappedFile mappedFile;
+    mappedFile.address = env->GetDirectBufferAddress(buffer);
+    mappedFile.size = static_cast<size_t>(env->GetDirectBufferCapacity(buffer));
+    unmapFile(mappedFile);
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL Java_com_termux_shared_file_filesystem_AtomicFileOutputStream_beginNative
+  (JNIEnv *env, jclass, jstring javaPath, jint mode) {
+    ScopedUtfChars path(env, javaPath);
+    if (path.c_str() == NULL) { return 0; }
+
+    AtomicFile* atomicFile = new AtomicFile();
+    int error = atomicFile->begin(path.c_str(), static_cast<mode_t>(mode));
+    if (error != 0) {
+        delete atomicFile;
+        errno = error;
+        throwErrnoException(env, "open");
+        return 0;
+    }
+    return reinterpret_cast<jlong>(atomicFile);
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_termux_shared_file_filesystem_AtomicFileOutputStream_writeNative
+  (JNIEnv *env, jclass, jlong handle, jbyteArray data, jint offset, jint length) {
+    // Copy the data in chunks instead of pinning the whole array, so the gc is not blocked and
+    // memory usage is bounded for large writes
+    jbyte buffer[64 * 1024];
+    while (length > 0) {
+        jint chunk = length < static_cast<jint>(sizeof(buffer)) ? length : static_cast<jint>(sizeof(buffer));
+        env->GetByteArrayRegion(data, offset, chunk, buffer);
+        if (env->ExceptionCheck()) return;
+        int error = reinterpret_cast<AtomicFile*>(handle)->write(buffer, static_cast<size_t>(chunk));
+        if (error != 0) {
+            errno = error;
+            throwErrnoException(env, "write");
+            return;
+        }
+        offset += chunk;
+        length -= chunk;
+    }
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_termux_shared_file_filesystem_AtomicFileOutputStream_commitNative
+  (JNIEnv *env, jclass, jlong handle, jboolean sync) {
+    AtomicFile* atomicFile = reinterpret_cast<AtomicFile*>(handle);
+    int error = atomicFile->commit(sync);
+    delete atomicFile;
+    if (error != 0) {
+        errno = error;
+        throwErrnoException(env, "rename");
+    }
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_termux_shared_file_filesystem_AtomicFileOutputStream_abortNative
+  (JNIEnv *, jclass, jlong handle) {
+    delete reinterpret_cast<AtomicFile*>(handle);
+}
+
+extern "C"
+JNIEXPORT jstring JNICALL Java_com_termux_shared_file_filesystem_PathCanonicalizer_canonicalize
+  (JNIEnv *env, jclass, jstring javaPath) {
+    ScopedUtfChars path(env, javaPath);
+    if (path.c_str() == NULL) { return NULL; }
+
+    std::string result;
+    int error = canonicalizePath(path.c_str(), result);
+    if (error != 0) {
+        errno = error;
+        throwErrnoException(env, "canonicalize");
+        return NULL;
+    }
+    return env->NewStringUTF(result.c_str());
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_termux_shared_file_filesystem_PathCanonicalizer_invalidateCache
+  (JNIEnv *, jclass) {
+    invalidateCanonicalPathCache();
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_termux_shared_file_filesystem_FilePermissionsFixer_fixNative
+  (JNIEnv *env, jclass, jobject fixer, jstring javaRootPath, jint fileAddMode, jint fileRemoveMode,
+   jint dirAddMode, jint dirRemoveMode, jboolean recursive, jboolean checkOnly, jint maxEntries) {
+    if (fixer == NULL) {
+        jniThrowNullPointerException(env);
+        return;
+    }
+
+    ScopedUtfChars rootPath(env, javaRootPath);
+    if (rootPath.c_str() == NULL) { return; }
+
+    static jclass fixerClass = reinterpret_cast<jclass>(env->NewGlobalRef(env->GetObjectClass(fixer)));
+    static jclass stringClass = reinterpret_cast<jclass>(env->NewGlobalRef(env->FindClass("java/lang/String")));
+    static jfieldID checkedCountField = env->GetFieldID(fixerClass, "mCheckedCount", "J");
+    static jfieldID changedCountField = env->GetFieldID(fixerClass, "mChangedCount", "J");
+    static jfieldID failedCountField = env->GetFieldID(fixerClass, "mFailedCount", "J");
+    static jfieldID entryPathsField = env->GetFieldID(fixerClass, "mEntryPaths", "[Ljava/lang/String;");
+    static jfieldID entryOldModesField = env->GetFieldID(fixerClass, "mEntryOldModes", "[I");
+    static jfieldID entryNewModesField = env->GetFieldID(fixerClass, "mEntryNewModes", "[I");
+    static jfieldID entryErrnosField = env->GetFieldID(fixerClass, "mEntryErrnos", "[I");
+
+    ChmodTreeOptions options;
+    options.fileAddMode = static_cast<mode_t>(fileAddMode);
+    options.fileRemoveMode = static_cast<mode_t>(fileRemoveMode);
+    options.dirAddMode = static_cast<mode_t>(dirAddMode);
+    options.dirRemoveMode = static_cast<mode_t>(dirRemoveMode);
+    options.recursive = recursive;
+    options.checkOnly = checkOnly;
+    options.maxEntries = maxEntries > 0 ? static_cast<size_t>(maxEntries) : 0;
+
+    ChmodTreeResult result;
+    int error = chmodTree(rootPath.c_str(), options, result);
+    if (error != 0) {
+        errno = error;
+        throwErrnoException(env, "fstatat");
+        return;
+    }
+
+    env->SetLongField(fixer, checkedCountField, static_cast<jlong>(result.checkedCount));
+    env->SetLongField(fixer, changedCountField, static_cast<jlong>(result.changedCount));
+    env->SetLongField(fixer, failedCountField, static_cast<jlong>(result.failedCount));
+
+    jsize entryCount = static_cast<jsize>(result.entries.size());
+    ScopedLocalRef<jobjectArray> entryPaths(env, env->NewObjectArray(entryCount, stringClass, NULL));
+    if (entryPaths.get() == NULL) return;
+    std::vector<jint> oldModes(result.entries.size());
+    std::vector<jint> newModes(result.entries.size());
+    std::vector<jint> errnos(result.entries.size());
+    for (jsize i = 0; i < entryCount; i++) {
+        ScopedLocalRef<jstring> path(env, env->NewStringUTF(result.entries[i].path.c_str()));
+        if (path.get() == NULL) return;
+        env->SetObjectArrayElement(entryPaths.get(), i, path.get());
+        oldModes[i] = static_cast<jint>(result.entries[i].oldMode);
+        newModes[i] = static_cast<jint>(result.entries[i].newMode);
+        errnos[i] = result.entries[i].error;
+    }
+    ScopedLocalRef<jintArray> entryOldModes(env, env->NewIntArray(entryCount));
+    if (entryOldModes.get() == NULL) return;
+    env->SetIntArrayRegion(entryOldModes.get(), 0, entryCount, oldModes.data());
+    ScopedLocalRef<jintArray> entryNewModes(env, env->NewIntArray(entryCount));
+    if (entryNewModes.get() == NULL) return;
+    env->SetIntArrayRegion(entryNewModes.get(), 0, entryCount, newModes.data());
+    ScopedLocalRef<jintArray> entryErrnos(env, env->NewIntArray(entryCount));
+    if (entryErrnos.get() == NULL) return;
+    env->SetIntArrayRegion(entryErrnos.get(), 0, entryCount, errnos.data());
+
+    env->SetObjectField(fixer, entryPathsField, entryPaths.get());
+    env->SetObjectField(fixer, entryOldModesField, entryOldModes.get());
+    env->SetObjectField(fixer, entryNewModesField, entryNewModes.get());
+    env->SetObjectField(fixer, entryErrnosField, entryErrnos.get());
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_termux_shared_file_filesystem_FileTreeCopier_copyNative
+  (JNIEnv *env, jclass, jobject copier, jstring javaSrcPath, jstring javaDestPath, jint threadCount,
+   jint maxErrors, jlong progressIntervalMillis) {
+    if (copier == NULL) {
+        jniThrowNullPointerException(env);
+        return;
+    }
+
+    ScopedUtfChars srcPath(env, javaSrcPath);
+    if (srcPath.c_str() == NULL) { return; }
+    ScopedUtfChars destPath(env, javaDestPath);
+    if (destPath.c_str() == NULL) { return; }
+
+    static jclass copierClass = reinterpret_cast<jclass>(env->NewGlobalRef(env->GetObjectClass(copier)));
+    static jclass stringClass = reinterpret_cast<jclass>(env->NewGlobalRef(env->FindClass("java/lang/String")));
+    static jmethodID onNativeProgress = env->GetMethodID(copierClass, "onNativeProgress", "(JJJ)Z");
+    static jfieldID copiedCountField = env->GetFieldID(copierClass, "mCopiedCount", "J");
+    static jfieldID copiedBytesField = env->GetFieldID(copierClass, "mCopiedBytes", "J");
+    static jfieldID failedCountField = env->GetFieldID(copierClass, "mFailedCount", "J");
+    static jfieldID cancelledField = env->GetFieldID(copierClass, "mCancelled", "Z");
+    static jfieldID errorPathsField = env->GetFieldID(copierClass, "mErrorPaths", "[Ljava/lang/String;");
+    static jfieldID errorErrnosField = env->GetFieldID(copierClass, "mErrorErrnos", "[I");
+
+    CopyTreeResult result;
+    int error = copyTree(srcPath.c_str(), destPath.c_str(), threadCount > 0 ? threadCount : 1,
+            maxErrors > 0 ? static_cast<size_t>(maxErrors) : 0, static_cast<long>(progressIntervalMillis),
+            [&](uint64_t copiedCount, uint64_t copiedBytes, uint64_t failedCount) {
+                jboolean cont = env->CallBooleanMethod(copier, onNativeProgress, static_cast<jlong>(copiedCount),
+                        static_cast<jlong>(copiedBytes), static_cast<jlong>(failedCount));
+                return !env->ExceptionCheck() && cont;
+            }, result);
+
+    if (env->ExceptionCheck()) return;
+    if (error != 0) {
+        errno = error;
+        throwErrnoException(env, "copy");
+        return;
+    }
+
+    env->SetLongField(copier, copiedCountField, static_cast<jlong>(result.copiedCount.load()));
+    env->SetLongField(copier, copiedBytesField, static_cast<jlong>(result.copiedBytes.load()));
+    env->SetLongField(copier, failedCountField, static_cast<jlong>(result.failedCount.load()));
+    env->SetBooleanField(copier, cancelledField, result.cancelled);
+
+    jsize errorCount = static_cast<jsize>(result.errors.size());
+    ScopedLocalRef<jobjectArray> errorPaths(env, env->NewObjectArray(errorCount, stringClass, NULL));
+    if (errorPaths.get() == NULL) return;
+    std::vector<jint> errnos(result.errors.size());
+    for (jsize i = 0; i < errorCount; i++) {
+        ScopedLocalRef<jstring> path(env, env->NewStringUTF(result.errors[i].path.c_str()));
+        if (path.get() == NULL) return;
+        env->SetObjectArrayElement(errorPaths.get(), i, path.get());
+        errnos[i] = result.errors[i].error;
+    }
+    ScopedLocalRef<jintArray> errorErrnos(env, env->NewIntArray(errorCount));
+    if (errorErrnos.get() == NULL) return;
+    env->SetIntArrayRegion(errorErrnos.get(), 0, errorCount, errnos.data());
+
+    env->SetObjectField(copier, errorPathsField, errorPaths.get());
+    env->SetObjectField(copier, errorErrnosField, errorErrnos.get());
+}
+
 extern "C"
 JNIEXPORT jstring JNICALL Java_com_termux_shared_file_libcore_PosixBuild_nativeGet
   (JNIEnv *env, jclass, jstring keyJ, jstring defJ) {
@@ -214,6 +1504,10 @@ JNIEXPORT void JNICALL Java_com_termux_shared_file_libcore_OsConstants_initConst
 #endif
     initConstant(env, c, "AI_PASSIVE", AI_PASSIVE);
     initConstant(env, c, "AI_V4MAPPED", AI_V4MAPPED);
+    initConstant(env, c, "AT_STATX_DONT_SYNC", AT_STATX_DONT_SYNC);
+    initConstant(env, c, "AT_STATX_FORCE_SYNC", AT_STATX_FORCE_SYNC);
+    initConstant(env, c, "AT_STATX_SYNC_AS_STAT", AT_STATX_SYNC_AS_STAT);
+    initConstant(env, c, "AT_SYMLINK_NOFOLLOW", AT_SYMLINK_NOFOLLOW);
     initConstant(env, c, "E2BIG", E2BIG);
     initConstant(env, c, "EACCES", EACCES);
     initConstant(env, c, "EADDRINUSE", EADDRINUSE);
@@ -528,6 +1822,20 @@ JNIEXPORT void JNICALL Java_com_termux_shared_file_libcore_OsConstants_initConst
     initConstant(env, c, "SO_SNDLOWAT", SO_SNDLOWAT);
     initConstant(env, c, "SO_SNDTIMEO", SO_SNDTIMEO);
     initConstant(env, c, "SO_TYPE", SO_TYPE);
+    initConstant(env, c, "STATX_ATIME", STATX_ATIME);
+    initConstant(env, c, "STATX_BASIC_STATS", STATX_BASIC_STATS);
+    initConstant(env, c, "STATX_BLOCKS", STATX_BLOCKS);
+    initConstant(env, c, "STATX_BTIME", STATX_BTIME);
+    initConstant(env, c, "STATX_CTIME", STATX_CTIME);
+    initConstant(env, c, "STATX_GID", STATX_GID);
+    initConstant(env, c, "STATX_INO", STATX_INO);
+    initConstant(env, c, "STATX_MNT_ID", STATX_MNT_ID);
+    initConstant(env, c, "STATX_MODE", STATX_MODE);
+    initConstant(env, c, "STATX_MTIME", STATX_MTIME);
+    initConstant(env, c, "STATX_NLINK", STATX_NLINK);
+    initConstant(env, c, "STATX_SIZE", STATX_SIZE);
+    initConstant(env, c, "STATX_TYPE", STATX_TYPE);
+    initConstant(env, c, "STATX_UID", STATX_UID);
     initConstant(env, c, "STDERR_FILENO", STDERR_FILENO);
     initConstant(env, c, "STDIN_FILENO", STDIN_FILENO);
     initConstant(env, c, "STDOUT_FILENO", STDOUT_FILENO);
@@ -0,0 +1,523 @@
+#include "include/process_runner.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+#include <algorithm>
+#include <vector>
+
+// posix_spawn_file_actions_addchdir_np() and posix_spawn_file_actions_addclosefrom_np() are only
+// available in bionic from api 34, and are referenced weakly
+#if defined(__ANDROID__)
+#define IS_POSIX_SPAWN_CHDIR_AVAILABLE() __builtin_available(android 34, *)
+#else
+#define IS_POSIX_SPAWN_CHDIR_AVAILABLE() true
+#endif
+
+namespace {
+
+// The interval to poll with wait4() for the exit of processes whose output was closed, if
+// pidfds are not supported by the kernel
+const int REAP_POLL_MILLIS = 10;
+
+// The max number of bytes read from an output pipe at once
+const size_t READ_BUFFER_SIZE = 64 * 1024;
+
+const int MAX_EVENTS = 32;
+
+void closeFd(int fd) {
+    if (fd != -1) ::close(fd);
+}
+
+// Open a pidfd for the process, which is readable once it exits. Returns -1 if not supported.
+int openPidFd(pid_t pid) {
+#if defined(__NR_pidfd_open)
+    return static_cast<int>(syscall(__NR_pidfd_open, pid, 0));
+#else
+    return -1;
+#endif
+}
+
+int64_t getMonotonicTimeNanos() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+int getExitCode(int status) {
+    if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+    return WEXITSTATUS(status);
+}
+
+struct linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+// Whether the kernel supports close_range(), checked once by closing a range that cannot be open
+bool isCloseRangeSupported() {
+#if defined(__NR_close_range)
+    static const bool supported = syscall(__NR_close_range, ~0U, ~0U, 0) == 0;
+    return supported;
+#else
+    return false;
+#endif
+}
+
+/*
+ * Get the fds from minFd that are open in the parent by reading /proc/self/fd, so that a vfork
+ * child on a kernel without close_range() only closes those, instead of every fd up to
+ * RLIMIT_NOFILE. Returns false if the directory could not be read.
+ */
+bool getOpenFds(int minFd, std::vector<int>& fds) {
+    int dirFd = TEMP_FAILURE_RETRY(open("/proc/self/fd", O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (dirFd == -1) return false;
+
+    char buf[4096];
+    bool success = true;
+    for (;;) {
+        long n = TEMP_FAILURE_RETRY(syscall(__NR_getdents64, dirFd, buf, sizeof(buf)));
+        if (n <= 0) {
+            success = n == 0;
+            break;
+        }
+        for (long pos = 0; pos < n;) {
+            struct linux_dirent64* d = reinterpret_cast<struct linux_dirent64*>(buf + pos);
+            pos += d->d_reclen;
+            if (d->d_name[0] < '0' || d->d_name[0] > '9') continue;
+            int fd = atoi(d->d_name);
+            if (fd >= minFd && fd != dirFd) fds.push_back(fd);
+        }
+    }
+    ::close(dirFd);
+    return success;
+}
+
+/*
+ * Close all fds from minFd in a child that has not exec'd yet. The openFds are the fds read with
+ * getOpenFds() before forking, which is used if close_range() is not supported, and if it could not
+ * be read, then every fd up to RLIMIT_NOFILE is closed.
+ */
+void closeFdsFrom(int minFd, const std::vector<int>* openFds) {
+#if defined(__NR_close_range)
+    if (syscall(__NR_close_range, minFd, ~0U, 0) == 0) return;
+#endif
+    if (openFds != NULL) {
+        for (int fd : *openFds) ::close(fd);
+        return;
+    }
+    struct rlimit limit;
+    int maxFd = 1024;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+        maxFd = static_cast<int>(limit.rlim_cur);
+    for (int fd = minFd; fd < maxFd; fd++) ::close(fd);
+}
+
+/*
+ * Spawn the child with vfork(), for when posix_spawn() cannot change the working directory or
+ * close the inherited fds. All signals are blocked while the child shares the memory of the
+ * parent, so that no signal handler of the app runs in it.
+ */
+int spawnWithVfork(const char* path, char* const argv[], char* const envp[], const char* workingDirectory,
+                   const int childFds[3], pid_t* pid) {
+    // Read the open fds before forking, since the child must not allocate. Fds opened by other
+    // threads after this would not be closed, but the app opens all fds with O_CLOEXEC.
+    std::vector<int> openFds;
+    bool hasOpenFds = !isCloseRangeSupported() && getOpenFds(3, openFds);
+
+    sigset_t allSignals, oldSignals;
+    sigfillset(&allSignals);
+    pthread_sigmask(SIG_SETMASK, &allSignals, &oldSignals);
+
+    // Set by the child in the shared memory if it fails before exec
+    volatile int childError = 0;
+    pid_t child = vfork();
+    if (child == 0) {
+        struct sigaction defaultAction = {};
+        defaultAction.sa_handler = SIG_DFL;
+        for (int signal = 1; signal < NSIG; signal++)
+            sigaction(signal, &defaultAction, NULL);
+        sigset_t noSignals;
+        sigemptyset(&noSignals);
+        sigprocmask(SIG_SETMASK, &noSignals, NULL);
+
+        for (int fd = 0; fd < 3; fd++) {
+            if (dup2(childFds[fd], fd) == -1) {
+                childError = errno;
+                _exit(127);
+            }
+        }
+        closeFdsFrom(3, hasOpenFds ? &openFds : NULL);
+        if (workingDirectory != NULL && chdir(workingDirectory) == -1) {
+            childError = errno;
+            _exit(127);
+        }
+        execve(path, argv, envp);
+        childError = errno;
+        _exit(127);
+    }
+
+    int error = child == -1 ? errno : childError;
+    pthread_sigmask(SIG_SETMASK, &oldSignals, NULL);
+    if (child != -1 && error != 0)
+        TEMP_FAILURE_RETRY(waitpid(child, NULL, 0));
+    if (error == 0)
+        *pid = child;
+    return error;
+}
+
+int spawnChild(const char* path, char* const argv[], char* const envp[], const char* workingDirectory,
+               const int childFds[3], pid_t* pid) {
+    if (IS_POSIX_SPAWN_CHDIR_AVAILABLE()) {
+        posix_spawn_file_actions_t fileActions;
+        posix_spawnattr_t attr;
+        int error = posix_spawn_file_actions_init(&fileActions);
+        if (error != 0) return error;
+        error = posix_spawnattr_init(&attr);
+        if (error != 0) {
+            posix_spawn_file_actions_destroy(&fileActions);
+            return error;
+        }
+
+        // Reset the signal mask and the signals ignored or handled by the app
+        sigset_t noSignals, allSignals;
+        sigemptyset(&noSignals);
+        sigfillset(&allSignals);
+        posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+        posix_spawnattr_setsigmask(&attr, &noSignals);
+        posix_spawnattr_setsigdefault(&attr, &allSignals);
+
+        for (int fd = 0; fd < 3 && error == 0; fd++)
+            error = posix_spawn_file_actions_adddup2(&fileActions, childFds[fd], fd);
+        if (error == 0)
+            error = posix_spawn_file_actions_addclosefrom_np(&fileActions, 3);
+        if (error == 0 && workingDirectory != NULL)
+            error = posix_spawn_file_actions_addchdir_np(&fileActions, workingDirectory);
+        if (error == 0)
+            error = posix_spawn(pid, path, &fileActions, &attr, argv, envp);
+
+        posix_spawnattr_destroy(&attr);
+        posix_spawn_file_actions_destroy(&fileActions);
+        return error;
+    }
+
+    return spawnWithVfork(path, argv, envp, workingDirectory, childFds, pid);
+}
+
+}
+
+ProcessRunner::ProcessRunner() {}
+
+ProcessRunner::~ProcessRunner() {
+    processes.insert(processes.end(), spawnedProcesses.begin(), spawnedProcesses.end());
+    for (Process* process : processes) {
+        closeWatch(process->pidWatch);
+        closeWatch(process->stdinWatch);
+        closeWatch(process->stdoutWatch);
+        closeWatch(process->stderrWatch);
+        closeFd(process->stdoutCapture.spillFd);
+        closeFd(process->stderrCapture.spillFd);
+        delete process;
+    }
+    closeFd(epollFd);
+    closeFd(wakeFd);
+    pthread_mutex_destroy(&lock);
+}
+
+int ProcessRunner::init() {
+    // epoll_create1() is only available in bionic from api 21
+    epollFd = epoll_create(MAX_EVENTS);
+    if (epollFd == -1) return errno;
+    if (fcntl(epollFd, F_SETFD, FD_CLOEXEC) == -1) return errno;
+
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wakeFd == -1) return errno;
+
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event) == -1) return errno;
+
+    readBuffer.resize(READ_BUFFER_SIZE);
+    return 0;
+}
+
+int ProcessRunner::spawn(long id, const char* path, char* const argv[], char* const envp[], const char* workingDirectory,
+                         const std::string& stdinData, size_t maxOutputSize, const std::string& spillDirectory, pid_t* pid) {
+    int stdinFds[2] = {-1, -1};
+    int stdoutFds[2] = {-1, -1};
+    int stderrFds[2] = {-1, -1};
+    int error = 0;
+    if (pipe2(stdinFds, O_CLOEXEC) == -1 || pipe2(stdoutFds, O_CLOEXEC) == -1 || pipe2(stderrFds, O_CLOEXEC) == -1) {
+        error = errno;
+    } else {
+        const int childFds[3] = {stdinFds[0], stdoutFds[1], stderrFds[1]};
+        error = spawnChild(path, argv, envp, workingDirectory, childFds, pid);
+    }
+
+    closeFd(stdinFds[0]);
+    closeFd(stdoutFds[1]);
+    closeFd(stderrFds[1]);
+    if (error != 0) {
+        closeFd(stdinFds[1]);
+        closeFd(stdoutFds[0]);
+        closeFd(stderrFds[0]);
+        return error;
+    }
+
+    Process* process = new Process();
+    process->id = id;
+    process->pid = *pid;
+    process->spawnTimeNanos = getMonotonicTimeNanos();
+    process->pidWatch = {process, openPidFd(*pid)};
+    process->stdinWatch = {process, stdinFds[1]};
+    process->stdoutWatch = {process, stdoutFds[0]};
+    process->stderrWatch = {process, stderrFds[0]};
+    process->maxOutputSize = maxOutputSize;
+    process->spillDirectory = spillDirectory;
+    process->stdoutCapture.name = "stdout";
+    process->stderrCapture.name = "stderr";
+    fcntl(stdinFds[1], F_SETFL, O_NONBLOCK);
+    fcntl(stdoutFds[0], F_SETFL, O_NONBLOCK);
+    fcntl(stderrFds[0], F_SETFL, O_NONBLOCK);
+    // Close the stdin right away if there is nothing to write, so that the process reads EOF
+    if (stdinData.empty())
+        closeWatch(process->stdinWatch);
+    else
+        process->stdinData = stdinData;
+
+    pthread_mutex_lock(&lock);
+    spawnedProcesses.push_back(process);
+    pthread_mutex_unlock(&lock);
+
+    uint64_t value = 1;
+    TEMP_FAILURE_RETRY(write(wakeFd, &value, sizeof(value)));
+    return 0;
+}
+
+int ProcessRunner::addProcess(Process* process) {
+    processes.push_back(process);
+
+    Watch* watches[] = {&process->pidWatch, &process->stdinWatch, &process->stdoutWatch, &process->stderrWatch};
+    for (Watch* watch : watches) {
+        if (watch->fd == -1) continue;
+        struct epoll_event event = {};
+        event.events = watch == &process->stdinWatch ? EPOLLOUT : EPOLLIN;
+        event.data.ptr = watch;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, watch->fd, &event) == -1) return errno;
+    }
+    return 0;
+}
+
+void ProcessRunner::closeWatch(Watch& watch) {
+    if (watch.fd == -1) return;
+    // Remove the fd explicitly, since closing it only removes it from the epoll instance if no
+    // duplicate of it is open, like one inherited by a child that was forked concurrently
+    if (epollFd != -1)
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, watch.fd, NULL);
+    closeFd(watch.fd);
+    watch.fd = -1;
+}
+
+void ProcessRunner::writeStdin(Process* process) {
+    while (process->stdinOffset < process->stdinData.size()) {
+        ssize_t n = write(process->stdinWatch.fd, process->stdinData.data() + process->stdinOffset,
+                          process->stdinData.size() - process->stdinOffset);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN) return;
+            // The process closed its stdin, like by exiting without reading it
+            break;
+        }
+        process->stdinOffset += static_cast<size_t>(n);
+    }
+
+    closeWatch(process->stdinWatch);
+    std::string().swap(process->stdinData);
+}
+
+void ProcessRunner::readOutput(Watch& watch, Capture& capture) {
+    for (;;) {
+        ssize_t n = read(watch.fd, readBuffer.data(), readBuffer.size());
+        if (n > 0) {
+            appendOutput(watch.process, capture, readBuffer.data(), static_cast<size_t>(n));
+            continue;
+        }
+        if (n == -1 && errno == EINTR) continue;
+        if (n == -1 && errno == EAGAIN) return;
+        // EOF, since all the writers of the pipe closed it
+        closeWatch(watch);
+        return;
+    }
+}
+
+void ProcessRunner::appendOutput(Process* process, Capture& capture, const char* data, size_t size) {
+    capture.size += size;
+    size_t maxSize = process->maxOutputSize;
+    if (!capture.truncated && (maxSize == 0 || capture.head.size() + size <= maxSize)) {
+        capture.head.append(data, size);
+        return;
+    }
+
+    if (capture.truncated) {
+        spill(capture, data, size);
+    } else {
+        // Spill what was kept so far, and keep the first half of the max size as the head
+        capture.truncated = true;
+        if (!process->spillDirectory.empty()) {
+            std::string path = process->spillDirectory + "/" + std::to_string(process->pid) + "-" + capture.name + "-XXXXXX";
+            capture.spillFd = mkstemp(&path[0]);
+            if (capture.spillFd != -1) {
+                fcntl(capture.spillFd, F_SETFD, FD_CLOEXEC);
+                capture.spillPath = path;
+                spill(capture, capture.head.data(), capture.head.size());
+                spill(capture, data, size);
+            }
+        }
+
+        size_t headSize = maxSize / 2;
+        if (capture.head.size() > headSize) {
+            capture.tail.assign(capture.head, headSize, std::string::npos);
+            capture.head.resize(headSize);
+        } else {
+            size_t headAppended = std::min(headSize - capture.head.size(), size);
+            capture.head.append(data, headAppended);
+            data += headAppended;
+            size -= headAppended;
+        }
+        capture.head.shrink_to_fit();
+    }
+
+    size_t tailSize = maxSize - maxSize / 2;
+    capture.tail.append(data, size);
+    if (capture.tail.size() > 2 * tailSize)
+        capture.tail.erase(0, capture.tail.size() - tailSize);
+}
+
+void ProcessRunner::spill(Capture& capture, const char* data, size_t size) {
+    while (capture.spillFd != -1 && size > 0) {
+        ssize_t n = write(capture.spillFd, data, size);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            // The full output is lost, like if the storage is full, so only keep its head and tail
+            closeFd(capture.spillFd);
+            capture.spillFd = -1;
+            unlink(capture.spillPath.c_str());
+            capture.spillPath.clear();
+            return;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+}
+
+ProcessRunner::Output ProcessRunner::finishCapture(Process* process, Capture& capture) {
+    closeFd(capture.spillFd);
+    capture.spillFd = -1;
+
+    Output output;
+    output.headSize = capture.head.size();
+    output.size = capture.size;
+    output.spillPath = std::move(capture.spillPath);
+    output.data = std::move(capture.head);
+    if (capture.truncated) {
+        size_t tailSize = process->maxOutputSize - process->maxOutputSize / 2;
+        if (capture.tail.size() > tailSize)
+            capture.tail.erase(0, capture.tail.size() - tailSize);
+        output.data.append(capture.tail);
+        std::string().swap(capture.tail);
+    }
+    return output;
+}
+
+void ProcessRunner::reap(Process* process) {
+    int status;
+    pid_t rc = TEMP_FAILURE_RETRY(wait4(process->pid, &status, WNOHANG, &process->usage));
+    if (rc == 0) return;
+    process->exited = true;
+    process->wallTimeNanos = getMonotonicTimeNanos() - process->spawnTimeNanos;
+    // The process was already reaped by someone else, so its exit code and usage are unknown
+    process->exitCode = rc == -1 ? -1 : getExitCode(status);
+    if (rc == -1) memset(&process->usage, 0, sizeof(process->usage));
+    closeWatch(process->pidWatch);
+}
+
+int ProcessRunner::waitForExits(std::vector<Result>& results) {
+    results.clear();
+    struct epoll_event events[MAX_EVENTS];
+
+    for (;;) {
+        std::vector<Process*> newProcesses;
+        pthread_mutex_lock(&lock);
+        newProcesses.swap(spawnedProcesses);
+        pthread_mutex_unlock(&lock);
+        for (Process* process : newProcesses) {
+            int error = addProcess(process);
+            if (error != 0) return error;
+        }
+
+        // Report the processes that exited and whose output was closed. Processes are only
+        // deleted here, so the watches of the events returned by epoll_wait() stay valid.
+        bool polling = false;
+        for (auto it = processes.begin(); it != processes.end();) {
+            Process* process = *it;
+            bool outputClosed = process->stdoutWatch.fd == -1 && process->stderrWatch.fd == -1;
+            if (outputClosed && !process->exited && process->pidWatch.fd == -1) {
+                reap(process);
+                if (!process->exited) polling = true;
+            }
+            if (!outputClosed || !process->exited) {
+                ++it;
+                continue;
+            }
+
+            closeWatch(process->stdinWatch);
+            results.push_back({process->id, process->pid, process->exitCode, process->usage, process->wallTimeNanos,
+                               finishCapture(process, process->stdoutCapture), finishCapture(process, process->stderrCapture)});
+            delete process;
+            it = processes.erase(it);
+        }
+        if (!results.empty()) return 0;
+
+        int count = epoll_wait(epollFd, events, MAX_EVENTS, polling ? REAP_POLL_MILLIS : -1);
+        if (count == -1) {
+            if (errno == EINTR) continue;
+            return errno;
+        }
+
+        for (int i = 0; i < count; i++) {
+            Watch* watch = static_cast<Watch*>(events[i].data.ptr);
+            if (watch == NULL) {
+                uint64_t value;
+                TEMP_FAILURE_RETRY(read(wakeFd, &value, sizeof(value)));
+                continue;
+            }
+            if (watch->fd == -1) continue;
+
+            Process* process = watch->process;
+            if (watch == &process->pidWatch)
+                reap(process);
+            else if (watch == &process->stdinWatch)
+                writeStdin(process);
+            else if (watch == &process->stdoutWatch)
+                readOutput(*watch, process->stdoutCapture);
+            else
+                readOutput(*watch, process->stderrCapture);
+        }
+    }
+}
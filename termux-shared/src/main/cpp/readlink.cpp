@@ -14,29 +14,54 @@
  * limitations under the License.
  */
 
-#include "include/LocalArray.h"
 #include "include/readlink.h"
 
+#include <fcntl.h>
+#include <limits.h>
 #include <string>
+#include <sys/stat.h>
+#include <sys/syscall.h>
 #include <unistd.h>
 
+// readlinkat() is only available in bionic from api 21, so call the syscall directly
+static ssize_t sysReadlinkat(int dirFd, const char* path, char* buf, size_t bufSize) {
+    return static_cast<ssize_t>(syscall(__NR_readlinkat, dirFd, path, buf, bufSize));
+}
+
 bool readlink(const char* path, std::string& result) {
-    // We can't know how big a buffer readlink(2) will need, so we need to
-    // loop until it says "that fit".
-    size_t bufSize = 512;
+    return readlinkat(AT_FDCWD, path, result);
+}
+
+bool readlinkat(int dirFd, const char* path, std::string& result) {
+    // Nearly all targets fit in PATH_MAX, so first try with a buffer of that size on the stack.
+    char buf[PATH_MAX];
+    ssize_t len = sysReadlinkat(dirFd, path, buf, sizeof(buf));
+    if (len == -1) {
+        return false;
+    }
+    if (static_cast<size_t>(len) < sizeof(buf)) {
+        result.assign(buf, len);
+        return true;
+    }
+
+    // Otherwise size the buffer from the length that lstat(2) reports for the target, instead of
+    // retrying with doubled buffers. Some symlinks like the ones in procfs report a size of 0, and
+    // the target may also have been replaced in between, so only then fall back to doubling.
     while (true) {
-        LocalArray<512> buf(bufSize);
-        ssize_t len = readlink(path, &buf[0], buf.size());
+        struct stat sb;
+        if (fstatat(dirFd, path, &sb, AT_SYMLINK_NOFOLLOW) == -1) {
+            return false;
+        }
+        size_t bufSize = static_cast<size_t>(sb.st_size) > static_cast<size_t>(len) ?
+                static_cast<size_t>(sb.st_size) + 1 : static_cast<size_t>(len) * 2;
+        result.resize(bufSize);
+        len = sysReadlinkat(dirFd, path, &result[0], bufSize);
         if (len == -1) {
-            // An error occurred.
             return false;
         }
-        if (static_cast<size_t>(len) < buf.size()) {
-            // The buffer was big enough.
-            result.assign(&buf[0], len);
+        if (static_cast<size_t>(len) < bufSize) {
+            result.resize(len);
             return true;
         }
-        // Try again with a bigger buffer.
-        bufSize *= 2;
     }
 }
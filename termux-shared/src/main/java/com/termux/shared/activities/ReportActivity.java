@@ -122,7 +122,10 @@ public class ReportActivity extends AppCompatActivity {
             Logger.logVerbose(LOG_TAG, ReportInfo.class.getSimpleName() + " serialized object will be read from file at path \"" + mReportInfoFilePath + "\"");
             if (mReportInfoFilePath != null) {
                 try {
-                    FileUtils.ReadSerializableObjectResult result = FileUtils.readSerializableObjectFromFile(ReportInfo.class.getSimpleName(), mReportInfoFilePath, ReportInfo.class, false);
+                    // Memory map the file if it is under the app cache directory, where report
+                    // files are only replaced atomically by FileUtils.writeSerializableObjectToFile()
+                    boolean mapFile = FileUtils.getCanonicalPath(mReportInfoFilePath, null).startsWith(getReportInfoDirectoryPath(this) + "/");
+                    FileUtils.ReadSerializableObjectResult result = FileUtils.readSerializableObjectFromFile(ReportInfo.class.getSimpleName(), mReportInfoFilePath, ReportInfo.class, false, mapFile);
                     if (result.error != null) {
                         Logger.logErrorExtended(LOG_TAG, result.error.toString());
                         Logger.showToast(this, Error.getMinimalErrorString(result.error), true);
@@ -1,14 +1,21 @@
 package com.termux.shared.file;
 
-import android.os.Build;
 // import android.system.Os;
 
 import androidx.annotation.NonNull;
 import androidx.annotation.Nullable;
 
 import com.google.common.io.RecursiveDeleteOption;
+import com.termux.shared.file.filesystem.AtomicFileOutputStream;
+import com.termux.shared.file.filesystem.DirectoryLister;
+import com.termux.shared.file.filesystem.FileTreeCopier;
+import com.termux.shared.file.filesystem.FileTreeDeleter;
+import com.termux.shared.file.filesystem.FileTreeWalker;
 import com.termux.shared.file.filesystem.FileType;
 import com.termux.shared.file.filesystem.FileTypes;
+import com.termux.shared.file.filesystem.MappedFile;
+import com.termux.shared.file.filesystem.PathCanonicalizer;
+import com.termux.shared.file.libcore.ErrnoException;
 import com.termux.shared.file.libcore.Os;
 import com.termux.shared.data.DataUtils;
 import com.termux.shared.logger.Logger;
@@ -18,7 +25,10 @@ import com.termux.shared.errors.FunctionErrno;
 
 import org.apache.commons.io.filefilter.AgeFileFilter;
 import org.apache.commons.io.filefilter.IOFileFilter;
+import org.apache.commons.io.filefilter.TrueFileFilter;
 
+import java.io.BufferedInputStream;
+import java.io.BufferedOutputStream;
 import java.io.BufferedReader;
 import java.io.BufferedWriter;
 import java.io.Closeable;
@@ -26,14 +36,18 @@ import java.io.File;
 import java.io.FileInputStream;
 import java.io.FileOutputStream;
 import java.io.IOException;
-import java.io.InputStreamReader;
 import java.io.ObjectInputStream;
 import java.io.ObjectOutputStream;
 import java.io.OutputStreamWriter;
 import java.io.Serializable;
 import java.lang.reflect.Field;
 import java.lang.reflect.Method;
+import java.nio.ByteBuffer;
+import java.nio.CharBuffer;
+import java.nio.channels.ReadableByteChannel;
 import java.nio.charset.Charset;
+import java.nio.charset.CharsetDecoder;
+import java.nio.charset.CodingErrorAction;
 import java.nio.file.LinkOption;
 import java.nio.file.StandardCopyOption;
 import java.util.Arrays;
@@ -51,6 +65,13 @@ public class FileUtils {
      * Execute permissions should be attempted to be set, but ignored if they are missing */
     public static final String APP_WORKING_DIRECTORY_PERMISSIONS = "rwx"; // Default: "rwx"
 
+    /** The number of bytes read and characters decoded at a time when reading text from files. */
+    public static final int TEXT_READ_CHUNK_SIZE = 8 * 1024;
+
+    private static final Pattern MULTIPLE_SLASHES_PATTERN = Pattern.compile("/+");
+    private static final Pattern DOT_SLASH_PATTERN = Pattern.compile("\\./");
+    private static final Pattern TRAILING_SLASHES_PATTERN = Pattern.compile("/+$");
+
     private static final String LOG_TAG = "FileUtils";
     
     /**
@@ -87,13 +108,29 @@ public class FileUtils {
         }
 
         try {
-            return new File(absolutePath).getCanonicalPath();
+            return canonicalizePath(absolutePath);
         } catch(Exception e) {
         }
 
         return absolutePath;
     }
 
+    /**
+     * Get canonical path of an absolute path natively with {@link PathCanonicalizer}, which
+     * caches the directories resolved, or with {@link File#getCanonicalPath()} if that fails.
+     *
+     * @param absolutePath The absolute {@code path} to convert.
+     * @return Returns the {@code canonical path}.
+     * @throws IOException If the canonical path could not be found.
+     */
+    private static String canonicalizePath(@NonNull String absolutePath) throws IOException {
+        try {
+            return PathCanonicalizer.canonicalize(absolutePath);
+        } catch (ErrnoException e) {
+            return new File(absolutePath).getCanonicalPath();
+        }
+    }
+
     /**
      * Removes one or more forward slashes "//" with single slash "/"
      * Removes "./"
@@ -106,11 +143,11 @@ public class FileUtils {
     public static String normalizePath(String path) {
         if (path == null) return null;
 
-        path = path.replaceAll("/+", "/");
-        path = path.replaceAll("\\./", "");
+        path = MULTIPLE_SLASHES_PATTERN.matcher(path).replaceAll("/");
+        path = DOT_SLASH_PATTERN.matcher(path).replaceAll("");
 
         if (path.endsWith("/")) {
-            path = path.replaceAll("/+$", "");
+            path = TRAILING_SLASHES_PATTERN.matcher(path).replaceAll("");
         }
 
         return path;
@@ -167,7 +204,8 @@ public class FileUtils {
         if (path == null || path.isEmpty() || dirPaths == null || dirPaths.size() < 1) return false;
 
         try {
-            path = new File(path).getCanonicalPath();
+            // Relative paths are relative to the root directory, like for java.io.File on android
+            path = canonicalizePath(path.startsWith("/") ? path : "/" + path);
         } catch(Exception e) {
             return false;
         }
@@ -214,7 +252,6 @@ public class FileUtils {
         if (filePath == null || filePath.isEmpty()) return FunctionErrno.ERRNO_NULL_OR_EMPTY_PARAMETER.getError(label + "file path", "isDirectoryFileEmptyOrOnlyContainsSpecificFiles");
 
         try {
-            File file = new File(filePath);
             FileType fileType = getFileType(filePath, false);
 
             // If file exists but not a directory file
@@ -233,16 +270,9 @@ public class FileUtils {
                 }
             }
 
-            File[] subFiles = file.listFiles();
-            if (subFiles == null || subFiles.length == 0)
-                return null;
-
-            // If sub files exists but no file should be ignored
-            if (ignoredSubFilePaths == null || ignoredSubFilePaths.size() == 0)
-                return FileUtilsErrno.ERRNO_NON_EMPTY_DIRECTORY_FILE.getError(label, filePath);
-
-            // If a sub file does not exist in ignored file path
-            if (nonIgnoredSubFileExists(subFiles, ignoredSubFilePaths)) {
+            // If a sub file exists and it or none of its sub files are in ignored file paths. The
+            // directory is listed natively a page at a time, so checking stops at the first one.
+            if (nonIgnoredSubFileExists(filePath, ignoredSubFilePaths != null ? ignoredSubFilePaths : Collections.<String>emptyList())) {
                 return FileUtilsErrno.ERRNO_NON_EMPTY_DIRECTORY_FILE.getError(label, filePath);
             }
 
@@ -271,27 +301,25 @@ public class FileUtils {
     public static boolean nonIgnoredSubFileExists(File[] subFiles, @NonNull List<String> ignoredSubFilePaths) {
         if (subFiles == null || subFiles.length == 0) return false;
 
+        String[] subFilePaths = new String[subFiles.length];
+        for (int i = 0; i < subFiles.length; i++)
+            subFilePaths[i] = subFiles[i].getAbsolutePath();
+
+        // Get the types of all sub files with a single native call instead of a lstat per file
+        FileType[] subFileTypes = FileTypes.getFileTypes(subFilePaths, false);
+
         String subFilePath;
-        for (File subFile : subFiles) {
-            subFilePath = subFile.getAbsolutePath();
-            // If sub file does not exist in ignored sub file paths
-            if (!ignoredSubFilePaths.contains(subFilePath)) {
-                boolean isParentPath = false;
-                for (String ignoredSubFilePath : ignoredSubFilePaths) {
-                    if (ignoredSubFilePath.startsWith(subFilePath + "/") && fileExists(ignoredSubFilePath, false)) {
-                        isParentPath = true;
-                        break;
-                    }
-                }
-                // If sub file is not a parent of any existing ignored sub file paths
-                if (!isParentPath) {
-                    return true;
-                }
+        for (int i = 0; i < subFiles.length; i++) {
+            subFilePath = subFilePaths[i];
+            // If sub file does not exist in ignored sub file paths and is not a parent of any
+            // existing ignored sub file paths
+            if (!ignoredSubFilePaths.contains(subFilePath) && !isParentOfExistingFile(subFilePath, ignoredSubFilePaths)) {
+                return true;
             }
-                
-            if (getFileType(subFilePath, false) == FileType.DIRECTORY) {
+
+            if (subFileTypes[i] == FileType.DIRECTORY) {
                 // If non ignored sub file found, then early exit, otherwise continue looking
-                if (nonIgnoredSubFileExists(subFile.listFiles(), ignoredSubFilePaths))
+                if (nonIgnoredSubDirectoryFileExists(subFilePath, ignoredSubFilePaths))
                      return true;
             }
         }
@@ -299,6 +327,69 @@ public class FileUtils {
         return false;
     }
 
+    /**
+     * Check if directory at {@code directoryPath} contains a file not in {@code ignoredSubFilePaths}.
+     *
+     * The directory is listed natively with {@link DirectoryLister} a page at a time without
+     * finding anything but the type of each sub file, so that checking stops at the first non
+     * ignored sub file without listing the whole directory or creating {@link File} objects.
+     *
+     * If parent path of an ignored file exists, but ignored file itself does not exist, then directory
+     * is not considered empty.
+     *
+     * This function should ideally not be called by itself but through
+     * {@link #validateDirectoryFileEmptyOrOnlyContainsSpecificFiles(String, String, List, boolean)}.
+     *
+     * @param directoryPath The {@code path} of the directory to check.
+     * @param ignoredSubFilePaths The list of absolute file paths under {@code directoryPath} dir.
+     *                            Validation is done for the paths.
+     * @return Returns {@code true} if a file was found that did not exist in the {@code ignoredSubFilePaths},
+     * otherwise  {@code false}.
+     * @throws ErrnoException If the directory could not be listed. Sub directories that could not
+     * be listed are considered empty.
+     */
+    public static boolean nonIgnoredSubFileExists(@NonNull final String directoryPath, @NonNull final List<String> ignoredSubFilePaths) throws ErrnoException {
+        DirectoryLister lister = new DirectoryLister(directoryPath).setStat(false);
+        try {
+            DirectoryLister.Page page;
+            while ((page = lister.readPage()) != null) {
+                while (page.moveToNext()) {
+                    String subFilePath = page.getPath();
+                    // If sub file does not exist in ignored sub file paths and is not a parent of
+                    // any existing ignored sub file paths
+                    if (!ignoredSubFilePaths.contains(subFilePath) && !isParentOfExistingFile(subFilePath, ignoredSubFilePaths))
+                        return true;
+
+                    // If non ignored sub file found, then early exit, otherwise continue looking
+                    if (page.getFileTypeValue() == FileType.DIRECTORY.getValue() &&
+                        nonIgnoredSubDirectoryFileExists(subFilePath, ignoredSubFilePaths))
+                        return true;
+                }
+            }
+        } finally {
+            lister.close();
+        }
+
+        return false;
+    }
+
+    private static boolean nonIgnoredSubDirectoryFileExists(@NonNull final String directoryPath, @NonNull final List<String> ignoredSubFilePaths) {
+        try {
+            return nonIgnoredSubFileExists(directoryPath, ignoredSubFilePaths);
+        } catch (ErrnoException e) {
+            // Like with File.listFiles(), sub directories that cannot be listed are considered empty
+            return false;
+        }
+    }
+
+    private static boolean isParentOfExistingFile(@NonNull final String filePath, @NonNull final List<String> subFilePaths) {
+        for (String subFilePath : subFilePaths) {
+            if (subFilePath.startsWith(filePath + "/") && fileExists(subFilePath, false))
+                return true;
+        }
+        return false;
+    }
+
 
 
     /**
@@ -1145,27 +1236,9 @@ public class FileUtils {
                 if (error != null)
                     return error;
 
-                if (srcFileType == FileType.DIRECTORY) {
-                    // Will give runtime exceptions on android < 8 due to missing classes like java.nio.file.Path if org.apache.commons.io version > 2.5
-                    org.apache.commons.io.FileUtils.copyDirectory(srcFile, destFile, true);
-                } else if (srcFileType == FileType.SYMLINK) {
-                    if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.O) {
-                        // java.nio.file.Files.copy(srcFile.toPath(), destFile.toPath(), LinkOption.NOFOLLOW_LINKS, StandardCopyOption.REPLACE_EXISTING);
-                    } else {
-                        // read the target for the source file and create a symlink at dest
-                        // source file metadata will be lost
-                        error = createSymlinkFile(label + "dest", Os.readlink(srcFilePath), destFilePath);
-                        if (error != null)
-                            return error;
-                    }
-                } else {
-                    if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.O) {
-                       //  java.nio.file.Files.copy(srcFile.toPath(), destFile.toPath(), LinkOption.NOFOLLOW_LINKS, StandardCopyOption.REPLACE_EXISTING);
-                    } else {
-                        // Will give runtime exceptions on android < 8 due to missing classes like java.nio.file.Path if org.apache.commons.io version > 2.5
-                        org.apache.commons.io.FileUtils.copyFile(srcFile, destFile, true);
-                    }
-                }
+                // Copy natively with reflinks or in kernel copies where possible, which also
+                // preserves the mode and times and copies symlinks as symlinks on all android versions
+                copyFileTree(srcFilePath, destFilePath);
             }
 
             // If source file had to be moved
@@ -1319,38 +1392,15 @@ public class FileUtils {
 
             Logger.logVerbose(LOG_TAG, "Deleting " + label + "file at path \"" + filePath + "\"");
 
-            if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.O) {
-                /*
-                 * Try to use {@link SecureDirectoryStream} if available for safer directory
-                 * deletion, it should be available for android >= 8.0
-                 * https://guava.dev/releases/24.1-jre/api/docs/com/google/common/io/MoreFiles.html#deleteRecursively-java.nio.file.Path-com.google.common.io.RecursiveDeleteOption...-
-                 * https://github.com/google/guava/issues/365
-                 * https://cs.android.com/android/platform/superproject/+/android-11.0.0_r3:libcore/ojluni/src/main/java/sun/nio/fs/UnixSecureDirectoryStream.java
-                 *
-                 * MoreUtils is marked with the @Beta annotation so the API may be removed in
-                 * future but has been there for a few years now.
-                 *
-                 * If an exception is thrown, the exception message might not contain the full errors.
-                 * Individual failures get added to suppressed throwables which can be extracted
-                 * from the exception object by calling `Throwable[] getSuppressed()`. So just logging
-                 * the exception message and stacktrace may not be enough, the suppressed throwables
-                 * need to be logged as well, which the Logger class does if they are found in the
-                 * exception added to the Error that's returned by this function.
-                 * https://github.com/google/guava/blob/v30.1.1/guava/src/com/google/common/io/MoreFiles.java#L775
-                 */
-                //noinspection UnstableApiUsage
-                // com.google.common.io.MoreFiles.deleteRecursively(file.toPath(), RecursiveDeleteOption.ALLOW_INSECURE);
-            } else {
-                if (fileType == FileType.DIRECTORY) {
-                    // deleteDirectory() instead of forceDelete() gets the files list first instead of walking directory tree, so seems safer
-                    // Will give runtime exceptions on android < 8 due to missing classes like java.nio.file.Path if org.apache.commons.io version > 2.5
-                    org.apache.commons.io.FileUtils.deleteDirectory(file);
-                } else {
-                    // Will give runtime exceptions on android < 8 due to missing classes like java.nio.file.Path if org.apache.commons.io version > 2.5
-                    org.apache.commons.io.FileUtils.forceDelete(file);
-                }
+            if (fileType == FileType.DIRECTORY) {
+                // Delete the directory contents natively relative to directory fds, so that
+                // symlinks are not followed and no File objects are created for sub files
+                deleteDirectoryContents(filePath);
             }
 
+            if (!file.delete())
+                Logger.logVerbose(LOG_TAG, "Failed to delete " + label + "file at path \"" + filePath + "\"");
+
             // If file still exists after deleting it
             fileType = getFileType(filePath, false);
             if (fileType != FileType.NO_EXIST)
@@ -1409,15 +1459,7 @@ public class FileUtils {
 
             // If directory exists, clear its contents
             if (fileType == FileType.DIRECTORY) {
-                if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.O) {
-                    /* If an exception is thrown, the exception message might not contain the full errors.
-                     * Individual failures get added to suppressed throwables. */
-                    //noinspection UnstableApiUsage
-                    // com.google.common.io.MoreFiles.deleteDirectoryContents(file.toPath(), RecursiveDeleteOption.ALLOW_INSECURE);
-                } else {
-                    // Will give runtime exceptions on android < 8 due to missing classes like java.nio.file.Path if org.apache.commons.io version > 2.5
-                    org.apache.commons.io.FileUtils.cleanDirectory(new File(filePath));
-                }
+                deleteDirectoryContents(filePath);
             }
             // Else create it
             else {
@@ -1432,6 +1474,47 @@ public class FileUtils {
         return null;
     }
 
+    /**
+     * Delete everything under the directory at path natively in parallel with {@link FileTreeDeleter}.
+     *
+     * @param filePath The canonical {@code path} for directory to clear.
+     * @throws IOException If the directory could not be opened or any sub file could not be deleted.
+     */
+    private static void deleteDirectoryContents(@NonNull final String filePath) throws IOException {
+        FileTreeDeleter deleter = new FileTreeDeleter(filePath)
+            .setProgressCallback((deletedCount, failedCount) -> {
+                Logger.logVerbose(LOG_TAG, "Deleted " + deletedCount + " files under \"" + filePath + "\" so far");
+                return true;
+            }, 1000);
+        try {
+            if (!deleter.delete())
+                throw new IOException(deleter.getFailureMessage());
+        } catch (ErrnoException e) {
+            e.rethrowAsIOException();
+        }
+    }
+
+    /**
+     * Copy the file or directory at srcFilePath to destFilePath natively with {@link FileTreeCopier}.
+     *
+     * @param srcFilePath The {@code path} for source file to copy.
+     * @param destFilePath The {@code path} for destination file to copy to.
+     * @throws IOException If the source could not be read or any file could not be copied.
+     */
+    private static void copyFileTree(@NonNull final String srcFilePath, @NonNull final String destFilePath) throws IOException {
+        FileTreeCopier copier = new FileTreeCopier(srcFilePath, destFilePath)
+            .setProgressCallback((copiedCount, copiedBytes, failedCount) -> {
+                Logger.logVerbose(LOG_TAG, "Copied " + copiedCount + " files and " + copiedBytes + " bytes from \"" + srcFilePath + "\" so far");
+                return true;
+            }, 1000);
+        try {
+            if (!copier.copy())
+                throw new IOException(copier.getFailureMessage());
+        } catch (ErrnoException e) {
+            e.rethrowAsIOException();
+        }
+    }
+
     /**
      * Delete files under a directory older than x days.
      *
@@ -1490,6 +1573,21 @@ public class FileUtils {
             // If directory exists, delete its contents
             Calendar calendar = Calendar.getInstance();
             calendar.add(Calendar.DATE, -(days));
+
+            // If all or no subdirectories are to be searched, then delete natively in a single pass.
+            // Unlike AgeFileFilter, the timestamp of symlink files themselves is used.
+            if (dirFilter == null || dirFilter == TrueFileFilter.INSTANCE) {
+                FileTreeWalker walker = new FileTreeWalker(filePath)
+                    .setMaxDepth(dirFilter == null ? 1 : Integer.MAX_VALUE)
+                    .setFileTypeFlags(allowedFileTypeFlags & ~FileType.DIRECTORY.getValue())
+                    .setMtimeRange(Long.MIN_VALUE, calendar.getTimeInMillis())
+                    .setDelete(true);
+                if (!walker.walk())
+                    throw new IOException(walker.getFailureMessage());
+                Logger.logVerbose(LOG_TAG, "Deleted " + walker.getMatchedCount() + " files");
+                return null;
+            }
+
             // AgeFileFilter seems to apply to symlink destination timestamp instead of symlink file itself
             Iterator<File> filesToDelete =
                 org.apache.commons.io.FileUtils.iterateFiles(file, new AgeFileFilter(calendar.getTime()), dirFilter);
@@ -1524,6 +1622,29 @@ public class FileUtils {
      * @return Returns the {@code error} if reading was not successful, otherwise {@code null}.
      */
     public static Error readTextFromFile(String label, final String filePath, Charset charset, @NonNull final StringBuilder dataStringBuilder, final boolean ignoreNonExistentFile) {
+        return readTextFromFile(label, filePath, charset, dataStringBuilder, ignoreNonExistentFile, -1);
+    }
+
+    /**
+     * Read a text {@link String} from file at path with a specific {@link Charset} into {@code dataString}.
+     *
+     * The file is read and decoded in chunks of {@link #TEXT_READ_CHUNK_SIZE}, so that only the
+     * text read is stored in the java heap. It is not memory mapped, since the app would be killed
+     * with {@code SIGBUS} if the file were truncated by another process while being read. Line
+     * terminators are converted to {@code "\n"} and the trailing one is removed.
+     *
+     * @param label The optional label for file to read. This can optionally be {@code null}.
+     * @param filePath The {@code path} for file to read.
+     * @param charset The {@link Charset} of the file. If this is {@code null},
+     *                then default {@link Charset} will be used.
+     * @param dataStringBuilder The {@code StringBuilder} to read data into.
+     * @param ignoreNonExistentFile The {@code boolean} that decides if it should be considered an
+     *                              error if file to read doesn't exist.
+     * @param maxSize The max number of bytes of the file to read, after which the rest of the file
+     *                is ignored. If this is {@code < 0}, then the whole file is read.
+     * @return Returns the {@code error} if reading was not successful, otherwise {@code null}.
+     */
+    public static Error readTextFromFile(String label, final String filePath, Charset charset, @NonNull final StringBuilder dataStringBuilder, final boolean ignoreNonExistentFile, final long maxSize) {
         label = (label == null || label.isEmpty() ? "" : label + " ");
         if (filePath == null || filePath.isEmpty()) return FunctionErrno.ERRNO_NULL_OR_EMPTY_PARAMETER.getError(label + "file path", "readStringFromFile");
 
@@ -1558,31 +1679,92 @@ public class FileUtils {
             return error;
 
         FileInputStream fileInputStream = null;
-        BufferedReader bufferedReader = null;
         try {
             // Read text from file
             fileInputStream = new FileInputStream(filePath);
-            bufferedReader = new BufferedReader(new InputStreamReader(fileInputStream, charset));
-
-            String receiveString;
-
-            boolean firstLine = true;
-            while ((receiveString = bufferedReader.readLine()) != null ) {
-                if (!firstLine) dataStringBuilder.append("\n"); else firstLine = false;
-                dataStringBuilder.append(receiveString);
-            }
+            decodeTextFromChannel(fileInputStream.getChannel(), charset, dataStringBuilder, maxSize);
 
             Logger.logVerbose(LOG_TAG, Logger.getMultiLineLogStringEntry("String", DataUtils.getTruncatedCommandOutput(dataStringBuilder.toString(), Logger.LOGGER_ENTRY_MAX_SAFE_PAYLOAD, true, false, true), "-"));
         } catch (Exception e) {
             return FileUtilsErrno.ERRNO_READING_TEXT_FROM_FILE_FAILED_WITH_EXCEPTION.getError(e, label + "file", filePath, e.getMessage());
         } finally {
             closeCloseable(fileInputStream);
-            closeCloseable(bufferedReader);
         }
 
         return null;
     }
 
+    /**
+     * Decode the text read from {@code channel} into {@code dataStringBuilder}, reading and
+     * decoding {@link #TEXT_READ_CHUNK_SIZE} bytes and characters at a time. Line terminators are
+     * converted like {@link BufferedReader#readLine()} does and the trailing one is removed.
+     * Malformed input is replaced. Pseudo files like the ones under /proc that report a size of
+     * {@code 0} are read until their end too.
+     */
+    private static void decodeTextFromChannel(@NonNull final ReadableByteChannel channel, @NonNull final Charset charset,
+                                              @NonNull final StringBuilder dataStringBuilder, final long maxSize) throws IOException {
+        CharsetDecoder decoder = charset.newDecoder()
+            .onMalformedInput(CodingErrorAction.REPLACE)
+            .onUnmappableCharacter(CodingErrorAction.REPLACE);
+        ByteBuffer bytes = ByteBuffer.allocate(TEXT_READ_CHUNK_SIZE);
+        CharBuffer chars = CharBuffer.allocate(TEXT_READ_CHUNK_SIZE);
+
+        long remainingBytes = maxSize < 0 ? Long.MAX_VALUE : maxSize;
+        boolean lastWasCarriageReturn = false;
+        boolean pendingNewline = false;
+        boolean endOfFile = false;
+        boolean maxSizeReached = maxSize == 0;
+        boolean decoded = false;
+        boolean done = false;
+        while (!done) {
+            if (!decoded) {
+                // Only read more once the chars decoded before have been appended
+                if (!endOfFile && !maxSizeReached && bytes.hasRemaining()) {
+                    bytes.limit(bytes.position() + (int) Math.min(bytes.remaining(), remainingBytes));
+                    int readBytes = channel.read(bytes);
+                    if (readBytes == -1)
+                        endOfFile = true;
+                    else if ((remainingBytes -= readBytes) == 0)
+                        maxSizeReached = true;
+                }
+
+                // Decoding stops with an overflow if the chars buffer is full and with an underflow
+                // if more bytes are needed. A partial character at maxSize is ignored.
+                bytes.flip();
+                decoded = decoder.decode(bytes, chars, endOfFile).isUnderflow() && (endOfFile || maxSizeReached);
+                bytes.compact();
+                done = decoded && !endOfFile;
+            } else {
+                done = decoder.flush(chars).isUnderflow();
+            }
+
+            chars.flip();
+            while (chars.hasRemaining()) {
+                char c = chars.get();
+                if (c == '\n' && lastWasCarriageReturn) {
+                    lastWasCarriageReturn = false;
+                    continue;
+                }
+                lastWasCarriageReturn = c == '\r';
+
+                if (c == '\r' || c == '\n') {
+                    // Only append the newline once text follows it, so that the trailing one is removed
+                    if (pendingNewline)
+                        dataStringBuilder.append('\n');
+                    pendingNewline = true;
+                    continue;
+                }
+
+                if (pendingNewline) {
+                    dataStringBuilder.append('\n');
+                    pendingNewline = false;
+                }
+                dataStringBuilder.append(c);
+            }
+            chars.clear();
+        }
+    }
+
     public static class ReadSerializableObjectResult {
         public final Error error;
         public final Serializable serializableObject;
@@ -1605,6 +1787,27 @@ public class FileUtils {
      */
     @NonNull
     public static <T extends Serializable> ReadSerializableObjectResult readSerializableObjectFromFile(String label, final String filePath, Class<T> readObjectType, final boolean ignoreNonExistentFile) {
+        return readSerializableObjectFromFile(label, filePath, readObjectType, ignoreNonExistentFile, false);
+    }
+
+    /**
+     * Read a {@link Serializable} object from file at path.
+     *
+     * @param label The optional label for file to read. This can optionally be {@code null}.
+     * @param filePath The {@code path} for file to read.
+     * @param readObjectType The {@link Class} of the object.
+     * @param ignoreNonExistentFile The {@code boolean} that decides if it should be considered an
+     *                              error if file to read doesn't exist.
+     * @param mapFile The {@code boolean} that decides if the file should be memory mapped with
+     *                {@link MappedFile} instead of being read into java buffers. This must only be
+     *                {@code true} for files that are private to the app and that are only replaced
+     *                atomically, like by {@link #writeSerializableObjectToFile(String, String, Serializable)},
+     *                since the app would be killed with {@code SIGBUS} if the file were truncated
+     *                while mapped.
+     * @return Returns the {@code error} if reading was not successful, otherwise {@code null}.
+     */
+    @NonNull
+    public static <T extends Serializable> ReadSerializableObjectResult readSerializableObjectFromFile(String label, final String filePath, Class<T> readObjectType, final boolean ignoreNonExistentFile, final boolean mapFile) {
         label = (label == null || label.isEmpty() ? "" : label + " ");
         if (filePath == null || filePath.isEmpty()) return new ReadSerializableObjectResult(FunctionErrno.ERRNO_NULL_OR_EMPTY_PARAMETER.getError(label + "file path", "readSerializableObjectFromFile"), null);
 
@@ -1631,12 +1834,18 @@ public class FileUtils {
             }
         }
 
+        MappedFile mappedFile = null;
         FileInputStream fileInputStream = null;
         ObjectInputStream objectInputStream = null;
         try {
             // Read serializable object from file
-            fileInputStream = new FileInputStream(filePath);
-            objectInputStream = new ObjectInputStream(fileInputStream);
+            if (mapFile) {
+                mappedFile = MappedFile.open(filePath);
+                objectInputStream = new ObjectInputStream(mappedFile.getInputStream());
+            } else {
+                fileInputStream = new FileInputStream(filePath);
+                objectInputStream = new ObjectInputStream(new BufferedInputStream(fileInputStream));
+            }
             //serializableObject = (T) objectInputStream.readObject();
             serializableObject = readObjectType.cast(objectInputStream.readObject());
 
@@ -1644,8 +1853,9 @@ public class FileUtils {
         } catch (Exception e) {
             return new ReadSerializableObjectResult(FileUtilsErrno.ERRNO_READING_SERIALIZABLE_OBJECT_TO_FILE_FAILED_WITH_EXCEPTION.getError(e, label + "file", filePath, e.getMessage()), null);
         } finally {
-            closeCloseable(fileInputStream);
             closeCloseable(objectInputStream);
+            closeCloseable(fileInputStream);
+            closeCloseable(mappedFile);
         }
 
         return new ReadSerializableObjectResult(null, serializableObject);
@@ -1700,6 +1910,56 @@ public class FileUtils {
         return null;
     }
 
+    /**
+     * Write text {@code dataString} with a specific {@link Charset} to file at path atomically with
+     * {@link AtomicFileOutputStream}. The data is written to a temp file in the same directory that
+     * is synced to disk and then renamed over the file, so readers never see a partially written file.
+     *
+     * @param label The optional label for file to write. This can optionally be {@code null}.
+     * @param filePath The {@code path} for file to write.
+     * @param charset The {@link Charset} of the {@code dataString}. If this is {@code null},
+     *                then default {@link Charset} will be used.
+     * @param dataString The data to write to file.
+     * @return Returns the {@code error} if writing was not successful, otherwise {@code null}.
+     */
+    public static Error writeTextToFileAtomically(String label, final String filePath, Charset charset, final String dataString) {
+        label = (label == null || label.isEmpty() ? "" : label + " ");
+        if (filePath == null || filePath.isEmpty()) return FunctionErrno.ERRNO_NULL_OR_EMPTY_PARAMETER.getError(label + "file path", "writeTextToFileAtomically");
+
+        Logger.logVerbose(LOG_TAG, Logger.getMultiLineLogStringEntry("Writing text atomically to " + label + "file at path \"" + filePath + "\"", DataUtils.getTruncatedCommandOutput(dataString, Logger.LOGGER_ENTRY_MAX_SAFE_PAYLOAD, true, false, true), "-"));
+
+        Error error;
+
+        error = preWriteToFile(label, filePath);
+        if (error != null)
+            return error;
+
+        if (charset == null) charset = Charset.defaultCharset();
+
+        // Check if charset is supported
+        error = isCharsetSupported(charset);
+        if (error != null)
+            return error;
+
+        AtomicFileOutputStream atomicFileOutputStream = null;
+        try {
+            // Write text to temp file and replace file with it when the writer is closed
+            atomicFileOutputStream = new AtomicFileOutputStream(filePath);
+            BufferedWriter bufferedWriter = new BufferedWriter(new OutputStreamWriter(atomicFileOutputStream, charset));
+
+            bufferedWriter.write(dataString);
+            bufferedWriter.close();
+        } catch (Exception e) {
+            return FileUtilsErrno.ERRNO_WRITING_TEXT_TO_FILE_FAILED_WITH_EXCEPTION.getError(e, label + "file", filePath, e.getMessage());
+        } finally {
+            // Delete the temp file if writing failed before the writer was closed
+            if (atomicFileOutputStream != null)
+                atomicFileOutputStream.abort();
+        }
+
+        return null;
+    }
+
     /**
      * Write the {@link Serializable} {@code serializableObject} to file at path.
      *
@@ -1720,20 +1980,21 @@ public class FileUtils {
         if (error != null)
             return error;
 
-        FileOutputStream fileOutputStream = null;
-        ObjectOutputStream objectOutputStream = null;
+        AtomicFileOutputStream atomicFileOutputStream = null;
         try {
-            // Write serializable object to file
-            fileOutputStream = new FileOutputStream(filePath);
-            objectOutputStream = new ObjectOutputStream(fileOutputStream);
+            // Write serializable object to temp file and replace file with it when the stream is
+            // closed, so that a partially written object is never read
+            atomicFileOutputStream = new AtomicFileOutputStream(filePath);
+            ObjectOutputStream objectOutputStream = new ObjectOutputStream(new BufferedOutputStream(atomicFileOutputStream));
 
             objectOutputStream.writeObject(serializableObject);
-            objectOutputStream.flush();
+            objectOutputStream.close();
         } catch (Exception e) {
             return FileUtilsErrno.ERRNO_WRITING_SERIALIZABLE_OBJECT_TO_FILE_FAILED_WITH_EXCEPTION.getError(e, label + "file", filePath, e.getMessage());
         } finally {
-            closeCloseable(fileOutputStream);
-            closeCloseable(objectOutputStream);
+            // Delete the temp file if writing failed before the stream was closed
+            if (atomicFileOutputStream != null)
+                atomicFileOutputStream.abort();
         }
 
         return null;
@@ -0,0 +1,117 @@
+package com.termux.shared.file.filesystem;
+
+import androidx.annotation.NonNull;
+
+import com.termux.shared.file.libcore.ErrnoException;
+
+import java.io.IOException;
+import java.io.OutputStream;
+
+/**
+ * A native {@link OutputStream} that replaces a file atomically.
+ *
+ * The data is written to a temp file in the same directory as the file, which is synced to disk
+ * and then renamed over the file with {@code renameat()} on {@link #close()}, so that readers
+ * either see the old or the new file, and never a partially written one, even if the app is killed
+ * while writing. The temp file keeps the permissions of the existing file. If writing fails or
+ * {@link #abort()} is called, then the temp file is deleted and the file is left unchanged.
+ *
+ * The stream is not buffered, so wrap it in a {@link java.io.BufferedOutputStream} or
+ * {@link java.io.BufferedWriter} for small writes.
+ */
+public final class AtomicFileOutputStream extends OutputStream {
+
+    /** The default mode for new files, which is masked by the umask. */
+    public static final int DEFAULT_MODE = 0666;
+
+    private final String mPath;
+    private final boolean mSync;
+    private long mHandle;
+
+    /**
+     * Create an new instance of {@link AtomicFileOutputStream} and the temp file.
+     *
+     * @param path The {@code path} of the file to replace.
+     * @throws IOException If the temp file could not be created.
+     */
+    public AtomicFileOutputStream(@NonNull String path) throws IOException {
+        this(path, DEFAULT_MODE, true);
+    }
+
+    /**
+     * Create an new instance of {@link AtomicFileOutputStream} and the temp file.
+     *
+     * @param path The {@code path} of the file to replace.
+     * @param mode The mode of the file if it does not exist yet.
+     * @param sync Whether to sync the file to disk before replacing it, so that the new file
+     *             survives a power loss.
+     * @throws IOException If the temp file could not be created.
+     */
+    public AtomicFileOutputStream(@NonNull String path, int mode, boolean sync) throws IOException {
+        mPath = path;
+        mSync = sync;
+        try {
+            mHandle = beginNative(path, mode);
+        } catch (ErrnoException e) {
+            throw new IOException("Failed to create temp file for \"" + path + "\": " + e.getMessage(), e);
+        }
+    }
+
+    @Override
+    public void write(int b) throws IOException {
+        write(new byte[] {(byte) b}, 0, 1);
+    }
+
+    @Override
+    public synchronized void write(@NonNull byte[] b, int off, int len) throws IOException {
+        if (mHandle == 0) throw new IOException("The stream for \"" + mPath + "\" is closed");
+        if (off < 0 || len < 0 || off + len > b.length) throw new IndexOutOfBoundsException();
+
+        try {
+            writeNative(mHandle, b, off, len);
+        } catch (ErrnoException e) {
+            abort();
+            e.rethrowAsIOException();
+        }
+    }
+
+    /** Replace the file with the data written. Does nothing if already closed or aborted. */
+    @Override
+    public synchronized void close() throws IOException {
+        if (mHandle == 0) return;
+
+        long handle = mHandle;
+        mHandle = 0;
+        try {
+            commitNative(handle, mSync);
+        } catch (ErrnoException e) {
+            throw new IOException("Failed to replace \"" + mPath + "\": " + e.getMessage(), e);
+        }
+    }
+
+    /** Delete the temp file and leave the file unchanged. Does nothing if already closed or aborted. */
+    public synchronized void abort() {
+        if (mHandle == 0) return;
+
+        abortNative(mHandle);
+        mHandle = 0;
+    }
+
+    @NonNull
+    public String getPath() {
+        return mPath;
+    }
+
+
+
+    private static native long beginNative(String path, int mode) throws ErrnoException;
+
+    private static native void writeNative(long handle, byte[] data, int offset, int length) throws ErrnoException;
+
+    private static native void commitNative(long handle, boolean sync) throws ErrnoException;
+
+    private static native void abortNative(long handle);
+
+    static { System.loadLibrary("posix"); }
+
+}
@@ -0,0 +1,212 @@
+package com.termux.shared.file.filesystem;
+
+import androidx.annotation.Keep;
+import androidx.annotation.NonNull;
+import androidx.annotation.Nullable;
+
+import com.termux.shared.file.libcore.ErrnoException;
+
+import java.io.Closeable;
+import java.nio.charset.Charset;
+
+/**
+ * A native streaming lister for the entries of a single directory.
+ *
+ * The entries are read natively with getdents64() and fstatat() relative to the file descriptor
+ * of the directory, and returned in {@link Page}s of packed arrays instead of creating a
+ * {@link java.io.File} for each entry. Entries are only read from the kernel as pages are
+ * requested, so checks like whether a directory is empty can stop at the first entry that matters
+ * without listing the whole directory. Symlinks of entries are never followed.
+ *
+ * Example:
+ * <pre>
+ * DirectoryLister lister = new DirectoryLister(dirPath).setStat(false);
+ * try {
+ *     DirectoryLister.Page page;
+ *     while ((page = lister.readPage()) != null) {
+ *         while (page.moveToNext()) {
+ *             ...
+ *         }
+ *     }
+ * } finally {
+ *     lister.close();
+ * }
+ * </pre>
+ */
+public final class DirectoryLister implements Closeable {
+
+    /** The default max number of entries in each {@link Page}. */
+    public static final int DEFAULT_PAGE_SIZE = 256;
+
+    private static final Charset UTF_8 = Charset.forName("UTF-8");
+
+    private final String mPath;
+    private int mPageSize = DEFAULT_PAGE_SIZE;
+    private boolean mStat = true;
+    private long mHandle;
+    private boolean mEnded;
+
+    /* The last page read, set by native. */
+    @Keep
+    private byte[] mPageNames;
+    @Keep
+    private long[] mPageEntries;
+
+    /**
+     * Create an new instance of {@link DirectoryLister}. The directory is opened by the first
+     * call to {@link #readPage()}.
+     *
+     * @param path The {@code path} of the directory to list.
+     */
+    public DirectoryLister(@NonNull String path) {
+        mPath = path;
+    }
+
+    /** Set the max number of entries in each {@link Page}. Defaults to {@link #DEFAULT_PAGE_SIZE}. */
+    public DirectoryLister setPageSize(int pageSize) {
+        mPageSize = pageSize;
+        return this;
+    }
+
+    /**
+     * Set whether the mode, size and modification time should be found for entries. Otherwise
+     * only the type is found, which does not require a {@code fstatat()} call for each entry on
+     * most filesystems. Defaults to {@code true}.
+     */
+    public DirectoryLister setStat(boolean stat) {
+        mStat = stat;
+        return this;
+    }
+
+    /**
+     * Read the next page of entries.
+     *
+     * @return Returns the next {@link Page}, or {@code null} if all entries have been read.
+     * @throws ErrnoException If the directory could not be opened or read.
+     */
+    @Nullable
+    public synchronized Page readPage() throws ErrnoException {
+        if (mEnded) return null;
+        if (mHandle == 0)
+            mHandle = openNative(mPath);
+
+        int count = readNative(mHandle, this, Math.max(mPageSize, 1), mStat);
+        if (count == 0) {
+            close();
+            mEnded = true;
+            return null;
+        }
+        return new Page(mPath, mPageNames, mPageEntries, count);
+    }
+
+    /** Close the directory. Further calls to {@link #readPage()} return {@code null}. */
+    @Override
+    public synchronized void close() {
+        mEnded = true;
+        if (mHandle == 0) return;
+        closeNative(mHandle);
+        mHandle = 0;
+    }
+
+    @NonNull
+    public String getPath() {
+        return mPath;
+    }
+
+
+
+    /**
+     * A cursor over a page of entries read by the native lister. The names are only decoded
+     * if requested.
+     */
+    public static final class Page {
+
+        // The fields of each entry, which must be kept in sync with the LIST_ENTRY_FIELD_*
+        // constants in posix.cpp.
+        private static final int FIELD_NAME_OFFSET = 0;
+        private static final int FIELD_NAME_LENGTH = 1;
+        private static final int FIELD_TYPE = 2;
+        private static final int FIELD_MODE = 3;
+        private static final int FIELD_SIZE = 4;
+        private static final int FIELD_MTIME_MILLIS = 5;
+        private static final int FIELD_ERRNO = 6;
+        private static final int FIELD_COUNT = 7;
+
+        private final String mDirectoryPath;
+        private final byte[] mNames;
+        private final long[] mEntries;
+        private final int mCount;
+        private int mPosition = -1;
+        private int mOffset = -FIELD_COUNT;
+
+        Page(String directoryPath, byte[] names, long[] entries, int count) {
+            mDirectoryPath = directoryPath;
+            mNames = names;
+            mEntries = entries;
+            mCount = count;
+        }
+
+        /** Get the number of entries. */
+        public int getCount() {
+            return mCount;
+        }
+
+        /** Move to the next entry. Returns {@code false} if there are no more entries. */
+        public boolean moveToNext() {
+            if (mPosition + 1 >= mCount) return false;
+            mPosition++;
+            mOffset += FIELD_COUNT;
+            return true;
+        }
+
+        /** Get the name of the current entry. */
+        @NonNull
+        public String getName() {
+            return new String(mNames, (int) mEntries[mOffset + FIELD_NAME_OFFSET],
+                (int) mEntries[mOffset + FIELD_NAME_LENGTH], UTF_8);
+        }
+
+        /** Get the path of the current entry. */
+        @NonNull
+        public String getPath() {
+            return mDirectoryPath.endsWith("/") ? mDirectoryPath + getName() : mDirectoryPath + "/" + getName();
+        }
+
+        /** Get the {@link FileType#getValue()} of the current entry. */
+        public int getFileTypeValue() {
+            return (int) mEntries[mOffset + FIELD_TYPE];
+        }
+
+        /** Get the {@code st_mode} of the current entry, or 0 if it was not found. */
+        public int getMode() {
+            return (int) mEntries[mOffset + FIELD_MODE];
+        }
+
+        /** Get the size of the current entry, or 0 if it was not found. */
+        public long getSize() {
+            return mEntries[mOffset + FIELD_SIZE];
+        }
+
+        /** Get the modification time in milliseconds of the current entry, or 0 if it was not found. */
+        public long getMtimeMillis() {
+            return mEntries[mOffset + FIELD_MTIME_MILLIS];
+        }
+
+        /** Get the errno if the current entry failed to be stat-ed, otherwise 0. */
+        public int getErrno() {
+            return (int) mEntries[mOffset + FIELD_ERRNO];
+        }
+
+    }
+
+
+
+    private static native long openNative(String path) throws ErrnoException;
+
+    private static native int readNative(long handle, DirectoryLister lister, int maxEntries, boolean stat) throws ErrnoException;
+
+    private static native void closeNative(long handle);
+
+    static { System.loadLibrary("posix"); }
+
+}
@@ -0,0 +1,171 @@
+package com.termux.shared.file.filesystem;
+
+import androidx.annotation.NonNull;
+
+import com.termux.shared.file.libcore.ErrnoException;
+import com.termux.shared.logger.Logger;
+
+import java.util.ArrayList;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Map;
+
+/**
+ * A native inotify watcher that notifies {@link Listener}s when files are changed, like config
+ * files that should only be reloaded when they are actually modified.
+ *
+ * The parent directories of the files are watched, so files that do not exist yet or are replaced
+ * by a rename are also detected, and if a parent directory does not exist, then its closest
+ * existing ancestor is watched until it is created. Changes are debounced for
+ * {@link #DEFAULT_DEBOUNCE_MILLIS}, so that all the writes of a save are reported once.
+ *
+ * The {@link Listener}s are called on a single background thread of the process-wide
+ * {@link #getInstance()}, which is started when the first file is watched.
+ */
+public final class FileChangeWatcher {
+
+    /** The default time changes must stop for before listeners are called. */
+    public static final long DEFAULT_DEBOUNCE_MILLIS = 300;
+
+    private static FileChangeWatcher sInstance;
+
+    private final long mDebounceMillis;
+    private final Map<String, List<Listener>> mListeners = new HashMap<>();
+    private long mHandle;
+    private Thread mThread;
+    private boolean mFailed;
+
+    private static final String LOG_TAG = "FileChangeWatcher";
+
+    /** The listener for changes to watched files. */
+    public interface Listener {
+        /**
+         * Called on the watcher thread when a watched file was created, modified, replaced or deleted.
+         *
+         * @param path The {@code path} of the file as passed to {@link #addListener(String, Listener)}.
+         */
+        void onFileChanged(@NonNull String path);
+    }
+
+    private FileChangeWatcher(long debounceMillis) {
+        mDebounceMillis = debounceMillis;
+    }
+
+    /** Get the process-wide {@link FileChangeWatcher}. */
+    @NonNull
+    public static synchronized FileChangeWatcher getInstance() {
+        if (sInstance == null)
+            sInstance = new FileChangeWatcher(DEFAULT_DEBOUNCE_MILLIS);
+        return sInstance;
+    }
+
+    /**
+     * Add a listener for changes to the file at path.
+     *
+     * @param path The absolute {@code path} of the file to watch.
+     * @param listener The {@link Listener} to call.
+     * @return Returns {@code true} if the file is being watched, otherwise {@code false} if the
+     * watcher failed to start, in which case the caller must assume that the file may change anytime.
+     */
+    public synchronized boolean addListener(@NonNull String path, @NonNull Listener listener) {
+        if (!start()) return false;
+
+        List<Listener> listeners = mListeners.get(path);
+        if (listeners == null) {
+            listeners = new ArrayList<>();
+            mListeners.put(path, listeners);
+        }
+        listeners.add(listener);
+        updatePaths();
+        return true;
+    }
+
+    /** Remove the listener for changes to the file at path. */
+    public synchronized void removeListener(@NonNull String path, @NonNull Listener listener) {
+        List<Listener> listeners = mListeners.get(path);
+        if (listeners == null || !listeners.remove(listener)) return;
+        if (listeners.isEmpty())
+            mListeners.remove(path);
+        if (mHandle != 0)
+            updatePaths();
+    }
+
+    /**
+     * Whether files are being watched. If the watcher failed, then listeners are no longer called
+     * and callers must assume that files may change anytime.
+     */
+    public synchronized boolean isWatching() {
+        return mThread != null && !mFailed;
+    }
+
+    private boolean start() {
+        if (mFailed) return false;
+        if (mThread != null) return true;
+
+        try {
+            mHandle = createNative();
+        } catch (ErrnoException e) {
+            Logger.logStackTraceWithMessage(LOG_TAG, "Failed to create file change watcher", e);
+            mFailed = true;
+            return false;
+        }
+
+        final long handle = mHandle;
+        mThread = new Thread(() -> watch(handle), LOG_TAG);
+        mThread.setDaemon(true);
+        mThread.start();
+        return true;
+    }
+
+    private void updatePaths() {
+        setPathsNative(mHandle, mListeners.keySet().toArray(new String[0]));
+    }
+
+    private void watch(long handle) {
+        try {
+            String[] changedPaths;
+            while ((changedPaths = waitNative(handle, mDebounceMillis)) != null) {
+                for (String path : changedPaths) {
+                    List<Listener> listeners;
+                    synchronized (this) {
+                        listeners = mListeners.get(path);
+                        if (listeners == null) continue;
+                        listeners = new ArrayList<>(listeners);
+                    }
+
+                    Logger.logVerbose(LOG_TAG, "File changed at \"" + path + "\"");
+                    for (Listener listener : listeners) {
+                        try {
+                            listener.onFileChanged(path);
+                        } catch (Exception e) {
+                            Logger.logStackTraceWithMessage(LOG_TAG, "Listener for changes to \"" + path + "\" failed", e);
+                        }
+                    }
+                }
+            }
+        } catch (ErrnoException e) {
+            Logger.logStackTraceWithMessage(LOG_TAG, "Watching files for changes failed", e);
+        }
+
+        // Listeners can no longer be notified, so further calls to addListener() must fail
+        synchronized (this) {
+            mFailed = true;
+            mHandle = 0;
+            mListeners.clear();
+        }
+        destroyNative(handle);
+    }
+
+
+
+    private static native long createNative() throws ErrnoException;
+
+    private static native void setPathsNative(long handle, String[] paths);
+
+    private static native String[] waitNative(long handle, long debounceMillis) throws ErrnoException;
+
+    private static native void destroyNative(long handle);
+
+    static { System.loadLibrary("posix"); }
+
+}
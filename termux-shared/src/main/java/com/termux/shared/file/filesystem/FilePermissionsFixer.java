@@ -0,0 +1,200 @@
+package com.termux.shared.file.filesystem;
+
+import androidx.annotation.Keep;
+import androidx.annotation.NonNull;
+import androidx.annotation.Nullable;
+
+import com.termux.shared.file.libcore.ErrnoException;
+
+/**
+ * A native fixer for the permissions of the regular files and directories at and under a path.
+ *
+ * Directories are walked depth first with their open fds, the mode of each file is read with
+ * {@code fstatat()} and {@code fchmodat()} is only called for files that actually need their
+ * permission bits changed. The mode of a directory is fixed before it is opened, so directories
+ * without read or execute permission are fixed too. Symlinks are never followed and other file
+ * types are ignored. Failures do not stop the walk. The changed files and failures are reported,
+ * up to {@link #setMaxEntries(int)} of them.
+ *
+ * Example:
+ * <pre>
+ * FilePermissionsFixer fixer = new FilePermissionsFixer(prefixPath)
+ *     .setFileModes(0600, 0)
+ *     .setDirectoryModes(0700, 0);
+ * if (!fixer.fix())
+ *     Logger.logError(LOG_TAG, fixer.getReport());
+ * </pre>
+ */
+public final class FilePermissionsFixer {
+
+    /** The default max number of changed files and failures to collect. */
+    public static final int DEFAULT_MAX_ENTRIES = 100;
+
+    private final String mRootPath;
+    private int mFileAddMode;
+    private int mFileRemoveMode;
+    private int mDirectoryAddMode;
+    private int mDirectoryRemoveMode;
+    private boolean mRecursive = true;
+    private boolean mCheckOnly;
+    private int mMaxEntries = DEFAULT_MAX_ENTRIES;
+
+    /* The results of the last fix, set by native. */
+    @Keep
+    private long mCheckedCount;
+    @Keep
+    private long mChangedCount;
+    @Keep
+    private long mFailedCount;
+    @Keep
+    private String[] mEntryPaths;
+    @Keep
+    private int[] mEntryOldModes;
+    @Keep
+    private int[] mEntryNewModes;
+    @Keep
+    private int[] mEntryErrnos;
+
+    /**
+     * Create an new instance of {@link FilePermissionsFixer}.
+     *
+     * @param rootPath The {@code path} of the file or directory to fix. This must be the canonical
+     *                 path since symlinks are not followed.
+     */
+    public FilePermissionsFixer(@NonNull String rootPath) {
+        mRootPath = rootPath;
+    }
+
+    /** Set the permission bits to add to and remove from regular files. Defaults to none. */
+    public FilePermissionsFixer setFileModes(int addMode, int removeMode) {
+        mFileAddMode = addMode;
+        mFileRemoveMode = removeMode;
+        return this;
+    }
+
+    /** Set the permission bits to add to and remove from directories. Defaults to none. */
+    public FilePermissionsFixer setDirectoryModes(int addMode, int removeMode) {
+        mDirectoryAddMode = addMode;
+        mDirectoryRemoveMode = removeMode;
+        return this;
+    }
+
+    /** Set whether everything under the root directory is fixed too. Defaults to {@code true}. */
+    public FilePermissionsFixer setRecursive(boolean recursive) {
+        mRecursive = recursive;
+        return this;
+    }
+
+    /** Set whether to only report the files that need fixing without changing them. Defaults to {@code false}. */
+    public FilePermissionsFixer setCheckOnly(boolean checkOnly) {
+        mCheckOnly = checkOnly;
+        return this;
+    }
+
+    /** Set the max number of changed files and failures to collect. Defaults to {@link #DEFAULT_MAX_ENTRIES}. */
+    public FilePermissionsFixer setMaxEntries(int maxEntries) {
+        mMaxEntries = maxEntries;
+        return this;
+    }
+
+    /**
+     * Fix the permissions. Failures do not stop the walk, check {@link #getFailedCount()} and
+     * {@link #getReport()}.
+     *
+     * @return Returns {@code true} if all files were checked and fixed, otherwise {@code false}.
+     * @throws ErrnoException If the root file could not be checked.
+     */
+    public boolean fix() throws ErrnoException {
+        mCheckedCount = 0;
+        mChangedCount = 0;
+        mFailedCount = 0;
+        mEntryPaths = new String[0];
+        mEntryOldModes = new int[0];
+        mEntryNewModes = new int[0];
+        mEntryErrnos = new int[0];
+
+        fixNative(this, mRootPath, mFileAddMode, mFileRemoveMode, mDirectoryAddMode, mDirectoryRemoveMode,
+            mRecursive, mCheckOnly, mMaxEntries);
+        return mFailedCount == 0;
+    }
+
+    /** Get the number of regular files and directories checked by the last fix. */
+    public long getCheckedCount() {
+        return mCheckedCount;
+    }
+
+    /** Get the number of files whose permissions were changed, or need to be if check only, by the last fix. */
+    public long getChangedCount() {
+        return mChangedCount;
+    }
+
+    /** Get the number of failures of the last fix. */
+    public long getFailedCount() {
+        return mFailedCount;
+    }
+
+    /** Get the paths relative to the root of the changed files and failures collected by the last fix. The root itself is an empty path. */
+    @NonNull
+    public String[] getEntryPaths() {
+        return mEntryPaths;
+    }
+
+    /** Get the permission bits before the change of the entries collected by the last fix. */
+    @NonNull
+    public int[] getEntryOldModes() {
+        return mEntryOldModes;
+    }
+
+    /** Get the permission bits after the change of the entries collected by the last fix. */
+    @NonNull
+    public int[] getEntryNewModes() {
+        return mEntryNewModes;
+    }
+
+    /** Get the errnos of the entries collected by the last fix, which are 0 for changed files. */
+    @NonNull
+    public int[] getEntryErrnos() {
+        return mEntryErrnos;
+    }
+
+    /** Get a report of the changed files and failures of the last fix, or {@code null} if there were none. */
+    @Nullable
+    public String getReport() {
+        if (mChangedCount == 0 && mFailedCount == 0) return null;
+
+        StringBuilder report = new StringBuilder();
+        report.append(mCheckOnly ? "Permissions need fixing" : "Fixed permissions").append(" for ")
+            .append(mChangedCount).append(" of ").append(mCheckedCount).append(" files with ")
+            .append(mFailedCount).append(" failures under \"").append(mRootPath).append("\":");
+        for (int i = 0; i < mEntryPaths.length; i++) {
+            report.append("\n");
+            if (mEntryErrnos[i] != 0)
+                report.append(new ErrnoException("chmod", mEntryErrnos[i]).getMessage());
+            else
+                report.append(String.format("%04o -> %04o", mEntryOldModes[i], mEntryNewModes[i]));
+            report.append(": \"").append(getEntryFullPath(i)).append("\"");
+        }
+        if (mChangedCount + mFailedCount > mEntryPaths.length)
+            report.append("\n...");
+        return report.toString();
+    }
+
+    @NonNull
+    private String getEntryFullPath(int index) {
+        return mEntryPaths[index].isEmpty() ? mRootPath : mRootPath + "/" + mEntryPaths[index];
+    }
+
+    @NonNull
+    public String getRootPath() {
+        return mRootPath;
+    }
+
+
+
+    private static native void fixNative(FilePermissionsFixer fixer, String rootPath, int fileAddMode, int fileRemoveMode,
+                                         int directoryAddMode, int directoryRemoveMode, boolean recursive,
+                                         boolean checkOnly, int maxEntries) throws ErrnoException;
+
+    static { System.loadLibrary("posix"); }
+
+}
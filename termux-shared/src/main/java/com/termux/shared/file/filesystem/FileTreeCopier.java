@@ -0,0 +1,199 @@
+package com.termux.shared.file.filesystem;
+
+import androidx.annotation.Keep;
+import androidx.annotation.NonNull;
+import androidx.annotation.Nullable;
+
+import com.termux.shared.file.libcore.ErrnoException;
+
+/**
+ * A native copier for a file or everything under a directory.
+ *
+ * The data of regular files is copied in the kernel where possible, by trying in order a
+ * {@code FICLONE} reflink that shares the data blocks, {@code copy_file_range()} (Android 11+,
+ * since the seccomp filter of older versions kills the app for it), {@code sendfile()}, and finally
+ * a read/write loop with a large buffer. Symlinks are copied as symlinks with the same target and
+ * are never followed. The permission mode and the access and modification times of all files and
+ * directories are preserved. The files of a directory copy are split between a small pool of
+ * native threads. Failures do not stop the copy, they are counted and the first
+ * {@link #setMaxErrors(int)} of them are collected.
+ *
+ * Example:
+ * <pre>
+ * FileTreeCopier copier = new FileTreeCopier(srcPath, destPath)
+ *     .setProgressCallback((copiedCount, copiedBytes, failedCount) -> {
+ *         Logger.logVerbose(LOG_TAG, "Copied " + copiedCount + " files");
+ *         return true;
+ *     }, 1000);
+ * if (!copier.copy())
+ *     Logger.logError(LOG_TAG, copier.getFailureMessage());
+ * </pre>
+ */
+public final class FileTreeCopier {
+
+    /** The default max number of threads, since more do not help much on flash storage. */
+    public static final int DEFAULT_MAX_THREAD_COUNT = 4;
+
+    /** The default max number of errors to collect. */
+    public static final int DEFAULT_MAX_ERRORS = 100;
+
+    private final String mSrcPath;
+    private final String mDestPath;
+    private int mThreadCount = Math.min(DEFAULT_MAX_THREAD_COUNT, Runtime.getRuntime().availableProcessors());
+    private int mMaxErrors = DEFAULT_MAX_ERRORS;
+    private ProgressCallback mProgressCallback;
+    private long mProgressIntervalMillis;
+
+    /* The results of the last copy, set by native. */
+    @Keep
+    private long mCopiedCount;
+    @Keep
+    private long mCopiedBytes;
+    @Keep
+    private long mFailedCount;
+    @Keep
+    private boolean mCancelled;
+    @Keep
+    private String[] mErrorPaths;
+    @Keep
+    private int[] mErrorErrnos;
+
+    /** The callback for the progress of the copy. */
+    public interface ProgressCallback {
+        /**
+         * Called periodically on the thread that called {@link #copy()}.
+         *
+         * @param copiedCount The number of files and directories copied so far.
+         * @param copiedBytes The number of bytes of regular files copied so far.
+         * @param failedCount The number of failures so far.
+         * @return Returns {@code true} to continue the copy, otherwise {@code false} to cancel it.
+         */
+        boolean onProgress(long copiedCount, long copiedBytes, long failedCount);
+    }
+
+    /**
+     * Create an new instance of {@link FileTreeCopier}.
+     *
+     * @param srcPath The {@code path} of the file or directory to copy. If it is a symlink, the
+     *                symlink itself is copied.
+     * @param destPath The {@code path} to copy to. Its parent directory must exist. An existing
+     *                 directory is merged into and existing files are overwritten.
+     */
+    public FileTreeCopier(@NonNull String srcPath, @NonNull String destPath) {
+        mSrcPath = srcPath;
+        mDestPath = destPath;
+    }
+
+    /** Set the number of threads to copy with. Defaults to the number of processors up to {@link #DEFAULT_MAX_THREAD_COUNT}. */
+    public FileTreeCopier setThreadCount(int threadCount) {
+        mThreadCount = threadCount;
+        return this;
+    }
+
+    /** Set the max number of errors to collect. Defaults to {@link #DEFAULT_MAX_ERRORS}. */
+    public FileTreeCopier setMaxErrors(int maxErrors) {
+        mMaxErrors = maxErrors;
+        return this;
+    }
+
+    /** Set the {@link ProgressCallback} to call every {@code intervalMillis}. */
+    public FileTreeCopier setProgressCallback(@Nullable ProgressCallback progressCallback, long intervalMillis) {
+        mProgressCallback = progressCallback;
+        mProgressIntervalMillis = intervalMillis;
+        return this;
+    }
+
+    /**
+     * Copy the source file to the destination. Failures for files under a source directory do
+     * not stop the copy, check {@link #getFailedCount()} and {@link #getErrorPaths()}.
+     *
+     * @return Returns {@code true} if everything was copied, otherwise {@code false} if any
+     * failures occurred or the copy was cancelled.
+     * @throws ErrnoException If the source could not be read or the destination not created.
+     */
+    public boolean copy() throws ErrnoException {
+        mCopiedCount = 0;
+        mCopiedBytes = 0;
+        mFailedCount = 0;
+        mCancelled = false;
+        mErrorPaths = new String[0];
+        mErrorErrnos = new int[0];
+
+        copyNative(this, mSrcPath, mDestPath, mThreadCount, mMaxErrors, mProgressCallback != null ? mProgressIntervalMillis : 0);
+        return mFailedCount == 0 && !mCancelled;
+    }
+
+    /** Get the number of files and directories copied by the last copy. */
+    public long getCopiedCount() {
+        return mCopiedCount;
+    }
+
+    /** Get the number of bytes of regular files copied by the last copy. */
+    public long getCopiedBytes() {
+        return mCopiedBytes;
+    }
+
+    /** Get the number of failures of the last copy, which may be more than the errors collected. */
+    public long getFailedCount() {
+        return mFailedCount;
+    }
+
+    /** Whether the last copy was cancelled by the {@link ProgressCallback}. */
+    public boolean isCancelled() {
+        return mCancelled;
+    }
+
+    /** Get the paths relative to the source directory of the errors collected by the last copy. */
+    @NonNull
+    public String[] getErrorPaths() {
+        return mErrorPaths;
+    }
+
+    /** Get the errnos of the errors collected by the last copy. */
+    @NonNull
+    public int[] getErrorErrnos() {
+        return mErrorErrnos;
+    }
+
+    /** Get a message for the errors of the last copy, or {@code null} if there were none. */
+    @Nullable
+    public String getFailureMessage() {
+        if (mFailedCount == 0) return mCancelled ? "Copying \"" + mSrcPath + "\" to \"" + mDestPath + "\" was cancelled" : null;
+
+        StringBuilder message = new StringBuilder();
+        message.append(mFailedCount).append(" failures while copying \"").append(mSrcPath)
+            .append("\" to \"").append(mDestPath).append("\":");
+        for (int i = 0; i < mErrorPaths.length; i++) {
+            message.append("\n").append(new ErrnoException("copy", mErrorErrnos[i]).getMessage())
+                .append(": \"").append(mSrcPath).append("/").append(mErrorPaths[i]).append("\"");
+        }
+        if (mFailedCount > mErrorPaths.length)
+            message.append("\n...");
+        return message.toString();
+    }
+
+    @NonNull
+    public String getSrcPath() {
+        return mSrcPath;
+    }
+
+    @NonNull
+    public String getDestPath() {
+        return mDestPath;
+    }
+
+    /** Called by native every {@link #mProgressIntervalMillis}. */
+    @Keep
+    @SuppressWarnings("unused")
+    private boolean onNativeProgress(long copiedCount, long copiedBytes, long failedCount) {
+        return mProgressCallback == null || mProgressCallback.onProgress(copiedCount, copiedBytes, failedCount);
+    }
+
+
+
+    private static native void copyNative(FileTreeCopier copier, String srcPath, String destPath, int threadCount,
+                                          int maxErrors, long progressIntervalMillis) throws ErrnoException;
+
+    static { System.loadLibrary("posix"); }
+
+}
@@ -0,0 +1,177 @@
+package com.termux.shared.file.filesystem;
+
+import androidx.annotation.Keep;
+import androidx.annotation.NonNull;
+import androidx.annotation.Nullable;
+
+import com.termux.shared.file.libcore.ErrnoException;
+
+/**
+ * A native parallel deleter for everything under a directory.
+ *
+ * The subdirectories are split between a small pool of native threads, each of which deletes the
+ * files of a directory with unlinkat() relative to its open fd and removes it once everything
+ * under it has been removed. Symlinks are never followed. Failures do not stop the delete, they
+ * are counted and the first {@link #setMaxErrors(int)} of them are collected.
+ *
+ * Example:
+ * <pre>
+ * FileTreeDeleter deleter = new FileTreeDeleter(dirPath)
+ *     .setProgressCallback((deletedCount, failedCount) -> {
+ *         Logger.logVerbose(LOG_TAG, "Deleted " + deletedCount + " files");
+ *         return true;
+ *     }, 1000);
+ * if (!deleter.delete())
+ *     Logger.logError(LOG_TAG, deleter.getFailureMessage());
+ * </pre>
+ */
+public final class FileTreeDeleter {
+
+    /** The default max number of threads, since more do not help much on flash storage. */
+    public static final int DEFAULT_MAX_THREAD_COUNT = 4;
+
+    /** The default max number of errors to collect. */
+    public static final int DEFAULT_MAX_ERRORS = 100;
+
+    private final String mRootPath;
+    private int mThreadCount = Math.min(DEFAULT_MAX_THREAD_COUNT, Runtime.getRuntime().availableProcessors());
+    private int mMaxErrors = DEFAULT_MAX_ERRORS;
+    private ProgressCallback mProgressCallback;
+    private long mProgressIntervalMillis;
+
+    /* The results of the last delete, set by native. */
+    @Keep
+    private long mDeletedCount;
+    @Keep
+    private long mFailedCount;
+    @Keep
+    private boolean mCancelled;
+    @Keep
+    private String[] mErrorPaths;
+    @Keep
+    private int[] mErrorErrnos;
+
+    /** The callback for the progress of the delete. */
+    public interface ProgressCallback {
+        /**
+         * Called periodically on the thread that called {@link #delete()}.
+         *
+         * @param deletedCount The number of files and directories deleted so far.
+         * @param failedCount The number of failures so far.
+         * @return Returns {@code true} to continue the delete, otherwise {@code false} to cancel it.
+         */
+        boolean onProgress(long deletedCount, long failedCount);
+    }
+
+    /**
+     * Create an new instance of {@link FileTreeDeleter}.
+     *
+     * @param rootPath The {@code path} of the directory whose contents should be deleted. This
+     *                 must be the canonical path since symlinks are not followed. The directory
+     *                 itself is not deleted.
+     */
+    public FileTreeDeleter(@NonNull String rootPath) {
+        mRootPath = rootPath;
+    }
+
+    /** Set the number of threads to delete with. Defaults to the number of processors up to {@link #DEFAULT_MAX_THREAD_COUNT}. */
+    public FileTreeDeleter setThreadCount(int threadCount) {
+        mThreadCount = threadCount;
+        return this;
+    }
+
+    /** Set the max number of errors to collect. Defaults to {@link #DEFAULT_MAX_ERRORS}. */
+    public FileTreeDeleter setMaxErrors(int maxErrors) {
+        mMaxErrors = maxErrors;
+        return this;
+    }
+
+    /** Set the {@link ProgressCallback} to call every {@code intervalMillis}. */
+    public FileTreeDeleter setProgressCallback(@Nullable ProgressCallback progressCallback, long intervalMillis) {
+        mProgressCallback = progressCallback;
+        mProgressIntervalMillis = intervalMillis;
+        return this;
+    }
+
+    /**
+     * Delete everything under the root directory. Failures do not stop the delete, check
+     * {@link #getFailedCount()} and {@link #getErrorPaths()}.
+     *
+     * @return Returns {@code true} if everything was deleted, otherwise {@code false} if any
+     * failures occurred or the delete was cancelled.
+     * @throws ErrnoException If the root directory could not be opened.
+     */
+    public boolean delete() throws ErrnoException {
+        mDeletedCount = 0;
+        mFailedCount = 0;
+        mCancelled = false;
+        mErrorPaths = new String[0];
+        mErrorErrnos = new int[0];
+
+        deleteNative(this, mRootPath, mThreadCount, mMaxErrors, mProgressCallback != null ? mProgressIntervalMillis : 0);
+        return mFailedCount == 0 && !mCancelled;
+    }
+
+    /** Get the number of files and directories deleted by the last delete. */
+    public long getDeletedCount() {
+        return mDeletedCount;
+    }
+
+    /** Get the number of failures of the last delete, which may be more than the errors collected. */
+    public long getFailedCount() {
+        return mFailedCount;
+    }
+
+    /** Whether the last delete was cancelled by the {@link ProgressCallback}. */
+    public boolean isCancelled() {
+        return mCancelled;
+    }
+
+    /** Get the paths relative to the root directory of the errors collected by the last delete. */
+    @NonNull
+    public String[] getErrorPaths() {
+        return mErrorPaths;
+    }
+
+    /** Get the errnos of the errors collected by the last delete. */
+    @NonNull
+    public int[] getErrorErrnos() {
+        return mErrorErrnos;
+    }
+
+    /** Get a message for the errors of the last delete, or {@code null} if there were none. */
+    @Nullable
+    public String getFailureMessage() {
+        if (mFailedCount == 0) return mCancelled ? "Deleting under \"" + mRootPath + "\" was cancelled" : null;
+
+        StringBuilder message = new StringBuilder();
+        message.append(mFailedCount).append(" failures while deleting under \"").append(mRootPath).append("\":");
+        for (int i = 0; i < mErrorPaths.length; i++) {
+            message.append("\n").append(new ErrnoException("delete", mErrorErrnos[i]).getMessage())
+                .append(": \"").append(mRootPath).append("/").append(mErrorPaths[i]).append("\"");
+        }
+        if (mFailedCount > mErrorPaths.length)
+            message.append("\n...");
+        return message.toString();
+    }
+
+    @NonNull
+    public String getRootPath() {
+        return mRootPath;
+    }
+
+    /** Called by native every {@link #mProgressIntervalMillis}. */
+    @Keep
+    @SuppressWarnings("unused")
+    private boolean onNativeProgress(long deletedCount, long failedCount) {
+        return mProgressCallback == null || mProgressCallback.onProgress(deletedCount, failedCount);
+    }
+
+
+
+    private static native void deleteNative(FileTreeDeleter deleter, String rootPath, int threadCount,
+                                            int maxErrors, long progressIntervalMillis) throws ErrnoException;
+
+    static { System.loadLibrary("posix"); }
+
+}
@@ -0,0 +1,301 @@
+package com.termux.shared.file.filesystem;
+
+import androidx.annotation.Keep;
+import androidx.annotation.NonNull;
+import androidx.annotation.Nullable;
+
+import com.termux.shared.file.libcore.ErrnoException;
+
+import java.nio.charset.Charset;
+
+/**
+ * A native walker for the file tree under a directory.
+ *
+ * The walk is done natively with openat(), getdents64() and fstatat() relative to the file
+ * descriptor of each parent directory, so no {@link java.io.File} objects are created, paths
+ * are not looked up again for every entry and symlinks are never followed. The filters for
+ * {@link FileType}, modification time and name glob are evaluated natively and matched entries
+ * are optionally deleted natively and/or reported to a {@link Callback} in batches.
+ *
+ * Example to delete all "*.log" regular files older than a week:
+ * <pre>
+ * FileTreeWalker walker = new FileTreeWalker(dirPath)
+ *     .setFileTypeFlags(FileType.REGULAR.getValue())
+ *     .setMtimeRange(Long.MIN_VALUE, System.currentTimeMillis() - 7 * 86400000L)
+ *     .setNameGlob("*.log")
+ *     .setDelete(true);
+ * if (!walker.walk())
+ *     Logger.logError(LOG_TAG, walker.getFailureMessage());
+ * </pre>
+ */
+public final class FileTreeWalker {
+
+    /**
+     * The flags passed to native, which must be kept in sync with the WALK_FLAG_* constants
+     * in posix.cpp.
+     */
+    private static final int FLAG_DELETE = 1;
+    private static final int FLAG_STAT = 2;
+    private static final int FLAG_REPORT = 4;
+
+    /** The default number of entries reported to the {@link Callback} in each {@link Batch}. */
+    public static final int DEFAULT_BATCH_SIZE = 256;
+
+    private static final Charset UTF_8 = Charset.forName("UTF-8");
+
+    private final String mRootPath;
+    private int mFileTypeFlags = FileTypes.FILE_TYPE_ANY_FLAGS;
+    private int mMaxDepth = Integer.MAX_VALUE;
+    private long mMinMtimeMillis = Long.MIN_VALUE;
+    private long mMaxMtimeMillis = Long.MAX_VALUE;
+    private String mNameGlob;
+    private boolean mDelete;
+    private boolean mStat;
+    private int mBatchSize = DEFAULT_BATCH_SIZE;
+    private Callback mCallback;
+
+    /* The results of the last walk, set by native. */
+    @Keep
+    private long mMatchedCount;
+    @Keep
+    private long mFailedCount;
+    @Keep
+    private int mFirstFailedErrno;
+    @Keep
+    private String mFirstFailedPath;
+
+    /** The callback for the entries matched by the walk. */
+    public interface Callback {
+        /**
+         * Called for each batch of matched entries. Directories are reported before their
+         * contents, unless they are deleted, in which case they are reported after.
+         *
+         * @param batch The {@link Batch} of entries, which is only valid during the call.
+         * @return Returns {@code true} to continue the walk, otherwise {@code false} to stop it.
+         */
+        boolean onBatch(@NonNull Batch batch);
+    }
+
+    /**
+     * Create an new instance of {@link FileTreeWalker}.
+     *
+     * @param rootPath The {@code path} of the directory to walk. This must be the canonical path
+     *                 since symlinks are not followed. The directory itself is not included.
+     */
+    public FileTreeWalker(@NonNull String rootPath) {
+        mRootPath = rootPath;
+    }
+
+    /** Set the {@link FileType} flags of entries to match. Defaults to {@link FileTypes#FILE_TYPE_ANY_FLAGS}. */
+    public FileTreeWalker setFileTypeFlags(int fileTypeFlags) {
+        mFileTypeFlags = fileTypeFlags;
+        return this;
+    }
+
+    /** Set the max depth to walk, where 1 is the entries directly under the root directory. Defaults to unlimited. */
+    public FileTreeWalker setMaxDepth(int maxDepth) {
+        mMaxDepth = maxDepth;
+        return this;
+    }
+
+    /** Set the inclusive range of modification times in milliseconds of entries to match. */
+    public FileTreeWalker setMtimeRange(long minMtimeMillis, long maxMtimeMillis) {
+        mMinMtimeMillis = minMtimeMillis;
+        mMaxMtimeMillis = maxMtimeMillis;
+        return this;
+    }
+
+    /** Set the fnmatch(3) glob that the names of entries to match must match. Defaults to {@code null} to match all. */
+    public FileTreeWalker setNameGlob(@Nullable String nameGlob) {
+        mNameGlob = nameGlob;
+        return this;
+    }
+
+    /**
+     * Set whether matched entries should be deleted. A matched directory is only deleted if it
+     * is empty after its contents have been walked, so its contents should match as well.
+     */
+    public FileTreeWalker setDelete(boolean delete) {
+        mDelete = delete;
+        return this;
+    }
+
+    /**
+     * Set whether the mode, size and modification time should always be found for reported
+     * entries. Otherwise they are only found if required by the filters.
+     */
+    public FileTreeWalker setStat(boolean stat) {
+        mStat = stat;
+        return this;
+    }
+
+    /** Set the {@link Callback} for matched entries and the max number of entries in each {@link Batch}. */
+    public FileTreeWalker setCallback(@Nullable Callback callback, int batchSize) {
+        mCallback = callback;
+        mBatchSize = batchSize;
+        return this;
+    }
+
+    /**
+     * Walk the file tree. Failures for entries do not stop the walk, check {@link #getFailedCount()}.
+     *
+     * @return Returns {@code true} if no failures occurred for any entry, otherwise {@code false}.
+     * @throws ErrnoException If the root directory could not be opened or read.
+     */
+    public boolean walk() throws ErrnoException {
+        mMatchedCount = 0;
+        mFailedCount = 0;
+        mFirstFailedErrno = 0;
+        mFirstFailedPath = null;
+
+        int flags = 0;
+        if (mDelete) flags |= FLAG_DELETE;
+        if (mStat) flags |= FLAG_STAT;
+        if (mCallback != null) flags |= FLAG_REPORT;
+
+        walkNative(this, mRootPath, flags, mFileTypeFlags, mMaxDepth, mMinMtimeMillis, mMaxMtimeMillis, mNameGlob, mBatchSize);
+        return mFailedCount == 0;
+    }
+
+    /** Get the number of entries matched by the last walk. */
+    public long getMatchedCount() {
+        return mMatchedCount;
+    }
+
+    /** Get the number of entries that could not be read, walked or deleted by the last walk. */
+    public long getFailedCount() {
+        return mFailedCount;
+    }
+
+    /** Get the errno of the first failed entry of the last walk. */
+    public int getFirstFailedErrno() {
+        return mFirstFailedErrno;
+    }
+
+    /** Get the path relative to the root directory of the first failed entry of the last walk. */
+    @Nullable
+    public String getFirstFailedPath() {
+        return mFirstFailedPath;
+    }
+
+    /** Get a message for the failures of the last walk, or {@code null} if there were none. */
+    @Nullable
+    public String getFailureMessage() {
+        if (mFailedCount == 0) return null;
+        return mFailedCount + " failures while walking \"" + mRootPath + "\", first for \"" +
+            mRootPath + "/" + mFirstFailedPath + "\": " + new ErrnoException("walk", mFirstFailedErrno).getMessage();
+    }
+
+    @NonNull
+    public String getRootPath() {
+        return mRootPath;
+    }
+
+    /** Called by native for each batch of entries. */
+    @Keep
+    @SuppressWarnings("unused")
+    private boolean onNativeBatch(byte[] paths, long[] entries, int count) {
+        return mCallback == null || mCallback.onBatch(new Batch(mRootPath, paths, entries, count));
+    }
+
+
+
+    /**
+     * A cursor over a batch of entries reported by the native walk. The paths are only decoded
+     * if requested.
+     */
+    public static final class Batch {
+
+        // The fields of each entry, which must be kept in sync with the WALK_ENTRY_FIELD_*
+        // constants in posix.cpp.
+        private static final int FIELD_PATH_OFFSET = 0;
+        private static final int FIELD_PATH_LENGTH = 1;
+        private static final int FIELD_TYPE = 2;
+        private static final int FIELD_MODE = 3;
+        private static final int FIELD_SIZE = 4;
+        private static final int FIELD_MTIME_MILLIS = 5;
+        private static final int FIELD_DEPTH = 6;
+        private static final int FIELD_ERRNO = 7;
+        private static final int FIELD_COUNT = 8;
+
+        private final String mRootPath;
+        private final byte[] mPaths;
+        private final long[] mEntries;
+        private final int mCount;
+        private int mPosition = -1;
+        private int mOffset = -FIELD_COUNT;
+
+        Batch(String rootPath, byte[] paths, long[] entries, int count) {
+            mRootPath = rootPath;
+            mPaths = paths;
+            mEntries = entries;
+            mCount = count;
+        }
+
+        /** Get the number of entries. */
+        public int getCount() {
+            return mCount;
+        }
+
+        /** Move to the next entry. Returns {@code false} if there are no more entries. */
+        public boolean moveToNext() {
+            if (mPosition + 1 >= mCount) return false;
+            mPosition++;
+            mOffset += FIELD_COUNT;
+            return true;
+        }
+
+        /** Get the path of the current entry relative to the root directory. */
+        @NonNull
+        public String getRelativePath() {
+            return new String(mPaths, (int) mEntries[mOffset + FIELD_PATH_OFFSET],
+                (int) mEntries[mOffset + FIELD_PATH_LENGTH], UTF_8);
+        }
+
+        /** Get the absolute path of the current entry. */
+        @NonNull
+        public String getPath() {
+            return mRootPath + "/" + getRelativePath();
+        }
+
+        /** Get the {@link FileType#getValue()} of the current entry. */
+        public int getFileTypeValue() {
+            return (int) mEntries[mOffset + FIELD_TYPE];
+        }
+
+        /** Get the {@code st_mode} of the current entry, or 0 if it was not found. */
+        public int getMode() {
+            return (int) mEntries[mOffset + FIELD_MODE];
+        }
+
+        /** Get the size of the current entry, or 0 if it was not found. */
+        public long getSize() {
+            return mEntries[mOffset + FIELD_SIZE];
+        }
+
+        /** Get the modification time in milliseconds of the current entry, or 0 if it was not found. */
+        public long getMtimeMillis() {
+            return mEntries[mOffset + FIELD_MTIME_MILLIS];
+        }
+
+        /** Get the depth of the current entry, where 1 is directly under the root directory. */
+        public int getDepth() {
+            return (int) mEntries[mOffset + FIELD_DEPTH];
+        }
+
+        /** Get the errno if the current entry failed to be read, walked or deleted, otherwise 0. */
+        public int getErrno() {
+            return (int) mEntries[mOffset + FIELD_ERRNO];
+        }
+
+    }
+
+
+
+    private static native void walkNative(FileTreeWalker walker, String rootPath, int flags, int fileTypeFlags,
+                                          int maxDepth, long minMtimeMillis, long maxMtimeMillis,
+                                          String nameGlob, int batchSize) throws ErrnoException;
+
+    static { System.loadLibrary("posix"); }
+
+}
@@ -4,6 +4,9 @@ import android.system.Os;
 
 import androidx.annotation.NonNull;
 
+import com.termux.shared.file.libcore.OsConstants;
+import com.termux.shared.file.libcore.StructStatArray;
+import com.termux.shared.file.libcore.StructStatx;
 import com.termux.shared.logger.Logger;
 
 import java.io.File;
@@ -58,7 +61,8 @@ public class FileTypes {
      *
      * So we get the file type directly with {@link Os#lstat(String)} if {@code followLinks} is
      * {@code false} and {@link Os#stat(String)} if {@code followLinks} is {@code true}. All exceptions
-     * are assumed as non-existence.
+     * are assumed as non-existence. The {@link com.termux.shared.file.libcore.Os#statx(String, int, int)}
+     * is used to do that and only requests {@link OsConstants#STATX_TYPE}.
      *
      * The {@link org.apache.commons.io.FileUtils#isSymlink(File)} can also be used for checking
      * symlinks but {@link FileAttributes} will provide access to more attributes if necessary,
@@ -87,8 +91,9 @@ public class FileTypes {
         if (filePath == null || filePath.isEmpty()) return FileType.NO_EXIST;
 
         try {
-            FileAttributes fileAttributes = FileAttributes.get(filePath, followLinks);
-            return getFileType(fileAttributes);
+            // Only request the file type, which is cheaper than a full stat on FUSE filesystems
+            StructStatx stx = com.termux.shared.file.libcore.Os.statx(filePath, followLinks ? 0 : OsConstants.AT_SYMLINK_NOFOLLOW, OsConstants.STATX_TYPE);
+            return getFileType(stx.stx_mode);
         } catch (Exception e) {
             // If not a ENOENT (No such file or directory) exception
             if (e.getMessage() != null && !e.getMessage().contains("ENOENT"))
@@ -97,6 +102,42 @@ public class FileTypes {
         }
     }
 
+    /**
+     * Checks the type of files that exist at {@code filePaths} with a single call to
+     * {@link com.termux.shared.file.libcore.Os#statMany(String[], int)}, instead of creating a
+     * {@link FileAttributes} for each file like {@link #getFileType(String, boolean)} does.
+     *
+     * @param filePaths The {@code paths} for files to check.
+     * @param followLinks The {@code boolean} that decides if symlinks will be followed while
+     *                       finding type. Check {@link #getFileType(String, boolean)} for details.
+     * @return Returns the {@link FileType} of each file in the same order as {@code filePaths}.
+     * The {@link FileType#NO_EXIST} is returned for a {@code null} or empty path or if stat failed.
+     */
+    @NonNull
+    public static FileType[] getFileTypes(@NonNull final String[] filePaths, final boolean followLinks) {
+        FileType[] fileTypes = new FileType[filePaths.length];
+
+        StructStatArray stats;
+        try {
+            stats = StructStatArray.statMany(filePaths, followLinks);
+        } catch (Throwable t) {
+            Logger.logError("Failed to get file types for " + filePaths.length + " files: " + t.getMessage());
+            for (int i = 0; i < filePaths.length; i++)
+                fileTypes[i] = getFileType(filePaths[i], followLinks);
+            return fileTypes;
+        }
+
+        while (stats.moveToNext()) {
+            int i = stats.getPosition();
+            if (filePaths[i] == null || filePaths[i].isEmpty() || !stats.exists())
+                fileTypes[i] = FileType.NO_EXIST;
+            else
+                fileTypes[i] = getFileType(stats.getMode());
+        }
+
+        return fileTypes;
+    }
+
     public static FileType getFileType(@NonNull final FileAttributes fileAttributes) {
         if (fileAttributes.isRegularFile())
             return FileType.REGULAR;
@@ -116,4 +157,25 @@ public class FileTypes {
             return FileType.UNKNOWN;
     }
 
+    /** Get the {@link FileType} for the file type bits of a {@code st_mode}. */
+    public static FileType getFileType(final int st_mode) {
+        int type = st_mode & UnixConstants.S_IFMT;
+        if (type == UnixConstants.S_IFREG)
+            return FileType.REGULAR;
+        else if (type == UnixConstants.S_IFDIR)
+            return FileType.DIRECTORY;
+        else if (type == UnixConstants.S_IFLNK)
+            return FileType.SYMLINK;
+        else if (type == UnixConstants.S_IFSOCK)
+            return FileType.SOCKET;
+        else if (type == UnixConstants.S_IFCHR)
+            return FileType.CHARACTER;
+        else if (type == UnixConstants.S_IFIFO)
+            return FileType.FIFO;
+        else if (type == UnixConstants.S_IFBLK)
+            return FileType.BLOCK;
+        else
+            return FileType.UNKNOWN;
+    }
+
 }
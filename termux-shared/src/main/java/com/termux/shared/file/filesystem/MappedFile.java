@@ -0,0 +1,125 @@
+package com.termux.shared.file.filesystem;
+
+import androidx.annotation.NonNull;
+
+import com.termux.shared.file.libcore.ErrnoException;
+
+import java.io.Closeable;
+import java.io.InputStream;
+import java.nio.ByteBuffer;
+
+/**
+ * A native read-only memory mapped view of a whole regular file.
+ *
+ * The pages of the file are only read from disk when they are accessed and are not part of the
+ * java heap, so large files like logs and reports can be read in chunks without loading them into
+ * memory first.
+ *
+ * The {@link ByteBuffer}s returned by {@link #getBuffer()} must not be accessed after
+ * {@link #close()} is called, since the memory is unmapped.
+ *
+ * Only files that are private to the app and that are only replaced atomically, like with
+ * {@link AtomicFileOutputStream}, must be mapped. If a mapped file is truncated, like by another
+ * process writing to it, then accessing the pages past its new end kills the app with
+ * {@code SIGBUS}. Use streams for other files.
+ *
+ * Example:
+ * <pre>
+ * try (MappedFile mappedFile = MappedFile.open(filePath)) {
+ *     ByteBuffer buffer = mappedFile.getBuffer();
+ *     ...
+ * }
+ * </pre>
+ */
+public final class MappedFile implements Closeable {
+
+    private final String mPath;
+    private ByteBuffer mBuffer;
+    private final boolean mMapped;
+
+    private MappedFile(@NonNull String path, ByteBuffer buffer) {
+        mPath = path;
+        mMapped = buffer != null;
+        mBuffer = buffer != null ? buffer : ByteBuffer.allocate(0);
+    }
+
+    /**
+     * Map the regular file at path.
+     *
+     * @param path The {@code path} of the file to map.
+     * @return Returns the {@link MappedFile}.
+     * @throws ErrnoException If the file could not be opened or mapped, with {@code EINVAL} if it
+     * is not a regular file and {@code EFBIG} if it is larger than {@link Integer#MAX_VALUE}.
+     */
+    @NonNull
+    public static MappedFile open(@NonNull String path) throws ErrnoException {
+        return new MappedFile(path, mapNative(path));
+    }
+
+    /**
+     * Get a new read-only {@link ByteBuffer} for the contents of the file, with its own position
+     * and limit.
+     */
+    @NonNull
+    public synchronized ByteBuffer getBuffer() {
+        if (mBuffer == null) throw new IllegalStateException("The file at \"" + mPath + "\" is already unmapped");
+        return mBuffer.asReadOnlyBuffer();
+    }
+
+    /**
+     * Get a new {@link InputStream} for the contents of the file, with its own position. It must
+     * not be read after {@link #close()} is called.
+     */
+    @NonNull
+    public InputStream getInputStream() {
+        final ByteBuffer buffer = getBuffer();
+        return new InputStream() {
+            @Override
+            public int read() {
+                return buffer.hasRemaining() ? buffer.get() & 0xff : -1;
+            }
+
+            @Override
+            public int read(@NonNull byte[] bytes, int offset, int length) {
+                if (length == 0) return 0;
+                if (!buffer.hasRemaining()) return -1;
+                length = Math.min(length, buffer.remaining());
+                buffer.get(bytes, offset, length);
+                return length;
+            }
+
+            @Override
+            public int available() {
+                return buffer.remaining();
+            }
+        };
+    }
+
+    /** Get the size of the file when it was mapped. */
+    public synchronized long getSize() {
+        return mBuffer == null ? 0 : mBuffer.capacity();
+    }
+
+    @NonNull
+    public String getPath() {
+        return mPath;
+    }
+
+    /** Unmap the file. */
+    @Override
+    public synchronized void close() {
+        if (mBuffer == null) return;
+        if (mMapped)
+            unmapNative(mBuffer);
+        mBuffer = null;
+    }
+
+
+
+    private static native ByteBuffer mapNative(String path) throws ErrnoException;
+
+    private static native void unmapNative(ByteBuffer buffer);
+
+    static { System.loadLibrary("posix"); }
+
+}
@@ -0,0 +1,46 @@
+package com.termux.shared.file.filesystem;
+
+import androidx.annotation.NonNull;
+
+import com.termux.shared.file.libcore.ErrnoException;
+
+import java.io.File;
+
+/**
+ * A native canonicalizer for absolute paths, like {@link File#getCanonicalPath()}.
+ *
+ * {@link File#getCanonicalPath()} does an {@code lstat()} and {@code readlink()} for every
+ * component of the path. Instead, the path is resolved one component at a time with
+ * {@code openat(O_PATH)} relative to the directory resolved so far, and the canonical paths of the
+ * directories along it are kept in a small LRU cache. Paths under a recently canonicalized
+ * directory, like the executables and working directories under {@code $PREFIX} that are validated
+ * for every command, then only need a {@code stat()} to check that the cached directory still is
+ * the same inode and one to resolve the last component.
+ */
+public final class PathCanonicalizer {
+
+    private PathCanonicalizer() {}
+
+    /**
+     * Get the canonical path of an absolute path. All symlinks are resolved and "." and ".."
+     * components and duplicate and trailing slashes are removed. Like with
+     * {@link File#getCanonicalPath()}, the components after the first one that does not exist or
+     * cannot be accessed are only normalized.
+     *
+     * @param path The absolute {@code path} to canonicalize.
+     * @return Returns the {@code canonical path}.
+     * @throws ErrnoException If {@code path} is not absolute or too many symlinks were followed.
+     */
+    @NonNull
+    public static native String canonicalize(@NonNull String path) throws ErrnoException;
+
+    /**
+     * Remove all directories from the cache. This is not needed for symlinks or directories that
+     * are replaced or renamed, since those are detected by their changed inode, but can be used to
+     * release the memory of the cache.
+     */
+    public static native void invalidateCache();
+
+    static { System.loadLibrary("posix"); }
+
+}
@@ -2,5 +2,12 @@ package com.termux.shared.file.libcore;
 import com.termux.shared.nio.charset.Charset;
 public class NativeConverter {
     public static native Charset charsetForName(String charsetName);
+    /**
+     * Check out an idle converter from the pool of the charset descriptor, or open a new one.
+     * It must be returned with {@link #returnConverter(long, long)}.
+     */
+    public static native long checkoutConverter(long charsetDescriptor);
+    /** Reset and return a converter checked out with {@link #checkoutConverter(long)} to its pool. */
+    public static native void returnConverter(long charsetDescriptor, long converter);
     static { System.loadLibrary("nativeconverter"); }
 }
@@ -8,6 +8,22 @@ public class Os {
     public static native StructStat stat(String path) throws ErrnoException;
     public static native StructStat lstat(String path) throws ErrnoException;
     public static native StructStat fstat(FileDescriptor fd) throws ErrnoException;
+    /**
+     * Stat all paths with a single call without throwing for failures. Pass
+     * {@link OsConstants#AT_SYMLINK_NOFOLLOW} in flags to not follow symlinks like lstat().
+     * Use {@link StructStatArray} to read the packed result.
+     */
+    public static native long[] statMany(String[] paths, int flags);
+    /**
+     * Get the attributes of the file at path with statx(2), requesting only the
+     * {@link OsConstants}{@code .STATX_*} fields in mask. Pass {@link OsConstants#AT_SYMLINK_NOFOLLOW}
+     * in flags to not follow symlinks. Check {@link StructStatx#stx_mask} for the fields that
+     * were filled, since on devices without statx only {@link OsConstants#STATX_BASIC_STATS} are.
+     */
+    public static StructStatx statx(String path, int flags, int mask) throws ErrnoException {
+        return new StructStatx(statxNative(path, flags, mask));
+    }
+    private static native long[] statxNative(String path, int flags, int mask) throws ErrnoException;
     public static native void chmod(String path, int mode) throws ErrnoException;
 
     static { System.loadLibrary("posix"); }
@@ -41,6 +41,10 @@ public final class OsConstants {
     public static final int AI_NUMERICSERV = placeholder();
     public static final int AI_PASSIVE = placeholder();
     public static final int AI_V4MAPPED = placeholder();
+    public static final int AT_STATX_DONT_SYNC = placeholder();
+    public static final int AT_STATX_FORCE_SYNC = placeholder();
+    public static final int AT_STATX_SYNC_AS_STAT = placeholder();
+    public static final int AT_SYMLINK_NOFOLLOW = placeholder();
     public static final int E2BIG = placeholder();
     public static final int EACCES = placeholder();
     public static final int EADDRINUSE = placeholder();
@@ -307,6 +311,20 @@ public final class OsConstants {
     public static final int SO_SNDLOWAT = placeholder();
     public static final int SO_SNDTIMEO = placeholder();
     public static final int SO_TYPE = placeholder();
+    public static final int STATX_ATIME = placeholder();
+    public static final int STATX_BASIC_STATS = placeholder();
+    public static final int STATX_BLOCKS = placeholder();
+    public static final int STATX_BTIME = placeholder();
+    public static final int STATX_CTIME = placeholder();
+    public static final int STATX_GID = placeholder();
+    public static final int STATX_INO = placeholder();
+    public static final int STATX_MNT_ID = placeholder();
+    public static final int STATX_MODE = placeholder();
+    public static final int STATX_MTIME = placeholder();
+    public static final int STATX_NLINK = placeholder();
+    public static final int STATX_SIZE = placeholder();
+    public static final int STATX_TYPE = placeholder();
+    public static final int STATX_UID = placeholder();
     public static final int STDERR_FILENO = placeholder();
     public static final int STDIN_FILENO = placeholder();
     public static final int STDOUT_FILENO = placeholder();
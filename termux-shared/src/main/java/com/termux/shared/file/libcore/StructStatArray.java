@@ -0,0 +1,131 @@
+package com.termux.shared.file.libcore;
+
+/**
+ * A cursor over the packed results of {@link Os#statMany(String[], int)}, so that the stat
+ * results of many files can be read without creating a {@link StructStat} object for each.
+ *
+ * Each entry has {@link #FIELD_COUNT} long fields. The field indexes must be kept in sync with the
+ * STAT_MANY_FIELD_* constants in posix.cpp.
+ *
+ * Example:
+ * <pre>
+ * StructStatArray stats = StructStatArray.statMany(paths, false);
+ * while (stats.moveToNext()) {
+ *     if (stats.exists() && OsConstants.S_ISDIR(stats.getMode()))
+ *         ...
+ * }
+ * </pre>
+ */
+public final class StructStatArray {
+
+    public static final int FIELD_ERRNO = 0;
+    public static final int FIELD_DEV = 1;
+    public static final int FIELD_INO = 2;
+    public static final int FIELD_MODE = 3;
+    public static final int FIELD_NLINK = 4;
+    public static final int FIELD_UID = 5;
+    public static final int FIELD_GID = 6;
+    public static final int FIELD_RDEV = 7;
+    public static final int FIELD_SIZE = 8;
+    public static final int FIELD_BLKSIZE = 9;
+    public static final int FIELD_BLOCKS = 10;
+    public static final int FIELD_ATIME_SEC = 11;
+    public static final int FIELD_ATIME_NSEC = 12;
+    public static final int FIELD_MTIME_SEC = 13;
+    public static final int FIELD_MTIME_NSEC = 14;
+    public static final int FIELD_CTIME_SEC = 15;
+    public static final int FIELD_CTIME_NSEC = 16;
+    /** The number of fields of each entry. */
+    public static final int FIELD_COUNT = 17;
+
+    private final String[] mPaths;
+    private final long[] mData;
+    private int mPosition = -1;
+    private int mOffset = -FIELD_COUNT;
+
+    /**
+     * Create an new instance of {@link StructStatArray}.
+     *
+     * @param paths The paths passed to {@link Os#statMany(String[], int)}.
+     * @param data The array returned by {@link Os#statMany(String[], int)}.
+     */
+    public StructStatArray(String[] paths, long[] data) {
+        if (data.length != paths.length * FIELD_COUNT)
+            throw new IllegalArgumentException("The data length " + data.length + " is not " + FIELD_COUNT + " times the paths count " + paths.length);
+        mPaths = paths;
+        mData = data;
+    }
+
+    /**
+     * Stat all paths with a single call to {@link Os#statMany(String[], int)}.
+     *
+     * @param paths The paths to stat.
+     * @param followLinks If symlinks should be followed like stat() instead of lstat().
+     * @return Returns the {@link StructStatArray} positioned before the first entry.
+     */
+    public static StructStatArray statMany(String[] paths, boolean followLinks) {
+        return new StructStatArray(paths, Os.statMany(paths, followLinks ? 0 : OsConstants.AT_SYMLINK_NOFOLLOW));
+    }
+
+    /** Get the number of entries. */
+    public int getCount() {
+        return mPaths.length;
+    }
+
+    /** Get the current position, which is -1 before the first call to {@link #moveToNext()}. */
+    public int getPosition() {
+        return mPosition;
+    }
+
+    /** Move to the entry at position. Returns {@code false} if it is out of range. */
+    public boolean moveToPosition(int position) {
+        if (position < 0 || position >= mPaths.length) return false;
+        mPosition = position;
+        mOffset = position * FIELD_COUNT;
+        return true;
+    }
+
+    /** Move to the next entry. Returns {@code false} if there are no more entries. */
+    public boolean moveToNext() {
+        return moveToPosition(mPosition + 1);
+    }
+
+    /** Get the value of field of the current entry. */
+    public long getField(int field) {
+        return mData[mOffset + field];
+    }
+
+    public String getPath() { return mPaths[mPosition]; }
+
+    /** Get the errno for the current entry, which is 0 if stat was successful. */
+    public int getErrno() { return (int) getField(FIELD_ERRNO); }
+
+    /** Whether stat was successful for the current entry. */
+    public boolean exists() { return getErrno() == 0; }
+
+    public long getDev() { return getField(FIELD_DEV); }
+    public long getIno() { return getField(FIELD_INO); }
+    public int getMode() { return (int) getField(FIELD_MODE); }
+    public long getNlink() { return getField(FIELD_NLINK); }
+    public int getUid() { return (int) getField(FIELD_UID); }
+    public int getGid() { return (int) getField(FIELD_GID); }
+    public long getRdev() { return getField(FIELD_RDEV); }
+    public long getSize() { return getField(FIELD_SIZE); }
+    public long getBlksize() { return getField(FIELD_BLKSIZE); }
+    public long getBlocks() { return getField(FIELD_BLOCKS); }
+    public long getAtimeSec() { return getField(FIELD_ATIME_SEC); }
+    public long getAtimeNsec() { return getField(FIELD_ATIME_NSEC); }
+    public long getMtimeSec() { return getField(FIELD_MTIME_SEC); }
+    public long getMtimeNsec() { return getField(FIELD_MTIME_NSEC); }
+    public long getCtimeSec() { return getField(FIELD_CTIME_SEC); }
+    public long getCtimeNsec() { return getField(FIELD_CTIME_NSEC); }
+
+    /** Get a {@link StructStat} for the current entry, or {@code null} if stat failed for it. */
+    public StructStat toStructStat() {
+        if (!exists()) return null;
+        return new StructStat(getDev(), getIno(), getMode(), getNlink(), getUid(), getGid(),
+            getRdev(), getSize(), getAtimeSec(), getMtimeSec(), getCtimeSec(),
+            getBlksize(), getBlocks());
+    }
+
+}
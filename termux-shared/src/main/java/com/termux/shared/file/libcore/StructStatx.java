@@ -0,0 +1,104 @@
+package com.termux.shared.file.libcore;
+
+/**
+ * File information returned by {@link Os#statx(String, int, int)}. Corresponds to C's
+ * {@code struct statx} from {@code <linux/stat.h>}.
+ *
+ * Only the fields set in {@link #stx_mask} are valid, the rest are 0.
+ */
+public final class StructStatx {
+
+    // The fields of the array returned by the native, which must be kept in sync with the
+    // STATX_FIELD_* constants in posix.cpp.
+    static final int FIELD_MASK = 0;
+    static final int FIELD_BLKSIZE = 1;
+    static final int FIELD_ATTRIBUTES = 2;
+    static final int FIELD_NLINK = 3;
+    static final int FIELD_UID = 4;
+    static final int FIELD_GID = 5;
+    static final int FIELD_MODE = 6;
+    static final int FIELD_INO = 7;
+    static final int FIELD_SIZE = 8;
+    static final int FIELD_BLOCKS = 9;
+    static final int FIELD_ATIME_SEC = 10;
+    static final int FIELD_ATIME_NSEC = 11;
+    static final int FIELD_BTIME_SEC = 12;
+    static final int FIELD_BTIME_NSEC = 13;
+    static final int FIELD_CTIME_SEC = 14;
+    static final int FIELD_CTIME_NSEC = 15;
+    static final int FIELD_MTIME_SEC = 16;
+    static final int FIELD_MTIME_NSEC = 17;
+    static final int FIELD_RDEV = 18;
+    static final int FIELD_DEV = 19;
+    static final int FIELD_MNT_ID = 20;
+    static final int FIELD_COUNT = 21;
+
+    /** The {@link OsConstants}{@code .STATX_*} mask of the fields that are filled. */
+    public final int stx_mask;
+    /** Block size for filesystem I/O. */
+    public final long stx_blksize;
+    /** The {@code STATX_ATTR_*} file attribute flags. */
+    public final long stx_attributes;
+    /** Number of hard links to the file. */
+    public final long stx_nlink;
+    /** User ID of file. */
+    public final int stx_uid;
+    /** Group ID of file. */
+    public final int stx_gid;
+    /** Mode (file type and permissions) of file. */
+    public final int stx_mode;
+    /** File serial number (inode). */
+    public final long stx_ino;
+    /** The file size in bytes. */
+    public final long stx_size;
+    /** Number of 512-byte blocks allocated for file. */
+    public final long stx_blocks;
+    /** Time of last access. */
+    public final long stx_atime_sec;
+    public final long stx_atime_nsec;
+    /** Time of file creation, if {@link OsConstants#STATX_BTIME} is set in {@link #stx_mask}. */
+    public final long stx_btime_sec;
+    public final long stx_btime_nsec;
+    /** Time of last status change. */
+    public final long stx_ctime_sec;
+    public final long stx_ctime_nsec;
+    /** Time of last data modification. */
+    public final long stx_mtime_sec;
+    public final long stx_mtime_nsec;
+    /** Device ID (if file is character or block special). */
+    public final long stx_rdev;
+    /** Device ID of device containing file. */
+    public final long stx_dev;
+    /** Mount ID of the mount containing file, if {@link OsConstants#STATX_MNT_ID} is set in {@link #stx_mask}. */
+    public final long stx_mnt_id;
+
+    StructStatx(long[] fields) {
+        this.stx_mask = (int) fields[FIELD_MASK];
+        this.stx_blksize = fields[FIELD_BLKSIZE];
+        this.stx_attributes = fields[FIELD_ATTRIBUTES];
+        this.stx_nlink = fields[FIELD_NLINK];
+        this.stx_uid = (int) fields[FIELD_UID];
+        this.stx_gid = (int) fields[FIELD_GID];
+        this.stx_mode = (int) fields[FIELD_MODE];
+        this.stx_ino = fields[FIELD_INO];
+        this.stx_size = fields[FIELD_SIZE];
+        this.stx_blocks = fields[FIELD_BLOCKS];
+        this.stx_atime_sec = fields[FIELD_ATIME_SEC];
+        this.stx_atime_nsec = fields[FIELD_ATIME_NSEC];
+        this.stx_btime_sec = fields[FIELD_BTIME_SEC];
+        this.stx_btime_nsec = fields[FIELD_BTIME_NSEC];
+        this.stx_ctime_sec = fields[FIELD_CTIME_SEC];
+        this.stx_ctime_nsec = fields[FIELD_CTIME_NSEC];
+        this.stx_mtime_sec = fields[FIELD_MTIME_SEC];
+        this.stx_mtime_nsec = fields[FIELD_MTIME_NSEC];
+        this.stx_rdev = fields[FIELD_RDEV];
+        this.stx_dev = fields[FIELD_DEV];
+        this.stx_mnt_id = fields[FIELD_MNT_ID];
+    }
+
+    /** Whether all the {@link OsConstants}{@code .STATX_*} fields in mask are filled. */
+    public boolean hasFields(int mask) {
+        return (stx_mask & mask) == mask;
+    }
+
+}
@@ -211,8 +211,8 @@ public class ShareUtils {
             return;
         }
 
-        Error error = FileUtils.writeTextToFile(label, filePath,
-            Charset.defaultCharset(), text, false);
+        Error error = FileUtils.writeTextToFileAtomically(label, filePath,
+            Charset.defaultCharset(), text);
         if (error != null) {
             Logger.logErrorExtended(LOG_TAG, error.toString());
             Logger.showToast(context, Error.getMinimalErrorString(error), true);
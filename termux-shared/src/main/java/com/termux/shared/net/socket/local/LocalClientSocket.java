@@ -15,6 +15,7 @@ import java.io.InputStream;
 import java.io.InputStreamReader;
 import java.io.OutputStream;
 import java.io.OutputStreamWriter;
+import java.nio.charset.StandardCharsets;
 
 /** The client socket for {@link LocalSocketManager}. */
 public class LocalClientSocket implements Closeable {
@@ -45,6 +46,12 @@ public class LocalClientSocket implements Closeable {
     /** The {@link InputStream} implementation for the {@link LocalClientSocket}. */
     @NonNull protected final SocketInputStream mInputStream;
 
+    /**
+     * The buffer of {@link LocalSocketRunConfig#getMaxMessageSize()} used by
+     * {@link #readMessage(StringBuilder, MutableInt)}. It is created on first use.
+     */
+    protected byte[] mMessageBuffer;
+
     /**
      * Create an new instance of {@link LocalClientSocket}.
      *
@@ -61,7 +68,8 @@ public class LocalClientSocket implements Closeable {
         mPeerCred = peerCred;
 
         setFD(fd);
-        mPeerCred.fillPeerCred(localSocketManager.getContext());
+        // Names are resolved lazily only if needed by logs or policy checks
+        mPeerCred.setContext(localSocketManager.getContext());
     }
 
 
@@ -88,7 +96,8 @@ public class LocalClientSocket implements Closeable {
     @Override
     public void close() throws IOException {
         if (mFD >= 0) {
-            Logger.logVerbose(LOG_TAG, "Client socket close for \"" + mLocalSocketRunConfig.getTitle() + "\" server: " + getPeerCred().getMinimalString());
+            if (Logger.getLogLevel() >= Logger.LOG_LEVEL_VERBOSE)
+                Logger.logVerbose(LOG_TAG, "Client socket close for \"" + mLocalSocketRunConfig.getTitle() + "\" server: " + getPeerCred().getMinimalString());
             JniResult result = LocalSocketManager.closeSocket(mLocalSocketRunConfig.getLogTitle() + " (client)", mFD);
             if (result == null || result.retval != 0) {
                 throw new IOException(JniResult.getErrorString(result));
@@ -172,6 +181,211 @@ public class LocalClientSocket implements Closeable {
         return null;
     }
 
+    /**
+     * Attempts to fill multiple data buffers in order with a single JNI call. On success, the total
+     * number of bytes read is returned in bytesRead, which will be less than the total size of the
+     * buffers only if end of file was reached.
+     *
+     * If while reading the {@link #mCreationTime} + the milliseconds returned by
+     * {@link LocalSocketRunConfig#getDeadline()} elapses but all the buffers have not been filled,
+     * an error would be returned.
+     *
+     * This is a wrapper for {@link LocalSocketManager#readv(String, int, byte[][], long)}.
+     *
+     * @param buffers The data buffers to read bytes into, like a header and payload buffer.
+     * @param bytesRead The actual bytes read.
+     * @return Returns the {@code error} if reading was not successful containing {@link JniResult}
+     * error {@link String}, otherwise {@code null}.
+     */
+    public Error readv(@NonNull byte[][] buffers, MutableInt bytesRead) {
+        bytesRead.value = 0;
+
+        if (mFD < 0) {
+            return LocalSocketErrno.ERRNO_USING_CLIENT_SOCKET_WITH_INVALID_FD.getError(mFD,
+                mLocalSocketRunConfig.getTitle());
+        }
+
+        JniResult result = LocalSocketManager.readv(mLocalSocketRunConfig.getLogTitle() + " (client)",
+            mFD, buffers,
+            mLocalSocketRunConfig.getDeadline() > 0 ? mCreationTime + mLocalSocketRunConfig.getDeadline() : 0);
+        if (result == null || result.retval != 0) {
+            return LocalSocketErrno.ERRNO_READV_DATA_FROM_CLIENT_SOCKET_FAILED.getError(
+                mLocalSocketRunConfig.getTitle(), JniResult.getErrorString(result));
+        }
+
+        bytesRead.value = result.intData;
+        return null;
+    }
+
+    /**
+     * Attempts to send multiple data buffers in order with a single JNI call and gathered write,
+     * instead of calling {@link #send(byte[])} for each buffer.
+     *
+     * If while sending the {@link #mCreationTime} + the milliseconds returned by
+     * {@link LocalSocketRunConfig#getDeadline()} elapses but all the data has not been sent, an
+     * error would be returned.
+     *
+     * This is a wrapper for {@link LocalSocketManager#writev(String, int, byte[][], long)}.
+     *
+     * @param buffers The data buffers containing bytes to send, like a header and payload buffer.
+     * @return Returns the {@code error} if sending was not successful containing {@link JniResult}
+     * error {@link String}, otherwise {@code null}.
+     */
+    public Error writev(@NonNull byte[]... buffers) {
+        if (mFD < 0) {
+            return LocalSocketErrno.ERRNO_USING_CLIENT_SOCKET_WITH_INVALID_FD.getError(mFD,
+                mLocalSocketRunConfig.getTitle());
+        }
+
+        JniResult result = LocalSocketManager.writev(mLocalSocketRunConfig.getLogTitle() + " (client)",
+            mFD, buffers,
+            mLocalSocketRunConfig.getDeadline() > 0 ? mCreationTime + mLocalSocketRunConfig.getDeadline() : 0);
+        if (result == null || result.retval != 0) {
+            return LocalSocketErrno.ERRNO_WRITEV_DATA_TO_CLIENT_SOCKET_FAILED.getError(
+                mLocalSocketRunConfig.getTitle(), JniResult.getErrorString(result));
+        }
+
+        return null;
+    }
+
+    /**
+     * Waits until data is available and copies up to data buffer length bytes into the data buffer
+     * without consuming them, so that they will be returned again by the next read. On success,
+     * the number of bytes peeked is returned in bytesPeeked, with zero indicating end of file.
+     *
+     * This is a wrapper for {@link LocalSocketManager#peek(String, int, byte[])}.
+     *
+     * @param data The data buffer to copy bytes into.
+     * @param bytesPeeked The actual bytes peeked.
+     * @return Returns the {@code error} if peeking was not successful containing {@link JniResult}
+     * error {@link String}, otherwise {@code null}.
+     */
+    public Error peek(@NonNull byte[] data, MutableInt bytesPeeked) {
+        bytesPeeked.value = 0;
+
+        if (mFD < 0) {
+            return LocalSocketErrno.ERRNO_USING_CLIENT_SOCKET_WITH_INVALID_FD.getError(mFD,
+                mLocalSocketRunConfig.getTitle());
+        }
+
+        JniResult result = LocalSocketManager.peek(mLocalSocketRunConfig.getLogTitle() + " (client)", mFD, data);
+        if (result == null || result.retval != 0) {
+            return LocalSocketErrno.ERRNO_PEEK_DATA_FROM_CLIENT_SOCKET_FAILED.getError(
+                mLocalSocketRunConfig.getTitle(), JniResult.getErrorString(result));
+        }
+
+        bytesPeeked.value = result.intData;
+        return null;
+    }
+
+    /**
+     * Attempts to read exactly one message from a {@link LocalSocketRunConfig#SOCKET_TYPE_SEQPACKET}
+     * socket into the data buffer. On success, the number of bytes in the message is returned in
+     * bytesRead, with zero indicating that the peer closed the connection. If the message is larger
+     * than the data buffer, an error is returned since the rest of the message is discarded.
+     *
+     * If the {@link #mCreationTime} + the milliseconds returned by
+     * {@link LocalSocketRunConfig#getDeadline()} has elapsed before reading, an error would be
+     * returned.
+     *
+     * This is a wrapper for {@link LocalSocketManager#readMessage(String, int, byte[], long)}.
+     *
+     * @param data The data buffer to read the message into.
+     * @param bytesRead The actual bytes read.
+     * @return Returns the {@code error} if reading was not successful containing {@link JniResult}
+     * error {@link String}, otherwise {@code null}.
+     */
+    public Error readMessage(@NonNull byte[] data, MutableInt bytesRead) {
+        bytesRead.value = 0;
+
+        Error error = checkMessageApiUsage();
+        if (error != null) return error;
+
+        JniResult result = LocalSocketManager.readMessage(mLocalSocketRunConfig.getLogTitle() + " (client)",
+            mFD, data,
+            mLocalSocketRunConfig.getDeadline() > 0 ? mCreationTime + mLocalSocketRunConfig.getDeadline() : 0);
+        if (result == null || result.retval != 0) {
+            return LocalSocketErrno.ERRNO_READ_MESSAGE_FROM_CLIENT_SOCKET_FAILED.getError(
+                mLocalSocketRunConfig.getTitle(), JniResult.getErrorString(result));
+        }
+
+        bytesRead.value = result.intData;
+        return null;
+    }
+
+    /**
+     * Attempts to read exactly one message of max {@link LocalSocketRunConfig#getMaxMessageSize()}
+     * from a {@link LocalSocketRunConfig#SOCKET_TYPE_SEQPACKET} socket and appends it to
+     * {@code message} decoded as UTF-8.
+     *
+     * This is a wrapper for {@link #readMessage(byte[], MutableInt)}.
+     *
+     * @param message The {@link StringBuilder} to append the message read into.
+     * @param bytesRead The actual bytes read. This will be zero if peer closed the connection.
+     * @return Returns the {@code error} if reading was not successful containing {@link JniResult}
+     * error {@link String}, otherwise {@code null}.
+     */
+    public synchronized Error readMessage(@NonNull StringBuilder message, MutableInt bytesRead) {
+        if (mMessageBuffer == null)
+            mMessageBuffer = new byte[mLocalSocketRunConfig.getMaxMessageSize()];
+
+        Error error = readMessage(mMessageBuffer, bytesRead);
+        if (error != null) return error;
+
+        if (bytesRead.value > 0)
+            message.append(new String(mMessageBuffer, 0, bytesRead.value, StandardCharsets.UTF_8));
+        return null;
+    }
+
+    /**
+     * Attempts to send the data buffer as exactly one message to a
+     * {@link LocalSocketRunConfig#SOCKET_TYPE_SEQPACKET} socket. The message must not be empty.
+     *
+     * If the {@link #mCreationTime} + the milliseconds returned by
+     * {@link LocalSocketRunConfig#getDeadline()} has elapsed before sending, an error would be
+     * returned.
+     *
+     * This is a wrapper for {@link LocalSocketManager#sendMessage(String, int, byte[], long)}.
+     *
+     * @param data The data buffer containing bytes of the message to send.
+     * @return Returns the {@code error} if sending was not successful containing {@link JniResult}
+     * error {@link String}, otherwise {@code null}.
+     */
+    public Error sendMessage(@NonNull byte[] data) {
+        Error error = checkMessageApiUsage();
+        if (error != null) return error;
+
+        JniResult result = LocalSocketManager.sendMessage(mLocalSocketRunConfig.getLogTitle() + " (client)",
+            mFD, data,
+            mLocalSocketRunConfig.getDeadline() > 0 ? mCreationTime + mLocalSocketRunConfig.getDeadline() : 0);
+        if (result == null || result.retval != 0) {
+            return LocalSocketErrno.ERRNO_SEND_MESSAGE_TO_CLIENT_SOCKET_FAILED.getError(
+                mLocalSocketRunConfig.getTitle(), JniResult.getErrorString(result));
+        }
+
+        return null;
+    }
+
+    /** Wrapper for {@link #sendMessage(byte[])} that sends {@code message} encoded as UTF-8. */
+    public Error sendMessage(@NonNull String message) {
+        return sendMessage(message.getBytes(StandardCharsets.UTF_8));
+    }
+
+    /** Check if message api can be used for the client socket. */
+    private Error checkMessageApiUsage() {
+        if (mFD < 0) {
+            return LocalSocketErrno.ERRNO_USING_CLIENT_SOCKET_WITH_INVALID_FD.getError(mFD,
+                mLocalSocketRunConfig.getTitle());
+        }
+
+        if (!mLocalSocketRunConfig.isSeqPacketSocket()) {
+            return LocalSocketErrno.ERRNO_USING_MESSAGE_API_ON_NON_SEQPACKET_CLIENT_SOCKET.getError(
+                mLocalSocketRunConfig.getTitle(), LocalSocketRunConfig.getSocketTypeName(mLocalSocketRunConfig.getSocketType()));
+        }
+
+        return null;
+    }
+
     /**
      * Attempts to read all the bytes available on {@link SocketInputStream} and appends them to
      * {@code data} {@link StringBuilder}.
@@ -72,6 +72,11 @@ public class LocalServerSocket implements Closeable {
             return LocalSocketErrno.ERRNO_SERVER_SOCKET_BACKLOG_INVALID.getError(mLocalSocketRunConfig.getTitle(), backlog);
         }
 
+        int socketType = mLocalSocketRunConfig.getSocketType();
+        if (!LocalSocketRunConfig.isValidSocketType(socketType)) {
+            return LocalSocketErrno.ERRNO_SERVER_SOCKET_TYPE_INVALID.getError(mLocalSocketRunConfig.getTitle(), socketType);
+        }
+
         Error error;
 
         // If server socket is not in abstract namespace
@@ -98,7 +103,7 @@ public class LocalServerSocket implements Closeable {
 
         // Create the server socket
         JniResult result = LocalSocketManager.createServerSocket(mLocalSocketRunConfig.getLogTitle() + " (server)",
-            path.getBytes(StandardCharsets.UTF_8), backlog);
+            path.getBytes(StandardCharsets.UTF_8), backlog, socketType);
         if (result == null || result.retval != 0) {
             return LocalSocketErrno.ERRNO_CREATE_SERVER_SOCKET_FAILED.getError(mLocalSocketRunConfig.getTitle(), JniResult.getErrorString(result));
         }
@@ -227,7 +232,9 @@ public class LocalServerSocket implements Closeable {
             }
 
             LocalClientSocket clientSocket =  new LocalClientSocket(mLocalSocketManager, clientFD, peerCred);
-            Logger.logVerbose(LOG_TAG, "Client socket accept for \"" + mLocalSocketRunConfig.getTitle() + "\" server\n" + clientSocket.getLogString());
+            // Only build log string if it will be logged, since peer cred names are resolved lazily
+            if (Logger.getLogLevel() >= Logger.LOG_LEVEL_VERBOSE)
+                Logger.logVerbose(LOG_TAG, "Client socket accept for \"" + mLocalSocketRunConfig.getTitle() + "\" server\n" + clientSocket.getLogString());
 
             // Only allow connection if the peer has the same uid as server app's user id or root user id
             if (peerUid != mLocalSocketManager.getContext().getApplicationInfo().uid && peerUid != 0) {
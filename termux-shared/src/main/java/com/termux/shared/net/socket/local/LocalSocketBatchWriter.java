@@ -0,0 +1,200 @@
+package com.termux.shared.net.socket.local;
+
+import androidx.annotation.NonNull;
+
+import com.termux.shared.errors.Error;
+
+import java.util.ArrayList;
+import java.util.List;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.ScheduledExecutorService;
+import java.util.concurrent.ScheduledFuture;
+import java.util.concurrent.ScheduledThreadPoolExecutor;
+import java.util.concurrent.TimeUnit;
+
+/**
+ * A batching writer for a {@link LocalClientSocket} that accumulates small writes and sends them
+ * with a single {@link LocalClientSocket#writev(byte[]...)} call, instead of a JNI call and
+ * syscall for each write. This is useful for chatty protocols that send many small messages.
+ *
+ * The pending buffers are flushed when their total size reaches {@link #mMaxBatchBytes}, their count
+ * reaches {@link #MAX_BATCH_BUFFERS}, {@link #mMaxBatchDelay} milliseconds have elapsed since the
+ * first pending write, or {@link #flush()} or {@link #close()} is called.
+ *
+ * The delayed flushes of all writers are timed by a shared scheduler thread, but each flush runs
+ * on its own thread of a shared cached pool, so that a client that is not reading and blocks its
+ * flush until the {@link LocalSocketRunConfig#getSendTimeout()} elapses does not delay the
+ * flushes of other sockets.
+ *
+ * The buffers passed to {@link #write(byte[])} are not copied, so they must not be modified until
+ * they have been flushed.
+ */
+public class LocalSocketBatchWriter {
+
+    public static final String LOG_TAG = "LocalSocketBatchWriter";
+
+    /** The max number of buffers that can be sent in one call, which is IOV_MAX on Linux. */
+    public static final int MAX_BATCH_BUFFERS = 1024;
+
+    /** The default value for {@link #mMaxBatchBytes}. */
+    public static final int DEFAULT_MAX_BATCH_BYTES = 8 * 1024;
+
+    /** The default value for {@link #mMaxBatchDelay}. */
+    public static final int DEFAULT_MAX_BATCH_DELAY = 5;
+
+    /** The shared scheduler to start flushing pending buffers after {@link #mMaxBatchDelay}. */
+    private static ScheduledExecutorService sFlushScheduler;
+
+    /** The shared pool that runs the delayed flushes, so that blocking writes do not stall the scheduler. */
+    private static ExecutorService sFlushExecutor;
+
+    /** The {@link LocalSocketManager} instance for the local socket. */
+    @NonNull protected final LocalSocketManager mLocalSocketManager;
+
+    /** The {@link LocalClientSocket} to write to. */
+    @NonNull protected final LocalClientSocket mClientSocket;
+
+    /** The total size of pending buffers at which they should be flushed. */
+    protected final int mMaxBatchBytes;
+
+    /**
+     * The max milliseconds a pending buffer should wait before being flushed. If {@code <= 0},
+     * then buffers are only flushed on size thresholds or explicit calls.
+     */
+    protected final int mMaxBatchDelay;
+
+    /** The pending buffers. */
+    private final List<byte[]> mBuffers = new ArrayList<>();
+
+    /** The total size of {@link #mBuffers}. */
+    private int mBatchBytes;
+
+    /** The scheduled flush of {@link #mBuffers}, if any. */
+    private ScheduledFuture<?> mFlushFuture;
+
+    /**
+     * The generation of {@link #mFlushFuture}, which is incremented whenever it is scheduled or
+     * cancelled, since a cancelled flush may already have been handed to the flush pool.
+     */
+    private long mFlushGeneration;
+
+    /** The error of a failed flush, after which further writes will fail. */
+    private Error mError;
+
+    /**
+     * Create an new instance of {@link LocalSocketBatchWriter} with default thresholds.
+     *
+     * @param localSocketManager The {@link #mLocalSocketManager} value.
+     * @param clientSocket The {@link #mClientSocket} value.
+     */
+    public LocalSocketBatchWriter(@NonNull LocalSocketManager localSocketManager,
+                                  @NonNull LocalClientSocket clientSocket) {
+        this(localSocketManager, clientSocket, DEFAULT_MAX_BATCH_BYTES, DEFAULT_MAX_BATCH_DELAY);
+    }
+
+    /**
+     * Create an new instance of {@link LocalSocketBatchWriter}.
+     *
+     * @param localSocketManager The {@link #mLocalSocketManager} value.
+     * @param clientSocket The {@link #mClientSocket} value.
+     * @param maxBatchBytes The {@link #mMaxBatchBytes} value.
+     * @param maxBatchDelay The {@link #mMaxBatchDelay} value.
+     */
+    public LocalSocketBatchWriter(@NonNull LocalSocketManager localSocketManager,
+                                  @NonNull LocalClientSocket clientSocket,
+                                  int maxBatchBytes, int maxBatchDelay) {
+        mLocalSocketManager = localSocketManager;
+        mClientSocket = clientSocket;
+        mMaxBatchBytes = maxBatchBytes;
+        mMaxBatchDelay = maxBatchDelay;
+    }
+
+    /**
+     * Add a buffer to the pending buffers and flush them if a size threshold has been reached.
+     *
+     * @param data The data buffer containing bytes to send.
+     * @return Returns the {@code error} if a flush failed now or earlier, otherwise {@code null}.
+     */
+    public synchronized Error write(@NonNull byte[] data) {
+        if (mError != null) return mError;
+        if (data.length == 0) return null;
+
+        mBuffers.add(data);
+        mBatchBytes += data.length;
+
+        if (mBatchBytes >= mMaxBatchBytes || mBuffers.size() >= MAX_BATCH_BUFFERS)
+            return flush();
+
+        if (mMaxBatchDelay > 0 && mFlushFuture == null) {
+            final long generation = ++mFlushGeneration;
+            mFlushFuture = getFlushScheduler().schedule(() -> getFlushExecutor().execute(() -> onFlushDelayElapsed(generation)),
+                mMaxBatchDelay, TimeUnit.MILLISECONDS);
+        }
+
+        return null;
+    }
+
+    /**
+     * Send all pending buffers with a single {@link LocalClientSocket#writev(byte[]...)} call.
+     *
+     * @return Returns the {@code error} if a flush failed now or earlier, otherwise {@code null}.
+     */
+    public synchronized Error flush() {
+        if (mFlushFuture != null) {
+            mFlushFuture.cancel(false);
+            mFlushFuture = null;
+            mFlushGeneration++;
+        }
+
+        if (mError != null) return mError;
+        if (mBuffers.isEmpty()) return null;
+
+        byte[][] buffers = mBuffers.toArray(new byte[0][]);
+        mBuffers.clear();
+        mBatchBytes = 0;
+
+        mError = mClientSocket.writev(buffers);
+        return mError;
+    }
+
+    /** Flush any pending buffers. The {@link LocalClientSocket} is not closed. */
+    public synchronized Error close() {
+        return flush();
+    }
+
+    private synchronized void onFlushDelayElapsed(long generation) {
+        // Ignore flushes that were cancelled after being handed to the flush pool, so that they do
+        // not clear a newer scheduled flush
+        if (generation != mFlushGeneration) return;
+        mFlushFuture = null;
+        if (mError != null) return;
+
+        Error error = flush();
+        if (error != null)
+            mLocalSocketManager.onError(mClientSocket, error);
+    }
+
+    private static synchronized ScheduledExecutorService getFlushScheduler() {
+        if (sFlushScheduler == null) {
+            sFlushScheduler = new ScheduledThreadPoolExecutor(1, runnable -> {
+                Thread thread = new Thread(runnable, LOG_TAG);
+                thread.setDaemon(true);
+                return thread;
+            });
+        }
+        return sFlushScheduler;
+    }
+
+    private static synchronized ExecutorService getFlushExecutor() {
+        if (sFlushExecutor == null) {
+            sFlushExecutor = Executors.newCachedThreadPool(runnable -> {
+                Thread thread = new Thread(runnable, LOG_TAG + "-flush");
+                thread.setDaemon(true);
+                return thread;
+            });
+        }
+        return sFlushExecutor;
+    }
+
+}
@@ -24,6 +24,7 @@ public class LocalSocketErrno extends Errno {
     public static final Errno ERRNO_CLIENT_SOCKET_PEER_UID_DISALLOWED = new Errno(TYPE, 160, "Disallowed peer %1$s tried to connect with \"%2$s\" server.");
     public static final Errno ERRNO_CLOSE_SERVER_SOCKET_FAILED_WITH_EXCEPTION = new Errno(TYPE, 161, "Close \"%1$s\" server socket failed.\nException: %2$s");
     public static final Errno ERRNO_CLIENT_SOCKET_LISTENER_FAILED_WITH_EXCEPTION = new Errno(TYPE, 162, "Exception in client socket listener for \"%1$s\" server.\nException: %2$s");
+    public static final Errno ERRNO_SERVER_SOCKET_TYPE_INVALID = new Errno(TYPE, 163, "The \"%1$s\" server socket type \"%2$s\" is not supported.");
 
     /** Errors for {@link LocalClientSocket} (200-250) */
     public static final Errno ERRNO_SET_CLIENT_SOCKET_READ_TIMEOUT_FAILED = new Errno(TYPE, 200, "Set \"%1$s\" client socket read (SO_RCVTIMEO) timeout to \"%2$s\" failed.\n%3$s");
@@ -35,6 +36,12 @@ public class LocalSocketErrno extends Errno {
     public static final Errno ERRNO_CHECK_AVAILABLE_DATA_ON_CLIENT_SOCKET_FAILED = new Errno(TYPE, 206, "Check available data on \"%1$s\" client socket failed.\n%2$s");
     public static final Errno ERRNO_CLOSE_CLIENT_SOCKET_FAILED_WITH_EXCEPTION = new Errno(TYPE, 207, "Close \"%1$s\" client socket failed.\n%2$s");
     public static final Errno ERRNO_USING_CLIENT_SOCKET_WITH_INVALID_FD = new Errno(TYPE, 208, "Trying to use client socket with invalid file descriptor \"%1$s\" for \"%2$s\" server.");
+    public static final Errno ERRNO_USING_MESSAGE_API_ON_NON_SEQPACKET_CLIENT_SOCKET = new Errno(TYPE, 209, "Trying to use message api on \"%1$s\" client socket of type \"%2$s\" instead of \"SOCK_SEQPACKET\".");
+    public static final Errno ERRNO_READ_MESSAGE_FROM_CLIENT_SOCKET_FAILED = new Errno(TYPE, 210, "Read message from \"%1$s\" client socket failed.\n%2$s");
+    public static final Errno ERRNO_SEND_MESSAGE_TO_CLIENT_SOCKET_FAILED = new Errno(TYPE, 211, "Send message to \"%1$s\" client socket failed.\n%2$s");
+    public static final Errno ERRNO_PEEK_DATA_FROM_CLIENT_SOCKET_FAILED = new Errno(TYPE, 212, "Peek data from \"%1$s\" client socket failed.\n%2$s");
+    public static final Errno ERRNO_READV_DATA_FROM_CLIENT_SOCKET_FAILED = new Errno(TYPE, 213, "Read data into multiple buffers from \"%1$s\" client socket failed.\n%2$s");
+    public static final Errno ERRNO_WRITEV_DATA_TO_CLIENT_SOCKET_FAILED = new Errno(TYPE, 214, "Send data from multiple buffers to \"%1$s\" client socket failed.\n%2$s");
 
     LocalSocketErrno(final String type, final int code, final String message) {
         super(type, code, message);
@@ -10,7 +10,8 @@ import com.termux.shared.jni.models.JniResult;
 import com.termux.shared.logger.Logger;
 
 /**
- * Manager for an AF_UNIX/SOCK_STREAM local server.
+ * Manager for an AF_UNIX/SOCK_STREAM or AF_UNIX/SOCK_SEQPACKET local server. The socket type is
+ * defined by {@link LocalSocketRunConfig#getSocketType()}.
  *
  * Usage:
  * 1. Implement the {@link ILocalSocketManager} that will receive call backs from the server including
@@ -107,7 +108,7 @@ public class LocalSocketManager {
     */
 
     /**
-     * Creates an AF_UNIX/SOCK_STREAM local server socket at {@code path}, with the specified backlog.
+     * Creates an AF_UNIX local server socket at {@code path}, with the specified backlog and type.
      *
      * @param serverTitle The server title used for logging and errors.
      * @param path The path at which to create the socket.
@@ -117,14 +118,16 @@ public class LocalSocketManager {
      * @param backlog The maximum length to which the queue of pending connections for the socket
      *                may grow. This value may be ignored or may not have one-to-one mapping
      *                in kernel implementation. Value must be greater than 0.
+     * @param socketType The socket type, one of {@link LocalSocketRunConfig#SOCKET_TYPE_STREAM} or
+     *                   {@link LocalSocketRunConfig#SOCKET_TYPE_SEQPACKET}.
      * @return Returns the {@link JniResult}. If server creation was successful, then
      * {@link JniResult#retval} will be 0 and {@link JniResult#intData} will contain the server socket
      * fd.
      */
     @Nullable
-    public static JniResult createServerSocket(@NonNull String serverTitle, @NonNull byte[] path, int backlog) {
+    public static JniResult createServerSocket(@NonNull String serverTitle, @NonNull byte[] path, int backlog, int socketType) {
         try {
-            return createServerSocketNative(serverTitle, path, backlog);
+            return createServerSocketNative(serverTitle, path, backlog, socketType);
         } catch (Throwable t) {
             String message = "Exception in createServerSocketNative()";
             Logger.logStackTraceWithMessage(LOG_TAG, message, t);
@@ -223,6 +226,134 @@ public class LocalSocketManager {
         }
     }
 
+    /**
+     * Attempts to read into multiple data buffers from the file descriptor with a single JNI call,
+     * filling them in order with readv(). On error, the {@link JniResult#errno} and
+     * {@link JniResult#errmsg} will be set.
+     *
+     * If while reading the deadline elapses but all the buffers have not been filled, the call
+     * will fail.
+     *
+     * @param serverTitle The server title used for logging and errors.
+     * @param fd The socket fd.
+     * @param buffers The data buffers to read bytes into. The count must not be greater than IOV_MAX.
+     * @param deadline The deadline milliseconds since epoch.
+     * @return Returns the {@link JniResult}. If reading was successful, then {@link JniResult#retval}
+     * will be 0 and {@link JniResult#intData} will contain the total bytes read, which will be less
+     * than the total size of buffers only if end of file was reached.
+     */
+    @Nullable
+    public static JniResult readv(@NonNull String serverTitle, int fd, @NonNull byte[][] buffers, long deadline) {
+        try {
+            return readvNative(serverTitle, fd, buffers, deadline);
+        } catch (Throwable t) {
+            String message = "Exception in readvNative()";
+            Logger.logStackTraceWithMessage(LOG_TAG, message, t);
+            return new JniResult(message, t);
+        }
+    }
+
+    /**
+     * Attempts to send multiple data buffers to the file descriptor with a single JNI call, in
+     * order with a single gathered write, like writev(). On error, the {@link JniResult#errno} and
+     * {@link JniResult#errmsg} will be set.
+     *
+     * If while sending the deadline elapses but all the data has not been sent, the call will fail.
+     *
+     * @param serverTitle The server title used for logging and errors.
+     * @param fd The socket fd.
+     * @param buffers The data buffers containing bytes to send. The count must not be greater
+     *                than IOV_MAX.
+     * @param deadline The deadline milliseconds since epoch.
+     * @return Returns the {@link JniResult}. If sending was successful, then {@link JniResult#retval}
+     * will be 0 and {@link JniResult#intData} will contain the total bytes sent.
+     */
+    @Nullable
+    public static JniResult writev(@NonNull String serverTitle, int fd, @NonNull byte[][] buffers, long deadline) {
+        try {
+            return writevNative(serverTitle, fd, buffers, deadline);
+        } catch (Throwable t) {
+            String message = "Exception in writevNative()";
+            Logger.logStackTraceWithMessage(LOG_TAG, message, t);
+            return new JniResult(message, t);
+        }
+    }
+
+    /**
+     * Attempts to read exactly one message from a {@link LocalSocketRunConfig#SOCKET_TYPE_SEQPACKET}
+     * socket fd into the data buffer. On success, the number of bytes in the message is returned
+     * (zero indicates end of file). If the message is larger than the data buffer, the call will
+     * fail with {@link JniResult#errno} set to {@code EMSGSIZE} since the remaining bytes of the
+     * message are discarded by the kernel. The next message can still be read after that.
+     *
+     * If the deadline has already elapsed before reading, the call will fail.
+     *
+     * @param serverTitle The server title used for logging and errors.
+     * @param fd The socket fd.
+     * @param data The data buffer to read the message into.
+     * @param deadline The deadline milliseconds since epoch.
+     * @return Returns the {@link JniResult}. If reading was successful, then {@link JniResult#retval}
+     * will be 0 and {@link JniResult#intData} will contain the bytes read.
+     */
+    @Nullable
+    public static JniResult readMessage(@NonNull String serverTitle, int fd, @NonNull byte[] data, long deadline) {
+        try {
+            return readMessageNative(serverTitle, fd, data, deadline);
+        } catch (Throwable t) {
+            String message = "Exception in readMessageNative()";
+            Logger.logStackTraceWithMessage(LOG_TAG, message, t);
+            return new JniResult(message, t);
+        }
+    }
+
+    /**
+     * Attempts to send the data buffer as exactly one message to a
+     * {@link LocalSocketRunConfig#SOCKET_TYPE_SEQPACKET} socket fd. The message must not be empty.
+     * On error, the {@link JniResult#errno} and {@link JniResult#errmsg} will be set.
+     *
+     * If the deadline has already elapsed before sending, the call will fail.
+     *
+     * @param serverTitle The server title used for logging and errors.
+     * @param fd The socket fd.
+     * @param data The data buffer containing bytes of the message to send.
+     * @param deadline The deadline milliseconds since epoch.
+     * @return Returns the {@link JniResult}. If sending was successful, then {@link JniResult#retval}
+     * will be 0.
+     */
+    @Nullable
+    public static JniResult sendMessage(@NonNull String serverTitle, int fd, @NonNull byte[] data, long deadline) {
+        try {
+            return sendMessageNative(serverTitle, fd, data, deadline);
+        } catch (Throwable t) {
+            String message = "Exception in sendMessageNative()";
+            Logger.logStackTraceWithMessage(LOG_TAG, message, t);
+            return new JniResult(message, t);
+        }
+    }
+
+    /**
+     * Waits until data is available on file descriptor fd and copies up to data buffer length bytes
+     * into the data buffer without removing them from the receive queue, so that they are returned
+     * again by the next read. On success, the number of bytes peeked is returned (zero indicates end
+     * of file). On error, the {@link JniResult#errno} and {@link JniResult#errmsg} will be set.
+     *
+     * @param serverTitle The server title used for logging and errors.
+     * @param fd The socket fd.
+     * @param data The data buffer to copy bytes into.
+     * @return Returns the {@link JniResult}. If peeking was successful, then {@link JniResult#retval}
+     * will be 0 and {@link JniResult#intData} will contain the bytes peeked.
+     */
+    @Nullable
+    public static JniResult peek(@NonNull String serverTitle, int fd, @NonNull byte[] data) {
+        try {
+            return peekNative(serverTitle, fd, data);
+        } catch (Throwable t) {
+            String message = "Exception in peekNative()";
+            Logger.logStackTraceWithMessage(LOG_TAG, message, t);
+            return new JniResult(message, t);
+        }
+    }
+
     /**
      * Gets the number of bytes available to read on the socket.
      *
@@ -302,6 +433,29 @@ public class LocalSocketManager {
         }
     }
 
+    /**
+     * Set the {@link PeerCred#pname} and {@link PeerCred#cmdline} of a {@link PeerCred} whose
+     * {@link PeerCred#pid} and {@link PeerCred#startTime} were set by
+     * {@link #getPeerCred(String, int, PeerCred)}. The values are cached natively by
+     * (pid, start time), so repeated calls for the same process do not read "/proc/[pid]/cmdline".
+     *
+     * @param serverTitle The server title used for logging and errors.
+     * @param peerCred The {@link PeerCred} to fill.
+     * @return Returns the {@link JniResult}. If reading process info failed, then
+     * {@link JniResult#retval} will be non-zero and {@link JniResult#errmsg} will be set. Failure
+     * to access "/proc/[pid]/cmdline" of other users/apps is not considered an error.
+     */
+    @Nullable
+    public static JniResult getPeerProcessInfo(@NonNull String serverTitle, @NonNull PeerCred peerCred) {
+        try {
+            return getPeerProcessInfoNative(serverTitle, peerCred);
+        } catch (Throwable t) {
+            String message = "Exception in getPeerProcessInfoNative()";
+            Logger.logStackTraceWithMessage(LOG_TAG, message, t);
+            return new JniResult(message, t);
+        }
+    }
+
 
 
     /** Wrapper for {@link #onError(LocalClientSocket, Error)} for {@code null} {@link LocalClientSocket}. */
@@ -429,7 +583,7 @@ public class LocalSocketManager {
 
 
 
-    @Nullable private static native JniResult createServerSocketNative(@NonNull String serverTitle, @NonNull byte[] path, int backlog);
+    @Nullable private static native JniResult createServerSocketNative(@NonNull String serverTitle, @NonNull byte[] path, int backlog, int socketType);
 
     @Nullable private static native JniResult closeSocketNative(@NonNull String serverTitle, int fd);
 
@@ -439,6 +593,16 @@ public class LocalSocketManager {
 
     @Nullable private static native JniResult sendNative(@NonNull String serverTitle, int fd, @NonNull byte[] data, long deadline);
 
+    @Nullable private static native JniResult readvNative(@NonNull String serverTitle, int fd, @NonNull byte[][] buffers, long deadline);
+
+    @Nullable private static native JniResult writevNative(@NonNull String serverTitle, int fd, @NonNull byte[][] buffers, long deadline);
+
+    @Nullable private static native JniResult readMessageNative(@NonNull String serverTitle, int fd, @NonNull byte[] data, long deadline);
+
+    @Nullable private static native JniResult sendMessageNative(@NonNull String serverTitle, int fd, @NonNull byte[] data, long deadline);
+
+    @Nullable private static native JniResult peekNative(@NonNull String serverTitle, int fd, @NonNull byte[] data);
+
     @Nullable private static native JniResult availableNative(@NonNull String serverTitle, int fd);
 
     private static native JniResult setSocketReadTimeoutNative(@NonNull String serverTitle, int fd, int timeout);
@@ -447,4 +611,6 @@ public class LocalSocketManager {
 
     @Nullable private static native JniResult getPeerCredNative(@NonNull String serverTitle, int fd, PeerCred peerCred);
 
+    @Nullable private static native JniResult getPeerProcessInfoNative(@NonNull String serverTitle, PeerCred peerCred);
+
 }
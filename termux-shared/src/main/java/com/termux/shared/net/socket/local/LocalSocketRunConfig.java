@@ -94,6 +94,36 @@ public class LocalSocketRunConfig implements Serializable {
     protected Integer mBacklog;
     public static final int DEFAULT_BACKLOG = 50;
 
+    /**
+     * The {@link LocalServerSocket} type.
+     *
+     * With {@link #SOCKET_TYPE_STREAM} (SOCK_STREAM), data is a byte stream without any message
+     * boundaries, so the peers must use some other way to frame data, like closing the connection
+     * after a single request.
+     * With {@link #SOCKET_TYPE_SEQPACKET} (SOCK_SEQPACKET), message boundaries are preserved, so
+     * multiple requests and responses can be sent over a single connection with
+     * {@link LocalClientSocket#sendMessage(byte[])} and {@link LocalClientSocket#readMessage(byte[], LocalClientSocket.MutableInt)}.
+     *
+     * https://manpages.debian.org/testing/manpages/unix.7.en.html
+     * Defaults to {@link #DEFAULT_SOCKET_TYPE}.
+     */
+    protected Integer mSocketType;
+    public static final int SOCKET_TYPE_STREAM = 0;
+    public static final int SOCKET_TYPE_SEQPACKET = 1;
+    public static final int DEFAULT_SOCKET_TYPE = SOCKET_TYPE_STREAM;
+
+    /**
+     * The max size in bytes of a single message that can be read by
+     * {@link LocalClientSocket#readMessage(StringBuilder, LocalClientSocket.MutableInt)} for
+     * {@link #SOCKET_TYPE_SEQPACKET} sockets. Larger messages are truncated by the kernel and
+     * reading them fails with {@code EMSGSIZE}. Servers should also not send larger messages, since
+     * clients may use the same limit. Messages larger than the socket send buffer, which is
+     * usually around 200 KiB, cannot be sent at all, so it should not be raised above that.
+     * Defaults to {@link #DEFAULT_MAX_MESSAGE_SIZE}.
+     */
+    protected Integer mMaxMessageSize;
+    public static final int DEFAULT_MAX_MESSAGE_SIZE = 64 * 1024;
+
 
     /**
      * Create an new instance of {@link LocalSocketRunConfig}.
@@ -194,6 +224,48 @@ public class LocalSocketRunConfig implements Serializable {
             mBacklog = backlog;
     }
 
+    /** Get {@link #mSocketType} if set, otherwise {@link #DEFAULT_SOCKET_TYPE}. */
+    public Integer getSocketType() {
+        return mSocketType != null ? mSocketType : DEFAULT_SOCKET_TYPE;
+    }
+
+    /** Set {@link #mSocketType}. */
+    public void setSocketType(Integer socketType) {
+        mSocketType = socketType;
+    }
+
+    /** Check if {@link #getSocketType()} is {@link #SOCKET_TYPE_SEQPACKET}. */
+    public boolean isSeqPacketSocket() {
+        return getSocketType() == SOCKET_TYPE_SEQPACKET;
+    }
+
+    /** Check if {@code socketType} is one of the supported socket types. */
+    public static boolean isValidSocketType(Integer socketType) {
+        return socketType != null && (socketType == SOCKET_TYPE_STREAM || socketType == SOCKET_TYPE_SEQPACKET);
+    }
+
+    /** Get {@link #mMaxMessageSize} if set, otherwise {@link #DEFAULT_MAX_MESSAGE_SIZE}. */
+    public Integer getMaxMessageSize() {
+        return mMaxMessageSize != null ? mMaxMessageSize : DEFAULT_MAX_MESSAGE_SIZE;
+    }
+
+    /** Set {@link #mMaxMessageSize}. Value must be greater than 0. */
+    public void setMaxMessageSize(Integer maxMessageSize) {
+        if (maxMessageSize > 0)
+            mMaxMessageSize = maxMessageSize;
+    }
+
+    /** Get the name of a socket type. */
+    @NonNull
+    public static String getSocketTypeName(Integer socketType) {
+        if (socketType == null) return "null";
+        switch (socketType) {
+            case SOCKET_TYPE_STREAM: return "SOCK_STREAM";
+            case SOCKET_TYPE_SEQPACKET: return "SOCK_SEQPACKET";
+            default: return "unknown (" + socketType + ")";
+        }
+    }
+
 
     /**
      * Get a log {@link String} for {@link LocalSocketRunConfig}.
@@ -221,6 +293,9 @@ public class LocalSocketRunConfig implements Serializable {
         logString.append("\n").append(Logger.getSingleLineLogStringEntry("SendTimeout", getSendTimeout(), "-"));
         logString.append("\n").append(Logger.getSingleLineLogStringEntry("Deadline", getDeadline(), "-"));
         logString.append("\n").append(Logger.getSingleLineLogStringEntry("Backlog", getBacklog(), "-"));
+        logString.append("\n").append(Logger.getSingleLineLogStringEntry("SocketType", getSocketTypeName(getSocketType()), "-"));
+        if (isSeqPacketSocket())
+            logString.append("\n").append(Logger.getSingleLineLogStringEntry("MaxMessageSize", getMaxMessageSize(), "-"));
 
         return logString.toString();
     }
@@ -250,6 +325,9 @@ public class LocalSocketRunConfig implements Serializable {
         markdownString.append("\n").append(MarkdownUtils.getSingleLineMarkdownStringEntry("SendTimeout", getSendTimeout(), "-"));
         markdownString.append("\n").append(MarkdownUtils.getSingleLineMarkdownStringEntry("Deadline", getDeadline(), "-"));
         markdownString.append("\n").append(MarkdownUtils.getSingleLineMarkdownStringEntry("Backlog", getBacklog(), "-"));
+        markdownString.append("\n").append(MarkdownUtils.getSingleLineMarkdownStringEntry("SocketType", getSocketTypeName(getSocketType()), "-"));
+        if (isSeqPacketSocket())
+            markdownString.append("\n").append(MarkdownUtils.getSingleLineMarkdownStringEntry("MaxMessageSize", getMaxMessageSize(), "-"));
 
         return markdownString.toString();
     }
@@ -10,7 +10,14 @@ import com.termux.shared.android.UserUtils;
 import com.termux.shared.logger.Logger;
 import com.termux.shared.markdown.MarkdownUtils;
 
-/** The {@link PeerCred} of the {@link LocalClientSocket} containing info of client/peer. */
+/**
+ * The {@link PeerCred} of the {@link LocalClientSocket} containing info of client/peer.
+ *
+ * Only the {@link #pid}, {@link #uid}, {@link #gid} and {@link #startTime} are set by JNI when
+ * the client is accepted. The process name, cmdline, user name and group name are resolved lazily
+ * on first call to their getters, like when a log statement or policy check needs them, since
+ * resolving them requires reading "/proc/[pid]/cmdline" and package manager calls.
+ */
 @Keep
 public class PeerCred {
 
@@ -34,29 +41,55 @@ public class PeerCred {
     /** Command line that started the process. */
     public String cmdline;
 
+    /**
+     * The start time of the process in clock ticks after system boot, or 0 if it could not be read.
+     * The ({@link #pid}, {@link #startTime}) pair is used as the key for native process info cache.
+     */
+    public long startTime;
+
+    /** The {@link Context} used to lazily resolve names, or {@code null} if not set. */
+    private Context mContext;
+
+    /** Whether {@link #pname} and {@link #cmdline} have been resolved. */
+    private boolean mProcessInfoResolved;
+
+    /** Whether {@link #uname} and {@link #gname} have been resolved. */
+    private boolean mNamesResolved;
+
     PeerCred() {
         // Initialize to -1 instead of 0 in case a failed getPeerCred()/getsockopt() call somehow doesn't report failure and returns the uid of root
         pid = -1; uid = -1; gid = -1;
     }
 
+    /** Set the {@link Context} used to lazily resolve data that was not set by JNI. */
+    void setContext(@NonNull Context context) {
+        mContext = context;
+    }
+
     /** Set data that was not set by JNI. */
     public void fillPeerCred(@NonNull Context context) {
+        mContext = context;
         fillUnameAndGname(context);
         fillPname(context);
     }
 
     /** Set {@link #uname} and {@link #gname} if not set. */
-    public void fillUnameAndGname(@NonNull Context context) {
-       uname = UserUtils.getNameForUid(context, uid);
+    public synchronized void fillUnameAndGname(@NonNull Context context) {
+        if (mNamesResolved) return;
+        mNamesResolved = true;
+
+        uname = UserUtils.getNameForUid(context, uid);
 
-       if (gid != uid)
-           gname = UserUtils.getNameForUid(context, gid);
-       else
-           gname = uname;
+        if (gid != uid)
+            gname = UserUtils.getNameForUid(context, gid);
+        else
+            gname = uname;
     }
 
     /** Set {@link #pname} if not set. */
-    public void fillPname(@NonNull Context context) {
+    public synchronized void fillPname(@NonNull Context context) {
+        fillProcessInfo();
+
         // If jni did not set process name since it wouldn't be able to access /proc/<pid> of other
         // users/apps, then try to see if any app has that pid, but this wouldn't check child
         // processes of the app.
@@ -64,6 +97,44 @@ public class PeerCred {
             pname = ProcessUtils.getAppProcessNameForPid(context, pid);
     }
 
+    /** Set {@link #pname} and {@link #cmdline} from "/proc/[pid]/cmdline" with JNI if not set. */
+    private synchronized void fillProcessInfo() {
+        if (mProcessInfoResolved) return;
+        mProcessInfoResolved = true;
+
+        if (pid > 0)
+            LocalSocketManager.getPeerProcessInfo(LOG_TAG, this);
+    }
+
+    /** Get {@link #pname}, resolving it if not already done. */
+    public synchronized String getPname() {
+        if (mContext != null)
+            fillPname(mContext);
+        else
+            fillProcessInfo();
+        return pname;
+    }
+
+    /** Get {@link #cmdline}, resolving it if not already done. */
+    public synchronized String getCmdline() {
+        fillProcessInfo();
+        return cmdline;
+    }
+
+    /** Get {@link #uname}, resolving it if not already done. */
+    public synchronized String getUname() {
+        if (mContext != null)
+            fillUnameAndGname(mContext);
+        return uname;
+    }
+
+    /** Get {@link #gname}, resolving it if not already done. */
+    public synchronized String getGname() {
+        if (mContext != null)
+            fillUnameAndGname(mContext);
+        return gname;
+    }
+
     /**
      * Get a log {@link String} for {@link PeerCred}.
      *
@@ -86,6 +157,7 @@ public class PeerCred {
         logString.append("\n").append(Logger.getSingleLineLogStringEntry("User", getUserString(), "-"));
         logString.append("\n").append(Logger.getSingleLineLogStringEntry("Group", getGroupString(), "-"));
 
+        String cmdline = getCmdline();
         if (cmdline != null)
             logString.append("\n").append(Logger.getMultiLineLogStringEntry("Cmdline", cmdline, "-"));
 
@@ -113,6 +185,7 @@ public class PeerCred {
         markdownString.append("\n").append(MarkdownUtils.getSingleLineMarkdownStringEntry("User", getUserString(), "-"));
         markdownString.append("\n").append(MarkdownUtils.getSingleLineMarkdownStringEntry("Group", getGroupString(), "-"));
 
+        String cmdline = getCmdline();
         if (cmdline != null)
             markdownString.append("\n").append(MarkdownUtils.getMultiLineMarkdownStringEntry("Cmdline", cmdline, "-"));
 
@@ -126,16 +199,19 @@ public class PeerCred {
 
     @NonNull
     public String getProcessString() {
+        String pname = getPname();
         return pname != null && !pname.isEmpty() ? pid + " (" + pname + ")" : String.valueOf(pid);
     }
 
     @NonNull
     public String getUserString() {
+        String uname = getUname();
         return uname != null ? uid + " (" + uname + ")" : String.valueOf(uid);
     }
 
     @NonNull
     public String getGroupString() {
+        String gname = getGname();
         return gname != null ? gid + " (" + gname + ")" : String.valueOf(gid);
     }
 
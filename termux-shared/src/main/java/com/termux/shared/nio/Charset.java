@@ -17,13 +17,22 @@
 package com.termux.shared.nio.charset;
 import java.io.UnsupportedEncodingException;
 import com.termux.shared.nio.charset.spi.CharsetProvider;
-import java.util.HashMap;
+import java.util.Collections;
 import java.util.HashSet;
 import java.util.ServiceLoader;
 import java.util.Set;
+import java.util.concurrent.ConcurrentHashMap;
 import com.termux.shared.file.libcore.NativeConverter;
 public abstract class Charset implements Comparable<Charset> {
-    private static final HashMap<String, Charset> CACHED_CHARSETS = new HashMap<String, Charset>();
+    /** The charsets by their names and aliases. Lookups do not lock, so cached charsets never contend. */
+    private static final ConcurrentHashMap<String, Charset> CACHED_CHARSETS = new ConcurrentHashMap<String, Charset>();
+    /**
+     * The names that were not found by any provider, so that repeated lookups of them do not
+     * search the providers again. It is cleared when it reaches {@link #MAX_UNSUPPORTED_CHARSET_NAMES},
+     * since the names may come from untrusted input.
+     */
+    private static final Set<String> UNSUPPORTED_CHARSET_NAMES = Collections.newSetFromMap(new ConcurrentHashMap<String, Boolean>());
+    private static final int MAX_UNSUPPORTED_CHARSET_NAMES = 64;
     private static final Charset DEFAULT_CHARSET = getDefaultCharset();
     private final String canonicalName;
     private final HashSet<String> aliasesSet;
@@ -74,26 +83,23 @@ public abstract class Charset implements Comparable<Charset> {
                 c == '-' || c == '.' || c == ':' || c == '_';
     }
 private static Charset cacheCharset(String charsetName, Charset cs) {
-        synchronized (CACHED_CHARSETS) {
-            // Get the canonical name for this charset, and the canonical instance from the table.
-            String canonicalName = cs.name();
-            Charset canonicalCharset = CACHED_CHARSETS.get(canonicalName);
-            if (canonicalCharset == null) {
-                canonicalCharset = cs;
-            }
-            // Cache the charset by its canonical name...
-            CACHED_CHARSETS.put(canonicalName, canonicalCharset);
-            // And the name the user used... (Section 1.4 of http://unicode.org/reports/tr22/ means
-            // that many non-alias, non-canonical names are valid. For example, "utf8" isn't an
-            // alias of the canonical name "UTF-8", but we shouldn't penalize consistent users of
-            // such names unduly.)
-            CACHED_CHARSETS.put(charsetName, canonicalCharset);
-            // And all its aliases...
-            for (String alias : cs.aliasesSet) {
-                CACHED_CHARSETS.put(alias, canonicalCharset);
-            }
-            return canonicalCharset;
+        // Cache the charset by its canonical name, unless another thread cached its canonical
+        // instance first.
+        String canonicalName = cs.name();
+        Charset canonicalCharset = CACHED_CHARSETS.putIfAbsent(canonicalName, cs);
+        if (canonicalCharset == null) {
+            canonicalCharset = cs;
         }
+        // And the name the user used... (Section 1.4 of http://unicode.org/reports/tr22/ means
+        // that many non-alias, non-canonical names are valid. For example, "utf8" isn't an
+        // alias of the canonical name "UTF-8", but we shouldn't penalize consistent users of
+        // such names unduly.)
+        CACHED_CHARSETS.put(charsetName, canonicalCharset);
+        // And all its aliases...
+        for (String alias : cs.aliasesSet) {
+            CACHED_CHARSETS.put(alias, canonicalCharset);
+        }
+        return canonicalCharset;
     }
     /**
      * Returns a {@code Charset} instance for the named charset.
@@ -105,17 +111,18 @@ private static Charset cacheCharset(String charsetName, Charset cs) {
      *             if the desired charset is not supported by this runtime.
      */
     public static Charset forName(String charsetName) {
-        // Is this charset in our cache?
-        Charset cs;
-        synchronized (CACHED_CHARSETS) {
-            cs = CACHED_CHARSETS.get(charsetName);
-            if (cs != null) {
-                return cs;
-            }
-        }
         if (charsetName == null) {
             throw new IllegalCharsetNameException(null);
         }
+        // Is this charset in our cache?
+        Charset cs = CACHED_CHARSETS.get(charsetName);
+        if (cs != null) {
+            return cs;
+        }
+        // Was this charset already not found?
+        if (UNSUPPORTED_CHARSET_NAMES.contains(charsetName)) {
+            throw new UnsupportedCharsetException(charsetName);
+        }
         // Is this a built-in charset supported by ICU?
         checkCharsetName(charsetName);
         cs = NativeConverter.charsetForName(charsetName);
@@ -129,6 +136,10 @@ private static Charset cacheCharset(String charsetName, Charset cs) {
                 return cacheCharset(charsetName, cs);
             }
         }
+        if (UNSUPPORTED_CHARSET_NAMES.size() >= MAX_UNSUPPORTED_CHARSET_NAMES) {
+            UNSUPPORTED_CHARSET_NAMES.clear();
+        }
+        UNSUPPORTED_CHARSET_NAMES.add(charsetName);
         throw new UnsupportedCharsetException(charsetName);
     }
     /**
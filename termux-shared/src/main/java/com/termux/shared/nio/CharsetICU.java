@@ -10,8 +10,19 @@ package com.termux.shared.nio.charset;
 import com.termux.shared.file.libcore.NativeConverter;
 final class CharsetICU extends Charset {
     private final String icuCanonicalName;
-    protected CharsetICU(String canonicalName, String icuCanonName, String[] aliases) {
+    /** The native descriptor of the charset, which owns the pool of its converters. */
+    private final long nativeDescriptor;
+    protected CharsetICU(String canonicalName, String icuCanonName, String[] aliases, long nativeDescriptor) {
          super(canonicalName, aliases);
          icuCanonicalName = icuCanonName;
+         this.nativeDescriptor = nativeDescriptor;
+    }
+    /** Check out a pooled converter, which must be returned with {@link #returnConverter(long)}. */
+    long checkoutConverter() {
+        return NativeConverter.checkoutConverter(nativeDescriptor);
+    }
+    /** Return a converter checked out with {@link #checkoutConverter()}. */
+    void returnConverter(long converter) {
+        NativeConverter.returnConverter(nativeDescriptor, converter);
     }
 }
@@ -12,10 +12,14 @@ import com.termux.shared.R;
 import com.termux.shared.android.PackageUtils;
 import com.termux.shared.android.PermissionUtils;
 import com.termux.shared.errors.Error;
+import com.termux.shared.file.libcore.OsConstants;
+import com.termux.shared.jni.models.JniResult;
 import com.termux.shared.logger.Logger;
 import com.termux.shared.net.socket.local.ILocalSocketManager;
 import com.termux.shared.net.socket.local.LocalClientSocket;
 import com.termux.shared.net.socket.local.LocalServerSocket;
+import com.termux.shared.net.socket.local.LocalSocketBatchWriter;
+import com.termux.shared.net.socket.local.LocalSocketErrno;
 import com.termux.shared.net.socket.local.LocalSocketManager;
 import com.termux.shared.net.socket.local.LocalSocketManagerClientBase;
 import com.termux.shared.net.socket.local.LocalSocketRunConfig;
@@ -24,10 +28,16 @@ import com.termux.shared.shell.command.ExecutionCommand;
 
 import java.io.ByteArrayOutputStream;
 import java.io.PrintStream;
+import java.nio.ByteBuffer;
 import java.nio.charset.StandardCharsets;
 import java.util.ArrayList;
 import java.util.Arrays;
 import java.util.List;
+import java.util.concurrent.ArrayBlockingQueue;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.ThreadPoolExecutor;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicInteger;
 
 /**
  * A AF_UNIX/SOCK_STREAM local server managed with {@link LocalSocketManager} whose
@@ -40,6 +50,24 @@ import java.util.List;
  * back in the format `exit_code\0stdout\0stderr\0` where `\0` represents a null character.
  * Check termux/termux-am-socket for implementation of a native c client.
  *
+ * If {@link LocalSocketRunConfig#getSocketType()} is {@link LocalSocketRunConfig#SOCKET_TYPE_SEQPACKET},
+ * then the client can instead send multiple am commands over the same connection, each as a
+ * separate message, and the result of each command is sent back as a separate message in the same
+ * format. The server processes commands until the client closes the connection or stays idle for
+ * longer than the receive timeout. Commands and results must not be larger than
+ * {@link LocalSocketRunConfig#getMaxMessageSize()}, otherwise an error result is sent back instead.
+ *
+ * If {@link AmSocketServerRunConfig#getMaxProtocolVersion()} is {@link #PROTOCOL_VERSION_PIPELINED},
+ * then a SOCK_STREAM client can request a persistent connection by sending the
+ * {@link #PROTOCOL_HANDSHAKE_BYTE} followed by the requested protocol version byte. The server
+ * replies with the {@link #PROTOCOL_HANDSHAKE_BYTE} followed by the accepted version byte and then
+ * the client can send multiple requests without waiting for their responses. Each request is
+ * a 4 byte request id, a 4 byte command length and the am command, and each response is the 4 byte
+ * request id of the request, a 4 byte result length and the result in the same format as the
+ * legacy protocol. All integers are unsigned big endian. Responses may be sent in a different
+ * order than requests were received, so clients must match them by request id. Since legacy
+ * clients never send a null byte first, both protocols can be served on the same socket.
+ *
  * Usage:
  * 1. Optionally extend {@link AmSocketServerClient}, the implementation for
  *    {@link ILocalSocketManager} that will receive call backs from the server including
@@ -61,6 +89,31 @@ public class AmSocketServer {
 
     public static final String LOG_TAG = "AmSocketServer";
 
+    /** The legacy am socket protocol version where a connection is used for a single command. */
+    public static final int PROTOCOL_VERSION_LEGACY = 1;
+
+    /** The am socket protocol version where a connection is used for multiple pipelined commands. */
+    public static final int PROTOCOL_VERSION_PIPELINED = 2;
+
+    /** The first byte sent by clients that want to negotiate a protocol version other than {@link #PROTOCOL_VERSION_LEGACY}. */
+    public static final byte PROTOCOL_HANDSHAKE_BYTE = 0;
+
+    /** The size of the request and response header for {@link #PROTOCOL_VERSION_PIPELINED}. */
+    public static final int PIPELINED_HEADER_SIZE = 8;
+
+    /** The max size of an am command request for {@link #PROTOCOL_VERSION_PIPELINED}. */
+    public static final int PIPELINED_MAX_REQUEST_SIZE = 1024 * 1024;
+
+    /**
+     * The max number of received requests of a pipelined connection that are queued while all
+     * threads of its pool are busy. Once full, the request is run on the thread that reads the
+     * connection, so that no further requests are read until a thread is free.
+     */
+    private static final int PIPELINED_MAX_QUEUED_REQUESTS = 32;
+
+    /** The max time in milliseconds to wait for running commands of a pipelined connection to finish after it was closed. */
+    private static final long PIPELINED_SHUTDOWN_TIMEOUT = 60000;
+
     /**
      * Create the {@link AmSocketServer} {@link LocalServerSocket} and start listening for new {@link LocalClientSocket}.
      *
@@ -81,6 +134,29 @@ public class AmSocketServer {
 
     public static void processAmClient(@NonNull LocalSocketManager localSocketManager,
                                        @NonNull LocalClientSocket clientSocket) {
+        if (localSocketManager.getLocalSocketRunConfig().isSeqPacketSocket()) {
+            processAmClientMessages(localSocketManager, clientSocket);
+            return;
+        }
+
+        AmSocketServerRunConfig amSocketServerRunConfig = (AmSocketServerRunConfig) localSocketManager.getLocalSocketRunConfig();
+        if (amSocketServerRunConfig.getMaxProtocolVersion() >= PROTOCOL_VERSION_PIPELINED) {
+            // Check if client wants to negotiate protocol version without consuming the first byte,
+            // since for legacy clients it will be part of the am command
+            byte[] firstByte = new byte[1];
+            LocalClientSocket.MutableInt bytesPeeked = new LocalClientSocket.MutableInt(0);
+            Error error = clientSocket.peek(firstByte, bytesPeeked);
+            if (error != null) {
+                localSocketManager.onError(clientSocket, error);
+                return;
+            }
+
+            if (bytesPeeked.value == 1 && firstByte[0] == PROTOCOL_HANDSHAKE_BYTE) {
+                processPipelinedAmClient(localSocketManager, clientSocket);
+                return;
+            }
+        }
+
         Error error;
 
         // Read amCommandString client sent and close input stream
@@ -91,37 +167,284 @@ public class AmSocketServer {
             return;
         }
 
-        String amCommandString = data.toString();
+        // Run am command and send its result to the client and close output stream
+        error = clientSocket.sendDataToOutputStream(runAmCommandString(localSocketManager, clientSocket, data.toString()), true);
+        if (error != null) {
+            localSocketManager.onError(clientSocket, error);
+        }
+    }
+
+    /**
+     * Process am commands sent by a {@link LocalSocketRunConfig#SOCKET_TYPE_SEQPACKET} client.
+     * Each message received is a single am command and its result is sent back as a single message
+     * in the same format as {@link #sendResultToClient(LocalSocketManager, LocalClientSocket, int, String, String)}.
+     * Commands are read until the client closes the connection or the receive timeout elapses
+     * while it is idle, so a client can run multiple commands without reconnecting.
+     *
+     * Both the am command and result messages are limited to {@link LocalSocketRunConfig#getMaxMessageSize()}.
+     * If a larger message is received, then the rest of it is discarded by the kernel and an error
+     * result is sent back for it, and if a result is larger, then an error result is sent instead.
+     * The connection can be used for further commands in both cases.
+     *
+     * @param localSocketManager The {@link LocalSocketManager} instance for the local socket.
+     * @param clientSocket The {@link LocalClientSocket} that sent the am commands.
+     */
+    public static void processAmClientMessages(@NonNull LocalSocketManager localSocketManager,
+                                               @NonNull LocalClientSocket clientSocket) {
+        LocalSocketRunConfig localSocketRunConfig = localSocketManager.getLocalSocketRunConfig();
+        int maxMessageSize = localSocketRunConfig.getMaxMessageSize();
+        byte[] message = new byte[maxMessageSize];
+        Error error;
+
+        while (true) {
+            // Read message directly with LocalSocketManager to get access to errno
+            JniResult result = LocalSocketManager.readMessage(localSocketRunConfig.getLogTitle() + " (client)",
+                clientSocket.getFD(), message,
+                localSocketRunConfig.getDeadline() > 0 ? clientSocket.getCreationTime() + localSocketRunConfig.getDeadline() : 0);
+
+            String amCommandResult;
+            if (result != null && result.retval != 0 && result.errno == OsConstants.EMSGSIZE) {
+                // Message boundaries are preserved, so only this command is lost
+                amCommandResult = getResultString(clientSocket, 1, null, AmSocketServerErrno.ERRNO_MESSAGE_TOO_LARGE.getError(
+                    clientSocket.getPeerCred().getMinimalString(), maxMessageSize).toString());
+            } else if (result == null || result.retval != 0) {
+                // The receive timeout elapsed while the client was idle, so just close the connection
+                if (result != null && result.errno == OsConstants.EAGAIN) {
+                    Logger.logVerbose(LOG_TAG, "Closing idle connection of peer " + clientSocket.getPeerCred().getMinimalString());
+                    return;
+                }
+                localSocketManager.onError(clientSocket, LocalSocketErrno.ERRNO_READ_MESSAGE_FROM_CLIENT_SOCKET_FAILED.getError(
+                    localSocketRunConfig.getTitle(), JniResult.getErrorString(result)));
+                return;
+            } else if (result.intData == 0) {
+                // Client closed the connection
+                return;
+            } else {
+                amCommandResult = runAmCommandString(localSocketManager, clientSocket,
+                    new String(message, 0, result.intData, StandardCharsets.UTF_8));
+            }
+
+            byte[] resultBytes = amCommandResult.getBytes(StandardCharsets.UTF_8);
+            if (resultBytes.length > maxMessageSize) {
+                resultBytes = getResultString(clientSocket, 1, null, AmSocketServerErrno.ERRNO_RESULT_MESSAGE_TOO_LARGE.getError(
+                    resultBytes.length, clientSocket.getPeerCred().getMinimalString(), maxMessageSize).toString())
+                    .getBytes(StandardCharsets.UTF_8);
+            }
+
+            error = clientSocket.sendMessage(resultBytes);
+            if (error != null) {
+                localSocketManager.onError(clientSocket, error);
+                return;
+            }
+        }
+    }
+
+    /**
+     * Process am commands sent by a {@link #PROTOCOL_VERSION_PIPELINED} client. The requests are
+     * read until the client closes the connection and are run on a per connection thread pool of
+     * {@link AmSocketServerRunConfig#getMaxPipelinedParallelCommands()} threads with a queue of
+     * {@link #PIPELINED_MAX_QUEUED_REQUESTS} requests. This returns only
+     * after the responses for all requests have been sent.
+     *
+     * @param localSocketManager The {@link LocalSocketManager} instance for the local socket.
+     * @param clientSocket The {@link LocalClientSocket} that sent the am commands.
+     */
+    public static void processPipelinedAmClient(@NonNull LocalSocketManager localSocketManager,
+                                                @NonNull LocalClientSocket clientSocket) {
+        AmSocketServerRunConfig amSocketServerRunConfig = (AmSocketServerRunConfig) localSocketManager.getLocalSocketRunConfig();
+        Error error;
+
+        // Read handshake and reply with the accepted protocol version
+        byte[] handshake = new byte[2];
+        LocalClientSocket.MutableInt bytesRead = new LocalClientSocket.MutableInt(0);
+        error = clientSocket.read(handshake, bytesRead);
+        if (error != null) {
+            localSocketManager.onError(clientSocket, error);
+            return;
+        }
+
+        if (bytesRead.value != 2 || handshake[0] != PROTOCOL_HANDSHAKE_BYTE || handshake[1] < PROTOCOL_VERSION_PIPELINED) {
+            localSocketManager.onError(clientSocket,
+                AmSocketServerErrno.ERRNO_PIPELINED_PROTOCOL_HANDSHAKE_INVALID.getError(clientSocket.getPeerCred().getMinimalString()));
+            return;
+        }
+
+        int protocolVersion = Math.min(handshake[1], amSocketServerRunConfig.getMaxProtocolVersion());
+        error = clientSocket.send(new byte[]{PROTOCOL_HANDSHAKE_BYTE, (byte) protocolVersion});
+        if (error != null) {
+            localSocketManager.onError(clientSocket, error);
+            return;
+        }
+
+        if (Logger.getLogLevel() >= Logger.LOG_LEVEL_VERBOSE)
+            Logger.logVerbose(LOG_TAG, "Pipelined am socket protocol version " + protocolVersion + " negotiated with peer " + clientSocket.getPeerCred().getMinimalString());
+
+        int maxParallelCommands = amSocketServerRunConfig.getMaxPipelinedParallelCommands();
+        ExecutorService executor = new ThreadPoolExecutor(maxParallelCommands, maxParallelCommands,
+            0L, TimeUnit.MILLISECONDS, new ArrayBlockingQueue<>(PIPELINED_MAX_QUEUED_REQUESTS),
+            new ThreadPoolExecutor.CallerRunsPolicy());
+        // Responses finished while other requests are still running are batched, and sent as soon
+        // as no request is running, so that a single request does not wait for the batch delay
+        final LocalSocketBatchWriter batchWriter = new LocalSocketBatchWriter(localSocketManager, clientSocket);
+        final AtomicInteger runningRequests = new AtomicInteger();
+        try {
+            byte[] header = new byte[PIPELINED_HEADER_SIZE];
+            while (true) {
+                // Read header directly with LocalSocketManager to get access to errno
+                JniResult result = LocalSocketManager.read(amSocketServerRunConfig.getLogTitle() + " (client)",
+                    clientSocket.getFD(), header,
+                    amSocketServerRunConfig.getDeadline() > 0 ? clientSocket.getCreationTime() + amSocketServerRunConfig.getDeadline() : 0);
+                if (result == null || result.retval != 0) {
+                    // The receive timeout elapsed while the client was idle, so just close the connection
+                    if (result != null && result.errno == OsConstants.EAGAIN) {
+                        Logger.logVerbose(LOG_TAG, "Closing idle pipelined connection of peer " + clientSocket.getPeerCred().getMinimalString());
+                        return;
+                    }
+                    localSocketManager.onError(clientSocket, LocalSocketErrno.ERRNO_READ_DATA_FROM_CLIENT_SOCKET_FAILED.getError(
+                        amSocketServerRunConfig.getTitle(), JniResult.getErrorString(result)));
+                    return;
+                }
+
+                // Client closed the connection
+                if (result.intData == 0)
+                    return;
+
+                if (result.intData != PIPELINED_HEADER_SIZE) {
+                    localSocketManager.onError(clientSocket, AmSocketServerErrno.ERRNO_PIPELINED_REQUEST_TRUNCATED.getError(
+                        clientSocket.getPeerCred().getMinimalString(), PIPELINED_HEADER_SIZE, result.intData));
+                    return;
+                }
+
+                ByteBuffer headerBuffer = ByteBuffer.wrap(header);
+                final int requestId = headerBuffer.getInt();
+                long requestSize = headerBuffer.getInt() & 0xFFFFFFFFL;
+                if (requestSize > PIPELINED_MAX_REQUEST_SIZE) {
+                    localSocketManager.onError(clientSocket, AmSocketServerErrno.ERRNO_PIPELINED_REQUEST_TOO_LARGE.getError(
+                        requestSize, clientSocket.getPeerCred().getMinimalString(), PIPELINED_MAX_REQUEST_SIZE));
+                    return;
+                }
+
+                byte[] request = new byte[(int) requestSize];
+                if (request.length > 0) {
+                    error = clientSocket.read(request, bytesRead);
+                    if (error != null) {
+                        localSocketManager.onError(clientSocket, error);
+                        return;
+                    }
+
+                    if (bytesRead.value != request.length) {
+                        localSocketManager.onError(clientSocket, AmSocketServerErrno.ERRNO_PIPELINED_REQUEST_TRUNCATED.getError(
+                            clientSocket.getPeerCred().getMinimalString(), request.length, bytesRead.value));
+                        return;
+                    }
+                }
+
+                final String amCommandString = new String(request, StandardCharsets.UTF_8);
+                runningRequests.incrementAndGet();
+                executor.execute(() -> {
+                    String amCommandResult = runAmCommandString(localSocketManager, clientSocket, amCommandString);
+                    Error sendError = sendPipelinedResultToClient(batchWriter, requestId, amCommandResult,
+                        runningRequests.decrementAndGet() == 0);
+                    if (sendError != null) {
+                        localSocketManager.onError(clientSocket, sendError);
+                    }
+                });
+            }
+        } finally {
+            // Wait for responses of all requests already received to be sent before the caller
+            // closes the client socket
+            executor.shutdown();
+            try {
+                if (!executor.awaitTermination(PIPELINED_SHUTDOWN_TIMEOUT, TimeUnit.MILLISECONDS))
+                    executor.shutdownNow();
+            } catch (InterruptedException e) {
+                executor.shutdownNow();
+            }
+
+            error = batchWriter.close();
+            if (error != null) {
+                localSocketManager.onError(clientSocket, error);
+            }
+        }
+    }
+
+    /**
+     * Send result to a {@link #PROTOCOL_VERSION_PIPELINED} {@link LocalClientSocket} with its
+     * {@link LocalSocketBatchWriter}, so that the results of commands finishing together are sent
+     * with a single gathered write. The header and result are added while holding the writer lock,
+     * so that responses of commands running in parallel are not interleaved, and the result does
+     * not need to be copied into a combined buffer.
+     *
+     * @param batchWriter The {@link LocalSocketBatchWriter} of the {@link LocalClientSocket} to which
+     *                    the result is to be sent.
+     * @param requestId The request id of the command.
+     * @param result The result {@link String} returned by {@link #runAmCommandString(LocalSocketManager, LocalClientSocket, String)}.
+     * @param flush Whether to send the pending results now, like when no other command is running.
+     * @return Returns the {@code error} if sending was not successful, otherwise {@code null}.
+     */
+    public static Error sendPipelinedResultToClient(@NonNull LocalSocketBatchWriter batchWriter,
+                                                    int requestId, @NonNull String result, boolean flush) {
+        byte[] resultBytes = result.getBytes(StandardCharsets.UTF_8);
+        ByteBuffer header = ByteBuffer.allocate(PIPELINED_HEADER_SIZE);
+        header.putInt(requestId);
+        header.putInt(resultBytes.length);
+
+        synchronized (batchWriter) {
+            Error error = batchWriter.write(header.array());
+            if (error == null)
+                error = batchWriter.write(resultBytes);
+            if (error == null && flush)
+                error = batchWriter.flush();
+            return error;
+        }
+    }
+
+    /**
+     * Parse and run the am command in {@code amCommandString} and get its result in the format
+     * `exit_code\0stdout\0stderr` that should be sent to the client.
+     *
+     * @param localSocketManager The {@link LocalSocketManager} instance for the local socket.
+     * @param clientSocket The {@link LocalClientSocket} that sent the am command.
+     * @param amCommandString The am command {@link String} sent by the client.
+     * @return Returns the result {@link String}.
+     */
+    @NonNull
+    public static String runAmCommandString(@NonNull LocalSocketManager localSocketManager,
+                                            @NonNull LocalClientSocket clientSocket,
+                                            String amCommandString) {
+        Error error;
 
-        Logger.logVerbose(LOG_TAG, "am command received from peer " + clientSocket.getPeerCred().getMinimalString() +
-            "\nam command: `" + amCommandString + "`");
+        // Only build log strings if they will be logged, since peer cred names are resolved lazily
+        if (Logger.getLogLevel() >= Logger.LOG_LEVEL_VERBOSE)
+            Logger.logVerbose(LOG_TAG, "am command received from peer " + clientSocket.getPeerCred().getMinimalString() +
+                "\nam command: `" + amCommandString + "`");
 
         // Parse am command string and convert it to a list of arguments
         List<String> amCommandList = new ArrayList<>();
         error = parseAmCommand(amCommandString, amCommandList);
         if (error != null) {
-            sendResultToClient(localSocketManager, clientSocket, 1, null, error.toString());
-            return;
+            return getResultString(clientSocket, 1, null, error.toString());
         }
 
         String[] amCommandArray = amCommandList.toArray(new String[0]);
 
-        Logger.logDebug(LOG_TAG, "am command received from peer " + clientSocket.getPeerCred().getMinimalString() +
-            "\n" + ExecutionCommand.getArgumentsLogString("am command", amCommandArray));
+        if (Logger.getLogLevel() >= Logger.LOG_LEVEL_DEBUG)
+            Logger.logDebug(LOG_TAG, "am command received from peer " + clientSocket.getPeerCred().getMinimalString() +
+                "\n" + ExecutionCommand.getArgumentsLogString("am command", amCommandArray));
 
         AmSocketServerRunConfig amSocketServerRunConfig = (AmSocketServerRunConfig) localSocketManager.getLocalSocketRunConfig();
 
-        // Run am command and send its result to the client
+        // Run am command and get its result
         StringBuilder stdout = new StringBuilder();
         StringBuilder stderr = new StringBuilder();
         error = runAmCommand(localSocketManager.getContext(), amCommandArray, stdout, stderr,
             amSocketServerRunConfig.shouldCheckDisplayOverAppsPermission());
         if (error != null) {
-            sendResultToClient(localSocketManager, clientSocket, 1, stdout.toString(),
+            return getResultString(clientSocket, 1, stdout.toString(),
                 !stderr.toString().isEmpty() ? stderr + "\n\n" + error : error.toString());
         }
 
-        sendResultToClient(localSocketManager, clientSocket, 0, stdout.toString(), stderr.toString());
+        return getResultString(clientSocket, 0, stdout.toString(), stderr.toString());
     }
 
     /**
@@ -137,18 +460,24 @@ public class AmSocketServer {
                                           @NonNull LocalClientSocket clientSocket,
                                           int exitCode,
                                           @Nullable String stdout, @Nullable String stderr) {
+        // Send result to client and close output stream
+        Error error = clientSocket.sendDataToOutputStream(getResultString(clientSocket, exitCode, stdout, stderr), true);
+        if (error != null) {
+            localSocketManager.onError(clientSocket, error);
+        }
+    }
+
+    /** Get the result {@link String} in the format `exit_code\0stdout\0stderr` that should be sent to the client. */
+    @NonNull
+    public static String getResultString(@NonNull LocalClientSocket clientSocket, int exitCode,
+                                         @Nullable String stdout, @Nullable String stderr) {
         StringBuilder result = new StringBuilder();
         result.append(sanitizeExitCode(clientSocket, exitCode));
         result.append('\0');
         result.append(stdout != null ? stdout : "");
         result.append('\0');
         result.append(stderr != null ? stderr : "");
-
-        // Send result to client and close output stream
-        Error error = clientSocket.sendDataToOutputStream(result.toString(), true);
-        if (error != null) {
-            localSocketManager.onError(clientSocket, error);
-        }
+        return result.toString();
     }
 
     /**
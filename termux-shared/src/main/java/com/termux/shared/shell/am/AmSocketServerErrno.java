@@ -10,6 +10,11 @@ public class AmSocketServerErrno extends Errno {
     /** Errors for {@link AmSocketServer} (100-150) */
     public static final Errno ERRNO_PARSE_AM_COMMAND_FAILED_WITH_EXCEPTION = new Errno(TYPE, 100, "Parse am command `%1$s` failed.\nException: %2$s");
     public static final Errno ERRNO_RUN_AM_COMMAND_FAILED_WITH_EXCEPTION = new Errno(TYPE, 101, "Run am command `%1$s` failed.\nException: %2$s");
+    public static final Errno ERRNO_PIPELINED_PROTOCOL_HANDSHAKE_INVALID = new Errno(TYPE, 102, "The am socket protocol handshake sent by peer %1$s is invalid.");
+    public static final Errno ERRNO_PIPELINED_REQUEST_TRUNCATED = new Errno(TYPE, 103, "The am command request received from peer %1$s was truncated. Expected %2$s bytes but received %3$s bytes.");
+    public static final Errno ERRNO_PIPELINED_REQUEST_TOO_LARGE = new Errno(TYPE, 104, "The am command request of %1$s bytes received from peer %2$s is larger than max allowed size of %3$s bytes.");
+    public static final Errno ERRNO_MESSAGE_TOO_LARGE = new Errno(TYPE, 105, "The am command message received from peer %1$s is larger than max allowed size of %2$s bytes.");
+    public static final Errno ERRNO_RESULT_MESSAGE_TOO_LARGE = new Errno(TYPE, 106, "The am command result of %1$s bytes for peer %2$s is larger than max allowed message size of %3$s bytes.");
 
     AmSocketServerErrno(final String type, final int code, final String message) {
         super(type, code, message);
@@ -26,6 +26,26 @@ public class AmSocketServerRunConfig extends LocalSocketRunConfig implements Ser
     private Boolean mCheckDisplayOverAppsPermission;
     public static final boolean DEFAULT_CHECK_DISPLAY_OVER_APPS_PERMISSION = true;
 
+    /**
+     * The max am socket protocol version that clients are allowed to request. If set to
+     * {@link AmSocketServer#PROTOCOL_VERSION_LEGACY}, then all clients are handled with the legacy
+     * single command per connection protocol. If set to {@link AmSocketServer#PROTOCOL_VERSION_PIPELINED},
+     * then clients that send the {@link AmSocketServer#PROTOCOL_HANDSHAKE_BYTE} as the first byte
+     * can send multiple length-prefixed commands over the same connection.
+     * Defaults to {@link #DEFAULT_MAX_PROTOCOL_VERSION}.
+     */
+    private Integer mMaxProtocolVersion;
+    public static final int DEFAULT_MAX_PROTOCOL_VERSION = AmSocketServer.PROTOCOL_VERSION_LEGACY;
+
+    /**
+     * The max number of am commands of a single {@link AmSocketServer#PROTOCOL_VERSION_PIPELINED}
+     * connection that are run in parallel. Results may be sent in a different order than commands
+     * were received if greater than 1.
+     * Defaults to {@link #DEFAULT_MAX_PIPELINED_PARALLEL_COMMANDS}.
+     */
+    private Integer mMaxPipelinedParallelCommands;
+    public static final int DEFAULT_MAX_PIPELINED_PARALLEL_COMMANDS = 4;
+
     /**
      * Create an new instance of {@link AmSocketServerRunConfig}.
      *
@@ -48,6 +68,27 @@ public class AmSocketServerRunConfig extends LocalSocketRunConfig implements Ser
         mCheckDisplayOverAppsPermission = checkDisplayOverAppsPermission;
     }
 
+    /** Get {@link #mMaxProtocolVersion} if set, otherwise {@link #DEFAULT_MAX_PROTOCOL_VERSION}. */
+    public int getMaxProtocolVersion() {
+        return mMaxProtocolVersion != null ? mMaxProtocolVersion : DEFAULT_MAX_PROTOCOL_VERSION;
+    }
+
+    /** Set {@link #mMaxProtocolVersion}. */
+    public void setMaxProtocolVersion(Integer maxProtocolVersion) {
+        mMaxProtocolVersion = maxProtocolVersion;
+    }
+
+    /** Get {@link #mMaxPipelinedParallelCommands} if set, otherwise {@link #DEFAULT_MAX_PIPELINED_PARALLEL_COMMANDS}. */
+    public int getMaxPipelinedParallelCommands() {
+        return mMaxPipelinedParallelCommands != null ? mMaxPipelinedParallelCommands : DEFAULT_MAX_PIPELINED_PARALLEL_COMMANDS;
+    }
+
+    /** Set {@link #mMaxPipelinedParallelCommands}. Value must be greater than 0. */
+    public void setMaxPipelinedParallelCommands(Integer maxPipelinedParallelCommands) {
+        if (maxPipelinedParallelCommands > 0)
+            mMaxPipelinedParallelCommands = maxPipelinedParallelCommands;
+    }
+
 
 
     /**
@@ -70,6 +111,8 @@ public class AmSocketServerRunConfig extends LocalSocketRunConfig implements Ser
 
         logString.append("Am Command:");
         logString.append("\n").append(Logger.getSingleLineLogStringEntry("CheckDisplayOverAppsPermission", shouldCheckDisplayOverAppsPermission(), "-"));
+        logString.append("\n").append(Logger.getSingleLineLogStringEntry("MaxProtocolVersion", getMaxProtocolVersion(), "-"));
+        logString.append("\n").append(Logger.getSingleLineLogStringEntry("MaxPipelinedParallelCommands", getMaxPipelinedParallelCommands(), "-"));
 
         return logString.toString();
     }
@@ -93,6 +136,8 @@ public class AmSocketServerRunConfig extends LocalSocketRunConfig implements Ser
 
         markdownString.append("## ").append("Am Command");
         markdownString.append("\n").append(MarkdownUtils.getSingleLineMarkdownStringEntry("CheckDisplayOverAppsPermission", shouldCheckDisplayOverAppsPermission(), "-"));
+        markdownString.append("\n").append(MarkdownUtils.getSingleLineMarkdownStringEntry("MaxProtocolVersion", getMaxProtocolVersion(), "-"));
+        markdownString.append("\n").append(MarkdownUtils.getSingleLineMarkdownStringEntry("MaxPipelinedParallelCommands", getMaxPipelinedParallelCommands(), "-"));
 
         return markdownString.toString();
     }
@@ -0,0 +1,182 @@
+package com.termux.shared.shell.am.tests;
+
+import android.content.Context;
+import android.net.LocalSocket;
+import android.net.LocalSocketAddress;
+
+import androidx.annotation.NonNull;
+
+import com.termux.shared.logger.Logger;
+import com.termux.shared.shell.am.AmSocketServer;
+
+import java.io.ByteArrayOutputStream;
+import java.io.DataInputStream;
+import java.io.IOException;
+import java.io.InputStream;
+import java.io.OutputStream;
+import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
+import java.util.Arrays;
+
+public class AmSocketServerBenchmark {
+
+    private static final String LOG_TAG = "AmSocketServerBenchmark";
+
+    /**
+     * Run a load benchmark against a running {@link AmSocketServer} with a local stand-in client
+     * that sends {@code commandCount} am commands, first with the legacy protocol using a new
+     * connection for each command and then with the pipelined protocol over a single connection
+     * with up to {@code pipelineDepth} requests in flight. The commands/sec and latency percentiles
+     * of both protocols are logged.
+     *
+     * The server must have been started with
+     * {@link com.termux.shared.shell.am.AmSocketServerRunConfig#setMaxProtocolVersion(Integer)}
+     * set to {@link AmSocketServer#PROTOCOL_VERSION_PIPELINED} for the pipelined run.
+     *
+     * The log level must be set to verbose.
+     *
+     * Run at app startup like in an activity
+     * AmSocketServerBenchmark.runBenchmark(this, TermuxConstants.TERMUX_APP.TERMUX_AM_SOCKET_FILE_PATH,
+     *     "broadcast -a com.termux.benchmark.NOOP", 1000, 16);
+     *
+     * @param context The {@link Context} for operations.
+     * @param socketPath The filesystem path of the server socket.
+     * @param amCommand The am command to send, without the initial "am" arg.
+     * @param commandCount The number of commands to send for each protocol.
+     * @param pipelineDepth The max number of pipelined requests in flight.
+     */
+    public static void runBenchmark(@NonNull final Context context, @NonNull final String socketPath,
+                                    @NonNull final String amCommand, int commandCount, int pipelineDepth) {
+        try {
+            Logger.logInfo(LOG_TAG, "Running benchmark");
+            Logger.logInfo(LOG_TAG, "socketPath: \"" + socketPath + "\", amCommand: `" + amCommand +
+                "`, commandCount: " + commandCount + ", pipelineDepth: " + pipelineDepth);
+
+            logResult("legacy", runLegacyBenchmark(socketPath, amCommand, commandCount));
+            logResult("pipelined", runPipelinedBenchmark(socketPath, amCommand, commandCount, pipelineDepth));
+
+            Logger.logInfo(LOG_TAG, "Benchmark finished");
+        } catch (Exception e) {
+            Logger.logStackTraceWithMessage(LOG_TAG, "Benchmark failed", e);
+            Logger.showToast(context, e.getMessage(), true);
+        }
+    }
+
+    /** Send each command over a new connection and return the latency of each in nanoseconds. */
+    private static BenchmarkResult runLegacyBenchmark(@NonNull final String socketPath, @NonNull final String amCommand,
+                                                      int commandCount) throws IOException {
+        byte[] request = amCommand.getBytes(StandardCharsets.UTF_8);
+        long[] latencies = new long[commandCount];
+        byte[] buffer = new byte[8192];
+
+        long startTime = System.nanoTime();
+        for (int i = 0; i < commandCount; i++) {
+            long commandStartTime = System.nanoTime();
+            try (LocalSocket socket = connect(socketPath)) {
+                socket.getOutputStream().write(request);
+                socket.shutdownOutput();
+
+                InputStream inputStream = socket.getInputStream();
+                ByteArrayOutputStream response = new ByteArrayOutputStream();
+                int bytesRead;
+                while ((bytesRead = inputStream.read(buffer)) != -1)
+                    response.write(buffer, 0, bytesRead);
+                validateResult(response.toByteArray());
+            }
+            latencies[i] = System.nanoTime() - commandStartTime;
+        }
+
+        return new BenchmarkResult(latencies, System.nanoTime() - startTime);
+    }
+
+    /**
+     * Send all commands over a single connection with up to pipelineDepth requests in flight and
+     * return the latency of each in nanoseconds.
+     */
+    private static BenchmarkResult runPipelinedBenchmark(@NonNull final String socketPath, @NonNull final String amCommand,
+                                                         int commandCount, int pipelineDepth) throws IOException {
+        byte[] command = amCommand.getBytes(StandardCharsets.UTF_8);
+        long[] sendTimes = new long[commandCount];
+        long[] latencies = new long[commandCount];
+
+        long startTime = System.nanoTime();
+        try (LocalSocket socket = connect(socketPath)) {
+            OutputStream outputStream = socket.getOutputStream();
+            DataInputStream inputStream = new DataInputStream(socket.getInputStream());
+
+            outputStream.write(new byte[]{AmSocketServer.PROTOCOL_HANDSHAKE_BYTE, AmSocketServer.PROTOCOL_VERSION_PIPELINED});
+            if (inputStream.readByte() != AmSocketServer.PROTOCOL_HANDSHAKE_BYTE ||
+                inputStream.readByte() != AmSocketServer.PROTOCOL_VERSION_PIPELINED)
+                throw new IOException("Server did not accept pipelined protocol version " + AmSocketServer.PROTOCOL_VERSION_PIPELINED);
+
+            int sent = 0;
+            int received = 0;
+            while (received < commandCount) {
+                while (sent < commandCount && sent - received < pipelineDepth) {
+                    ByteBuffer request = ByteBuffer.allocate(AmSocketServer.PIPELINED_HEADER_SIZE + command.length);
+                    request.putInt(sent);
+                    request.putInt(command.length);
+                    request.put(command);
+                    sendTimes[sent] = System.nanoTime();
+                    outputStream.write(request.array());
+                    sent++;
+                }
+
+                int requestId = inputStream.readInt();
+                byte[] result = new byte[inputStream.readInt()];
+                inputStream.readFully(result);
+                if (requestId < 0 || requestId >= sent)
+                    throw new IOException("Received response for unknown request id " + requestId);
+                validateResult(result);
+                latencies[requestId] = System.nanoTime() - sendTimes[requestId];
+                received++;
+            }
+        }
+
+        return new BenchmarkResult(latencies, System.nanoTime() - startTime);
+    }
+
+    @NonNull
+    private static LocalSocket connect(@NonNull final String socketPath) throws IOException {
+        LocalSocket socket = new LocalSocket();
+        socket.connect(new LocalSocketAddress(socketPath, LocalSocketAddress.Namespace.FILESYSTEM));
+        return socket;
+    }
+
+    /** Validate that result is in the `exit_code\0stdout\0stderr` format. */
+    private static void validateResult(@NonNull byte[] result) throws IOException {
+        String resultString = new String(result, StandardCharsets.UTF_8);
+        if (resultString.split("\0", -1).length != 3)
+            throw new IOException("Invalid result received: \"" + resultString + "\"");
+    }
+
+    private static void logResult(@NonNull String label, @NonNull BenchmarkResult result) {
+        Logger.logInfo(LOG_TAG, label + ": " + result.latencies.length + " commands in " +
+            (result.totalTime / 1000000) + "ms, " + String.format("%.1f", result.getCommandsPerSecond()) + " commands/sec" +
+            ", p50: " + (result.getPercentile(50) / 1000) + "us" +
+            ", p99: " + (result.getPercentile(99) / 1000) + "us" +
+            ", max: " + (result.getPercentile(100) / 1000) + "us");
+    }
+
+    private static class BenchmarkResult {
+        final long[] latencies;
+        final long totalTime;
+
+        BenchmarkResult(@NonNull long[] latencies, long totalTime) {
+            this.latencies = latencies;
+            this.totalTime = totalTime;
+            Arrays.sort(this.latencies);
+        }
+
+        double getCommandsPerSecond() {
+            return totalTime > 0 ? latencies.length * 1e9 / totalTime : 0;
+        }
+
+        long getPercentile(double percentile) {
+            if (latencies.length == 0) return 0;
+            int index = (int) Math.ceil(percentile / 100.0 * latencies.length) - 1;
+            return latencies[Math.max(0, Math.min(index, latencies.length - 1))];
+        }
+    }
+
+}
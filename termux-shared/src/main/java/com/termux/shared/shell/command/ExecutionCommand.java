@@ -7,6 +7,7 @@ import androidx.annotation.NonNull;
 import androidx.annotation.Nullable;
 
 import com.termux.shared.data.IntentUtils;
+import com.termux.shared.shell.command.result.OutputCapture;
 import com.termux.shared.shell.command.result.ResultConfig;
 import com.termux.shared.shell.command.result.ResultData;
 import com.termux.shared.errors.Error;
@@ -14,6 +15,7 @@ import com.termux.shared.logger.Logger;
 import com.termux.shared.markdown.MarkdownUtils;
 import com.termux.shared.data.DataUtils;
 import com.termux.shared.shell.command.runner.app.AppShell;
+import com.termux.shared.shell.command.runner.app.AppShellScheduler;
 import com.termux.terminal.TerminalSession;
 
 import java.util.Collections;
@@ -184,6 +186,20 @@ public class ExecutionCommand {
      */
     public Integer backgroundCustomLogLevel;
 
+    /**
+     * The max size in bytes of the stdout and stderr of background {@link AppShell} commands kept
+     * in memory. The full output of a larger stream is spilled to a file in the app cache directory
+     * and only its head and tail are kept in {@link ResultData}. Set to {@code 0} to keep the full
+     * output in memory.
+     */
+    public int maxOutputSize = OutputCapture.DEFAULT_MAX_SIZE;
+
+    /**
+     * The {@link AppShellScheduler.Priority} name of background {@link AppShell} commands, which
+     * decides how they are queued if the max number of background commands are already running.
+     */
+    public String backgroundPriority;
+
 
     /** The session action of {@link Runner#TERMINAL_SESSION} commands. */
     public String sessionAction;
@@ -387,6 +403,9 @@ public class ExecutionCommand {
 
             if (!ignoreNull || executionCommand.backgroundCustomLogLevel != null)
                 logString.append("\n").append(executionCommand.getBackgroundCustomLogLevelLogString());
+
+            if (!ignoreNull || executionCommand.backgroundPriority != null)
+                logString.append("\n").append(executionCommand.getBackgroundPriorityLogString());
         }
 
         if (!ignoreNull || executionCommand.sessionAction != null)
@@ -490,6 +509,8 @@ public class ExecutionCommand {
                 markdownString.append("\n").append(MarkdownUtils.getMultiLineMarkdownStringEntry("Stdin", executionCommand.stdin, "-"));
             if (executionCommand.backgroundCustomLogLevel != null)
                 markdownString.append("\n").append(MarkdownUtils.getSingleLineMarkdownStringEntry("Background Custom Log Level", executionCommand.backgroundCustomLogLevel, "-"));
+            if (executionCommand.backgroundPriority != null)
+                markdownString.append("\n").append(MarkdownUtils.getSingleLineMarkdownStringEntry("Background Priority", executionCommand.backgroundPriority, "-"));
         }
 
         markdownString.append("\n").append(MarkdownUtils.getSingleLineMarkdownStringEntry("Session Action", executionCommand.sessionAction, "-"));
@@ -582,6 +603,10 @@ public class ExecutionCommand {
         return "Background Custom Log Level: `" + backgroundCustomLogLevel + "`";
     }
 
+    public String getBackgroundPriorityLogString() {
+        return Logger.getSingleLineLogStringEntry("Background Priority", backgroundPriority, "-");
+    }
+
     public String getSessionActionLogString() {
         return Logger.getSingleLineLogStringEntry("Session Action", sessionAction, "-");
     }
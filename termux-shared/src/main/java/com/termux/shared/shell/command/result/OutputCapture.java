@@ -0,0 +1,364 @@
+package com.termux.shared.shell.command.result;
+
+import android.content.Context;
+
+import androidx.annotation.NonNull;
+import androidx.annotation.Nullable;
+
+import com.termux.shared.logger.Logger;
+import com.termux.shared.shell.StreamGobbler;
+
+import java.io.BufferedOutputStream;
+import java.io.ByteArrayOutputStream;
+import java.io.File;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.io.InputStream;
+import java.io.OutputStream;
+import java.nio.charset.StandardCharsets;
+import java.util.Arrays;
+import java.util.Locale;
+
+/**
+ * A bounded capture of the stdout or stderr of a command.
+ *
+ * The output is kept in memory until it is larger than the max size. After that only its first
+ * and last max size / 2 bytes are kept in memory, and the full output is written to a file in the
+ * spill directory, so that a command that prints a lot cannot exhaust the memory of the app. A
+ * stream is read into it in chunks with {@link #startReading(InputStream)}, so that unlike the
+ * lines of a {@link StreamGobbler}, an output without newlines is not kept in memory in full,
+ * and {@link #of(byte[], int, long, String)} wraps an output that was already captured the same
+ * way by native.
+ *
+ * The kept output and the path of the spill file are set in the {@link ResultData} with
+ * {@link ResultData#appendStdout(OutputCapture)} and {@link ResultData#appendStderr(OutputCapture)}
+ * once the capture is closed.
+ */
+public final class OutputCapture {
+
+    /** The default max size in bytes of an output kept in memory. */
+    public static final int DEFAULT_MAX_SIZE = 1024 * 1024;
+
+    /** The size in bytes of the buffer a stream is read into by {@link #startReading(InputStream)}. */
+    private static final int READ_BUFFER_SIZE = 8 * 1024;
+
+    /** The name of the directory in the app cache directory for the spill files. */
+    private static final String SPILL_DIRECTORY_NAME = "command-output";
+    /** The age after which spill files are deleted, since results are sent long before. */
+    private static final long SPILL_FILE_MAX_AGE_MILLIS = 24 * 60 * 60 * 1000;
+    /** The max total size in bytes of the spill files, after which the oldest ones are deleted. */
+    private static final long SPILL_DIRECTORY_MAX_SIZE = 256 * 1024 * 1024;
+
+    private final String mName;
+    private final int mMaxSize;
+    private final File mSpillDirectory;
+
+    /* The output while it is not larger than the max size. */
+    private ByteArrayOutputStream mBuffer;
+    /* The head and the tail ring of the output once it is truncated. */
+    private byte[] mHead;
+    private int mHeadSize;
+    private byte[] mTail;
+    private int mTailEnd;
+    private int mTailSize;
+    private OutputStream mSpillStream;
+    private File mSpillFile;
+
+    /* The kept output once closed, with the tail after the head. */
+    private byte[] mData;
+    private long mSize;
+
+    private static final String LOG_TAG = "OutputCapture";
+
+    /**
+     * Create an new instance of {@link OutputCapture}.
+     *
+     * @param name The name of the output, which is the prefix of its spill file.
+     * @param maxSize The max size in bytes of the output kept in memory, or {@code 0} to keep all of it.
+     * @param spillDirectory The directory to create the spill file in, or {@code null} to only keep
+     *                       the head and tail of the output.
+     */
+    public OutputCapture(@NonNull String name, int maxSize, @Nullable File spillDirectory) {
+        mName = name;
+        mMaxSize = Math.max(maxSize, 0);
+        mSpillDirectory = spillDirectory;
+        mBuffer = new ByteArrayOutputStream();
+    }
+
+    /**
+     * Get an {@link OutputCapture} for an output already captured by native.
+     *
+     * @param data The head of the output, followed by its tail if it was truncated.
+     * @param headSize The size of the head in {@code data}.
+     * @param size The size in bytes of the full output.
+     * @param spillFilePath The path of the file with the full output, if it was truncated and spilled.
+     * @return Returns the closed {@link OutputCapture}.
+     */
+    @NonNull
+    public static OutputCapture of(@NonNull byte[] data, int headSize, long size, @Nullable String spillFilePath) {
+        OutputCapture capture = new OutputCapture("", 0, null);
+        capture.mBuffer = null;
+        capture.mData = data;
+        capture.mHeadSize = headSize;
+        capture.mSize = size;
+        capture.mSpillFile = spillFilePath != null ? new File(spillFilePath) : null;
+        return capture;
+    }
+
+    /**
+     * Get the directory for spill files in the app cache directory, creating it if needed. Spill
+     * files older than a day are deleted, and then the oldest ones until the total size of the
+     * rest is not larger than {@link #SPILL_DIRECTORY_MAX_SIZE}.
+     *
+     * @param context The {@link Context} for operations.
+     * @return Returns the directory, or {@code null} if it could not be created.
+     */
+    @Nullable
+    public static File getSpillDirectory(@NonNull Context context) {
+        File spillDirectory = new File(context.getCacheDir(), SPILL_DIRECTORY_NAME);
+        if (!spillDirectory.isDirectory() && !spillDirectory.mkdirs()) {
+            Logger.logError(LOG_TAG, "Failed to create command output spill directory at \"" + spillDirectory.getAbsolutePath() + "\"");
+            return null;
+        }
+
+        synchronized (OutputCapture.class) {
+            deleteStaleSpillFiles(spillDirectory);
+        }
+
+        return spillDirectory;
+    }
+
+    private static void deleteStaleSpillFiles(@NonNull File spillDirectory) {
+        File[] files = spillDirectory.listFiles();
+        if (files == null || files.length == 0) return;
+
+        // Sort the newest first by the last modified times read once, since they may change while sorting
+        long[] lastModifiedTimes = new long[files.length];
+        Integer[] order = new Integer[files.length];
+        for (int i = 0; i < files.length; i++) {
+            lastModifiedTimes[i] = files[i].lastModified();
+            order[i] = i;
+        }
+        Arrays.sort(order, (a, b) -> Long.compare(lastModifiedTimes[b], lastModifiedTimes[a]));
+
+        // Keep the newest files, since they are most likely still being written or not yet sent,
+        // and always the newest one, even if it alone is larger than the max size
+        long now = System.currentTimeMillis();
+        long totalSize = 0;
+        for (int i : order) {
+            File file = files[i];
+            totalSize += file.length();
+            boolean stale = now - lastModifiedTimes[i] > SPILL_FILE_MAX_AGE_MILLIS;
+            if (!stale && (totalSize <= SPILL_DIRECTORY_MAX_SIZE || i == order[0]))
+                continue;
+
+            if (file.delete())
+                Logger.logVerbose(LOG_TAG, "Deleted stale command output spill file at \"" + file.getAbsolutePath() + "\"");
+            else
+                Logger.logWarn(LOG_TAG, "Failed to delete stale command output spill file at \"" + file.getAbsolutePath() + "\"");
+        }
+    }
+
+    /**
+     * Start a thread that appends what is read from {@code inputStream} to the output until the
+     * stream ends and then closes it.
+     *
+     * @param inputStream The {@link InputStream} to read, like the stdout of a process.
+     * @return Returns the started {@link Thread}, which should be joined before calling {@link #close()}.
+     */
+    @NonNull
+    public Thread startReading(@NonNull final InputStream inputStream) {
+        Thread thread = new Thread(() -> {
+            byte[] buffer = new byte[READ_BUFFER_SIZE];
+            try {
+                int length;
+                while ((length = inputStream.read(buffer)) != -1)
+                    append(buffer, 0, length);
+            } catch (IOException e) {
+                // The stream was closed, like after the process was killed
+            } finally {
+                try {
+                    inputStream.close();
+                } catch (IOException e) {
+                    // ignore
+                }
+            }
+        }, "OutputCapture-" + mName);
+        thread.start();
+        return thread;
+    }
+
+    /** Append {@code length} bytes of {@code data} from {@code offset} to the output. */
+    public synchronized void append(@NonNull byte[] data, int offset, int length) {
+        if (mData != null) return;
+        mSize += length;
+
+        if (mBuffer != null) {
+            if (mMaxSize == 0 || mBuffer.size() + length <= mMaxSize) {
+                mBuffer.write(data, offset, length);
+                return;
+            }
+
+            // Spill what was kept so far, and keep the first half of the max size as the head
+            byte[] kept = mBuffer.toByteArray();
+            mBuffer = null;
+            openSpillFile();
+            spill(kept, 0, kept.length);
+            spill(data, offset, length);
+
+            mHead = new byte[mMaxSize / 2];
+            mTail = new byte[mMaxSize - mHead.length];
+            mHeadSize = Math.min(kept.length, mHead.length);
+            System.arraycopy(kept, 0, mHead, 0, mHeadSize);
+            appendTail(kept, mHeadSize, kept.length - mHeadSize);
+
+            int headAppended = Math.min(mHead.length - mHeadSize, length);
+            System.arraycopy(data, offset, mHead, mHeadSize, headAppended);
+            mHeadSize += headAppended;
+            appendTail(data, offset + headAppended, length - headAppended);
+            return;
+        }
+
+        spill(data, offset, length);
+        appendTail(data, offset, length);
+    }
+
+    private void appendTail(@NonNull byte[] data, int offset, int length) {
+        int capacity = mTail.length;
+        if (capacity == 0 || length == 0) return;
+        if (length >= capacity) {
+            System.arraycopy(data, offset + length - capacity, mTail, 0, capacity);
+            mTailEnd = 0;
+            mTailSize = capacity;
+            return;
+        }
+
+        int firstLength = Math.min(length, capacity - mTailEnd);
+        System.arraycopy(data, offset, mTail, mTailEnd, firstLength);
+        System.arraycopy(data, offset + firstLength, mTail, 0, length - firstLength);
+        mTailEnd = (mTailEnd + length) % capacity;
+        mTailSize = Math.min(capacity, mTailSize + length);
+    }
+
+    private void openSpillFile() {
+        if (mSpillDirectory == null) return;
+        try {
+            mSpillFile = File.createTempFile(mName + "-", null, mSpillDirectory);
+            mSpillStream = new BufferedOutputStream(new FileOutputStream(mSpillFile), 64 * 1024);
+        } catch (IOException e) {
+            Logger.logStackTraceWithMessage(LOG_TAG, "Failed to create spill file for \"" + mName + "\" output", e);
+            deleteSpillFile();
+        }
+    }
+
+    private void spill(@NonNull byte[] data, int offset, int length) {
+        if (mSpillStream == null) return;
+        try {
+            mSpillStream.write(data, offset, length);
+        } catch (IOException e) {
+            // The full output is lost, like if the storage is full, so only keep its head and tail
+            Logger.logStackTraceWithMessage(LOG_TAG, "Failed to write spill file for \"" + mName + "\" output", e);
+            deleteSpillFile();
+        }
+    }
+
+    private void deleteSpillFile() {
+        if (mSpillStream != null) {
+            try {
+                mSpillStream.close();
+            } catch (IOException e) {
+                // ignore
+            }
+            mSpillStream = null;
+        }
+        if (mSpillFile != null) {
+            //noinspection ResultOfMethodCallIgnored
+            mSpillFile.delete();
+            mSpillFile = null;
+        }
+    }
+
+    /** Finish the capture, closing the spill file. Further appends are ignored. */
+    public synchronized void close() {
+        if (mData != null) return;
+
+        if (mBuffer != null) {
+            mData = mBuffer.toByteArray();
+            mHeadSize = mData.length;
+            mBuffer = null;
+            return;
+        }
+
+        if (mSpillStream != null) {
+            try {
+                mSpillStream.close();
+                mSpillStream = null;
+            } catch (IOException e) {
+                Logger.logStackTraceWithMessage(LOG_TAG, "Failed to close spill file for \"" + mName + "\" output", e);
+                deleteSpillFile();
+            }
+        }
+
+        mData = new byte[mHeadSize + mTailSize];
+        System.arraycopy(mHead, 0, mData, 0, mHeadSize);
+        int tailStart = (mTailEnd - mTailSize + mTail.length) % Math.max(mTail.length, 1);
+        int firstLength = Math.min(mTailSize, mTail.length - tailStart);
+        System.arraycopy(mTail, tailStart, mData, mHeadSize, firstLength);
+        System.arraycopy(mTail, 0, mData, mHeadSize + firstLength, mTailSize - firstLength);
+        mHead = null;
+        mTail = null;
+    }
+
+    /** Get the size in bytes of the full output. */
+    public synchronized long getSize() {
+        return mSize;
+    }
+
+    /** Check whether only the head and tail of the output were kept in memory. */
+    public synchronized boolean isTruncated() {
+        return mData == null ? mBuffer == null : mSize > mData.length;
+    }
+
+    /** Get the path of the file with the full output if it was truncated and spilled, otherwise {@code null}. */
+    @Nullable
+    public synchronized String getSpillFilePath() {
+        return mSpillFile != null ? mSpillFile.getAbsolutePath() : null;
+    }
+
+    /**
+     * Append the kept output of the closed capture to {@code output}, decoded as UTF-8. If it was
+     * truncated, then a line with the number of bytes truncated is added between its head and tail.
+     */
+    public synchronized void appendTo(@NonNull StringBuilder output) {
+        if (mData == null) close();
+
+        if (!isTruncated()) {
+            output.append(new String(mData, StandardCharsets.UTF_8));
+            return;
+        }
+
+        // Do not split a character between the head and tail
+        int headEnd = mHeadSize;
+        int continuationCount = 0;
+        while (headEnd - continuationCount > 0 && continuationCount < 3 && (mData[headEnd - continuationCount - 1] & 0xC0) == 0x80)
+            continuationCount++;
+        if (headEnd - continuationCount > 0) {
+            int lead = mData[headEnd - continuationCount - 1] & 0xFF;
+            int sequenceLength = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+            if (sequenceLength > continuationCount + 1)
+                headEnd -= continuationCount + 1;
+        }
+        int tailStart = mHeadSize;
+        while (tailStart < mData.length && tailStart < mHeadSize + 3 && (mData[tailStart] & 0xC0) == 0x80)
+            tailStart++;
+
+        output.append(new String(mData, 0, headEnd, StandardCharsets.UTF_8));
+        if (headEnd > 0 && mData[headEnd - 1] != '\n')
+            output.append("\n");
+        String spillFilePath = getSpillFilePath();
+        output.append(String.format(Locale.ENGLISH, "[... %d bytes truncated%s ...]\n", mSize - mData.length,
+            spillFilePath != null ? ", full output in \"" + spillFilePath + "\"" : ""));
+        output.append(new String(mData, tailStart, mData.length - tailStart, StandardCharsets.UTF_8));
+    }
+
+}
@@ -0,0 +1,127 @@
+package com.termux.shared.shell.command.result;
+
+import android.os.Bundle;
+
+import androidx.annotation.NonNull;
+import androidx.annotation.Nullable;
+
+import java.io.Serializable;
+import java.util.Locale;
+
+/**
+ * The resources used by the process of a command, as reported by {@code wait4()} when it was
+ * reaped, and the time it ran for.
+ *
+ * The resource usage is only known if the process was reaped by the app, like by the native
+ * {@link com.termux.shared.shell.command.runner.app.AppShell} runner or for a
+ * {@link com.termux.terminal.TerminalSession}. Processes reaped by the framework for
+ * {@link Process}, only have their {@link #wallTimeMillis} set and the other fields are {@code -1}.
+ */
+public class ResourceUsage implements Serializable {
+
+    /* The fields of the usage array of native. These must be kept in sync with the
+     * RUSAGE_FIELD_* constants of posix.cpp and the format of JNI.waitFor() of termux.c. */
+    static final int FIELD_USER_CPU_TIME_MICROS = 0;
+    static final int FIELD_SYSTEM_CPU_TIME_MICROS = 1;
+    static final int FIELD_MAX_RSS_KB = 2;
+    static final int FIELD_VOLUNTARY_CONTEXT_SWITCHES = 3;
+    static final int FIELD_INVOLUNTARY_CONTEXT_SWITCHES = 4;
+    static final int FIELD_COUNT = 5;
+
+    /** The {@link Bundle} key for {@link #userCpuTimeMillis}. */
+    public static final String KEY_USER_CPU_TIME_MILLIS = "user_cpu_time_ms"; // Default: "user_cpu_time_ms"
+    /** The {@link Bundle} key for {@link #systemCpuTimeMillis}. */
+    public static final String KEY_SYSTEM_CPU_TIME_MILLIS = "system_cpu_time_ms"; // Default: "system_cpu_time_ms"
+    /** The {@link Bundle} key for {@link #maxRssKb}. */
+    public static final String KEY_MAX_RSS_KB = "max_rss_kb"; // Default: "max_rss_kb"
+    /** The {@link Bundle} key for {@link #wallTimeMillis}. */
+    public static final String KEY_WALL_TIME_MILLIS = "wall_time_ms"; // Default: "wall_time_ms"
+    /** The {@link Bundle} key for {@link #voluntaryContextSwitches}. */
+    public static final String KEY_VOLUNTARY_CONTEXT_SWITCHES = "voluntary_context_switches"; // Default: "voluntary_context_switches"
+    /** The {@link Bundle} key for {@link #involuntaryContextSwitches}. */
+    public static final String KEY_INVOLUNTARY_CONTEXT_SWITCHES = "involuntary_context_switches"; // Default: "involuntary_context_switches"
+
+    /** The user CPU time in milliseconds, or {@code -1} if unknown. */
+    public final long userCpuTimeMillis;
+    /** The system CPU time in milliseconds, or {@code -1} if unknown. */
+    public final long systemCpuTimeMillis;
+    /** The max resident set size in KiB, or {@code -1} if unknown. */
+    public final long maxRssKb;
+    /** The time in milliseconds from the start of the process until it exited. */
+    public final long wallTimeMillis;
+    /** The number of voluntary context switches, or {@code -1} if unknown. */
+    public final long voluntaryContextSwitches;
+    /** The number of involuntary context switches, or {@code -1} if unknown. */
+    public final long involuntaryContextSwitches;
+
+    public ResourceUsage(long userCpuTimeMillis, long systemCpuTimeMillis, long maxRssKb, long wallTimeMillis,
+                         long voluntaryContextSwitches, long involuntaryContextSwitches) {
+        this.userCpuTimeMillis = userCpuTimeMillis;
+        this.systemCpuTimeMillis = systemCpuTimeMillis;
+        this.maxRssKb = maxRssKb;
+        this.wallTimeMillis = wallTimeMillis;
+        this.voluntaryContextSwitches = voluntaryContextSwitches;
+        this.involuntaryContextSwitches = involuntaryContextSwitches;
+    }
+
+    /**
+     * Get a {@link ResourceUsage} for the usage array of native.
+     *
+     * @param usage The usage array with the {@code FIELD_*} fields. If {@code null} or too short,
+     *              then only the wall time is set.
+     * @param wallTimeMillis The time in milliseconds from the start of the process until it exited.
+     * @return Returns the {@link ResourceUsage}.
+     */
+    @NonNull
+    public static ResourceUsage of(@Nullable long[] usage, long wallTimeMillis) {
+        if (usage == null || usage.length < FIELD_COUNT)
+            return ofWallTime(wallTimeMillis);
+
+        return new ResourceUsage(usage[FIELD_USER_CPU_TIME_MICROS] / 1000, usage[FIELD_SYSTEM_CPU_TIME_MICROS] / 1000,
+            usage[FIELD_MAX_RSS_KB], wallTimeMillis,
+            usage[FIELD_VOLUNTARY_CONTEXT_SWITCHES], usage[FIELD_INVOLUNTARY_CONTEXT_SWITCHES]);
+    }
+
+    /** Get a {@link ResourceUsage} with only the wall time known. */
+    @NonNull
+    public static ResourceUsage ofWallTime(long wallTimeMillis) {
+        return new ResourceUsage(-1, -1, -1, wallTimeMillis, -1, -1);
+    }
+
+    /** Check whether the {@code wait4()} usage of the process is known, and not just its wall time. */
+    public boolean hasProcessUsage() {
+        return userCpuTimeMillis >= 0;
+    }
+
+    /** Get a {@link Bundle} with the known fields, to be sent with the result of the command. */
+    @NonNull
+    public Bundle toBundle() {
+        Bundle bundle = new Bundle();
+        bundle.putLong(KEY_WALL_TIME_MILLIS, wallTimeMillis);
+        if (hasProcessUsage()) {
+            bundle.putLong(KEY_USER_CPU_TIME_MILLIS, userCpuTimeMillis);
+            bundle.putLong(KEY_SYSTEM_CPU_TIME_MILLIS, systemCpuTimeMillis);
+            bundle.putLong(KEY_MAX_RSS_KB, maxRssKb);
+            bundle.putLong(KEY_VOLUNTARY_CONTEXT_SWITCHES, voluntaryContextSwitches);
+            bundle.putLong(KEY_INVOLUNTARY_CONTEXT_SWITCHES, involuntaryContextSwitches);
+        }
+        return bundle;
+    }
+
+    /** Get a single line {@link String} with the known fields, like "cpu=12ms user + 3ms sys, wall=20ms, ...". */
+    @NonNull
+    public String toSingleLineString() {
+        if (!hasProcessUsage())
+            return String.format(Locale.ENGLISH, "wall=%dms", wallTimeMillis);
+
+        return String.format(Locale.ENGLISH, "cpu=%dms user + %dms sys, wall=%dms, max_rss=%dKiB, ctx_switches=%d voluntary + %d involuntary",
+            userCpuTimeMillis, systemCpuTimeMillis, wallTimeMillis, maxRssKb, voluntaryContextSwitches, involuntaryContextSwitches);
+    }
+
+    @NonNull
+    @Override
+    public String toString() {
+        return toSingleLineString();
+    }
+
+}
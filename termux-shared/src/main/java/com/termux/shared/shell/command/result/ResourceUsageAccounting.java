@@ -0,0 +1,130 @@
+package com.termux.shared.shell.command.result;
+
+import androidx.annotation.NonNull;
+import androidx.annotation.Nullable;
+
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.HashMap;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Locale;
+import java.util.Map;
+
+/**
+ * The {@link ResourceUsage} of commands aggregated per caller, like the package name of the app
+ * that sent them, so that expensive automation can be found.
+ */
+public class ResourceUsageAccounting {
+
+    /** The aggregated {@link ResourceUsage} of the commands of a caller. */
+    public static final class Totals {
+        /** The number of commands. */
+        public long commandCount;
+        /** The number of commands whose {@link ResourceUsage#hasProcessUsage()} is known, which
+         * the CPU time, RSS and context switches totals are for. */
+        public long processUsageCount;
+        /** The total user CPU time in milliseconds. */
+        public long userCpuTimeMillis;
+        /** The total system CPU time in milliseconds. */
+        public long systemCpuTimeMillis;
+        /** The total wall time in milliseconds. */
+        public long wallTimeMillis;
+        /** The max of the max resident set size in KiB. */
+        public long maxRssKb;
+        /** The total number of voluntary context switches. */
+        public long voluntaryContextSwitches;
+        /** The total number of involuntary context switches. */
+        public long involuntaryContextSwitches;
+
+        void add(@NonNull ResourceUsage resourceUsage) {
+            commandCount++;
+            wallTimeMillis += resourceUsage.wallTimeMillis;
+            if (!resourceUsage.hasProcessUsage()) return;
+            processUsageCount++;
+            userCpuTimeMillis += resourceUsage.userCpuTimeMillis;
+            systemCpuTimeMillis += resourceUsage.systemCpuTimeMillis;
+            maxRssKb = Math.max(maxRssKb, resourceUsage.maxRssKb);
+            voluntaryContextSwitches += resourceUsage.voluntaryContextSwitches;
+            involuntaryContextSwitches += resourceUsage.involuntaryContextSwitches;
+        }
+
+        @NonNull
+        Totals copy() {
+            Totals totals = new Totals();
+            totals.commandCount = commandCount;
+            totals.processUsageCount = processUsageCount;
+            totals.userCpuTimeMillis = userCpuTimeMillis;
+            totals.systemCpuTimeMillis = systemCpuTimeMillis;
+            totals.wallTimeMillis = wallTimeMillis;
+            totals.maxRssKb = maxRssKb;
+            totals.voluntaryContextSwitches = voluntaryContextSwitches;
+            totals.involuntaryContextSwitches = involuntaryContextSwitches;
+            return totals;
+        }
+
+        /** Get the total user and system CPU time in milliseconds. */
+        public long getCpuTimeMillis() {
+            return userCpuTimeMillis + systemCpuTimeMillis;
+        }
+
+        @NonNull
+        @Override
+        public String toString() {
+            return String.format(Locale.ENGLISH, "commands=%d, cpu=%dms user + %dms sys, wall=%dms, max_rss=%dKiB, ctx_switches=%d voluntary + %d involuntary",
+                commandCount, userCpuTimeMillis, systemCpuTimeMillis, wallTimeMillis, maxRssKb, voluntaryContextSwitches, involuntaryContextSwitches);
+        }
+    }
+
+    private final Map<String, Totals> mTotals = new HashMap<>();
+
+    /**
+     * Add the {@link ResourceUsage} of a command to the {@link Totals} of its caller.
+     *
+     * @param caller The caller of the command.
+     * @param resourceUsage The {@link ResourceUsage} of the command. If {@code null}, like if its
+     *                      process was never started, then it is ignored.
+     */
+    public synchronized void add(@NonNull String caller, @Nullable ResourceUsage resourceUsage) {
+        if (resourceUsage == null) return;
+        Totals totals = mTotals.get(caller);
+        if (totals == null) {
+            totals = new Totals();
+            mTotals.put(caller, totals);
+        }
+        totals.add(resourceUsage);
+    }
+
+    /** Get a copy of the {@link Totals} of {@code caller}, or {@code null} if it has no commands. */
+    @Nullable
+    public synchronized Totals get(@NonNull String caller) {
+        Totals totals = mTotals.get(caller);
+        return totals != null ? totals.copy() : null;
+    }
+
+    /** Get a copy of the {@link Totals} of all callers, ordered by their CPU time, highest first. */
+    @NonNull
+    public synchronized Map<String, Totals> getAll() {
+        List<Map.Entry<String, Totals>> entries = new ArrayList<>(mTotals.entrySet());
+        Collections.sort(entries, (a, b) -> Long.compare(b.getValue().getCpuTimeMillis(), a.getValue().getCpuTimeMillis()));
+        Map<String, Totals> totals = new LinkedHashMap<>();
+        for (Map.Entry<String, Totals> entry : entries)
+            totals.put(entry.getKey(), entry.getValue().copy());
+        return totals;
+    }
+
+    /** Get a log friendly {@link String} with the {@link Totals} of all callers, one per line. */
+    @NonNull
+    public String getLogString() {
+        Map<String, Totals> totals = getAll();
+        if (totals.isEmpty()) return "-";
+
+        StringBuilder logString = new StringBuilder();
+        for (Map.Entry<String, Totals> entry : totals.entrySet()) {
+            if (logString.length() > 0) logString.append("\n");
+            logString.append(entry.getKey()).append(": ").append(entry.getValue());
+        }
+        return logString.toString();
+    }
+
+}
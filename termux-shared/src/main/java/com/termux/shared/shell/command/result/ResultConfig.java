@@ -30,6 +30,14 @@ public class ResultConfig {
     public String resultStdoutOriginalLengthKey;
     /** The key with which to send original length of {@link ResultData#stderr} in {@link #resultPendingIntent}. */
     public String resultStderrOriginalLengthKey;
+    /** The key with which to send {@link ResultData#stdoutFilePath} in {@link #resultPendingIntent},
+     * which is only sent if its creator has the same uid as the app and so can read the file. */
+    public String resultStdoutFilePathKey;
+    /** The key with which to send {@link ResultData#stderrFilePath} in {@link #resultPendingIntent},
+     * which is only sent if its creator has the same uid as the app and so can read the file. */
+    public String resultStderrFilePathKey;
+    /** The key with which to send {@link ResultData#resourceUsage} as a {@link android.os.Bundle} in {@link #resultPendingIntent}. */
+    public String resultResourceUsageKey;
 
 
     /** Defines the directory path in which to write the result of the command. */
@@ -115,6 +123,12 @@ public class ResultConfig {
             resultPendingIntentVariablesString.append("\n").append(Logger.getSingleLineLogStringEntry("Result Stdout Original Length Key", resultStdoutOriginalLengthKey, "-"));
         if (!ignoreNull || resultStderrOriginalLengthKey != null)
             resultPendingIntentVariablesString.append("\n").append(Logger.getSingleLineLogStringEntry("Result Stderr Original Length Key", resultStderrOriginalLengthKey, "-"));
+        if (!ignoreNull || resultStdoutFilePathKey != null)
+            resultPendingIntentVariablesString.append("\n").append(Logger.getSingleLineLogStringEntry("Result Stdout File Path Key", resultStdoutFilePathKey, "-"));
+        if (!ignoreNull || resultStderrFilePathKey != null)
+            resultPendingIntentVariablesString.append("\n").append(Logger.getSingleLineLogStringEntry("Result Stderr File Path Key", resultStderrFilePathKey, "-"));
+        if (!ignoreNull || resultResourceUsageKey != null)
+            resultPendingIntentVariablesString.append("\n").append(Logger.getSingleLineLogStringEntry("Result Resource Usage Key", resultResourceUsageKey, "-"));
 
         return resultPendingIntentVariablesString.toString();
     }
@@ -19,8 +19,20 @@ public class ResultData implements Serializable {
     public final StringBuilder stdout = new StringBuilder();
     /** The stderr of command. */
     public final StringBuilder stderr = new StringBuilder();
+    /** The path of the file with the full stdout of command if it was larger than the max size
+     * kept in memory, in which case {@link #stdout} only has its head and tail. */
+    public String stdoutFilePath;
+    /** The path of the file with the full stderr of command if it was larger than the max size
+     * kept in memory, in which case {@link #stderr} only has its head and tail. */
+    public String stderrFilePath;
+    /** The size in bytes of the full stdout of command if {@link #stdout} was truncated. */
+    public Long stdoutOriginalSize;
+    /** The size in bytes of the full stderr of command if {@link #stderr} was truncated. */
+    public Long stderrOriginalSize;
     /** The exit code of command. */
     public Integer exitCode;
+    /** The {@link ResourceUsage} of the process of command if it was started. */
+    public ResourceUsage resourceUsage;
 
     /** The internal errors list of command. */
     public List<Error> errorsList =  new ArrayList<>();
@@ -50,6 +62,17 @@ public class ResultData implements Serializable {
         return stdout.append(message).append("\n");
     }
 
+    /** Append the output of {@code capture} to {@link #stdout}, and set {@link #stdoutFilePath}
+     * and {@link #stdoutOriginalSize} if it was truncated. */
+    public StringBuilder appendStdout(@NonNull OutputCapture capture) {
+        capture.appendTo(stdout);
+        if (capture.isTruncated()) {
+            stdoutFilePath = capture.getSpillFilePath();
+            stdoutOriginalSize = capture.getSize();
+        }
+        return stdout;
+    }
+
 
     public void clearStderr() {
         stderr.setLength(0);
@@ -71,6 +94,17 @@ public class ResultData implements Serializable {
         return stderr.append(message).append("\n");
     }
 
+    /** Append the output of {@code capture} to {@link #stderr}, and set {@link #stderrFilePath}
+     * and {@link #stderrOriginalSize} if it was truncated. */
+    public StringBuilder appendStderr(@NonNull OutputCapture capture) {
+        capture.appendTo(stderr);
+        if (capture.isTruncated()) {
+            stderrFilePath = capture.getSpillFilePath();
+            stderrOriginalSize = capture.getSize();
+        }
+        return stderr;
+    }
+
 
     public synchronized boolean setStateFailed(@NonNull Error error) {
         return setStateFailed(error.getType(), error.getCode(), error.getMessage(), null);
@@ -146,6 +180,7 @@ public class ResultData implements Serializable {
             logString.append("\n").append(resultData.getStderrLogString());
         }
         logString.append("\n").append(resultData.getExitCodeLogString());
+        logString.append("\n").append(resultData.getResourceUsageLogString());
 
         logString.append("\n\n").append(getErrorsListLogString(resultData));
 
@@ -172,6 +207,10 @@ public class ResultData implements Serializable {
         return Logger.getSingleLineLogStringEntry("Exit Code", exitCode, "-");
     }
 
+    public String getResourceUsageLogString() {
+        return Logger.getSingleLineLogStringEntry("Resource Usage", resourceUsage, "-");
+    }
+
     public static String getErrorsListLogString(final ResultData resultData) {
         if (resultData == null) return "null";
 
@@ -212,6 +251,7 @@ public class ResultData implements Serializable {
             markdownString.append("\n").append(MarkdownUtils.getMultiLineMarkdownStringEntry("Stderr", resultData.stderr.toString(), "-"));
 
         markdownString.append("\n").append(MarkdownUtils.getSingleLineMarkdownStringEntry("Exit Code", resultData.exitCode, "-"));
+        markdownString.append("\n").append(MarkdownUtils.getSingleLineMarkdownStringEntry("Resource Usage", resultData.resourceUsage, "-"));
 
         markdownString.append("\n\n").append(getErrorsListMarkdownString(resultData));
 
@@ -5,6 +5,7 @@ import android.app.PendingIntent;
 import android.content.Context;
 import android.content.Intent;
 import android.os.Bundle;
+import android.os.Process;
 
 import com.termux.shared.R;
 import com.termux.shared.data.DataUtils;
@@ -26,6 +27,10 @@ public class ResultSender {
      * {@link ResultConfig#resultDirectoryPath}. If both are not {@code null}, then result will be
      * sent via both.
      *
+     * The spill files of {@link ResultData#stdoutFilePath} and {@link ResultData#stderrFilePath}
+     * whose paths cannot be sent to the caller are deleted afterwards, since the caller cannot
+     * read them from the private app cache directory.
+     *
      * @param context The {@link Context} for operations.
      * @param logTag The log tag to use for logging.
      * @param label The label for the command.
@@ -39,18 +44,60 @@ public class ResultSender {
         if (context == null || resultConfig == null || resultData == null)
             return FunctionErrno.ERRNO_NULL_OR_EMPTY_PARAMETERS.getError("context, resultConfig or resultData", "sendCommandResultData");
 
-        Error error;
+        Error error = null;
 
-        if (resultConfig.resultPendingIntent != null) {
+        if (resultConfig.resultPendingIntent != null)
             error = sendCommandResultDataWithPendingIntent(context, logTag, label, resultConfig, resultData, logStdoutAndStderr);
-            if (error != null || resultConfig.resultDirectoryPath == null)
-                return error;
+
+        if (error == null) {
+            if (resultConfig.resultDirectoryPath != null)
+                error = sendCommandResultDataToDirectory(context, logTag, label, resultConfig, resultData, logStdoutAndStderr);
+            else if (resultConfig.resultPendingIntent == null)
+                error = FunctionErrno.ERRNO_UNSET_PARAMETERS.getError("resultConfig.resultPendingIntent or resultConfig.resultDirectoryPath", "sendCommandResultData");
         }
 
-        if (resultConfig.resultDirectoryPath != null) {
-            return sendCommandResultDataToDirectory(context, logTag, label, resultConfig, resultData, logStdoutAndStderr);
-        } else {
-            return FunctionErrno.ERRNO_UNSET_PARAMETERS.getError("resultConfig.resultPendingIntent or resultConfig.resultDirectoryPath", "sendCommandResultData");
+        // The spill files moved to the result directory no longer exist, so this only deletes the
+        // ones that were not sent, like if the result directory was not used or failed
+        boolean sendSpillFilePaths = shouldSendSpillFilePaths(resultConfig);
+        deleteSpillFiles(logTag, resultData,
+            !sendSpillFilePaths || resultConfig.resultStdoutFilePathKey == null,
+            !sendSpillFilePaths || resultConfig.resultStderrFilePathKey == null);
+
+        return error;
+    }
+
+    /**
+     * Check whether the paths of the spill files should be sent with {@link ResultConfig#resultPendingIntent}.
+     * The spill files are in the private app cache directory, so their paths are only sent to
+     * creators that run with the app uid, like the plugin apps with the shared user id.
+     */
+    private static boolean shouldSendSpillFilePaths(ResultConfig resultConfig) {
+        return resultConfig.resultPendingIntent != null && resultConfig.resultPendingIntent.getCreatorUid() == Process.myUid();
+    }
+
+    /**
+     * Delete the spill files of {@link ResultData#stdoutFilePath} and {@link ResultData#stderrFilePath},
+     * like for commands whose caller does not want the result, and unset their paths.
+     *
+     * @param logTag The log tag to use for logging.
+     * @param resultData The {@link ResultData} object containing result data.
+     * @param deleteStdout Set to {@code true} if the stdout spill file should be deleted.
+     * @param deleteStderr Set to {@code true} if the stderr spill file should be deleted.
+     */
+    public static void deleteSpillFiles(String logTag, ResultData resultData, boolean deleteStdout, boolean deleteStderr) {
+        if (resultData == null) return;
+        logTag = DataUtils.getDefaultIfNull(logTag, LOG_TAG);
+
+        Error error;
+        if (deleteStdout && resultData.stdoutFilePath != null) {
+            error = FileUtils.deleteRegularFile("stdout spill file", resultData.stdoutFilePath, true);
+            if (error != null) Logger.logErrorExtended(logTag, error.toString());
+            resultData.stdoutFilePath = null;
+        }
+        if (deleteStderr && resultData.stderrFilePath != null) {
+            error = FileUtils.deleteRegularFile("stderr spill file", resultData.stderrFilePath, true);
+            if (error != null) Logger.logErrorExtended(logTag, error.toString());
+            resultData.stderrFilePath = null;
         }
     }
 
@@ -80,8 +127,9 @@ public class ResultSender {
         String truncatedStdout = null;
         String truncatedStderr = null;
 
-        String stdoutOriginalLength = String.valueOf(resultDataStdout.length());
-        String stderrOriginalLength = String.valueOf(resultDataStderr.length());
+        // If the output was truncated, then report the size in bytes of the full output
+        String stdoutOriginalLength = String.valueOf(resultData.stdoutOriginalSize != null ? resultData.stdoutOriginalSize : resultDataStdout.length());
+        String stderrOriginalLength = String.valueOf(resultData.stderrOriginalSize != null ? resultData.stderrOriginalSize : resultDataStderr.length());
 
         // Truncate stdout and stdout to max TRANSACTION_SIZE_LIMIT_IN_BYTES
         if (resultDataStderr.isEmpty()) {
@@ -125,8 +173,15 @@ public class ResultSender {
         resultBundle.putString(resultConfig.resultStdoutOriginalLengthKey, stdoutOriginalLength);
         resultBundle.putString(resultConfig.resultStderrKey, resultDataStderr);
         resultBundle.putString(resultConfig.resultStderrOriginalLengthKey, stderrOriginalLength);
+        boolean sendSpillFilePaths = shouldSendSpillFilePaths(resultConfig);
+        if (sendSpillFilePaths && resultConfig.resultStdoutFilePathKey != null && resultData.stdoutFilePath != null)
+            resultBundle.putString(resultConfig.resultStdoutFilePathKey, resultData.stdoutFilePath);
+        if (sendSpillFilePaths && resultConfig.resultStderrFilePathKey != null && resultData.stderrFilePath != null)
+            resultBundle.putString(resultConfig.resultStderrFilePathKey, resultData.stderrFilePath);
         if (resultData.exitCode != null)
             resultBundle.putInt(resultConfig.resultExitCodeKey, resultData.exitCode);
+        if (resultConfig.resultResourceUsageKey != null && resultData.resourceUsage != null)
+            resultBundle.putBundle(resultConfig.resultResourceUsageKey, resultData.resourceUsage.toBundle());
         resultBundle.putInt(resultConfig.resultErrCodeKey, resultData.getErrCode());
         resultBundle.putString(resultConfig.resultErrmsgKey, resultDataErrmsg);
 
@@ -278,10 +333,15 @@ public class ResultSender {
             // Write result to result files under resultDirectoryPath
 
             // Write stdout to file
+            // If the full stdout was spilled to a file, then move it instead of writing the truncated stdout
             if (!resultDataStdout.isEmpty()) {
                 filename = RESULT_SENDER.RESULT_FILE_STDOUT_PREFIX + resultConfig.resultFilesSuffix;
-                error = FileUtils.writeTextToFile(filename, resultConfig.resultDirectoryPath + "/" + filename,
-                    null, resultDataStdout, false);
+                if (resultData.stdoutFilePath != null)
+                    error = FileUtils.moveRegularFile(filename, resultData.stdoutFilePath,
+                        resultConfig.resultDirectoryPath + "/" + filename, false);
+                else
+                    error = FileUtils.writeTextToFile(filename, resultConfig.resultDirectoryPath + "/" + filename,
+                        null, resultDataStdout, false);
                 if (error != null) {
                     return error;
                 }
@@ -290,8 +350,12 @@ public class ResultSender {
             // Write stderr to file
             if (!resultDataStderr.isEmpty()) {
                 filename = RESULT_SENDER.RESULT_FILE_STDERR_PREFIX + resultConfig.resultFilesSuffix;
-                error = FileUtils.writeTextToFile(filename, resultConfig.resultDirectoryPath + "/" + filename,
-                    null, resultDataStderr, false);
+                if (resultData.stderrFilePath != null)
+                    error = FileUtils.moveRegularFile(filename, resultData.stderrFilePath,
+                        resultConfig.resultDirectoryPath + "/" + filename, false);
+                else
+                    error = FileUtils.writeTextToFile(filename, resultConfig.resultDirectoryPath + "/" + filename,
+                        null, resultDataStderr, false);
                 if (error != null) {
                     return error;
                 }
@@ -1,6 +1,7 @@
 package com.termux.shared.shell.command.runner.app;
 
 import android.content.Context;
+import android.os.SystemClock;
 import android.system.ErrnoException;
 import android.system.Os;
 import android.system.OsConstants;
@@ -13,13 +14,14 @@ import com.termux.shared.R;
 import com.termux.shared.data.DataUtils;
 import com.termux.shared.shell.command.ExecutionCommand;
 import com.termux.shared.shell.command.environment.ShellEnvironmentUtils;
+import com.termux.shared.shell.command.result.OutputCapture;
+import com.termux.shared.shell.command.result.ResourceUsage;
 import com.termux.shared.shell.command.result.ResultData;
 import com.termux.shared.errors.Errno;
 import com.termux.shared.logger.Logger;
 import com.termux.shared.shell.command.ExecutionCommand.ExecutionState;
 import com.termux.shared.shell.command.environment.IShellEnvironment;
 import com.termux.shared.shell.ShellUtils;
-import com.termux.shared.shell.StreamGobbler;
 
 import java.io.DataOutputStream;
 import java.io.File;
@@ -28,21 +30,25 @@ import java.nio.charset.StandardCharsets;
 import java.util.Collections;
 import java.util.HashMap;
 import java.util.List;
+import java.util.Locale;
+import java.util.concurrent.CountDownLatch;
 
 /**
- * A class that maintains info for background app shells run with {@link Runtime#exec(String[], String[], File)}.
- * It also provides a way to link each {@link Process} with the {@link ExecutionCommand}
+ * A class that maintains info for background app shells run with {@link NativeProcessRunner}, or
+ * with {@link Runtime#exec(String[], String[], File)} if it is not supported.
+ * It also provides a way to link each process with the {@link ExecutionCommand}
  * that started it. The shell is run in the app user context.
  */
 public final class AppShell {
 
+    /** The {@link Process} if the shell was run with {@link Runtime#exec(String[], String[], File)}. */
     private final Process mProcess;
     private final ExecutionCommand mExecutionCommand;
     private final AppShellClient mAppShellClient;
 
     private static final String LOG_TAG = "AppShell";
 
-    private AppShell(@NonNull final Process process, @NonNull final ExecutionCommand executionCommand,
+    private AppShell(@Nullable final Process process, @NonNull final ExecutionCommand executionCommand,
                      final AppShellClient appShellClient) {
         this.mProcess = process;
         this.mExecutionCommand = executionCommand;
@@ -50,7 +56,8 @@ public final class AppShell {
     }
 
     /**
-     * Start execution of an {@link ExecutionCommand} with {@link Runtime#exec(String[], String[], File)}.
+     * Start execution of an {@link ExecutionCommand} with {@link NativeProcessRunner}, or with
+     * {@link Runtime#exec(String[], String[], File)} if it is not supported.
      *
      * The {@link ExecutionCommand#executable}, must be set.
      * The  {@link ExecutionCommand#commandLabel}, {@link ExecutionCommand#arguments} and
@@ -125,6 +132,13 @@ public final class AppShell {
         Logger.logVerboseExtended(LOG_TAG, "\"" + executionCommand.getCommandIdAndLabelLogString() + "\" AppShell Environment:\n" +
             Joiner.on("\n").join(environmentArray));
 
+        // Spawn the process with the native runner if possible, so that no threads are needed for it.
+        // Runtime.exec() also searches PATH for relative executables.
+        NativeProcessRunner nativeProcessRunner = commandArray[0].startsWith("/") ? NativeProcessRunner.getInstance() : null;
+        if (nativeProcessRunner != null)
+            return executeNative(currentPackageContext, nativeProcessRunner, executionCommand, appShellClient,
+                commandArray, environmentArray, isSynchronous);
+
         // Exec the process
         final Process process;
         try {
@@ -158,6 +172,102 @@ public final class AppShell {
         return appShell;
     }
 
+    /**
+     * Spawn the process of the {@link ExecutionCommand} with the {@link NativeProcessRunner}, which
+     * writes the stdin and collects the stdout and stderr of the process on its thread.
+     *
+     * If the process finishes, then {@link #onNativeProcessExited(int, int, ResourceUsage, OutputCapture, OutputCapture)} is
+     * called on the runner thread, or if {@code isSynchronous} is {@code true}, then this waits for it.
+     */
+    private static AppShell executeNative(@NonNull final Context context, @NonNull NativeProcessRunner nativeProcessRunner,
+                                          @NonNull ExecutionCommand executionCommand, final AppShellClient appShellClient,
+                                          @NonNull String[] commandArray, @NonNull String[] environmentArray,
+                                          final boolean isSynchronous) {
+        final AppShell appShell = new AppShell(null, executionCommand, appShellClient);
+        executionCommand.resultData.exitCode = null;
+
+        byte[] stdin = null;
+        if (!DataUtils.isNullOrEmpty(executionCommand.stdin))
+            stdin = (executionCommand.stdin + "\n").getBytes(StandardCharsets.UTF_8);
+
+        final CountDownLatch exitLatch = isSynchronous ? new CountDownLatch(1) : null;
+        int pid;
+        try {
+            pid = nativeProcessRunner.spawn(commandArray, environmentArray, executionCommand.workingDirectory, stdin,
+                executionCommand.maxOutputSize, OutputCapture.getSpillDirectory(context),
+                (exitedPid, exitCode, resourceUsage, stdout, stderr) -> {
+                    appShell.onNativeProcessExited(exitedPid, exitCode, resourceUsage, stdout, stderr);
+                    if (exitLatch != null) exitLatch.countDown();
+                });
+        } catch (com.termux.shared.file.libcore.ErrnoException e) {
+            executionCommand.setStateFailed(Errno.ERRNO_FAILED.getCode(), context.getString(R.string.error_failed_to_execute_app_shell_command, executionCommand.getCommandIdAndLabelLogString()), e);
+            AppShell.processAppShellResult(null, executionCommand);
+            return null;
+        }
+
+        executionCommand.mPid = pid;
+        Logger.logDebug(LOG_TAG, "Running \"" + executionCommand.getCommandIdAndLabelLogString() + "\" AppShell with pid " + pid);
+
+        if (exitLatch != null) {
+            try {
+                exitLatch.await();
+            } catch (InterruptedException e) {
+                // Restore the interrupt for the caller and kill the process, since its result
+                // cannot be returned anymore
+                Thread.currentThread().interrupt();
+                if (!executionCommand.hasExecuted() &&
+                    executionCommand.setStateFailed(Errno.ERRNO_FAILED.getCode(), context.getString(R.string.error_app_shell_command_wait_interrupted, executionCommand.getCommandIdAndLabelLogString()), e)) {
+                    executionCommand.resultData.exitCode = 137; // SIGKILL
+                    AppShell.processAppShellResult(appShell, null);
+                }
+                appShell.kill();
+            }
+        }
+
+        return appShell;
+    }
+
+    /**
+     * Called on a {@link NativeProcessRunner} exit listener thread when the process has exited. Sets
+     * {@link ResultData#stdout}, {@link ResultData#stderr}, {@link ResultData#exitCode} and
+     * {@link ResultData#resourceUsage} like {@link #executeInner(Context)}.
+     */
+    private void onNativeProcessExited(int pid, int exitCode, @NonNull ResourceUsage resourceUsage,
+                                       @NonNull OutputCapture stdout, @NonNull OutputCapture stderr) {
+        if (pid > 0)
+            mExecutionCommand.mPid = pid;
+        mExecutionCommand.resultData.resourceUsage = resourceUsage;
+
+        appendOutput(mExecutionCommand.mPid + "-stdout", stdout, true);
+        appendOutput(mExecutionCommand.mPid + "-stderr", stderr, false);
+
+        processExit(exitCode);
+    }
+
+    /**
+     * Append the output of the process to the result, ending with a newline if it does not
+     * already. The output is only split into lines if it is logged.
+     */
+    private void appendOutput(@NonNull String streamName, @NonNull OutputCapture capture, boolean isStdout) {
+        ResultData resultData = mExecutionCommand.resultData;
+        StringBuilder result = isStdout ? resultData.stdout : resultData.stderr;
+        int start = result.length();
+        if (isStdout)
+            resultData.appendStdout(capture);
+        else
+            resultData.appendStderr(capture);
+        if (result.length() == start) return;
+
+        if (result.charAt(result.length() - 1) != '\n')
+            result.append("\n");
+
+        if (Logger.shouldEnableLoggingForCustomLogLevel(mExecutionCommand.backgroundCustomLogLevel)) {
+            String defaultLogTag = Logger.getDefaultLogTag();
+            for (String line : result.substring(start).split("\n"))
+                Logger.logVerboseForce(defaultLogTag + "Command", String.format(Locale.ENGLISH, "[%s] %s", streamName, line)); // This will get truncated by LOGGER_ENTRY_MAX_LEN, likely 4KB
+        }
+    }
+
     /**
      * Sets up stdout and stderr readers for the {@link #mProcess} and waits for the process to end.
      *
@@ -168,20 +278,24 @@ public final class AppShell {
      * @param context The {@link Context} for operations.
      */
     private void executeInner(@NonNull final Context context) throws IllegalThreadStateException, InterruptedException {
+        long startTime = SystemClock.elapsedRealtime();
         mExecutionCommand.mPid = ShellUtils.getPid(mProcess);
 
         Logger.logDebug(LOG_TAG, "Running \"" + mExecutionCommand.getCommandIdAndLabelLogString() + "\" AppShell with pid " + mExecutionCommand.mPid);
 
         mExecutionCommand.resultData.exitCode = null;
 
-        // setup stdin, and stdout and stderr gobblers
+        // setup stdin, and stdout and stderr readers
         DataOutputStream STDIN = new DataOutputStream(mProcess.getOutputStream());
-        StreamGobbler STDOUT = new StreamGobbler(mExecutionCommand.mPid + "-stdout", mProcess.getInputStream(), mExecutionCommand.resultData.stdout, mExecutionCommand.backgroundCustomLogLevel);
-        StreamGobbler STDERR = new StreamGobbler(mExecutionCommand.mPid + "-stderr", mProcess.getErrorStream(), mExecutionCommand.resultData.stderr, mExecutionCommand.backgroundCustomLogLevel);
+        // Only the head and tail of large outputs are kept in memory, and the outputs are read in
+        // chunks instead of lines, so that a large output without newlines is bounded too
+        File spillDirectory = OutputCapture.getSpillDirectory(context);
+        OutputCapture stdoutCapture = new OutputCapture(mExecutionCommand.mPid + "-stdout", mExecutionCommand.maxOutputSize, spillDirectory);
+        OutputCapture stderrCapture = new OutputCapture(mExecutionCommand.mPid + "-stderr", mExecutionCommand.maxOutputSize, spillDirectory);
 
-        // start gobbling
-        STDOUT.start();
-        STDERR.start();
+        // start reading
+        Thread STDOUT = stdoutCapture.startReading(mProcess.getInputStream());
+        Thread STDERR = stderrCapture.startReading(mProcess.getErrorStream());
 
         if (!DataUtils.isNullOrEmpty(mExecutionCommand.stdin)) {
             try {
@@ -203,6 +317,8 @@ public final class AppShell {
                     mExecutionCommand.resultData.exitCode = 1;
                     AppShell.processAppShellResult(this, null);
                     kill();
+                    stdoutCapture.close();
+                    stderrCapture.close();
                     return;
                 }
             }
@@ -210,6 +326,8 @@ public final class AppShell {
 
         // wait for our process to finish, while we gobble away in the background
         int exitCode = mProcess.waitFor();
+        // The process is reaped by the framework, so only its wall time is known
+        mExecutionCommand.resultData.resourceUsage = ResourceUsage.ofWallTime(SystemClock.elapsedRealtime() - startTime);
 
         // make sure our threads are done gobbling
         // and the process is destroyed - while the latter shouldn't be
@@ -225,6 +343,20 @@ public final class AppShell {
         STDERR.join();
         mProcess.destroy();
 
+        stdoutCapture.close();
+        stderrCapture.close();
+        appendOutput(mExecutionCommand.mPid + "-stdout", stdoutCapture, true);
+        appendOutput(mExecutionCommand.mPid + "-stderr", stderrCapture, false);
+
+        processExit(exitCode);
+    }
+
+    /**
+     * Set the {@link ResultData#exitCode} of the exited process and call
+     * {@link #processAppShellResult(AppShell, ExecutionCommand)}, unless the execution command
+     * has already failed.
+     */
+    private void processExit(int exitCode) {
         // Process result
         if (exitCode == 0)
             Logger.logDebug(LOG_TAG, "The \"" + mExecutionCommand.getCommandIdAndLabelLogString() + "\" AppShell with pid " + mExecutionCommand.mPid + " exited normally");
@@ -278,7 +410,9 @@ public final class AppShell {
      * Kill this {@link AppShell} by sending a {@link OsConstants#SIGILL} to its {@link #mProcess}.
      */
     public void kill() {
-        int pid = ShellUtils.getPid(mProcess);
+        int pid = mProcess != null ? ShellUtils.getPid(mProcess) : mExecutionCommand.mPid;
+        // The pid is not known yet if the native runner has not returned from spawning the process
+        if (pid <= 0) return;
         try {
             // Send SIGKILL to process
             Os.kill(pid, OsConstants.SIGKILL);
@@ -325,6 +459,8 @@ public final class AppShell {
         }
     }
 
+    /** Get the {@link Process}, which is {@code null} if the shell was run with {@link NativeProcessRunner}. */
+    @Nullable
     public Process getProcess() {
         return mProcess;
     }
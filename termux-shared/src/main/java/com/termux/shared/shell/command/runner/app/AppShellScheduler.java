@@ -0,0 +1,396 @@
+package com.termux.shared.shell.command.runner.app;
+
+import android.os.SystemClock;
+
+import androidx.annotation.NonNull;
+import androidx.annotation.Nullable;
+
+import com.termux.shared.logger.Logger;
+
+import java.util.ArrayDeque;
+import java.util.ArrayList;
+import java.util.IdentityHashMap;
+import java.util.Iterator;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Locale;
+import java.util.Map;
+
+/**
+ * A scheduler that limits how many background {@link AppShell} commands run in parallel, so that
+ * a burst of commands, like from automation apps, does not fork dozens of processes at once and
+ * starve the foreground terminal sessions.
+ *
+ * Commands are submitted with a caller and a {@link Priority}. Queued {@link Priority#INTERACTIVE}
+ * commands are always started before queued {@link Priority#BATCH} commands, and one slot is kept
+ * for them if the max parallelism is more than 1, so that they never wait behind a full batch
+ * queue. Within a priority, the callers are served round-robin and the commands of each caller in
+ * FIFO order, so that one caller cannot delay the commands of others with a burst.
+ *
+ * Commands that have been running for longer than {@link #LONG_RUNNING_JOB_MILLIS}, like servers,
+ * no longer hold a slot, so that they cannot block queued commands forever. Since no command
+ * finishes when that happens, the owner must call {@link #checkLongRunningJobs()} after the delay
+ * it returns to start the queued commands in the released slots.
+ *
+ * The {@link Job} of a command is started on the thread that submitted it or that finished the
+ * command that freed its slot, which must then call {@link #onJobFinished(Object)} once the
+ * command has exited or failed to start.
+ */
+public final class AppShellScheduler {
+
+    /** The priority class of a command. */
+    public enum Priority {
+
+        /** Commands started by the user, like from widgets or shortcuts, that should run as soon as possible. */
+        INTERACTIVE("interactive"),
+
+        /** Commands started by automation that can be delayed, like from plugins. */
+        BATCH("batch");
+
+        private final String name;
+
+        Priority(final String name) {
+            this.name = name;
+        }
+
+        public String getName() {
+            return name;
+        }
+
+        /** Get {@link Priority} for {@code name} if found, otherwise {@code def}. */
+        @NonNull
+        public static Priority priorityOf(@Nullable String name, @NonNull Priority def) {
+            if (name == null) return def;
+            for (Priority v : Priority.values()) {
+                if (v.name.equals(name))
+                    return v;
+            }
+            return def;
+        }
+
+    }
+
+    /** The job that starts a command. */
+    public interface Job {
+        /**
+         * Start the command. {@link #onJobFinished(Object)} must be called for its key once it has
+         * exited, or right away if it could not be started.
+         */
+        void start();
+    }
+
+    /** A snapshot of the queueing metrics of the scheduler. */
+    public static final class Metrics {
+        /** The max number of commands run in parallel, or {@code 0} if unlimited. */
+        public int maxParallelism;
+        /** The number of commands running. */
+        public int runningCount;
+        /** The number of commands queued for each {@link Priority}, indexed by ordinal. */
+        public final int[] queuedCounts = new int[Priority.values().length];
+        /** The max number of commands queued at once since the scheduler was created. */
+        public int maxQueuedCount;
+        /** The number of commands started for each {@link Priority}. */
+        public final long[] startedCounts = new long[Priority.values().length];
+        /** The number of commands cancelled before they were started. */
+        public long cancelledCount;
+        /** The total time in milliseconds that the started commands of each {@link Priority} were queued. */
+        public final long[] totalWaitMillis = new long[Priority.values().length];
+        /** The max time in milliseconds that a started command of each {@link Priority} was queued. */
+        public final long[] maxWaitMillis = new long[Priority.values().length];
+
+        /** Get the average time in milliseconds that the started commands of {@code priority} were queued. */
+        public long getAverageWaitMillis(@NonNull Priority priority) {
+            long startedCount = startedCounts[priority.ordinal()];
+            return startedCount == 0 ? 0 : totalWaitMillis[priority.ordinal()] / startedCount;
+        }
+
+        @NonNull
+        @Override
+        public String toString() {
+            StringBuilder logString = new StringBuilder();
+            logString.append("Running: ").append(runningCount).append("/").append(maxParallelism == 0 ? "unlimited" : maxParallelism);
+            logString.append(", Max Queued: ").append(maxQueuedCount);
+            logString.append(", Cancelled: ").append(cancelledCount);
+            for (Priority priority : Priority.values()) {
+                int i = priority.ordinal();
+                logString.append(String.format(Locale.ENGLISH, ", %s: queued=%d started=%d wait avg=%dms max=%dms",
+                    priority.getName(), queuedCounts[i], startedCounts[i], getAverageWaitMillis(priority), maxWaitMillis[i]));
+            }
+            return logString.toString();
+        }
+    }
+
+    private static final class QueuedJob {
+        final Object key;
+        final Priority priority;
+        final String caller;
+        final Job job;
+        final long queuedTimeMillis;
+        long startTimeMillis;
+
+        QueuedJob(Object key, Priority priority, String caller, Job job, long queuedTimeMillis) {
+            this.key = key;
+            this.priority = priority;
+            this.caller = caller;
+            this.job = job;
+            this.queuedTimeMillis = queuedTimeMillis;
+        }
+    }
+
+    /** The number of slots kept for {@link Priority#INTERACTIVE} commands if the max parallelism is more than 1. */
+    public static final int INTERACTIVE_RESERVED_SLOTS = 1;
+
+    /** The time in milliseconds after which a running command no longer holds a slot. */
+    public static final long LONG_RUNNING_JOB_MILLIS = 60000;
+
+    private int mMaxParallelism;
+
+    /* The queues of each caller for each priority, in the round-robin order of the callers. */
+    @SuppressWarnings("unchecked")
+    private final LinkedHashMap<String, ArrayDeque<QueuedJob>>[] mQueues = new LinkedHashMap[Priority.values().length];
+    private final Map<Object, QueuedJob> mQueuedJobs = new IdentityHashMap<>();
+    private final Map<Object, QueuedJob> mRunningJobs = new IdentityHashMap<>();
+    private final Metrics mMetrics = new Metrics();
+
+    private static final String LOG_TAG = "AppShellScheduler";
+
+    /**
+     * Create an new instance of {@link AppShellScheduler}.
+     *
+     * @param maxParallelism The max number of commands to run in parallel, or {@code 0} for unlimited.
+     */
+    public AppShellScheduler(int maxParallelism) {
+        for (int i = 0; i < mQueues.length; i++)
+            mQueues[i] = new LinkedHashMap<>();
+        mMaxParallelism = Math.max(maxParallelism, 0);
+    }
+
+    /**
+     * Set the max number of commands to run in parallel, or {@code 0} for unlimited. If it was
+     * increased, then queued commands are started.
+     */
+    public void setMaxParallelism(int maxParallelism) {
+        synchronized (this) {
+            maxParallelism = Math.max(maxParallelism, 0);
+            if (maxParallelism == mMaxParallelism) return;
+            Logger.logDebug(LOG_TAG, "Changing max parallelism from " + mMaxParallelism + " to " + maxParallelism);
+            mMaxParallelism = maxParallelism;
+        }
+        startQueuedJobs();
+    }
+
+    /**
+     * Submit a command, which is started right away if a slot is free for its priority, otherwise
+     * it is queued.
+     *
+     * @param key The unique key of the command, compared by identity.
+     * @param priority The {@link Priority} of the command.
+     * @param caller The caller of the command, like the package name of the app that sent it.
+     * @param job The {@link Job} to start the command.
+     * @return Returns {@code true} if the command was started, otherwise {@code false} if it was queued.
+     */
+    public boolean submit(@NonNull Object key, @NonNull Priority priority, @NonNull String caller, @NonNull Job job) {
+        QueuedJob queuedJob = new QueuedJob(key, priority, caller, job, SystemClock.elapsedRealtime());
+        synchronized (this) {
+            if (mQueuedJobs.containsKey(key) || mRunningJobs.containsKey(key)) {
+                Logger.logWarn(LOG_TAG, "Ignoring command already submitted by \"" + caller + "\"");
+                return false;
+            }
+
+            // Queue behind already queued commands of the same priority, so that the order is kept
+            if (!hasFreeSlot(priority) || !mQueues[priority.ordinal()].isEmpty() ||
+                (priority == Priority.BATCH && !mQueues[Priority.INTERACTIVE.ordinal()].isEmpty())) {
+                ArrayDeque<QueuedJob> callerQueue = mQueues[priority.ordinal()].get(caller);
+                if (callerQueue == null) {
+                    callerQueue = new ArrayDeque<>();
+                    mQueues[priority.ordinal()].put(caller, callerQueue);
+                }
+                callerQueue.add(queuedJob);
+                mQueuedJobs.put(key, queuedJob);
+                mMetrics.queuedCounts[priority.ordinal()]++;
+                mMetrics.maxQueuedCount = Math.max(mMetrics.maxQueuedCount, mQueuedJobs.size());
+                Logger.logVerbose(LOG_TAG, "Queued " + priority.getName() + " command of \"" + caller + "\", " + getMetricsLocked());
+                queuedJob = null;
+            } else {
+                markStartedLocked(queuedJob);
+            }
+        }
+
+        if (queuedJob == null) return false;
+        startJob(queuedJob);
+        return true;
+    }
+
+    /**
+     * Notify the scheduler that the command with {@code key} has exited or failed to start, so
+     * that queued commands can be started in its slot. Unknown keys are ignored, like of commands
+     * that were started without the scheduler.
+     */
+    public void onJobFinished(@NonNull Object key) {
+        synchronized (this) {
+            if (mRunningJobs.remove(key) == null) return;
+        }
+        startQueuedJobs();
+    }
+
+    /**
+     * Start the queued commands that have a free slot now that running commands may have become
+     * long running, see {@link #LONG_RUNNING_JOB_MILLIS}.
+     *
+     * @return Returns the delay in milliseconds after which this should be called again, or
+     * {@code -1} if no command is queued.
+     */
+    public long checkLongRunningJobs() {
+        startQueuedJobs();
+        synchronized (this) {
+            if (mQueuedJobs.isEmpty()) return -1;
+
+            long now = SystemClock.elapsedRealtime();
+            long delay = LONG_RUNNING_JOB_MILLIS;
+            for (QueuedJob runningJob : mRunningJobs.values()) {
+                long runTime = now - runningJob.startTimeMillis;
+                if (runTime < LONG_RUNNING_JOB_MILLIS)
+                    delay = Math.min(delay, LONG_RUNNING_JOB_MILLIS - runTime);
+            }
+            return delay;
+        }
+    }
+
+    /**
+     * Cancel the queued command with {@code key}.
+     *
+     * @return Returns {@code true} if the command was queued and has been removed.
+     */
+    public synchronized boolean cancel(@NonNull Object key) {
+        QueuedJob queuedJob = mQueuedJobs.remove(key);
+        if (queuedJob == null) return false;
+
+        LinkedHashMap<String, ArrayDeque<QueuedJob>> queues = mQueues[queuedJob.priority.ordinal()];
+        ArrayDeque<QueuedJob> callerQueue = queues.get(queuedJob.caller);
+        if (callerQueue != null) {
+            callerQueue.remove(queuedJob);
+            if (callerQueue.isEmpty())
+                queues.remove(queuedJob.caller);
+        }
+        mMetrics.queuedCounts[queuedJob.priority.ordinal()]--;
+        mMetrics.cancelledCount++;
+        return true;
+    }
+
+    /**
+     * Cancel all the queued commands.
+     *
+     * @return Returns the keys of the cancelled commands.
+     */
+    @NonNull
+    public synchronized List<Object> cancelAll() {
+        List<Object> keys = new ArrayList<>(mQueuedJobs.keySet());
+        for (Object key : keys)
+            cancel(key);
+        return keys;
+    }
+
+    /** Check whether the command with {@code key} is queued. */
+    public synchronized boolean isQueued(@NonNull Object key) {
+        return mQueuedJobs.containsKey(key);
+    }
+
+    /** Get the number of queued commands. */
+    public synchronized int getQueuedCount() {
+        return mQueuedJobs.size();
+    }
+
+    /** Get a snapshot of the {@link Metrics} of the scheduler. */
+    @NonNull
+    public synchronized Metrics getMetrics() {
+        return getMetricsLocked();
+    }
+
+    private Metrics getMetricsLocked() {
+        Metrics metrics = new Metrics();
+        metrics.maxParallelism = mMaxParallelism;
+        metrics.runningCount = mRunningJobs.size();
+        metrics.maxQueuedCount = mMetrics.maxQueuedCount;
+        metrics.cancelledCount = mMetrics.cancelledCount;
+        System.arraycopy(mMetrics.queuedCounts, 0, metrics.queuedCounts, 0, metrics.queuedCounts.length);
+        System.arraycopy(mMetrics.startedCounts, 0, metrics.startedCounts, 0, metrics.startedCounts.length);
+        System.arraycopy(mMetrics.totalWaitMillis, 0, metrics.totalWaitMillis, 0, metrics.totalWaitMillis.length);
+        System.arraycopy(mMetrics.maxWaitMillis, 0, metrics.maxWaitMillis, 0, metrics.maxWaitMillis.length);
+        return metrics;
+    }
+
+    private boolean hasFreeSlot(@NonNull Priority priority) {
+        if (mMaxParallelism == 0) return true;
+
+        // Only commands that are not long running hold a slot
+        long now = SystemClock.elapsedRealtime();
+        int running = 0;
+        int runningBatch = 0;
+        for (QueuedJob runningJob : mRunningJobs.values()) {
+            if (now - runningJob.startTimeMillis >= LONG_RUNNING_JOB_MILLIS) continue;
+            running++;
+            if (runningJob.priority == Priority.BATCH) runningBatch++;
+        }
+
+        if (priority == Priority.INTERACTIVE || mMaxParallelism <= INTERACTIVE_RESERVED_SLOTS)
+            return running < mMaxParallelism;
+
+        // Batch commands cannot use the slots kept for interactive commands
+        return running < mMaxParallelism && runningBatch < mMaxParallelism - INTERACTIVE_RESERVED_SLOTS;
+    }
+
+    private void markStartedLocked(@NonNull QueuedJob queuedJob) {
+        int i = queuedJob.priority.ordinal();
+        queuedJob.startTimeMillis = SystemClock.elapsedRealtime();
+        long waitMillis = queuedJob.startTimeMillis - queuedJob.queuedTimeMillis;
+        mRunningJobs.put(queuedJob.key, queuedJob);
+        mMetrics.startedCounts[i]++;
+        mMetrics.totalWaitMillis[i] += waitMillis;
+        mMetrics.maxWaitMillis[i] = Math.max(mMetrics.maxWaitMillis[i], waitMillis);
+    }
+
+    /* Get the next queued command that has a free slot, serving the callers of each priority round-robin. */
+    @Nullable
+    private QueuedJob pollNextLocked() {
+        for (Priority priority : Priority.values()) {
+            LinkedHashMap<String, ArrayDeque<QueuedJob>> queues = mQueues[priority.ordinal()];
+            if (queues.isEmpty() || !hasFreeSlot(priority)) continue;
+
+            Iterator<Map.Entry<String, ArrayDeque<QueuedJob>>> iterator = queues.entrySet().iterator();
+            Map.Entry<String, ArrayDeque<QueuedJob>> entry = iterator.next();
+            QueuedJob queuedJob = entry.getValue().poll();
+            iterator.remove();
+            // Move the caller to the end of the round-robin order
+            if (queuedJob != null && !entry.getValue().isEmpty())
+                queues.put(entry.getKey(), entry.getValue());
+            if (queuedJob == null) continue;
+
+            mQueuedJobs.remove(queuedJob.key);
+            mMetrics.queuedCounts[priority.ordinal()]--;
+            return queuedJob;
+        }
+        return null;
+    }
+
+    private void startQueuedJobs() {
+        while (true) {
+            QueuedJob queuedJob;
+            synchronized (this) {
+                queuedJob = pollNextLocked();
+                if (queuedJob == null) return;
+                markStartedLocked(queuedJob);
+            }
+            startJob(queuedJob);
+        }
+    }
+
+    private void startJob(@NonNull QueuedJob queuedJob) {
+        try {
+            queuedJob.job.start();
+        } catch (Exception e) {
+            Logger.logStackTraceWithMessage(LOG_TAG, "Failed to start " + queuedJob.priority.getName() + " command of \"" + queuedJob.caller + "\"", e);
+            onJobFinished(queuedJob.key);
+        }
+    }
+
+}
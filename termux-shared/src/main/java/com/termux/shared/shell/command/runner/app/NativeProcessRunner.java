@@ -0,0 +1,233 @@
+package com.termux.shared.shell.command.runner.app;
+
+import android.os.Build;
+
+import androidx.annotation.Keep;
+import androidx.annotation.NonNull;
+import androidx.annotation.Nullable;
+
+import com.termux.shared.file.libcore.ErrnoException;
+import com.termux.shared.file.libcore.OsConstants;
+import com.termux.shared.logger.Logger;
+import com.termux.shared.shell.command.result.OutputCapture;
+import com.termux.shared.shell.command.result.ResourceUsage;
+
+import java.io.File;
+import java.util.HashMap;
+import java.util.Map;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.RejectedExecutionException;
+
+/**
+ * A native runner for background processes, which is used by {@link AppShell} instead of
+ * {@link Runtime#exec(String[], String[], java.io.File)} and a thread per stream.
+ *
+ * Processes are spawned with {@code posix_spawn()} with pipes for their stdin, stdout and stderr.
+ * The stdin of all the processes is written and their stdout and stderr are read as raw bytes on a
+ * single epoll thread of the process-wide {@link #getInstance()}. Once a process has exited and
+ * its output was closed, its {@link ExitListener} is called on a separate thread, so that slow
+ * listeners, like ones that send results to plugins, do not delay collecting the output of the
+ * other processes. Like {@link OutputCapture}, only the head and tail of an output larger than the
+ * max output size are kept in memory, and the full output is spilled to a file. Processes are
+ * reaped with {@code wait4()}, so that their {@link ResourceUsage} is reported with their exit.
+ */
+final class NativeProcessRunner {
+
+    /**
+     * The max size in bytes of the stdout and stderr kept in memory if no max output size is
+     * passed to {@link #spawn(String[], String[], String, byte[], int, File, ExitListener)}, since
+     * the output is passed to java in a single array.
+     */
+    static final int MAX_OUTPUT_SIZE = 16 * 1024 * 1024;
+
+    private static NativeProcessRunner sInstance;
+    private static boolean sFailed;
+
+    /** The executor for the {@link ExitListener} calls, which starts threads as needed. */
+    private static final ExecutorService EXIT_LISTENER_EXECUTOR = Executors.newCachedThreadPool(runnable -> {
+        Thread thread = new Thread(runnable, LOG_TAG + "-exit");
+        thread.setDaemon(true);
+        return thread;
+    });
+
+    private final long mHandle;
+    private final Map<Long, ExitListener> mExitListeners = new HashMap<>();
+    private long mNextId;
+    private boolean mStopped;
+
+    private static final String LOG_TAG = "NativeProcessRunner";
+
+    /** The listener for the exit of a process. */
+    interface ExitListener {
+        /**
+         * Called on an exit listener thread when the process has exited and its stdout and stderr were closed.
+         *
+         * @param pid The pid of the process, or -1 if the runner failed while it was running.
+         * @param exitCode The exit code of the process, 128 + the signal number if it was killed by
+         *                 a signal, or -1 if it is unknown.
+         * @param resourceUsage The {@link ResourceUsage} of the process, which only has the wall
+         *                      time if the exit code is unknown.
+         * @param stdout The closed {@link OutputCapture} of the stdout of the process.
+         * @param stderr The closed {@link OutputCapture} of the stderr of the process.
+         */
+        void onProcessExited(int pid, int exitCode, @NonNull ResourceUsage resourceUsage,
+                             @NonNull OutputCapture stdout, @NonNull OutputCapture stderr);
+    }
+
+    private NativeProcessRunner(long handle) {
+        mHandle = handle;
+    }
+
+    /**
+     * Get the process-wide {@link NativeProcessRunner}, starting its thread if needed.
+     *
+     * @return Returns the {@link NativeProcessRunner}, or {@code null} if it is not supported or
+     * failed, in which case {@link Runtime#exec(String[], String[], java.io.File)} must be used.
+     * Before android 7, the framework reaps all child processes of the app, so their exit codes
+     * would be lost.
+     */
+    @Nullable
+    static synchronized NativeProcessRunner getInstance() {
+        if (sInstance != null || sFailed || Build.VERSION.SDK_INT < Build.VERSION_CODES.N)
+            return sInstance;
+
+        try {
+            sInstance = new NativeProcessRunner(createNative());
+        } catch (ErrnoException e) {
+            Logger.logStackTraceWithMessage(LOG_TAG, "Failed to create native process runner", e);
+            sFailed = true;
+            return null;
+        }
+
+        final NativeProcessRunner runner = sInstance;
+        Thread thread = new Thread(runner::run, LOG_TAG);
+        thread.setDaemon(true);
+        thread.start();
+        return runner;
+    }
+
+    /**
+     * Spawn a process.
+     *
+     * @param commandArray The absolute path of the executable followed by its arguments.
+     * @param environmentArray The environment of the process.
+     * @param workingDirectory The {@code path} of the working directory of the process.
+     * @param stdin The bytes to write to the stdin of the process, which is then closed. This can
+     *              optionally be {@code null}.
+     * @param maxOutputSize The max size in bytes of the stdout and stderr kept in memory, or
+     *                      {@code 0} to keep up to {@link #MAX_OUTPUT_SIZE}.
+     * @param spillDirectory The directory to write the full stdout or stderr to if it is larger
+     *                       than {@code maxOutputSize}. This can optionally be {@code null}.
+     * @param exitListener The {@link ExitListener} to call when the process exits.
+     * @return Returns the pid of the process.
+     * @throws ErrnoException If the process could not be spawned or the runner has stopped.
+     */
+    int spawn(@NonNull String[] commandArray, @NonNull String[] environmentArray, @NonNull String workingDirectory,
+              @Nullable byte[] stdin, int maxOutputSize, @Nullable File spillDirectory,
+              @NonNull ExitListener exitListener) throws ErrnoException {
+        long id;
+        synchronized (this) {
+            if (mStopped)
+                throw new ErrnoException("posix_spawn", OsConstants.ECANCELED);
+            id = mNextId++;
+            // Add the listener first, since the process may exit before spawnNative() returns
+            mExitListeners.put(id, exitListener);
+        }
+
+        try {
+            return spawnNative(mHandle, id, commandArray, environmentArray, workingDirectory, stdin,
+                maxOutputSize > 0 ? Math.min(maxOutputSize, MAX_OUTPUT_SIZE) : MAX_OUTPUT_SIZE, spillDirectory != null ? spillDirectory.getAbsolutePath() : null);
+        } catch (ErrnoException e) {
+            synchronized (this) {
+                mExitListeners.remove(id);
+            }
+            throw e;
+        }
+    }
+
+    private void run() {
+        try {
+            while (true)
+                waitNative(this, mHandle);
+        } catch (Throwable t) {
+            // Errors are caught too, like an OutOfMemoryError or a NoSuchMethodError if onNativeExit()
+            // was not kept, since they would otherwise kill the app
+            Logger.logStackTraceWithMessage(LOG_TAG, "Waiting for native processes failed", t);
+        }
+
+        // The output and exits of the running processes can no longer be collected, so further
+        // commands must use Runtime.exec(). The native runner is not destroyed, since other
+        // threads may still be spawning with it.
+        synchronized (NativeProcessRunner.class) {
+            sFailed = true;
+            sInstance = null;
+        }
+        Map<Long, ExitListener> exitListeners;
+        synchronized (this) {
+            mStopped = true;
+            exitListeners = new HashMap<>(mExitListeners);
+            mExitListeners.clear();
+        }
+
+        // Report the running processes as exited with an unknown exit code, so that their callers
+        // do not wait forever
+        for (ExitListener exitListener : exitListeners.values()) {
+            dispatchExit(exitListener, -1, -1, ResourceUsage.ofWallTime(0), OutputCapture.of(new byte[0], 0, 0, null),
+                OutputCapture.of(new byte[0], 0, 0, null));
+        }
+    }
+
+    /**
+     * Called by native for each process that exited. The arrays and strings are {@code null} if
+     * native failed to create them, like when out of memory.
+     */
+    @Keep
+    @SuppressWarnings("unused")
+    private void onNativeExit(long id, int pid, int exitCode, long[] usage, long wallTimeMillis,
+                              byte[] stdout, int stdoutHeadSize, long stdoutSize, String stdoutSpillPath,
+                              byte[] stderr, int stderrHeadSize, long stderrSize, String stderrSpillPath) {
+        ExitListener exitListener;
+        synchronized (this) {
+            exitListener = mExitListeners.remove(id);
+        }
+        if (exitListener == null) return;
+
+        // The usage is zeroed if the process was reaped by someone else
+        dispatchExit(exitListener, pid, exitCode, exitCode != -1 ? ResourceUsage.of(usage, wallTimeMillis) : ResourceUsage.ofWallTime(wallTimeMillis),
+            stdout != null ? OutputCapture.of(stdout, stdoutHeadSize, stdoutSize, stdoutSpillPath) : OutputCapture.of(new byte[0], 0, stdoutSize, stdoutSpillPath),
+            stderr != null ? OutputCapture.of(stderr, stderrHeadSize, stderrSize, stderrSpillPath) : OutputCapture.of(new byte[0], 0, stderrSize, stderrSpillPath));
+    }
+
+    /** Call the {@link ExitListener} of a process on an exit listener thread. */
+    private static void dispatchExit(@NonNull ExitListener exitListener, int pid, int exitCode, @NonNull ResourceUsage resourceUsage,
+                                     @NonNull OutputCapture stdout, @NonNull OutputCapture stderr) {
+        Runnable runnable = () -> {
+            try {
+                exitListener.onProcessExited(pid, exitCode, resourceUsage, stdout, stderr);
+            } catch (Exception e) {
+                Logger.logStackTraceWithMessage(LOG_TAG, "Exit listener for process with pid " + pid + " failed", e);
+            }
+        };
+
+        try {
+            EXIT_LISTENER_EXECUTOR.execute(runnable);
+        } catch (RejectedExecutionException e) {
+            // A thread could not be started, so call the listener directly instead of losing the exit
+            Logger.logStackTraceWithMessage(LOG_TAG, "Failed to dispatch exit of process with pid " + pid, e);
+            runnable.run();
+        }
+    }
+
+
+
+    private static native long createNative() throws ErrnoException;
+
+    private static native int spawnNative(long handle, long id, String[] argv, String[] envp, String workingDirectory,
+                                          byte[] stdin, int maxOutputSize, String spillDirectory) throws ErrnoException;
+
+    private static native void waitNative(NativeProcessRunner runner, long handle) throws ErrnoException;
+
+    static { System.loadLibrary("posix"); }
+
+}
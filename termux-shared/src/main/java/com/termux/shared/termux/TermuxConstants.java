@@ -11,7 +11,7 @@ import java.util.Formatter;
 import java.util.List;
 
 /*
- * Version: v0.52.0
+ * Version: v0.55.0
  * SPDX-License-Identifier: MIT
  *
  * Changelog
@@ -277,6 +277,21 @@ import java.util.List;
  *
  * - 0.52.0 (2022-06-18)
  *      - Added `TERMUX_PREFIX_DIR_IGNORED_SUB_FILES_PATHS_TO_CONSIDER_AS_EMPTY`.
+ *
+ * - 0.53.0 (2026-10-19)
+ *      - Added following to `TERMUX_SERVICE`:
+ *          `EXTRA_PLUGIN_RESULT_BUNDLE_STDOUT_FILE_PATH`,
+ *          `EXTRA_PLUGIN_RESULT_BUNDLE_STDERR_FILE_PATH`.
+ *
+ * - 0.54.0 (2026-10-19)
+ *      - Added following to `TERMUX_SERVICE`:
+ *          `EXTRA_BACKGROUND_PRIORITY`.
+ *      - Added following to `RUN_COMMAND_SERVICE`:
+ *          `EXTRA_BACKGROUND_PRIORITY`.
+ *
+ * - 0.55.0 (2026-10-19)
+ *      - Added following to `TERMUX_SERVICE`:
+ *          `EXTRA_PLUGIN_RESULT_BUNDLE_RESOURCE_USAGE`.
  */
 
 /**
@@ -1008,6 +1023,9 @@ public final class TermuxConstants {
             public static final String EXTRA_RUNNER = TERMUX_PACKAGE_NAME + ".execute.runner"; // Default: "com.termux.execute.runner"
             /** Intent {@code String} extra for custom log level for background commands defined by {@link com.termux.shared.logger.Logger} for the TERMUX_SERVICE.ACTION_SERVICE_EXECUTE intent */
             public static final String EXTRA_BACKGROUND_CUSTOM_LOG_LEVEL = TERMUX_PACKAGE_NAME + ".execute.background_custom_log_level"; // Default: "com.termux.execute.background_custom_log_level"
+            /** Intent {@code String} extra for the {@link com.termux.shared.shell.command.runner.app.AppShellScheduler.Priority}
+             * name of background commands for the TERMUX_SERVICE.ACTION_SERVICE_EXECUTE intent */
+            public static final String EXTRA_BACKGROUND_PRIORITY = TERMUX_PACKAGE_NAME + ".execute.background_priority"; // Default: "com.termux.execute.background_priority"
             /** Intent {@code String} extra for session action for {@link Runner#TERMINAL_SESSION} commands for the TERMUX_SERVICE.ACTION_SERVICE_EXECUTE intent */
             public static final String EXTRA_SESSION_ACTION = TERMUX_PACKAGE_NAME + ".execute.session_action"; // Default: "com.termux.execute.session_action"
             /** Intent {@code String} extra for shell name for commands for the TERMUX_SERVICE.ACTION_SERVICE_EXECUTE intent */
@@ -1101,6 +1119,22 @@ public final class TermuxConstants {
             public static final String EXTRA_PLUGIN_RESULT_BUNDLE_STDERR = "stderr"; // Default: "stderr"
             /** Intent {@code String} extra for original length of stderr value of execute command of the {@link #EXTRA_PLUGIN_RESULT_BUNDLE} */
             public static final String EXTRA_PLUGIN_RESULT_BUNDLE_STDERR_ORIGINAL_LENGTH = "stderr_original_length"; // Default: "stderr_original_length"
+            /** Intent {@code String} extra for the path of the file in the Termux app cache directory
+             * with the full stdout of execute command of the {@link #EXTRA_PLUGIN_RESULT_BUNDLE} if
+             * it was too large to keep in memory, in which case the stdout only has its head and tail.
+             * It is only sent to apps with the Termux app shared user id, since other apps cannot
+             * read the file, and they can get the full stdout by writing the result to {@link #EXTRA_RESULT_DIRECTORY}. */
+            public static final String EXTRA_PLUGIN_RESULT_BUNDLE_STDOUT_FILE_PATH = "stdout_file_path"; // Default: "stdout_file_path"
+            /** Intent {@code String} extra for the path of the file in the Termux app cache directory
+             * with the full stderr of execute command of the {@link #EXTRA_PLUGIN_RESULT_BUNDLE} if
+             * it was too large to keep in memory, in which case the stderr only has its head and tail.
+             * It is only sent to apps with the Termux app shared user id, since other apps cannot
+             * read the file, and they can get the full stderr by writing the result to {@link #EXTRA_RESULT_DIRECTORY}. */
+            public static final String EXTRA_PLUGIN_RESULT_BUNDLE_STDERR_FILE_PATH = "stderr_file_path"; // Default: "stderr_file_path"
+            /** Intent {@code Bundle} extra for the {@link com.termux.shared.shell.command.result.ResourceUsage}
+             * of the process of execute command of the {@link #EXTRA_PLUGIN_RESULT_BUNDLE}, with the
+             * {@code ResourceUsage.KEY_*} keys */
+            public static final String EXTRA_PLUGIN_RESULT_BUNDLE_RESOURCE_USAGE = "resource_usage"; // Default: "resource_usage"
             /** Intent {@code int} extra for exit code value of execute command of the {@link #EXTRA_PLUGIN_RESULT_BUNDLE} */
             public static final String EXTRA_PLUGIN_RESULT_BUNDLE_EXIT_CODE = "exitCode"; // Default: "exitCode"
             /** Intent {@code int} extra for err value of execute command of the {@link #EXTRA_PLUGIN_RESULT_BUNDLE} */
@@ -1149,6 +1183,9 @@ public final class TermuxConstants {
             public static final String EXTRA_RUNNER = TERMUX_PACKAGE_NAME + ".RUN_COMMAND_RUNNER"; // Default: "com.termux.RUN_COMMAND_RUNNER"
             /** Intent {@code String} extra for custom log level for background commands defined by {@link com.termux.shared.logger.Logger} for the RUN_COMMAND_SERVICE.ACTION_RUN_COMMAND intent */
             public static final String EXTRA_BACKGROUND_CUSTOM_LOG_LEVEL = TERMUX_PACKAGE_NAME + ".RUN_COMMAND_BACKGROUND_CUSTOM_LOG_LEVEL"; // Default: "com.termux.RUN_COMMAND_BACKGROUND_CUSTOM_LOG_LEVEL"
+            /** Intent {@code String} extra for the {@link com.termux.shared.shell.command.runner.app.AppShellScheduler.Priority}
+             * name of background commands for the RUN_COMMAND_SERVICE.ACTION_RUN_COMMAND intent */
+            public static final String EXTRA_BACKGROUND_PRIORITY = TERMUX_PACKAGE_NAME + ".RUN_COMMAND_BACKGROUND_PRIORITY"; // Default: "com.termux.RUN_COMMAND_BACKGROUND_PRIORITY"
             /** Intent {@code String} extra for session action of {@link Runner#TERMINAL_SESSION} commands for the RUN_COMMAND_SERVICE.ACTION_RUN_COMMAND intent */
             public static final String EXTRA_SESSION_ACTION = TERMUX_PACKAGE_NAME + ".RUN_COMMAND_SESSION_ACTION"; // Default: "com.termux.RUN_COMMAND_SESSION_ACTION"
             /** Intent {@code String} extra for shell name of commands for the RUN_COMMAND_SERVICE.ACTION_RUN_COMMAND intent */
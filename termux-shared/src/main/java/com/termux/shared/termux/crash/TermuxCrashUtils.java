@@ -175,8 +175,9 @@ public class TermuxCrashUtils implements CrashHandler.CrashHandlerClient {
         Error error;
         StringBuilder reportStringBuilder = new StringBuilder();
 
-        // Read report string from crash log file
-        error = FileUtils.readTextFromFile("crash log", TermuxConstants.TERMUX_CRASH_LOG_FILE_PATH, Charset.defaultCharset(), reportStringBuilder, false);
+        // Read report string from crash log file. The report activity can only show text up to its
+        // size limit in bytes, so do not read more bytes of a large crash log into memory.
+        error = FileUtils.readTextFromFile("crash log", TermuxConstants.TERMUX_CRASH_LOG_FILE_PATH, Charset.defaultCharset(), reportStringBuilder, false, ReportActivity.ACTIVITY_TEXT_SIZE_LIMIT_IN_BYTES);
         if (error != null) {
             Logger.logErrorExtended(logTag, error.toString());
             return;
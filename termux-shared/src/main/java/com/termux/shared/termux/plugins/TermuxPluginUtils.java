@@ -98,6 +98,9 @@ public class TermuxPluginUtils {
                     executionCommand.resultConfig.resultPendingIntent != null ? executionCommand.resultConfig.resultPendingIntent.getCreatorPackage(): null);
             }
 
+        } else {
+            // No caller will read the full output
+            ResultSender.deleteSpillFiles(logTag, resultData, true, true);
         }
 
         if (!executionCommand.isStateFailed() && error == null)
@@ -214,6 +217,9 @@ public class TermuxPluginUtils {
         resultConfig.resultStdoutOriginalLengthKey = TERMUX_SERVICE.EXTRA_PLUGIN_RESULT_BUNDLE_STDOUT_ORIGINAL_LENGTH;
         resultConfig.resultStderrKey = TERMUX_SERVICE.EXTRA_PLUGIN_RESULT_BUNDLE_STDERR;
         resultConfig.resultStderrOriginalLengthKey = TERMUX_SERVICE.EXTRA_PLUGIN_RESULT_BUNDLE_STDERR_ORIGINAL_LENGTH;
+        resultConfig.resultStdoutFilePathKey = TERMUX_SERVICE.EXTRA_PLUGIN_RESULT_BUNDLE_STDOUT_FILE_PATH;
+        resultConfig.resultStderrFilePathKey = TERMUX_SERVICE.EXTRA_PLUGIN_RESULT_BUNDLE_STDERR_FILE_PATH;
+        resultConfig.resultResourceUsageKey = TERMUX_SERVICE.EXTRA_PLUGIN_RESULT_BUNDLE_RESOURCE_USAGE;
         resultConfig.resultExitCodeKey = TERMUX_SERVICE.EXTRA_PLUGIN_RESULT_BUNDLE_EXIT_CODE;
         resultConfig.resultErrCodeKey = TERMUX_SERVICE.EXTRA_PLUGIN_RESULT_BUNDLE_ERR;
         resultConfig.resultErrmsgKey = TERMUX_SERVICE.EXTRA_PLUGIN_RESULT_BUNDLE_ERRMSG;
@@ -6,6 +6,7 @@ import com.termux.shared.theme.NightMode;
 import com.termux.shared.file.FileUtils;
 import com.termux.shared.file.filesystem.FileType;
 import com.termux.shared.settings.properties.SharedProperties;
+import com.termux.shared.shell.command.runner.app.AppShellScheduler;
 import com.termux.shared.termux.TermuxConstants;
 import com.termux.shared.logger.Logger;
 import com.termux.terminal.TerminalEmulator;
@@ -18,7 +19,7 @@ import java.util.List;
 import java.util.Set;
 
 /*
- * Version: v0.18.0
+ * Version: v0.20.0
  * SPDX-License-Identifier: MIT
  *
  * Changelog
@@ -80,6 +81,12 @@ import java.util.Set;
  *
  * - 0.18.0 (2022-06-13)
  *      - Add `KEY_DISABLE_FILE_SHARE_RECEIVER` and `KEY_DISABLE_FILE_VIEW_RECEIVER`.
+ *
+ * - 0.19.0 (2026-10-19)
+ *      - Add `KEY_BACKGROUND_COMMANDS_MAX_PARALLELISM`.
+ *
+ * - 0.20.0 (2026-10-19)
+ *      - Add `KEY_TERMINAL_SESSION_POOL_SIZE`.
  */
 
 /**
@@ -233,6 +240,22 @@ public final class TermuxPropertyConstants {
 
 
 
+    /**
+     * Defines the key for the max number of background commands run in parallel by TermuxService,
+     * after which further commands are queued.
+     * `0` for unlimited. The default is the CPU count, but at least `2`, plus the slot reserved
+     * for interactive commands. Commands that run for as long as they want, like servers, release
+     * their slot after {@link AppShellScheduler#LONG_RUNNING_JOB_MILLIS}, so that they cannot
+     * block queued commands forever.
+     */
+    public static final String KEY_BACKGROUND_COMMANDS_MAX_PARALLELISM =  "background-commands-max-parallelism"; // Default: "background-commands-max-parallelism"
+    public static final int IVALUE_BACKGROUND_COMMANDS_MAX_PARALLELISM_MIN = 0;
+    public static final int IVALUE_BACKGROUND_COMMANDS_MAX_PARALLELISM_MAX = 1000;
+    public static final int DEFAULT_IVALUE_BACKGROUND_COMMANDS_MAX_PARALLELISM =
+        Math.max(2, Runtime.getRuntime().availableProcessors()) + AppShellScheduler.INTERACTIVE_RESERVED_SLOTS;
+
+
+
     /** Defines the key for the terminal margin on left and right in dp units */
     public static final String KEY_TERMINAL_MARGIN_HORIZONTAL =  "terminal-margin-horizontal"; // Default: "terminal-margin-horizontal"
     public static final int IVALUE_TERMINAL_MARGIN_HORIZONTAL_MIN = 0;
@@ -247,6 +270,18 @@ public final class TermuxPropertyConstants {
 
 
 
+    /**
+     * Defines the key for the number of terminal sessions whose shell is started in advance by
+     * TermuxService, so that a new session can be added without waiting for the shell to start.
+     * `0` to disable.
+     */
+    public static final String KEY_TERMINAL_SESSION_POOL_SIZE =  "terminal-session-pool-size"; // Default: "terminal-session-pool-size"
+    public static final int IVALUE_TERMINAL_SESSION_POOL_SIZE_MIN = 0;
+    public static final int IVALUE_TERMINAL_SESSION_POOL_SIZE_MAX = 4;
+    public static final int DEFAULT_IVALUE_TERMINAL_SESSION_POOL_SIZE = 0;
+
+
+
     /** Defines the key for the terminal transcript rows */
     public static final String KEY_TERMINAL_TRANSCRIPT_ROWS =  "terminal-transcript-rows"; // Default: "terminal-transcript-rows"
     public static final int IVALUE_TERMINAL_TRANSCRIPT_ROWS_MIN = TerminalEmulator.TERMINAL_TRANSCRIPT_ROWS_MIN;
@@ -406,12 +441,14 @@ public final class TermuxPropertyConstants {
         TermuxConstants.PROP_ALLOW_EXTERNAL_APPS,
 
         /* int */
+        KEY_BACKGROUND_COMMANDS_MAX_PARALLELISM,
         KEY_BELL_BEHAVIOUR,
         KEY_DELETE_TMPDIR_FILES_OLDER_THAN_X_DAYS_ON_EXIT,
         KEY_TERMINAL_CURSOR_BLINK_RATE,
         KEY_TERMINAL_CURSOR_STYLE,
         KEY_TERMINAL_MARGIN_HORIZONTAL,
         KEY_TERMINAL_MARGIN_VERTICAL,
+        KEY_TERMINAL_SESSION_POOL_SIZE,
         KEY_TERMINAL_TRANSCRIPT_ROWS,
 
         /* float */
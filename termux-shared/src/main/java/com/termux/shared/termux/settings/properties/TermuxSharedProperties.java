@@ -4,6 +4,7 @@ import android.content.Context;
 
 import androidx.annotation.NonNull;
 
+import com.termux.shared.file.filesystem.FileChangeWatcher;
 import com.termux.shared.logger.Logger;
 import com.termux.shared.data.DataUtils;
 import com.termux.shared.settings.properties.SharedProperties;
@@ -27,6 +28,11 @@ public abstract class TermuxSharedProperties {
     protected File mPropertiesFile;
     protected SharedProperties mSharedProperties;
 
+    /** Whether any of the {@link #mPropertiesFilePaths} files changed since they were last loaded. */
+    protected volatile boolean mPropertiesFilesChanged = true;
+    /** Whether the {@link #mPropertiesFilePaths} files are being watched by {@link FileChangeWatcher}. */
+    protected boolean mWatchingPropertiesFiles;
+
     public static final String LOG_TAG = "TermuxSharedProperties";
 
     public TermuxSharedProperties(@NonNull Context context, @NonNull String label, List<String> propertiesFilePaths,
@@ -36,13 +42,62 @@ public abstract class TermuxSharedProperties {
         mPropertiesFilePaths = propertiesFilePaths;
         mPropertiesList = propertiesList;
         mSharedPropertiesParser = sharedPropertiesParser;
+        mWatchingPropertiesFiles = watchPropertiesFiles();
         loadTermuxPropertiesFromDisk();
     }
 
+    /**
+     * Watch all the {@link #mPropertiesFilePaths} files, since a higher priority file may be
+     * created after the current one was loaded.
+     *
+     * @return Returns {@code true} if all files are being watched, otherwise {@code false}.
+     */
+    private boolean watchPropertiesFiles() {
+        if (mPropertiesFilePaths == null) return false;
+
+        FileChangeWatcher watcher = FileChangeWatcher.getInstance();
+        FileChangeWatcher.Listener listener = path -> {
+            Logger.logVerbose(LOG_TAG, mLabel + " properties file changed at \"" + path + "\"");
+            mPropertiesFilesChanged = true;
+        };
+        for (String path : mPropertiesFilePaths) {
+            if (path == null || !watcher.addListener(path, listener))
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * Whether any of the properties files may have changed since they were last loaded. This is
+     * always {@code true} if they cannot be watched.
+     */
+    public boolean havePropertiesFilesChanged() {
+        return mPropertiesFilesChanged || !mWatchingPropertiesFiles || !FileChangeWatcher.getInstance().isWatching();
+    }
+
+    /**
+     * Reload the termux properties from disk into an in-memory cache only if any of the properties
+     * files changed since they were last loaded, to not pay the parse cost otherwise.
+     *
+     * @return Returns {@code true} if the properties were reloaded, otherwise {@code false}.
+     */
+    public synchronized boolean loadTermuxPropertiesFromDiskIfChanged() {
+        if (!havePropertiesFilesChanged()) {
+            Logger.logVerbose(LOG_TAG, "Not reloading " + mLabel + " properties since files did not change");
+            return false;
+        }
+
+        loadTermuxPropertiesFromDisk();
+        return true;
+    }
+
     /**
      * Reload the termux properties from disk into an in-memory cache.
      */
     public synchronized void loadTermuxPropertiesFromDisk() {
+        // Reset before reading so that changes while reading are not lost
+        mPropertiesFilesChanged = false;
+
         // Properties files must be searched everytime since no file may exist when constructor is
         // called or a higher priority file may have been created afterward. Otherwise, if no file
         // was found, then default props would keep loading, since mSharedProperties would be null. #2836
@@ -259,6 +314,8 @@ public abstract class TermuxSharedProperties {
          */
         switch (key) {
             /* int */
+            case TermuxPropertyConstants.KEY_BACKGROUND_COMMANDS_MAX_PARALLELISM:
+                return (int) getBackgroundCommandsMaxParallelismInternalPropertyValueFromValue(value);
             case TermuxPropertyConstants.KEY_BELL_BEHAVIOUR:
                 return (int) getBellBehaviourInternalPropertyValueFromValue(value);
             case TermuxPropertyConstants.KEY_DELETE_TMPDIR_FILES_OLDER_THAN_X_DAYS_ON_EXIT:
@@ -271,6 +328,8 @@ public abstract class TermuxSharedProperties {
                 return (int) getTerminalMarginHorizontalInternalPropertyValueFromValue(value);
             case TermuxPropertyConstants.KEY_TERMINAL_MARGIN_VERTICAL:
                 return (int) getTerminalMarginVerticalInternalPropertyValueFromValue(value);
+            case TermuxPropertyConstants.KEY_TERMINAL_SESSION_POOL_SIZE:
+                return (int) getTerminalSessionPoolSizeInternalPropertyValueFromValue(value);
             case TermuxPropertyConstants.KEY_TERMINAL_TRANSCRIPT_ROWS:
                 return (int) getTerminalTranscriptRowsInternalPropertyValueFromValue(value);
 
@@ -336,6 +395,24 @@ public abstract class TermuxSharedProperties {
         return (int) SharedProperties.getDefaultIfNotInMap(TermuxPropertyConstants.KEY_BELL_BEHAVIOUR, TermuxPropertyConstants.MAP_BELL_BEHAVIOUR, SharedProperties.toLowerCase(value), TermuxPropertyConstants.DEFAULT_IVALUE_BELL_BEHAVIOUR, true, LOG_TAG);
     }
 
+    /**
+     * Returns the int for the value if its not null and is between
+     * {@link TermuxPropertyConstants#IVALUE_BACKGROUND_COMMANDS_MAX_PARALLELISM_MIN} and
+     * {@link TermuxPropertyConstants#IVALUE_BACKGROUND_COMMANDS_MAX_PARALLELISM_MAX},
+     * otherwise returns {@link TermuxPropertyConstants#DEFAULT_IVALUE_BACKGROUND_COMMANDS_MAX_PARALLELISM}.
+     *
+     * @param value The {@link String} value to convert.
+     * @return Returns the internal value for value.
+     */
+    public static int getBackgroundCommandsMaxParallelismInternalPropertyValueFromValue(String value) {
+        return SharedProperties.getDefaultIfNotInRange(TermuxPropertyConstants.KEY_BACKGROUND_COMMANDS_MAX_PARALLELISM,
+            DataUtils.getIntFromString(value, TermuxPropertyConstants.DEFAULT_IVALUE_BACKGROUND_COMMANDS_MAX_PARALLELISM),
+            TermuxPropertyConstants.DEFAULT_IVALUE_BACKGROUND_COMMANDS_MAX_PARALLELISM,
+            TermuxPropertyConstants.IVALUE_BACKGROUND_COMMANDS_MAX_PARALLELISM_MIN,
+            TermuxPropertyConstants.IVALUE_BACKGROUND_COMMANDS_MAX_PARALLELISM_MAX,
+            true, true, LOG_TAG);
+    }
+
     /**
      * Returns the int for the value if its not null and is between
      * {@link TermuxPropertyConstants#IVALUE_DELETE_TMPDIR_FILES_OLDER_THAN_X_DAYS_ON_EXIT_MIN} and
@@ -420,6 +497,24 @@ public abstract class TermuxSharedProperties {
             true, true, LOG_TAG);
     }
 
+    /**
+     * Returns the int for the value if its not null and is between
+     * {@link TermuxPropertyConstants#IVALUE_TERMINAL_SESSION_POOL_SIZE_MIN} and
+     * {@link TermuxPropertyConstants#IVALUE_TERMINAL_SESSION_POOL_SIZE_MAX},
+     * otherwise returns {@link TermuxPropertyConstants#DEFAULT_IVALUE_TERMINAL_SESSION_POOL_SIZE}.
+     *
+     * @param value The {@link String} value to convert.
+     * @return Returns the internal value for value.
+     */
+    public static int getTerminalSessionPoolSizeInternalPropertyValueFromValue(String value) {
+        return SharedProperties.getDefaultIfNotInRange(TermuxPropertyConstants.KEY_TERMINAL_SESSION_POOL_SIZE,
+            DataUtils.getIntFromString(value, TermuxPropertyConstants.DEFAULT_IVALUE_TERMINAL_SESSION_POOL_SIZE),
+            TermuxPropertyConstants.DEFAULT_IVALUE_TERMINAL_SESSION_POOL_SIZE,
+            TermuxPropertyConstants.IVALUE_TERMINAL_SESSION_POOL_SIZE_MIN,
+            TermuxPropertyConstants.IVALUE_TERMINAL_SESSION_POOL_SIZE_MAX,
+            true, true, LOG_TAG);
+    }
+
     /**
      * Returns the int for the value if its not null and is between
      * {@link TermuxPropertyConstants#IVALUE_TERMINAL_TRANSCRIPT_ROWS_MIN} and
@@ -626,6 +721,10 @@ public abstract class TermuxSharedProperties {
         return (boolean) getInternalPropertyValue(TermuxPropertyConstants.KEY_USE_FULLSCREEN_WORKAROUND, true);
     }
 
+    public int getBackgroundCommandsMaxParallelism() {
+        return (int) getInternalPropertyValue(TermuxPropertyConstants.KEY_BACKGROUND_COMMANDS_MAX_PARALLELISM, true);
+    }
+
     public int getBellBehaviour() {
         return (int) getInternalPropertyValue(TermuxPropertyConstants.KEY_BELL_BEHAVIOUR, true);
     }
@@ -650,6 +749,10 @@ public abstract class TermuxSharedProperties {
         return (int) getInternalPropertyValue(TermuxPropertyConstants.KEY_TERMINAL_MARGIN_VERTICAL, true);
     }
 
+    public int getTerminalSessionPoolSize() {
+        return (int) getInternalPropertyValue(TermuxPropertyConstants.KEY_TERMINAL_SESSION_POOL_SIZE, true);
+    }
+
     public int getTerminalTranscriptRows() {
         return (int) getInternalPropertyValue(TermuxPropertyConstants.KEY_TERMINAL_TRANSCRIPT_ROWS, true);
     }
@@ -7,6 +7,7 @@ import android.widget.ArrayAdapter;
 import androidx.annotation.NonNull;
 
 import com.termux.shared.shell.command.ExecutionCommand;
+import com.termux.shared.shell.command.result.ResourceUsageAccounting;
 import com.termux.shared.shell.command.runner.app.AppShell;
 import com.termux.shared.termux.settings.preferences.TermuxAppSharedPreferences;
 import com.termux.shared.termux.shell.command.runner.terminal.TermuxSession;
@@ -40,6 +41,12 @@ public class TermuxShellManager {
      */
     public final List<ExecutionCommand> mPendingPluginExecutionCommands = new ArrayList<>();
 
+    /**
+     * The resource usage of the finished TermuxSessions and TermuxTasks per caller package, since
+     * the app process was started.
+     */
+    public final ResourceUsageAccounting mResourceUsageAccounting = new ResourceUsageAccounting();
+
     /**
      * The {@link ExecutionCommand.Runner#APP_SHELL} number after app process was started/restarted.
      */
@@ -44,16 +44,10 @@ public class TermuxShellEnvironment extends AndroidShellEnvironment {
         HashMap<String, String> environmentMap = new TermuxShellEnvironment().getEnvironment(currentPackageContext, false);
         String environmentString = ShellEnvironmentUtils.convertEnvironmentToDotEnvFile(environmentMap);
 
-        // Write environment string to temp file and then move to final location since otherwise
-        // writing may happen while file is being sourced/read
-        Error error = FileUtils.writeTextToFile("termux.env.tmp", TermuxConstants.TERMUX_ENV_TEMP_FILE_PATH,
-            Charset.defaultCharset(), environmentString, false);
-        if (error != null) {
-            Logger.logErrorExtended(LOG_TAG, error.toString());
-            return;
-        }
-
-        error = FileUtils.moveRegularFile("termux.env.tmp", TermuxConstants.TERMUX_ENV_TEMP_FILE_PATH, TermuxConstants.TERMUX_ENV_FILE_PATH, true);
+        // Write environment string atomically since otherwise writing may happen while file is
+        // being sourced/read
+        Error error = FileUtils.writeTextToFileAtomically("termux.env", TermuxConstants.TERMUX_ENV_FILE_PATH,
+            Charset.defaultCharset(), environmentString);
         if (error != null) {
             Logger.logErrorExtended(LOG_TAG, error.toString());
         }
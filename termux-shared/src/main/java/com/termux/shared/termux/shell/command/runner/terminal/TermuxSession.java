@@ -11,6 +11,7 @@ import com.termux.shared.R;
 import com.termux.shared.shell.command.ExecutionCommand;
 import com.termux.shared.shell.command.environment.ShellEnvironmentUtils;
 import com.termux.shared.shell.command.environment.UnixShellEnvironment;
+import com.termux.shared.shell.command.result.ResourceUsage;
 import com.termux.shared.shell.command.result.ResultData;
 import com.termux.shared.errors.Errno;
 import com.termux.shared.logger.Logger;
@@ -168,8 +169,8 @@ public class TermuxSession {
      * Signal that this {@link TermuxSession} has finished.  This should be called when
      * {@link TerminalSessionClient#onSessionFinished(TerminalSession)} callback is received by the caller.
      *
-     * If the processes has finished, then sets {@link ResultData#stdout}, {@link ResultData#stderr}
-     * and {@link ResultData#exitCode} for the {@link #mExecutionCommand} of the {@code termuxTask}
+     * If the processes has finished, then sets {@link ResultData#stdout}, {@link ResultData#stderr},
+     * {@link ResultData#exitCode} and {@link ResultData#resourceUsage} for the {@link #mExecutionCommand} of the {@code termuxTask}
      * and then calls {@link #processTermuxSessionResult(TermuxSession, ExecutionCommand)} to process the result}.
      *
      */
@@ -178,6 +179,7 @@ public class TermuxSession {
         if (mTerminalSession.isRunning()) return;
 
         int exitCode = mTerminalSession.getExitStatus();
+        mExecutionCommand.resultData.resourceUsage = ResourceUsage.of(mTerminalSession.getResourceUsage(), mTerminalSession.getRunTime());
 
         if (exitCode == 0)
             Logger.logDebug(LOG_TAG, "The \"" + mExecutionCommand.getCommandIdAndLabelLogString() + "\" TermuxSession exited normally");